@@ -29,6 +29,7 @@ extern "C"
 }
 
     // C++ system header files
+#include <cstdio>
 
 
     // webdar headers
@@ -41,43 +42,63 @@ extern "C"
 
 using namespace std;
 
+const string answer::empty_body;
+
 void answer::clear()
 {
     status = maj_vers = min_vers = 0;
     reason = "";
     attributes.clear();
-    next_read = attributes.begin();
-    set_attribute(HDR_SERVER, "webdar/0.0");
+    encoded_bodies.clear();
+    next_read = 0;
+    set_attribute(http_token::hdr_server, "webdar/0.0");
     add_body(""); // this adds the Content-Lenght header
 };
 
 void answer::add_cookie(const string & key, const string & value)
 {
-    string oldval;
-    string xval = key+"="+value;
-
         // we cannot use add_attribute_member as it builds a comma (,)
         // separated list while the Set-Cookie field receives a
         // semi-column (;) separated list of attributes
-    if(find_attribute(HDR_SET_COOKIE, oldval))
-        set_attribute(HDR_SET_COOKIE, oldval + "; " + xval);
-    else
-        set_attribute(HDR_SET_COOKIE, xval);
+    attributes.append(http_token::hdr_set_cookie, "; ", key + "=" + value);
 }
 
 void answer::add_body(const string & key)
 {
+    add_body(make_shared<const string>(key));
+}
+
+void answer::add_body(const shared_ptr<const string> & key)
+{
+    if(!key)
+        throw WEBDAR_BUG;
     body = key;
-    set_attribute(HDR_CONTENT_LENGTH, webdar_tools_convert_to_string(body.size()));
+    fbody.reset();
+    encoded_bodies.clear();
+    set_attribute(http_token::hdr_content_length, webdar_tools_convert_to_string(body->size()));
 }
 
-void answer::add_attribute_member(const string & key, const string & value)
+void answer::add_body_file(const shared_ptr<const file_body> & file)
+{
+    if(!file)
+        throw WEBDAR_BUG;
+    body.reset();
+    fbody = file;
+    encoded_bodies.clear();
+    set_attribute(http_token::hdr_content_length, webdar_tools_convert_to_string(fbody->get_size()));
+}
+
+size_t answer::get_body_size() const
 {
-    string in_place;
-    if(find_attribute(key, in_place))
-        set_attribute(key, in_place + "," + value);
+    if(fbody)
+        return fbody->get_size();
     else
-        set_attribute(key, value);
+        return get_body().size();
+}
+
+void answer::add_attribute_member(const string & key, const string & value)
+{
+    attributes.append(key, ",", value);
 }
 
 bool answer::is_valid() const
@@ -85,23 +106,65 @@ bool answer::is_valid() const
     return status < 600 && status > 99;
 }
 
-bool answer::find_attribute(const string & key, string & value) const
+bool answer::find_encoded_body(http_compression::coding c, shared_ptr<const string> & data) const
 {
-    string lkey = webdar_tools_to_canonical_case(key);
-    map<string,string>::const_iterator it = attributes.find(lkey);
+    map<http_compression::coding, shared_ptr<const string> >::const_iterator it = encoded_bodies.find(c);
 
-    if(it != attributes.end())
+    if(it != encoded_bodies.end())
     {
-        value = it->second;
+        data = it->second;
         return true;
     }
     else
         return false;
 }
 
+bool answer::find_attribute(const string & key, string & value) const
+{
+    return attributes.find(key, value);
+}
+
 void answer::write(proto_connexion & output)
 {
+    string head = build_header();
+    struct iovec vec[2];
+
+    vec[0].iov_base = (void *)(head.c_str());
+    vec[0].iov_len = head.size();
+
+    if(fbody)
+        output.write_file(vec, 1, fbody->get_fd(), 0, fbody->get_size());
+    else
+    {
+        vec[1].iov_base = (void *)(get_body().c_str());
+        vec[1].iov_len = get_body().size();
+        output.write_vector(vec, 2, body);
+    }
+}
+
+string answer::render() const
+{
+    if(fbody)
+        throw WEBDAR_BUG;
+
+    return build_header() + get_body();
+}
+
+void answer::write_header(proto_connexion & output)
+{
+    string head = build_header();
+    struct iovec vec;
+
+    vec.iov_base = (void *)(head.c_str());
+    vec.iov_len = head.size();
+    output.write_vector(&vec, 1);
+}
+
+string answer::build_header() const
+{
+    string ret;
     string key, val;
+    size_t len = 0;
 
     if(maj_vers != 1 || (min_vers != 0 && min_vers != 1))
         throw exception_feature("Unsupported HTTP protocole version: "
@@ -112,43 +175,76 @@ void answer::write(proto_connexion & output)
     if(status < 100 && status > 599)
         throw WEBDAR_BUG;
 
-    val = string("HTTP/") + webdar_tools_convert_to_string(maj_vers)
+        // sizing the string once for all
+
+    len = reason.size() + 20;
+    for(unsigned int i = 0; i < attributes.size(); ++i)
+        len += attributes.get_name(i).size() + attributes.get_value(i).size() + 4;
+    ret.reserve(len);
+
+    ret += string("HTTP/") + webdar_tools_convert_to_string(maj_vers)
         + "." + webdar_tools_convert_to_string(min_vers);
-    output.write(val.c_str(), val.size());
-    output.write(" ", 1);
-    val = webdar_tools_convert_to_string(status);
-    output.write(val.c_str(), val.size());
-    output.write(" ", 1);
-    output.write(reason.c_str(), reason.size());
-    output.write("\r\n", 2);
+    ret += " ";
+    ret += webdar_tools_convert_to_string(status);
+    ret += " ";
+    ret += reason;
+    ret += "\r\n";
 
     reset_read_next_attribute();
     while(read_next_attribute(key, val))
     {
-        output.write(key.c_str(), key.size());
-        output.write(": ", 2);
-        output.write(val.c_str(), val.size());
-        output.write("\r\n", 2);
+        ret += key;
+        ret += ": ";
+        ret += val;
+        ret += "\r\n";
     }
-    output.write("\r\n", 2); // empty line to indicate the start of the body
-    if(get_body().size() > 0)
-        output.write(body.c_str(), body.size());
+    ret += "\r\n"; // empty line to indicate the start of the body
+
+    return ret;
+}
+
+void answer::write_chunk(proto_connexion & output, const string & data)
+{
+    char size[sizeof(unsigned int)*2 + 3];
+    int len;
+    struct iovec vec[3];
+
+    if(data.empty())
+        throw WEBDAR_BUG;
+
+    len = snprintf(size, sizeof(size), "%x\r\n", (unsigned int)data.size());
+    if(len < 0 || (unsigned int)len >= sizeof(size))
+        throw WEBDAR_BUG;
+
+    vec[0].iov_base = size;
+    vec[0].iov_len = len;
+    vec[1].iov_base = (void *)(data.c_str());
+    vec[1].iov_len = data.size();
+    vec[2].iov_base = (void *)("\r\n");
+    vec[2].iov_len = 2;
+    output.write_vector(vec, 3);
+}
+
+void answer::write_last_chunk(proto_connexion & output)
+{
+    struct iovec vec;
 
-        // flushing output writings
-    output.flush_write();
+    vec.iov_base = (void *)("0\r\n\r\n");
+    vec.iov_len = 5;
+    output.write_vector(&vec, 1);
 }
 
 void answer::reset_read_next_attribute() const
 {
-    next_read = attributes.begin();
+    next_read = 0;
 }
 
 bool answer::read_next_attribute(string & key, string & value) const
 {
-    if(next_read != attributes.end())
+    if(next_read < attributes.size())
     {
-        key = next_read->first;
-        value = next_read->second;
+        key = attributes.get_name(next_read);
+        value = attributes.get_value(next_read);
         ++next_read;
         return true;
     }
@@ -164,5 +260,7 @@ void answer::copy_from(const answer & ref)
     min_vers = ref.min_vers;
     attributes = ref.attributes;
     body = ref.body;
-    next_read = attributes.begin();
+    fbody = ref.fbody;
+    encoded_bodies = ref.encoded_bodies;
+    next_read = 0;
 }
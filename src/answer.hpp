@@ -34,12 +34,17 @@ extern "C"
     // C++ system header files
 #include <string>
 #include <map>
+#include <memory>
 
     // webdar headers
 #include "uri.hpp"
 #include "webdar_tools.hpp"
 #include "exceptions.hpp"
 #include "proto_connexion.hpp"
+#include "http_compression.hpp"
+#include "file_body.hpp"
+#include "header_list.hpp"
+#include "http_token.hpp"
 
     /// class answer provides easy means to set an HTTP answer and means to sent it back to a proto_connexion object
 
@@ -89,11 +94,48 @@ public:
         /// \note this also set Content-Length accordingly
     void add_body(const std::string & key);
 
+        /// adds a body shared with other objects [optional]
+
+        /// \note the pointed to string must not be modified afterward, this
+        /// avoids copying large bodies and lets them be sent without copy
+    void add_body(const std::shared_ptr<const std::string> & key);
+
+        /// adds a body read from an opened file at the time the answer is sent [optional]
+
+        /// \note this also set Content-Length accordingly and drops any body
+        /// previously set by add_body()
+    void add_body_file(const std::shared_ptr<const file_body> & file);
+
         /// removes the body keeping header untouched (Content-Length in particular)
-    void drop_body_keep_header() { body = ""; };
+    void drop_body_keep_header() { body.reset(); encoded_bodies.clear(); fbody.reset(); };
+
+        /// provides an already encoded version of the body [optional]
+
+        /// \note this let the parser send this version of the body rather than compressing
+        /// it on the fly when the client accepts this content coding. The body set with
+        /// add_body() must be set first, as add_body() drops the encoded versions
+    void add_encoded_body(http_compression::coding c, const std::string & data) { encoded_bodies[c] = std::make_shared<const std::string>(data); };
+
+        /// provides an already encoded version of the body shared with other objects [optional]
+    void add_encoded_body(http_compression::coding c, const std::shared_ptr<const std::string> & data) { encoded_bodies[c] = data; };
+
+        /// whether some encoded version of the body is available
+    bool has_encoded_body() const { return !encoded_bodies.empty(); };
+
+        /// obtains the encoded version of the body for the given coding if available
+    bool find_encoded_body(http_compression::coding c, std::shared_ptr<const std::string> & data) const;
 
         /// set a given attribute to the HTTP header
-    void set_attribute(const std::string & key, const std::string & value) { attributes[webdar_tools_to_canonical_case(key)] = value; };
+    void set_attribute(const std::string & key, const std::string & value) { attributes.set(key, value); };
+
+        /// set a known attribute to the HTTP header
+    void set_attribute(http_token::header key, const std::string & value) { attributes.set(key, value); };
+
+        /// remove an attribute from the HTTP header if present
+    void drop_attribute(const std::string & key) { attributes.erase(key); };
+
+        /// remove a known attribute from the HTTP header if present
+    void drop_attribute(http_token::header key) { attributes.erase(key); };
 
         /// add an attribute to a possibly already existing message header
         ///
@@ -116,6 +158,9 @@ public:
         /// exists, the given value is added to the existing value to form a new CSV f
     void add_attribute_member(const std::string & key, const std::string & value);
 
+        /// add an attribute to a possibly already existing known message header
+    void add_attribute_member(http_token::header key, const std::string & value) { attributes.append(key, ",", value); };
+
 
         /////// VALIDATING THE OBJECT
 
@@ -139,7 +184,18 @@ public:
     unsigned int get_min_version() const { return min_vers; };
 
         /// get the current body of the answer
-    const std::string get_body() const { return body; };
+
+        /// \note a body set with add_body_file() is not returned here
+    const std::string & get_body() const { return body ? *body : empty_body; };
+
+        /// size of the body whatever is the way it was set
+    size_t get_body_size() const;
+
+        /// whether the body is read from a file
+    bool has_file_body() const { return bool(fbody); };
+
+        /// the file the body is read from, if any (see add_body_file())
+    const std::shared_ptr<const file_body> & get_file_body() const { return fbody; };
 
         /// retrieve the value of an attribute of the HTTP answer
         ///
@@ -148,36 +204,68 @@ public:
         /// \return true if the requested attribute has been found in this request
     bool find_attribute(const std::string & key, std::string & value) const;
 
+        /// look for the value of a known attribute in the HTTP header
+    bool find_attribute(http_token::header key, std::string & value) const { return attributes.find(key, value); };
+
+        /// reset the read_next_attribute to the beginning of the list
+    void reset_read_next_attribute() const;
+
+        /// reads the next attributes
+        ///
+        /// \param[out] key key of the next attribute
+        /// \param[out] value value of that attribute
+        /// \return true if a next attribute has been else, key and value are not set
+    bool read_next_attribute(std::string & key, std::string & value) const;
+
 
         /////// SERIALIZING THE OBJECT TO AN EXISTING CONNECTION
 
         /// send the answer
+
+        /// \note status line and header are assembled in memory and sent
+        /// at once with the body without copying it
     void write(proto_connexion & output);
 
+        /// provides the answer as sent on the wire (status line, header and body)
+
+        /// \note to be used for answers sent unchanged many times, the answer must not have a file body
+    std::string render() const;
+
+        /// send the status line and header only, the body being sent afterward by pieces
+
+        /// \note the caller is responsible for having set the headers (Transfer-Encoding or
+        /// Connection) that let the peer know where the body ends
+    void write_header(proto_connexion & output);
+
+        /// send a piece of body using the chunked transfer coding (RFC 7230 paragraph 4.1)
+
+        /// \note data must not be empty as an empty chunk marks the end of the body
+    static void write_chunk(proto_connexion & output, const std::string & data);
+
+        /// send the last (empty) chunk ending a chunked body
+    static void write_last_chunk(proto_connexion & output);
+
 private:
     unsigned int status;       ///< the HTTP status the answer should return
     std::string reason;        ///< the HTTP reason the answer should return
     unsigned int maj_vers;     ///< the HTTP version of the answer (in HTTP/1.0 maj_vers is 1)
     unsigned int min_vers;     ///< the HTTP decimal version of the answer (in HTTP/1.0 min_vers is 0)
-    std::map<std::string, std::string> attributes; ///< http answer attributes like cookies
-    std::string body;          ///< the HTTP body (HTML header + HTML Body) of the HTTP answer
+    header_list attributes;    ///< http answer attributes like cookies
+    std::shared_ptr<const std::string> body; ///< the HTTP body (HTML header + HTML Body) of the HTTP answer
+    std::shared_ptr<const file_body> fbody;  ///< the HTTP body when read from a file
+    std::map<http_compression::coding, std::shared_ptr<const std::string> > encoded_bodies; ///< precompressed versions of body
 
-        /// field used to sequentially read the map of attributes
-    mutable std::map<std::string, std::string>::const_iterator next_read;
+    static const std::string empty_body;
 
-        /// reset the read_next_attribute to the beginning of the list
-    void reset_read_next_attribute() const;
-
-        /// reads the next attributes
-        ///
-        /// \param[out] key key of the next attribute
-        /// \param[out] value value of that attribute
-        /// \return true if a next attribute has been else, key and value are not set
-    bool read_next_attribute(std::string & key, std::string & value) const;
+        /// index used to sequentially read the list of attributes
+    mutable unsigned int next_read;
 
         /// used in copy constructor and copy operators
     void copy_from(const answer & ref);
 
+        /// assemble the status line and the header
+    std::string build_header() const;
+
 };
 
 #endif
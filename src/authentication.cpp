@@ -0,0 +1,227 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+#if HAVE_STRING_H
+#include <string.h>
+#endif
+
+#if HAVE_SECURITY_PAM_APPL_H
+#include <security/pam_appl.h>
+#endif
+}
+
+    // C++ system header files
+#include <thread>
+#include <chrono>
+
+    // webdar headers
+#include "base64.hpp"
+#include "exceptions.hpp"
+
+    //
+#include "authentication.hpp"
+
+using namespace std;
+
+#if HAVE_SECURITY_PAM_APPL_H && HAVE_LIBPAM
+#define WEBDAR_PAM 1
+#endif
+
+#ifdef WEBDAR_PAM
+    /// what the PAM callbacks exchange with valid_credentials()
+struct pam_exchange
+{
+    const string *password;  ///< answer to any prompt
+    unsigned int delay;      ///< delay in microseconds PAM asks before reporting a failure
+};
+
+    /// PAM conversation function answering the password to any prompt
+
+    /// \note appdata_ptr points to a pam_exchange structure
+static int pam_conversation(int num_msg, const struct pam_message **msg, struct pam_response **resp, void *appdata_ptr);
+
+#ifdef PAM_FAIL_DELAY
+    /// records the delay a failed authentication asks rather than sleeping with the PAM lock held
+
+    /// \note appdata_ptr points to a pam_exchange structure
+static void pam_record_delay(int retval, unsigned usec_delay, void *appdata_ptr);
+#endif
+#endif
+
+bool authentication::valid_authorization(const string & token, string & username) const
+{
+    string user, pass;
+
+    if(decode_basic_token(token, user, pass)
+       && valid_credentials(user, pass))
+    {
+	username = user;
+	return true;
+    }
+    else
+	return false;
+}
+
+bool authentication::decode_basic_token(const string & token, string & username, string & credential)
+{
+    string clear = base64().decode(token);
+    string::size_type colon = clear.find(':');
+
+    if(colon == string::npos)
+	return false;
+
+    username = clear.substr(0, colon);
+    credential = clear.substr(colon + 1);
+
+    return true;
+}
+
+authentication_unix::authentication_unix(const string & service):
+    pam_service(service)
+{
+    if(!available())
+	throw exception_feature("system authentication (webdar has been built without PAM)");
+    if(pam_service.empty())
+	throw exception_range("empty PAM service name");
+}
+
+bool authentication_unix::valid_credentials(const string & username, const string & credential) const
+{
+#ifdef WEBDAR_PAM
+    pam_handle_t *handle = nullptr;
+    struct pam_conv conv;
+    pam_exchange exch;
+    int code;
+
+    if(username.empty() || credential.empty())
+	return false;
+
+    exch.password = &credential;
+    exch.delay = 0;
+    conv.conv = &pam_conversation;
+    conv.appdata_ptr = (void *)(&exch);
+
+    control.lock();
+    try
+    {
+	code = pam_start(pam_service.c_str(), username.c_str(), &conv, &handle);
+	if(code == PAM_SUCCESS)
+	{
+#ifdef PAM_FAIL_DELAY
+	    (void)pam_set_item(handle, PAM_FAIL_DELAY, (const void *)(&pam_record_delay));
+#endif
+	    code = pam_authenticate(handle, PAM_SILENT | PAM_DISALLOW_NULL_AUTHTOK);
+	    if(code == PAM_SUCCESS)
+		code = pam_acct_mgmt(handle, PAM_SILENT | PAM_DISALLOW_NULL_AUTHTOK);
+	    (void)pam_end(handle, code);
+	}
+    }
+    catch(...)
+    {
+	control.unlock();
+	throw;
+    }
+    control.unlock();
+
+	// the failure delay is spent by the calling thread only,
+	// the other connections may meanwhile authenticate
+    if(code != PAM_SUCCESS && exch.delay > 0)
+	this_thread::sleep_for(chrono::microseconds(exch.delay));
+
+    return code == PAM_SUCCESS;
+#else
+    return false;
+#endif
+}
+
+bool authentication_unix::available()
+{
+#ifdef WEBDAR_PAM
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef WEBDAR_PAM
+static int pam_conversation(int num_msg, const struct pam_message **msg, struct pam_response **resp, void *appdata_ptr)
+{
+    const pam_exchange *exch = (const pam_exchange *)(appdata_ptr);
+    struct pam_response *ret = nullptr;
+
+    if(num_msg <= 0 || exch == nullptr || exch->password == nullptr)
+	return PAM_CONV_ERR;
+
+	// the responses are released by PAM with free()
+    ret = (struct pam_response *)(calloc(num_msg, sizeof(struct pam_response)));
+    if(ret == nullptr)
+	return PAM_BUF_ERR;
+
+    for(int i = 0; i < num_msg; ++i)
+    {
+	switch(msg[i]->msg_style)
+	{
+	case PAM_PROMPT_ECHO_OFF:
+	case PAM_PROMPT_ECHO_ON:
+	    ret[i].resp = strdup(exch->password->c_str());
+	    if(ret[i].resp == nullptr)
+	    {
+		for(int j = 0; j < i; ++j)
+		    free(ret[j].resp);
+		free(ret);
+		return PAM_BUF_ERR;
+	    }
+	    break;
+	case PAM_ERROR_MSG:
+	case PAM_TEXT_INFO:
+	    break;
+	default:
+	    for(int j = 0; j < i; ++j)
+		free(ret[j].resp);
+	    free(ret);
+	    return PAM_CONV_ERR;
+	}
+    }
+
+    *resp = ret;
+    return PAM_SUCCESS;
+}
+
+#ifdef PAM_FAIL_DELAY
+static void pam_record_delay(int retval, unsigned usec_delay, void *appdata_ptr)
+{
+    pam_exchange *exch = (pam_exchange *)(appdata_ptr);
+
+    if(retval != PAM_SUCCESS && exch != nullptr)
+	exch->delay = usec_delay;
+}
+#endif
+#endif
@@ -28,11 +28,14 @@
 #include "my_config.h"
 extern "C"
 {
-
+#if HAVE_STRING_H
+#include <string.h>
+#endif
 }
 
     // C++ system header files
 #include <string>
+#include <libthreadar/libthreadar.hpp>
 
     // webdar headers
 
@@ -49,13 +52,50 @@ public:
     virtual ~authentication() {};
 
     virtual bool valid_credentials(const std::string & username, const std::string & credential) const = 0;
+
+	/// validate the credentials carried by a Basic Authorization header
+
+	/// \param[in] token the base64 encoded "user:password" part of the header value
+	/// \param[out] username the authenticated user, only set when true is returned
+	/// \note the default implementation decodes the token and calls valid_credentials()
+    virtual bool valid_authorization(const std::string & token, std::string & username) const;
+
+protected:
+	/// split a Basic Authorization token in username and credential
+
+	/// \return false if the token is not properly formed
+    static bool decode_basic_token(const std::string & token, std::string & username, std::string & credential);
 };
 
-    /// place holder class for Unix PAM authentication (not implemented for now)
+    /// authentication_unix checks the credentials against the system accounts through PAM
+
+    /// \note PAM modules are not all thread-safe, calls are serialized and are expected to be
+    /// slow, see class authentication_cache to avoid a PAM conversation for every request a
+    /// browser sends with the same credentials. The delay PAM applies to a failed attempt is
+    /// spent by the calling thread after the lock has been released.
 
 class authentication_unix : public authentication
 {
-/// A IMPLEMENTER
+public:
+	/// constructor
+
+	/// \param[in] service is the PAM service the accounts are checked against (/etc/pam.d/<service>)
+	/// \note throws exception_feature if webdar has been built without PAM support
+    authentication_unix(const std::string & service);
+    authentication_unix(const authentication_unix & ref) = delete;
+    authentication_unix(authentication_unix && ref) noexcept = delete;
+    authentication_unix & operator = (const authentication_unix & ref) = delete;
+    authentication_unix & operator = (authentication_unix && ref) noexcept = delete;
+    ~authentication_unix() = default;
+
+    virtual bool valid_credentials(const std::string & username, const std::string & credential) const override;
+
+	/// whether webdar has been built with PAM support
+    static bool available();
+
+private:
+    std::string pam_service;
+    mutable libthreadar::mutex control; ///< serializes the PAM conversations
 
 };
 
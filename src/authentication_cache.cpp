@@ -0,0 +1,303 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_OPENSSL_RAND_H
+#include <openssl/rand.h>
+#endif
+
+#if HAVE_OPENSSL_EVP_H
+#include <openssl/evp.h>
+#endif
+}
+
+    // C++ system header files
+
+
+    // webdar headers
+#include "exceptions.hpp"
+
+    //
+#include "authentication_cache.hpp"
+
+using namespace std;
+
+    /// default time in seconds a validated token is kept
+#define AUTH_CACHE_DEFAULT_LIFETIME 300
+
+    /// default max number of tokens kept
+#define AUTH_CACHE_DEFAULT_SIZE 256
+
+    /// max number of failed authentications for a user within AUTH_CACHE_FAILURE_WINDOW
+#define AUTH_CACHE_MAX_FAILURES 5
+
+    /// time in seconds failed authentications are counted
+#define AUTH_CACHE_FAILURE_WINDOW 60
+
+    /// size of the random salt in bytes
+#define AUTH_CACHE_SALT_SIZE 16
+
+unsigned int authentication_cache::default_lifetime = AUTH_CACHE_DEFAULT_LIFETIME;
+unsigned int authentication_cache::default_max_entries = AUTH_CACHE_DEFAULT_SIZE;
+
+authentication_cache::authentication_cache(const shared_ptr<const authentication> & base):
+    database(base),
+    lifetime(default_lifetime),
+    max_entries(default_max_entries)
+{
+    unsigned char tmp[AUTH_CACHE_SALT_SIZE];
+
+    if(!database)
+	throw WEBDAR_BUG;
+
+    if(RAND_bytes(tmp, sizeof(tmp)) <= 0)
+	throw exception_openssl();
+    salt.assign((const char *)(tmp), sizeof(tmp));
+}
+
+bool authentication_cache::valid_credentials(const string & username, const string & credential) const
+{
+    return database->valid_credentials(username, credential);
+}
+
+bool authentication_cache::valid_authorization(const string & token, string & username) const
+{
+    string hash;
+    string user, pass;
+
+    if(lifetime == 0 || max_entries == 0)
+	return database->valid_authorization(token, username);
+
+    hash = hash_of(token);
+    if(lookup(hash, username))
+	return true;
+
+    if(!decode_basic_token(token, user, pass))
+	return false;
+
+	// tokens already in cache are not concerned,
+	// a failing attacker does not disconnect the user
+    if(throttled(user))
+	return false;
+
+    if(database->valid_credentials(user, pass))
+    {
+	clear_failures(user);
+	record(hash, user);
+	username = user;
+	return true;
+    }
+    else
+    {
+	record_failure(user);
+	return false;
+    }
+}
+
+string authentication_cache::hash_of(const string & token) const
+{
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int md_len = 0;
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    bool ok;
+
+    if(ctx == nullptr)
+	throw exception_openssl();
+
+    ok = EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr) == 1
+	&& EVP_DigestUpdate(ctx, salt.data(), salt.size()) == 1
+	&& EVP_DigestUpdate(ctx, token.data(), token.size()) == 1
+	&& EVP_DigestFinal_ex(ctx, md, &md_len) == 1;
+    EVP_MD_CTX_free(ctx);
+
+    if(!ok)
+	throw exception_openssl();
+
+    return string((const char *)(md), md_len);
+}
+
+bool authentication_cache::lookup(const string & hash, string & username) const
+{
+    bool ret = false;
+
+    control.lock();
+    try
+    {
+	map<string, entry>::iterator it = cache.find(hash);
+
+	if(it != cache.end())
+	{
+	    if(time(nullptr) < it->second.expires)
+	    {
+		username = it->second.username;
+		ret = true;
+	    }
+	    else
+		cache.erase(it);
+	}
+    }
+    catch(...)
+    {
+	control.unlock();
+	throw;
+    }
+    control.unlock();
+
+    return ret;
+}
+
+void authentication_cache::record(const string & hash, const string & username) const
+{
+    control.lock();
+    try
+    {
+	time_t now = time(nullptr);
+
+	if(cache.size() >= max_entries)
+	{
+	    map<string, entry>::iterator it = cache.begin();
+
+	    while(it != cache.end())
+	    {
+		if(it->second.expires <= now)
+		    it = cache.erase(it);
+		else
+		    ++it;
+	    }
+	}
+
+	if(cache.size() >= max_entries)
+	{
+	    map<string, entry>::iterator oldest = cache.begin();
+
+	    for(map<string, entry>::iterator it = cache.begin(); it != cache.end(); ++it)
+		if(it->second.expires < oldest->second.expires)
+		    oldest = it;
+	    cache.erase(oldest);
+	}
+
+	entry & ent = cache[hash];
+	ent.username = username;
+	ent.expires = now + lifetime;
+    }
+    catch(...)
+    {
+	control.unlock();
+	throw;
+    }
+    control.unlock();
+}
+
+bool authentication_cache::throttled(const string & username) const
+{
+    bool ret = false;
+
+    control.lock();
+    try
+    {
+	map<string, failure>::iterator it = failed.find(username);
+
+	if(it != failed.end())
+	{
+	    if(time(nullptr) < it->second.window + AUTH_CACHE_FAILURE_WINDOW)
+		ret = it->second.count >= AUTH_CACHE_MAX_FAILURES;
+	    else
+		failed.erase(it);
+	}
+    }
+    catch(...)
+    {
+	control.unlock();
+	throw;
+    }
+    control.unlock();
+
+    return ret;
+}
+
+void authentication_cache::record_failure(const string & username) const
+{
+    control.lock();
+    try
+    {
+	time_t now = time(nullptr);
+	map<string, failure>::iterator it = failed.find(username);
+
+	if(it == failed.end() && failed.size() >= max_entries)
+	{
+	    it = failed.begin();
+	    while(it != failed.end())
+	    {
+		if(it->second.window + AUTH_CACHE_FAILURE_WINDOW <= now)
+		    it = failed.erase(it);
+		else
+		    ++it;
+	    }
+
+	    if(failed.size() >= max_entries)
+	    {
+		map<string, failure>::iterator oldest = failed.begin();
+
+		for(it = failed.begin(); it != failed.end(); ++it)
+		    if(it->second.window < oldest->second.window)
+			oldest = it;
+		failed.erase(oldest);
+	    }
+
+	    it = failed.end();
+	}
+
+	if(it == failed.end() || it->second.window + AUTH_CACHE_FAILURE_WINDOW <= now)
+	{
+	    failure & fail = failed[username];
+	    fail.count = 1;
+	    fail.window = now;
+	}
+	else
+	    ++(it->second.count);
+    }
+    catch(...)
+    {
+	control.unlock();
+	throw;
+    }
+    control.unlock();
+}
+
+void authentication_cache::clear_failures(const string & username) const
+{
+    control.lock();
+    try
+    {
+	failed.erase(username);
+    }
+    catch(...)
+    {
+	control.unlock();
+	throw;
+    }
+    control.unlock();
+}
@@ -0,0 +1,131 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef AUTHENTICATION_CACHE_HPP
+#define AUTHENTICATION_CACHE_HPP
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_TIME_H
+#include <time.h>
+#endif
+}
+
+    // C++ system header files
+#include <string>
+#include <map>
+#include <memory>
+#include <libthreadar/libthreadar.hpp>
+
+    // webdar headers
+#include "authentication.hpp"
+
+    /// authentication_cache remembers the Basic Authorization tokens recently validated by another authentication object
+
+    /// browsers resend the same Authorization header with every request, this class
+    /// lets only the first one go through the (possibly slow) underlying authentication.
+    /// Tokens are not stored, only a salted SHA-256 hash of them, the salt being
+    /// randomly generated for each object. An entry expires after a given lifetime,
+    /// the number of entries is bounded (the entry closest to expiration is evicted
+    /// first). Failed authentications are counted per user, after a few of them in a
+    /// short time, tokens for that user not already in cache are refused without
+    /// asking the underlying authentication until the time window has passed.
+
+class authentication_cache : public authentication
+{
+public:
+	/// constructor
+
+	/// \param[in] base is the authentication the tokens not found in cache are checked against
+    authentication_cache(const std::shared_ptr<const authentication> & base);
+    authentication_cache(const authentication_cache & ref) = delete;
+    authentication_cache(authentication_cache && ref) noexcept = delete;
+    authentication_cache & operator = (const authentication_cache & ref) = delete;
+    authentication_cache & operator = (authentication_cache && ref) noexcept = delete;
+    ~authentication_cache() = default;
+
+	/// credentials given directly are not cached and checked against the base authentication
+    virtual bool valid_credentials(const std::string & username, const std::string & credential) const override;
+
+    virtual bool valid_authorization(const std::string & token, std::string & username) const override;
+
+	/// set the cache parameters for the authentication_cache objects to come
+
+	/// \param[in] lifetime time in seconds a validated token is kept, zero disables the cache
+	/// \param[in] max_entries max number of tokens kept
+    static void set_parameters(unsigned int lifetime, unsigned int max_entries) { default_lifetime = lifetime; default_max_entries = max_entries; };
+
+	/// time in seconds a validated token is kept by the objects to come
+    static unsigned int get_lifetime() { return default_lifetime; };
+
+	/// max number of tokens kept by the objects to come
+    static unsigned int get_max_entries() { return default_max_entries; };
+
+private:
+    struct entry
+    {
+	std::string username; ///< user the token has been validated for
+	time_t expires;       ///< time after which the token must be validated again
+    };
+
+    struct failure
+    {
+	unsigned int count;   ///< number of failed authentications since window
+	time_t window;        ///< time the first of these failures occurred
+    };
+
+    std::shared_ptr<const authentication> database;
+    std::string salt;
+    unsigned int lifetime;
+    unsigned int max_entries;
+
+    mutable libthreadar::mutex control;        ///< protects the fields below
+    mutable std::map<std::string, entry> cache; ///< entries indexed by the salted hash of the token
+    mutable std::map<std::string, failure> failed; ///< recent failures indexed by username
+
+    static unsigned int default_lifetime;
+    static unsigned int default_max_entries;
+
+	/// salted hash of a token
+    std::string hash_of(const std::string & token) const;
+
+	/// lookup a token which hash is given, returns false if not found or expired
+    bool lookup(const std::string & hash, std::string & username) const;
+
+	/// record a validated token
+    void record(const std::string & hash, const std::string & username) const;
+
+	/// whether the user has failed authenticating too many times recently
+    bool throttled(const std::string & username) const;
+
+	/// account a failed authentication for the given user
+    void record_failure(const std::string & username) const;
+
+	/// forget the failures of the given user after a successful authentication
+    void clear_failures(const std::string & username) const;
+
+};
+
+#endif
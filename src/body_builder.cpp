@@ -677,6 +677,7 @@ string body_builder::get_body_part_or_cache(const chemin & path,
 
     if(path == last_body_path
        && req.get_uri() == (const uri)(last_body_req_uri)
+       && ! req.is_multipart() // multipart bodies are not kept by the request and cannot be compared
        && req.get_body() == last_body_req_body
        && ! body_changed)
     {
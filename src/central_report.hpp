@@ -61,6 +61,9 @@ public:
 
     void report(priority_t priority, const std::string & message);
 
+	/// whether messages of the given priority get reported (avoids building them for nothing)
+    bool is_reported(priority_t priority) const { return priority <= min; };
+
 protected:
     virtual void inherited_report(priority_t priority, const std::string & message) = 0;
 
@@ -32,7 +32,6 @@ extern "C"
 
 
     // webdar headers
-#include "base64.hpp"
 #include "session.hpp"
 #include "error_page.hpp"
     //
@@ -43,36 +42,32 @@ using namespace std;
 challenge::challenge(const shared_ptr<const authentication> & base):
     page("Webdar")
 {
-    if(!base)
-	throw WEBDAR_BUG;
-    database = base;
+    set_base(base);
 
     title.add_text(1, "Authentication required to access Webdar");
     page.adopt(&title);
 }
 
+void challenge::set_base(const shared_ptr<const authentication> & base)
+{
+    if(!base)
+	throw WEBDAR_BUG;
+    database = base;
+}
+
 
 bool challenge::is_an_authoritative_request(const request & req, string & user)
 {
     bool ret = false;
     string val;
 
-    if(req.find_attribute(HDR_AUTHORIZATION, val))
+    if(req.find_attribute(http_token::hdr_authorization, val))
     {
 	string sp1, sp2;
 
 	webdar_tools_split_in_two(' ', val, sp1, sp2);
 	if(webdar_tools_to_canonical_case(sp1) == webdar_tools_to_canonical_case("Basic"))
-	{
-	    string clear = base64().decode(sp2);
-	    webdar_tools_split_in_two(':', clear, sp1, sp2);
-
-	    if(database->valid_credentials(sp1, sp2))
-	    {
-		user = sp1;
-		ret = true;
-	    }
-	}
+	    ret = database->valid_authorization(sp2, user);
     }
 
     return ret;
@@ -86,7 +81,7 @@ answer challenge::give_answer(const request & req)
 	// Request a login/password
     ret.set_status(STATUS_CODE_UNAUTHORIZED);
     ret.set_reason("login/password requested");
-    ret.set_attribute(HDR_WWW_AUTHENTICATE, "Basic realm=\"/Webdar\"");
+    ret.set_attribute(http_token::hdr_www_authenticate, "Basic realm=\"/Webdar\"");
     ret.add_body(page.get_body_part(req.get_uri().get_path(), req));
 
     return ret;
@@ -51,6 +51,9 @@ public:
 	/// \note the base argument must survive this challenge object and is
     challenge(const std::shared_ptr<const authentication> & base);
 
+	/// change the authentication base to consider for the next requests
+    void set_base(const std::shared_ptr<const authentication> & base);
+
 	/// returns whether the request is authoritative
 	///
 	/// \param[in] req the request to analyse
@@ -162,6 +162,20 @@ void choose::set_owner(const string & user)
     }
 }
 
+void choose::clear()
+{
+    owner.clear();
+    disco.set_username("");
+    disconnect_req = false;
+    confirmed.set_visible(false);
+
+	// the sessions of the previous owner must not be the
+	// target of a form posted before the table is regenerated
+    release_boxes();
+    table.clear();
+    sess.clear();
+}
+
 answer choose::give_answer(const request & req)
 {
     answer ret;
@@ -173,7 +187,7 @@ answer choose::give_answer(const request & req)
 
 	// update the form fields when request is a POST
 
-    if(req.get_method() == "POST")
+    if(req.get_method_id() == http_token::method_post)
 	(void)page.get_body_part(req.get_uri().get_path(), req);
 
 	// generate response HTML page
@@ -80,6 +80,12 @@ public:
 	/// inherited from actor
     virtual void on_event(const std::string & event_name) override;
 
+	/// forget the owner, the sessions listed and any pending confirmation
+
+	/// \note to be called before the object serves another connection, set_owner()
+	/// has then to be called again before give_answer()
+    void clear();
+
 	/// whether user has requested to disconnect
     bool disconnection_requested() const { bool ret = disconnect_req; disconnect_req = false; return ret; };
 
@@ -44,18 +44,66 @@ extern "C"
 #if HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
+
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
+#if HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+
+#if HAVE_POLL_H
+#include <poll.h>
+#endif
+
+#if HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#endif
+
+#if HAVE_LINUX_ERRQUEUE_H
+#include <linux/errqueue.h>
+#endif
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 }
 
+    // C++ system header files
+#include <vector>
+
     // webdar headers
 
 #include "connexion.hpp"
 
 using namespace std;
 
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && HAVE_LINUX_ERRQUEUE_H && HAVE_POLL_H
+#define WEBDAR_ZEROCOPY 1
+#endif
+
+    /// max time to wait for the completion of zero-copy sends when closing the connection (ms)
+#define ZEROCOPY_CLOSING_WAIT 1000
+
+unsigned int connexion::zerocopy_threshold = 0;
+
 connexion::connexion(int fd, const string & peerip, unsigned int peerport):
     proto_connexion(peerip, peerport)
 {
     filedesc = fd;
+    zc_state = zc_unknown;
+    zc_sent = 0;
+    zc_done = 0;
+}
+
+bool connexion::zerocopy_available()
+{
+#ifdef WEBDAR_ZEROCOPY
+    return true;
+#else
+    return false;
+#endif
 }
 
 connexion::~connexion()
@@ -79,6 +127,21 @@ unsigned int connexion::read_impl(char *a, unsigned int size, bool blocking)
     if(get_status() != connected)
         throw WEBDAR_BUG;
 
+    if(!zc_pending.empty())
+	zerocopy_reap(false);
+	// else pending notifications would let the socket be
+	// signaled forever as in error by epoll()
+
+    if(blocking)
+    {
+	int wait = get_read_wait();
+
+	    // with a time limit, we wait for data before
+	    // calling recv() that would block without limit
+	while(wait >= 0 && !wait_socket(POLLIN, wait, true))
+	    wait = get_read_wait();
+    }
+
     lu = recv(filedesc, a, size, flag);
     if(lu == 0)
     {
@@ -127,20 +190,114 @@ void connexion::write_impl(const char *a, unsigned int size)
                 break;
             case EINTR:
                 break;
+	    case EAGAIN:
+		    // non-blocking socket (see ssl_connexion)
+		(void)wait_socket(POLLOUT, -1);
+		break;
             default:
                 throw exception_system("Error met while sending data: ", errno);
             }
         }
         else
             wrote += tmp;
+	count_write_syscall();
     }
 }
 
+void connexion::write_vector_impl(const struct iovec *vec,
+				  unsigned int count,
+				  const shared_ptr<const string> & owner)
+{
+    vector<struct iovec> tmp(vec, vec + count);
+
+    if(get_status() != connected)
+        throw WEBDAR_BUG;
+
+    if(count == 0)
+	return;
+
+#ifdef WEBDAR_ZEROCOPY
+    if(!zc_pending.empty())
+	zerocopy_reap(false);
+
+    if(owner
+       && zerocopy_threshold > 0
+       && tmp.back().iov_len >= zerocopy_threshold
+       && zerocopy_enable())
+    {
+	    // only the memory held by owner can be sent without copy, the
+	    // other areas may be reused by the caller as soon as we return
+
+	if(count > 1)
+	    send_vector(&(tmp[0]), count - 1, MSG_MORE);
+	send_vector(&(tmp.back()), 1, MSG_ZEROCOPY);
+	zc_pending.push_back(make_pair(zc_sent, owner));
+    }
+    else
+	send_vector(&(tmp[0]), count, 0);
+#else
+    send_vector(&(tmp[0]), count, 0);
+#endif
+}
+
+void connexion::send_file_impl(const struct iovec *vec, unsigned int count, int fd, off_t offset, size_t size)
+{
+#if HAVE_SYS_SENDFILE_H
+    ssize_t sent;
+
+    if(get_status() != connected)
+        throw WEBDAR_BUG;
+
+    if(count > 0)
+    {
+	vector<struct iovec> tmp(vec, vec + count);
+	send_vector(&(tmp[0]), count, size > 0 ? MSG_MORE : 0);
+    }
+
+    while(size > 0)
+    {
+	sent = sendfile(filedesc, fd, &offset, size);
+	count_write_syscall();
+	if(sent < 0)
+	{
+	    switch(errno)
+	    {
+	    case EINTR:
+		break;
+	    case EAGAIN:
+		(void)wait_socket(POLLOUT, -1);
+		break;
+	    case EINVAL:
+	    case ENOSYS:
+		    // file type not supported by sendfile(), falling back to read/write
+		proto_connexion::send_file_impl(nullptr, 0, fd, offset, size);
+		return;
+	    case EPIPE:
+		fermeture();
+		throw exception_system("Error met while sending data: ", errno);
+	    default:
+		throw exception_system("Error met while sending data: ", errno);
+	    }
+	}
+	else if(sent == 0)
+	    throw exception_range("file to send is shorter than expected");
+	else
+	    size -= sent;
+    }
+#else
+    proto_connexion::send_file_impl(vec, count, fd, offset, size);
+#endif
+}
+
 
 void connexion::fermeture()
 {
     if(get_status() == connected)
     {
+	if(!zc_pending.empty())
+	    zerocopy_reap(true);
+	zc_pending.clear();
+
         int shuted;
         int errnono;
 
@@ -156,3 +313,172 @@ void connexion::fermeture()
             throw exception_system("failed shutting down the socket", errnono);
     }
 }
+
+void connexion::send_vector(struct iovec *vec, unsigned int count, int flags)
+{
+    struct msghdr msg;
+    ssize_t tmp;
+    unsigned int index = 0;
+
+    while(index < count)
+    {
+	(void)memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = vec + index;
+	msg.msg_iovlen = count - index;
+
+	tmp = sendmsg(filedesc, &msg, flags | MSG_NOSIGNAL);
+	count_write_syscall();
+	if(tmp < 0)
+	{
+	    switch(errno)
+	    {
+	    case EPIPE:
+		fermeture();
+		throw exception_system("Error met while sending data: ", errno);
+	    case EINTR:
+		break;
+	    case EAGAIN:
+		(void)wait_socket(POLLOUT, -1);
+		break;
+#ifdef WEBDAR_ZEROCOPY
+	    case ENOBUFS:
+		if((flags & MSG_ZEROCOPY) != 0)
+		{
+			// no more memory to pin pages, sending with copy
+		    flags &= ~MSG_ZEROCOPY;
+		    break;
+		}
+		throw exception_system("Error met while sending data: ", errno);
+#endif
+	    default:
+		throw exception_system("Error met while sending data: ", errno);
+	    }
+	}
+	else
+	{
+#ifdef WEBDAR_ZEROCOPY
+	    if((flags & MSG_ZEROCOPY) != 0)
+		++zc_sent; // each successful zero-copy send gets its own notification
+#endif
+
+		// skipping what has been sent
+
+	    while(tmp > 0 && index < count)
+	    {
+		if((size_t)tmp >= vec[index].iov_len)
+		{
+		    tmp -= vec[index].iov_len;
+		    ++index;
+		}
+		else
+		{
+		    vec[index].iov_base = (char *)(vec[index].iov_base) + tmp;
+		    vec[index].iov_len -= tmp;
+		    tmp = 0;
+		}
+	    }
+	}
+    }
+}
+
+bool connexion::wait_socket(short events, int timeout, bool interruptible)
+{
+#if HAVE_POLL_H
+    struct pollfd pfd;
+    int ret;
+
+    pfd.fd = filedesc;
+    pfd.events = events;
+    pfd.revents = 0;
+
+    do
+    {
+	ret = poll(&pfd, 1, timeout);
+	if(ret < 0 && errno == EINTR && interruptible)
+	    throw exception_signal();
+    }
+    while(ret < 0 && errno == EINTR);
+
+    if(ret < 0)
+	throw exception_system("Error met while waiting on socket: ", errno);
+
+    return ret > 0;
+	// POLLERR and POLLHUP are reported as ready, the following
+	// read or write will report the error condition
+#else
+    throw exception_feature("poll() system call");
+#endif
+}
+
+bool connexion::zerocopy_enable()
+{
+#ifdef WEBDAR_ZEROCOPY
+    if(zc_state == zc_unknown)
+    {
+	int one = 1;
+
+	if(setsockopt(filedesc, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0)
+	    zc_state = zc_enabled;
+	else
+	    zc_state = zc_unavailable;
+    }
+
+    return zc_state == zc_enabled;
+#else
+    return false;
+#endif
+}
+
+void connexion::zerocopy_reap(bool wait)
+{
+#ifdef WEBDAR_ZEROCOPY
+    struct msghdr msg;
+    struct cmsghdr *cm;
+    struct sock_extended_err *serr;
+    char control[128];
+    struct pollfd pfd;
+    ssize_t ret;
+    int waited = 0;
+
+    while(!zc_pending.empty())
+    {
+	(void)memset(&msg, 0, sizeof(msg));
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	ret = recvmsg(filedesc, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+	if(ret < 0)
+	{
+	    if(errno == EINTR)
+		continue;
+	    if(errno != EAGAIN || !wait || waited >= ZEROCOPY_CLOSING_WAIT)
+		break;
+
+		// no notification yet, waiting for one (the error queue is signaled by POLLERR)
+	    pfd.fd = filedesc;
+	    pfd.events = 0;
+	    pfd.revents = 0;
+	    (void)poll(&pfd, 1, 10);
+	    waited += 10;
+	    continue;
+	}
+
+	for(cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm))
+	{
+	    if((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+	       || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+	    {
+		serr = (struct sock_extended_err *)CMSG_DATA(cm);
+		if(serr->ee_errno == 0
+		   && serr->ee_origin == SO_EE_ORIGIN_ZEROCOPY
+		   && serr->ee_data + 1 > zc_done)
+		    zc_done = serr->ee_data + 1;
+		    // ee_info to ee_data is the range of completed sends
+	    }
+	}
+
+	while(!zc_pending.empty() && zc_pending.front().first <= zc_done)
+	    zc_pending.pop_front();
+    }
+#endif
+}
@@ -28,6 +28,8 @@
 
     // C++ system header files
 #include <string>
+#include <deque>
+#include <memory>
 
     // webdar headers
 #include "exceptions.hpp"
@@ -53,6 +55,19 @@ public:
 	/// destructor
     ~connexion();
 
+	/// inherited from proto_connexion
+    virtual int get_socket() const override { return filedesc; };
+
+	/// set the minimal size of a body to be sent without copy (MSG_ZEROCOPY)
+
+	/// \note zero (the default) disables zero-copy sending. This is only
+	/// worth for large bodies (tens of kilobytes and above), as the kernel
+	/// has to notify the completion of each zero-copy send
+    static void set_zerocopy_threshold(unsigned int bytes) { zerocopy_threshold = bytes; };
+
+	/// whether zero-copy sending is supported on this system
+    static bool zerocopy_available();
+
 protected:
 
 	/// inherited from proto_connexion
@@ -61,14 +76,50 @@ protected:
     	/// inherited from proto_connexion
     virtual unsigned int read_impl(char *a, unsigned int size, bool blocking) override;
 
+	/// inherited from proto_connexion
+    virtual void write_vector_impl(const struct iovec *vec,
+				   unsigned int count,
+				   const std::shared_ptr<const std::string> & owner) override;
+
+	/// inherited from proto_connexion
+    virtual void send_file_impl(const struct iovec *vec, unsigned int count, int fd, off_t offset, size_t size) override;
+
+	/// wait for the socket to be ready for the given poll() events
+
+	/// \param[in] events POLLIN and/or POLLOUT
+	/// \param[in] timeout max time to wait in millisecond, -1 for no limit
+	/// \param[in] interruptible if true exception_signal is thrown when a signal is received
+	/// \return false if the timeout expired
+    bool wait_socket(short events, int timeout, bool interruptible = false);
 
 private:
 
+    enum zc_status { zc_unknown, zc_enabled, zc_unavailable };
+
     int filedesc; ///< file descriptor to operate on
+    zc_status zc_state;      ///< whether SO_ZEROCOPY has been set on the socket
+    unsigned int zc_sent;    ///< number of zero-copy sends done so far
+    unsigned int zc_done;    ///< number of zero-copy sends the kernel notified as completed
+    std::deque<std::pair<unsigned int, std::shared_ptr<const std::string> > > zc_pending; ///< memory to keep until the given send is completed
+
+    static unsigned int zerocopy_threshold; ///< minimal body size to use zero-copy
 
 	/// close the connexion
     void fermeture();
 
+	/// send all the data referred by vec with the given sendmsg() flags
+
+	/// \note vec is modified to track partial sends
+    void send_vector(struct iovec *vec, unsigned int count, int flags);
+
+	/// try enabling zero-copy on the socket
+    bool zerocopy_enable();
+
+	/// read the zero-copy completion notifications and release the related memory
+
+	/// \param[in] wait whether to wait (for a bounded time) all pending sends to complete
+    void zerocopy_reap(bool wait);
+
 };
 
 #endif
@@ -0,0 +1,481 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+
+}
+
+    // C++ system header files
+#include <chrono>
+#include <thread>
+
+    // webdar headers
+#include "exceptions.hpp"
+#include "webdar_tools.hpp"
+#include "static_object_library.hpp"
+#include "tokens.hpp"
+#include "metrics.hpp"
+#include "progress_feed.hpp"
+
+    //
+#include "conversation.hpp"
+
+    // period at which progress feeds are polled (milliseconds)
+#define FEED_POLL_PERIOD 500
+    // max time without sending anything to a progress feed stream (seconds)
+#define FEED_HEARTBEAT 15
+    // max duration of a progress feed stream before asking the page to reload (seconds)
+#define FEED_MAX_DURATION 600
+
+using namespace std;
+
+static string get_session_ID_from(const request & req);
+
+bool conversation::default_basic_auth = true;
+
+conversation::conversation(const shared_ptr<central_report> & log,
+			   const shared_ptr<const authentication> & auth,
+			   unique_ptr<proto_connexion> & source):
+    src(source, log),
+    rep(log),
+    sess(nullptr),
+    chal(auth),
+    initial(true),
+    ignore_auth(default_basic_auth? no_ignore: ignore_auth_steady)
+{
+    if(!log)
+	throw WEBDAR_BUG;
+}
+
+conversation::~conversation()
+{
+    try
+    {
+	release_session();
+    }
+    catch(...)
+    {
+	    // ignore exceptions in destructor
+    }
+}
+
+void conversation::answer_next_request()
+{
+    answer ans;
+    string session_ID;
+    session::session_summary info;
+    string user;
+    metrics::kind kind = metrics::kind_other;
+    chrono::steady_clock::time_point start, received, ready, sent;
+    chrono::steady_clock::duration acquiring = chrono::steady_clock::duration::zero();
+    bool streamed = false;
+
+    try
+    {
+	src.wait_for_request(); // pending for the next request to come
+	start = chrono::steady_clock::now();
+	const request & req = src.get_request();
+	received = chrono::steady_clock::now();
+
+	    // extract session info if any
+	session_ID = get_session_ID_from(req);
+
+	if(session_ID == METRICS_PATH_ID)
+	{
+	    kind = metrics::kind_metrics;
+	    if(chal.is_an_authoritative_request(req, user))
+		ans = metrics::give_answer();
+	    else
+		ans = chal.give_answer(req);
+	}
+	else if(session_ID == FEED_PATH_ID)
+	{
+	    kind = metrics::kind_feed;
+	    if(chal.is_an_authoritative_request(req, user))
+		streamed = stream_progress_feed(req, user, ans);
+	    else
+		ans = chal.give_answer(req);
+	}
+	else if(session_ID == STATUS_PATH_ID)
+	{
+		// read-only, served without acquiring the session which
+		// may be held meanwhile by a request rendering a page
+	    kind = metrics::kind_status;
+	    if(chal.is_an_authoritative_request(req, user))
+		ans = give_progress_status(req, user);
+	    else
+		ans = chal.give_answer(req);
+	}
+	else if(session_ID == STATIC_PATH_ID)
+	{
+	    kind = metrics::kind_static;
+	    try
+	    {
+		const static_object *obj = nullptr;
+		chemin tmp = req.get_uri().get_path();
+
+		string objname = tmp.back();
+		tmp.pop_back();
+		if(tmp.front() != STATIC_PATH_ID)
+		    throw WEBDAR_BUG;
+		    // either /st/<objname> or /st/<version>/<objname>
+		if(tmp.size() != 1 && tmp.size() != 2)
+		    throw exception_range("local exception to trigger an answer with STATUS_CODE_NOT_FOUND");
+		obj = static_object_library::find_object(objname);
+		if(obj == nullptr)
+		    throw WEBDAR_BUG;
+
+		    // an outdated version in the URL is served but not as immutable
+		tmp.pop_front();
+		ans = obj->give_answer(req, tmp.size() == 1 && tmp.front() == obj->get_version());
+	    }
+	    catch(exception_range & e)
+	    {
+		ans.set_reason("unknown static object");
+		ans.set_status(STATUS_CODE_NOT_FOUND);
+	    }
+	}
+	else // not a path to a static object
+	{
+		// show the disconnected page with uri cleaned from session info
+	    if(ignore_auth == ignore_auth_redir)
+	    {
+		ignore_auth = ignore_auth_steady;
+		disconned.set_redirect(false);
+		ans = disconned.give_answer(req);
+	    }
+		// check whether the session is authenticated
+	    else if(!chal.is_an_authoritative_request(req, user)
+		    || ignore_auth == ignore_auth_steady)
+	    {
+		    // ask for user authentication
+		kind = metrics::kind_challenge;
+		ans = chal.give_answer(req);
+		ignore_auth = no_ignore;
+	    }
+	    else // session authenticated for user "user"
+	    {
+		chooser.set_owner(user);
+
+		if(!session::get_session_info(session_ID, info)
+		   || info.locked
+		   || info.owner != user)
+		{
+			// session in URL is not valid for that user
+
+			// try creating a first session if just connected
+			// and no other session was created so far for that
+			// user, then go to that session (refresh in the provided answer)
+		    if(!initial
+		       || !session::create_new_session(user,
+						       true,
+						       req,
+						       ans))
+
+		    {
+			    // else display the list of available sessions for that user
+
+			initial = false;
+			kind = metrics::kind_choose;
+			ans = chooser.give_answer(req);
+			if(chooser.disconnection_requested() && !default_basic_auth)
+			{
+			    ignore_auth = ignore_auth_redir;
+			    disconned.set_redirect(true);
+			    ans = disconned.give_answer(req);
+			}
+		    }
+		}
+		else // this is a valid session for that user
+		{
+		    if(sess != nullptr && sess->get_session_ID() != session_ID)
+			release_session();
+			// the request targets another session than the one we hold
+
+		    kind = metrics::kind_session;
+		    if(sess == nullptr)
+		    {
+			chrono::steady_clock::time_point before = chrono::steady_clock::now();
+
+			sess = session::acquire_session(session_ID);
+			acquiring = chrono::steady_clock::now() - before;
+			if(sess == nullptr)
+			    throw WEBDAR_BUG;
+		    }
+			// obtaining the answer from the session object
+		    ans = sess->give_answer(req);
+		    if(sess->disconnection_requested() && !default_basic_auth)
+		    {
+			ignore_auth = ignore_auth_redir;
+			disconned.set_redirect(true);
+			ans = disconned.give_answer(req);
+		    }
+		}
+	    }
+	}
+
+	metrics::record(kind, metrics::phase_read, received - start);
+
+	    // send back the anwser (the duration of a streamed answer is not a processing time)
+	if(!streamed)
+	{
+	    ready = chrono::steady_clock::now();
+	    src.send_answer(ans);
+	    sent = chrono::steady_clock::now();
+
+	    if(kind == metrics::kind_session)
+		metrics::record(kind, metrics::phase_acquire, acquiring);
+	    metrics::record(kind, metrics::phase_render, ready - received - acquiring);
+	    metrics::record(kind, metrics::phase_write, sent - ready);
+	}
+    }
+    catch(exception_signal & e)
+    {
+	    // we have been interrupted, most probably to be cancelled:
+	    // the request may have been partially read, thus the
+	    // connection cannot be used any further
+	close();
+    }
+    catch(exception_input & e)
+    {
+	    // nothing to do
+    }
+}
+
+bool conversation::next_request_for_same_session()
+{
+    uri url;
+
+    return sess != nullptr
+	&& src.get_status() == proto_connexion::connected
+	&& src.get_next_request_uri(url)
+	&& webdar_tools_get_session_ID_from_URI(url) == sess->get_session_ID();
+}
+
+bool conversation::next_request_available()
+{
+    uri url;
+
+    return src.get_status() == proto_connexion::connected
+	&& src.get_next_request_uri(url);
+}
+
+bool conversation::stream_progress_feed(const request & req, const string & user, answer & ans)
+{
+    chemin path = req.get_uri().get_path();
+    shared_ptr<progress_feed> feed;
+    progress_feed::cursor cur;
+    string events;
+    bool more = true;
+    chrono::steady_clock::time_point started;
+    chrono::steady_clock::time_point last_sent;
+
+	// the path is /<FEED_PATH_ID>/<feed id>/<sequence number of the last message displayed>
+
+    if(path.size() == 3)
+    {
+	path.pop_front();
+	feed = progress_feed::find(path.front());
+	path.pop_front();
+	try
+	{
+	    cur.msg_seq = webdar_tools_convert_to_int(path.front());
+	}
+	catch(exception_range & e)
+	{
+	    feed.reset();
+	}
+    }
+
+    if(feed && !is_feed_owner(*feed, user))
+	feed.reset(); // not telling another user the feed exists
+
+    if(!feed)
+    {
+	ans.set_status(STATUS_CODE_NOT_FOUND);
+	ans.set_reason("unknown progress feed");
+	return false;
+    }
+
+	// a stream holds a server thread, only a few of them may run at a time,
+	// the page reloads on error and then polls the status snapshot instead
+    if(!progress_feed::acquire_stream())
+    {
+	ans.set_status(STATUS_CODE_SERVICE_UNAVAILABLE);
+	ans.set_reason("too many progress streams");
+	return false;
+    }
+
+    try
+    {
+	    // the stream lasts as long as libdar runs, the session
+	    // must stay available to the other connections meanwhile
+	release_session();
+
+	ans.set_status(STATUS_CODE_OK);
+	ans.set_reason("ok");
+	ans.set_attribute(http_token::hdr_content_type, "text/event-stream");
+	ans.set_attribute(http_token::hdr_cache_control, "no-cache");
+	src.send_answer_header(ans);
+
+	started = last_sent = chrono::steady_clock::now();
+	while(more)
+	{
+	    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+	    more = feed->next_events(cur, events);
+	    if(more && now - started > chrono::seconds(FEED_MAX_DURATION))
+	    {
+		    // a new page gets a new stream, this bounds the
+		    // time a server thread is held by a forgotten page
+		events += progress_feed::event("reload", "");
+		more = false;
+	    }
+
+	    if(events.empty() && now - last_sent > chrono::seconds(FEED_HEARTBEAT))
+		events = ":\n\n"; // comment line, lets us detect a peer that has gone
+
+	    if(!events.empty())
+	    {
+		src.send_body_piece(events);
+		last_sent = now;
+	    }
+
+	    if(more)
+	    {
+		if(src.streaming_interrupted())
+		    more = false;
+		else
+		    this_thread::sleep_for(chrono::milliseconds(FEED_POLL_PERIOD));
+	    }
+	}
+
+	src.end_of_body();
+    }
+    catch(...)
+    {
+	progress_feed::release_stream();
+	throw;
+    }
+    progress_feed::release_stream();
+
+    return true;
+}
+
+answer conversation::give_progress_status(const request & req, const string & user)
+{
+    answer ret;
+    chemin path = req.get_uri().get_path();
+    shared_ptr<progress_feed> feed;
+    unsigned int msg_seq = 0;
+
+	// the path is /<STATUS_PATH_ID>/<feed id>/<sequence number of the last message displayed>
+
+    if(path.size() == 3)
+    {
+	path.pop_front();
+	feed = progress_feed::find(path.front());
+	path.pop_front();
+	try
+	{
+	    msg_seq = webdar_tools_convert_to_int(path.front());
+	}
+	catch(exception_range & e)
+	{
+	    feed.reset();
+	}
+    }
+
+    if(feed && !is_feed_owner(*feed, user))
+	feed.reset();
+
+    if(!feed)
+    {
+	ret.set_status(STATUS_CODE_NOT_FOUND);
+	ret.set_reason("unknown progress feed");
+	return ret;
+    }
+
+    ret.set_status(STATUS_CODE_OK);
+    ret.set_reason("ok");
+    ret.set_attribute(http_token::hdr_content_type, "application/json");
+    ret.set_attribute(http_token::hdr_cache_control, "no-store");
+    ret.add_body(feed->status(msg_seq));
+
+    return ret;
+}
+
+bool conversation::is_feed_owner(const progress_feed & feed, const string & user)
+{
+    session::session_summary info;
+    string sessid = feed.get_session_ID();
+
+    return !sessid.empty()
+	&& session::get_session_info(sessid, info)
+	&& info.owner == user;
+}
+
+void conversation::release_session()
+{
+    if(sess != nullptr)
+    {
+	session *tmp = sess;
+
+	sess = nullptr;
+	session::release_session(tmp);
+    }
+}
+
+void conversation::close()
+{
+    try
+    {
+	release_session();
+    }
+    catch(...)
+    {
+	src.close();
+	throw;
+    }
+    src.close();
+}
+
+void conversation::reset(const shared_ptr<const authentication> & auth,
+			 unique_ptr<proto_connexion> & source)
+{
+    release_session();
+    chal.set_base(auth);
+    src.reset(source);
+    chooser.clear();
+    disconned.set_redirect(false);
+    initial = true;
+    ignore_auth = default_basic_auth ? no_ignore : ignore_auth_steady;
+}
+
+static string get_session_ID_from(const request & req)
+{
+    return webdar_tools_get_session_ID_from_URI(req.get_uri());
+}
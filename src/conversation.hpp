@@ -0,0 +1,159 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef CONVERSATION_HPP
+#define CONVERSATION_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+
+}
+
+    // C++ system header files
+#include <memory>
+
+    // webdar headers
+#include "parser.hpp"
+#include "central_report.hpp"
+#include "session.hpp"
+#include "authentication.hpp"
+#include "challenge.hpp"
+#include "choose.hpp"
+#include "disconnected_page.hpp"
+#include "progress_feed.hpp"
+
+    /// class conversation holds the state of an HTTP connection between two requests
+
+    /// a conversation object owns the connection to the browser (through a parser object)
+    /// and the per-connection components (challenge, choose and disconnected pages, authentication
+    /// status) that were formerly local to the server thread. This way a connection can be
+    /// handled by a thread during a whole TCP session (class server) or be parked between requests
+    /// and handled by any thread of a pool when a new request comes (class reactor).
+    /// \note a conversation object is not thread-safe, it must be used by a single thread at a time,
+    /// and the session acquired by a thread must be released by this same thread (release_session())
+    /// before the conversation object is handed to another thread.
+
+class conversation
+{
+public:
+    conversation(const std::shared_ptr<central_report> & log,
+		 const std::shared_ptr<const authentication> & auth,
+		 std::unique_ptr<proto_connexion> & source);
+    conversation(const conversation & ref) = delete;
+    conversation(conversation && ref) noexcept = delete;
+    conversation & operator = (const conversation & ref) = delete;
+    conversation & operator = (conversation && ref) noexcept = delete;
+    ~conversation();
+
+	/// provides visibility on the connection status
+    proto_connexion::status get_status() const { return src.get_status(); };
+
+	/// provides the file descriptor of the underlying socket
+    int get_socket() const { return src.get_socket(); };
+
+	/// whether data has already been received for a next request
+    bool has_pending_data() const { return src.has_pending_data(); };
+
+	/// whether a whole request header has been received (non blocking call)
+    bool request_header_available() { return src.request_header_available(); };
+
+	/// read the next request and send back the answer
+
+	/// \note the call is blocking until a request has been received. The session
+	/// the request is addressed to is acquired if not already done, and kept acquired
+	/// when this call returns.
+	/// \note exception_range is propagated when the connection is closed
+    void answer_next_request();
+
+	/// whether the next request is already available and addresses the session we currently hold (non blocking call)
+    bool next_request_for_same_session();
+
+	/// whether the next request is already available (non blocking call)
+    bool next_request_available();
+
+	/// release the session acquired by answer_next_request() if any
+    void release_session();
+
+	/// release the session if any and close the connection
+    void close();
+
+	/// start over with a new connection
+
+	/// \param[in] auth the authentication base to use for the new connection
+	/// \param[in] source the new connection, same responsibility transfer as with the constructor
+	/// \note the session if any is released, the per-connection components (challenge,
+	/// disconnected and session selection pages) are kept and reused as if they had just been
+	/// created, which saves their construction when a server thread handles many connections
+    void reset(const std::shared_ptr<const authentication> & auth,
+	       std::unique_ptr<proto_connexion> & source);
+
+	/// wether to emulate user logout while using basic authentication (see also class html_disconnect)
+    static void force_disconnection_at_end_of_session(bool val) { default_basic_auth = ! val; };
+
+private:
+
+    enum auth_consideration
+    {
+	ignore_auth_redir,  ///< user has just disconnected and will be redirected to steady page
+	ignore_auth_steady, ///< user has to be redirected to the steady page
+	no_ignore           ///< user has authenticated and can access webdar
+    };
+
+    parser src;                          ///< this object manages the given proto_connexion in constructor
+    std::shared_ptr<central_report> rep; ///< where do logs should go
+    session* sess;                       ///< the current session we use (we have acquired its mutex)
+    challenge chal;                      ///< authentication dialog
+    disconnected_page disconned;         ///< page shown when the user has disconnected
+    choose chooser;                      ///< session selection page
+    bool initial;                        ///< true until the first session selection page has been sent
+    auth_consideration ignore_auth;      ///< how to consider authentication info in request
+
+    static bool default_basic_auth;      ///< if true, no disconnection is provided (unless browser is restarted)
+
+	/// stream the events of the progress feed the request addresses
+
+	/// \param[in] req the request which path targets a progress_feed
+	/// \param[in] user the authenticated user, which must own the session of the feed
+	/// \param[out] ans the answer to send if the stream could not be started
+	/// \return true if the answer has been streamed, false if ans has to be sent
+	/// \note the session held if any is released before streaming
+    bool stream_progress_feed(const request & req, const std::string & user, answer & ans);
+
+	/// provide the JSON progression snapshot the request addresses
+
+	/// \param[in] req the request which path targets a progress_feed
+	/// \param[in] user the authenticated user, which must own the session of the feed
+	/// \return the answer holding the snapshot, or a "not found" answer
+	/// \note the session is not involved, this request is never delayed by another
+	/// request the session is answering
+    static answer give_progress_status(const request & req, const std::string & user);
+
+	/// whether the feed belongs to a session owned by the given user
+    static bool is_feed_owner(const progress_feed & feed, const std::string & user);
+
+};
+
+#endif
@@ -0,0 +1,85 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#if HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+}
+
+    // C++ system header files
+
+
+    // webdar headers
+#include "exceptions.hpp"
+
+    //
+#include "file_body.hpp"
+
+using namespace std;
+
+file_body::file_body(const string & filename)
+{
+    struct stat info;
+
+    fd = open(filename.c_str(), O_RDONLY|O_CLOEXEC);
+    if(fd < 0)
+	throw exception_system(string("Cannot open file ") + filename + ": ", errno);
+
+    if(fstat(fd, &info) < 0)
+    {
+	int tmp = errno;
+
+	close(fd);
+	throw exception_system(string("Cannot get size of file ") + filename + ": ", tmp);
+    }
+
+    if(!S_ISREG(info.st_mode))
+    {
+	close(fd);
+	throw exception_range(string("Not a plain file: ") + filename);
+    }
+
+    size = info.st_size;
+}
+
+file_body::~file_body()
+{
+    if(fd >= 0)
+	close(fd);
+}
@@ -0,0 +1,74 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef FILE_BODY_HPP
+#define FILE_BODY_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+#if HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+}
+
+    // C++ system header files
+#include <string>
+
+    // webdar headers
+
+    /// an opened file used as body of an answer
+
+    /// \note the file is opened read-only at construction time and closed
+    /// by the destructor. Objects of this class are shared between answer
+    /// copies thanks to std::shared_ptr, which lets the body be sent from the
+    /// file (using sendfile()) without loading it in memory.
+
+class file_body
+{
+public:
+	/// open the given file, throw exception_system if it cannot be opened
+    file_body(const std::string & filename);
+
+    file_body(const file_body & ref) = delete;
+    file_body(file_body && ref) noexcept = delete;
+    file_body & operator = (const file_body & ref) = delete;
+    file_body & operator = (file_body && ref) noexcept = delete;
+
+	/// close the file
+    ~file_body();
+
+	/// the file descriptor to read from (do not close it)
+    int get_fd() const { return fd; };
+
+	/// the size of the file at the time it was opened
+    off_t get_size() const { return size; };
+
+private:
+    int fd;
+    off_t size;
+};
+
+#endif
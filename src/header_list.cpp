@@ -0,0 +1,287 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_CTYPE_H
+#include <ctype.h>
+#endif
+}
+
+    // C++ system header files
+
+
+    // webdar headers
+#include "exceptions.hpp"
+
+    //
+#include "header_list.hpp"
+
+using namespace std;
+
+    // FNV-1a 32 bits parameters
+#define HEADER_HASH_BASIS 2166136261U
+#define HEADER_HASH_PRIME 16777619U
+
+header_list & header_list::operator = (const header_list & ref)
+{
+	// copying field by field rather than the whole vector
+	// let the slots already allocated here be reused
+
+    fold = ref.fold;
+    if(fields.size() < ref.used)
+	fields.resize(ref.used);
+    for(unsigned int i = 0; i < ref.used; ++i)
+    {
+	fields[i].hash = ref.fields[i].hash;
+	fields[i].id = ref.fields[i].id;
+	fields[i].name = ref.fields[i].name;
+	fields[i].value = ref.fields[i].value;
+    }
+    used = ref.used;
+
+    return *this;
+}
+
+const string *header_list::find(const string & name) const
+{
+    unsigned int index = locate(name, hash_of(name.data(), name.size()));
+
+    if(index < used)
+	return & fields[index].value;
+    else
+	return nullptr;
+}
+
+bool header_list::find(const string & name, string & value) const
+{
+    const string *ptr = find(name);
+
+    if(ptr != nullptr)
+    {
+	value = *ptr;
+	return true;
+    }
+    else
+	return false;
+}
+
+const string *header_list::find(http_token::header id) const
+{
+    unsigned int index = locate(id);
+
+    if(index < used)
+	return & fields[index].value;
+    else
+	return nullptr;
+}
+
+bool header_list::find(http_token::header id, string & value) const
+{
+    const string *ptr = find(id);
+
+    if(ptr != nullptr)
+    {
+	value = *ptr;
+	return true;
+    }
+    else
+	return false;
+}
+
+void header_list::set(const string & name, const string & value)
+{
+    uint32_t hash = hash_of(name.data(), name.size());
+    unsigned int index = locate(name, hash);
+
+    if(index < used)
+	fields[index].value = value;
+    else
+	add_slot(name.data(), name.size(), hash, fold ? http_token::header_of(name) : http_token::hdr_unknown).value = value;
+}
+
+void header_list::append(const string & name, const string & separator, const string & value)
+{
+    uint32_t hash = hash_of(name.data(), name.size());
+    unsigned int index = locate(name, hash);
+
+    if(index < used)
+    {
+	fields[index].value += separator;
+	fields[index].value += value;
+    }
+    else
+	add_slot(name.data(), name.size(), hash, fold ? http_token::header_of(name) : http_token::hdr_unknown).value = value;
+}
+
+void header_list::erase(const string & name)
+{
+    erase_at(locate(name, hash_of(name.data(), name.size())));
+}
+
+void header_list::set(http_token::header id, const string & value)
+{
+    unsigned int index = locate(id);
+
+    if(index < used)
+	fields[index].value = value;
+    else
+	add_slot(id).value = value;
+}
+
+void header_list::append(http_token::header id, const string & separator, const string & value)
+{
+    unsigned int index = locate(id);
+
+    if(index < used)
+    {
+	fields[index].value += separator;
+	fields[index].value += value;
+    }
+    else
+	add_slot(id).value = value;
+}
+
+void header_list::erase(http_token::header id)
+{
+    erase_at(locate(id));
+}
+
+uint32_t header_list::hash_of(const char *name, unsigned int len) const
+{
+    uint32_t ret = HEADER_HASH_BASIS;
+
+    for(unsigned int i = 0; i < len; ++i)
+    {
+	unsigned char c = name[i];
+
+	if(fold)
+	    c = tolower(c);
+	ret ^= c;
+	ret *= HEADER_HASH_PRIME;
+    }
+
+    return ret;
+}
+
+unsigned int header_list::locate(const string & name, uint32_t hash) const
+{
+    for(unsigned int i = 0; i < used; ++i)
+    {
+	const field & cur = fields[i];
+
+	if(cur.hash != hash || cur.name.size() != name.size())
+	    continue;
+
+	if(!fold)
+	{
+	    if(cur.name == name)
+		return i;
+	}
+	else
+	{
+	    string::const_iterator ita = cur.name.begin();
+	    string::const_iterator itb = name.begin();
+
+	    while(ita != cur.name.end() && tolower((unsigned char)*ita) == tolower((unsigned char)*itb))
+	    {
+		++ita;
+		++itb;
+	    }
+
+	    if(ita == cur.name.end())
+		return i;
+	}
+    }
+
+    return used;
+}
+
+unsigned int header_list::locate(http_token::header id) const
+{
+    if(!fold || id == http_token::hdr_unknown)
+	throw WEBDAR_BUG;
+
+    for(unsigned int i = 0; i < used; ++i)
+	if(fields[i].id == id)
+	    return i;
+
+    return used;
+}
+
+header_list::field & header_list::add_slot(http_token::header id)
+{
+    const char *name = http_token::header_name(id);
+    unsigned int len = char_traits<char>::length(name);
+
+    return add_slot(name, len, hash_of(name, len), id);
+}
+
+header_list::field & header_list::add_slot(const char *name, unsigned int len, uint32_t hash, http_token::header id)
+{
+    if(used == fields.size())
+	fields.resize(used + 1);
+
+    field & ret = fields[used++];
+
+    ret.hash = hash;
+    ret.name.assign(name, len);
+    ret.id = id;
+
+    if(fold)
+    {
+	    // same transformation as webdar_tools_to_canonical_case()
+	    // but done in place to reuse the memory of the slot
+
+	bool previous_is_alpha = false;
+
+	for(string::iterator it = ret.name.begin(); it != ret.name.end(); ++it)
+	{
+	    if(isalpha(*it))
+	    {
+		*it = previous_is_alpha ? tolower(*it) : toupper(*it);
+		previous_is_alpha = true;
+	    }
+	    else
+		previous_is_alpha = false;
+	}
+    }
+
+    return ret;
+}
+
+void header_list::erase_at(unsigned int index)
+{
+    if(index < used)
+    {
+	    // the slot is moved past the used ones, keeping
+	    // both the order of the remaining fields and the
+	    // memory of the slot for a later field
+
+	for(unsigned int i = index + 1; i < used; ++i)
+	    swap(fields[i - 1], fields[i]);
+	--used;
+    }
+}
@@ -0,0 +1,149 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef HEADER_LIST_HPP
+#define HEADER_LIST_HPP
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_STDINT_H
+#include <stdint.h>
+#endif
+}
+
+    // C++ system header files
+#include <string>
+#include <vector>
+
+    // webdar headers
+#include "http_token.hpp"
+
+    /// flat list of HTTP header fields (or cookies) reused from one request to the next
+
+    /// \note fields are kept in insertion order in a vector along with a hash of their
+    /// name, a lookup compares hashes first and names only when hashes match. Clearing
+    /// the list does not release the strings: the next fields are copied in the already
+    /// allocated slots, so a connection handling a series of similar requests does not
+    /// allocate memory for their headers once the first ones have been received.
+    /// \note with case insensitive names (the default, as used for HTTP header fields)
+    /// names are stored in canonical case (see webdar_tools_to_canonical_case()) and
+    /// known header fields also get their http_token identifier, which lets them be
+    /// looked up by identifier without comparing any string
+
+class header_list
+{
+public:
+	/// constructor
+
+	/// \param[in] case_insensitive whether field names are compared ignoring case
+    header_list(bool case_insensitive = true): fold(case_insensitive), used(0) {};
+    header_list(const header_list & ref) = default;
+    header_list(header_list && ref) noexcept = default;
+    header_list & operator = (const header_list & ref);
+    header_list & operator = (header_list && ref) noexcept = default;
+    ~header_list() = default;
+
+	/// remove all fields, keeping the memory allocated for them
+    void clear() { used = 0; };
+
+	/// number of fields
+    unsigned int size() const { return used; };
+
+	/// whether the list has no field
+    bool empty() const { return used == 0; };
+
+	/// name of the field at the given index (zero based, in insertion order)
+    const std::string & get_name(unsigned int index) const { return fields[index].name; };
+
+	/// value of the field at the given index (zero based, in insertion order)
+    const std::string & get_value(unsigned int index) const { return fields[index].value; };
+
+	/// lookup a field
+
+	/// \return the value of the field or nullptr if not present, the pointer
+	/// is valid until the list is modified
+    const std::string *find(const std::string & name) const;
+
+	/// lookup a field, copying its value
+    bool find(const std::string & name, std::string & value) const;
+
+	/// lookup a known header field (case insensitive lists only)
+    const std::string *find(http_token::header id) const;
+
+	/// lookup a known header field, copying its value (case insensitive lists only)
+    bool find(http_token::header id, std::string & value) const;
+
+	/// set the value of a field, replacing any existing value
+    void set(const std::string & name, const std::string & value);
+
+	/// add a value to a field, separated by the given string from the existing value if any
+    void append(const std::string & name, const std::string & separator, const std::string & value);
+
+	/// remove a field if present
+    void erase(const std::string & name);
+
+	/// set the value of a known header field, replacing any existing value
+    void set(http_token::header id, const std::string & value);
+
+	/// add a value to a known header field
+    void append(http_token::header id, const std::string & separator, const std::string & value);
+
+	/// remove a known header field if present
+    void erase(http_token::header id);
+
+private:
+    struct field
+    {
+	uint32_t hash;      ///< hash of the name, with case folded if fold is set
+	http_token::header id; ///< identifier of the name, hdr_unknown if not known or if fold is not set
+	std::string name;   ///< field name
+	std::string value;  ///< field value
+    };
+
+    bool fold;                  ///< whether names are case insensitive
+    std::vector<field> fields;  ///< slots, only the first "used" ones hold a field
+    unsigned int used;          ///< number of fields in the list
+
+	/// hash of a field name
+    uint32_t hash_of(const char *name, unsigned int len) const;
+
+	/// index of the field or used if not present
+    unsigned int locate(const std::string & name, uint32_t hash) const;
+
+	/// index of the known header field or used if not present
+    unsigned int locate(http_token::header id) const;
+
+	/// take a new slot at the end of the list and record the name in it
+    field & add_slot(const char *name, unsigned int len, uint32_t hash, http_token::header id);
+
+	/// take a new slot for a known header field
+    field & add_slot(http_token::header id);
+
+	/// remove the field at the given index
+    void erase_at(unsigned int index);
+
+};
+
+#endif
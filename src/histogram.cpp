@@ -0,0 +1,97 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_STDIO_H
+#include <stdio.h>
+#endif
+}
+
+    // C++ system header files
+
+
+    // webdar headers
+#include "webdar_tools.hpp"
+
+    //
+#include "histogram.hpp"
+
+using namespace std;
+
+const uint64_t histogram::bounds[num_bounds] =
+{
+    50, 100, 250, 500,
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 5000000, 10000000
+};
+
+histogram::histogram():
+    sum(0)
+{
+    for(unsigned int i = 0; i <= num_bounds; ++i)
+	buckets[i].store(0, memory_order_relaxed);
+}
+
+void histogram::record(uint64_t microseconds)
+{
+    unsigned int i = 0;
+
+    while(i < num_bounds && microseconds > bounds[i])
+	++i;
+
+    buckets[i].fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(microseconds, memory_order_relaxed);
+}
+
+void histogram::render(string & output, const string & name, const string & labels) const
+{
+    uint64_t cumul = 0;
+    string sep = labels.empty() ? "" : ",";
+    string lab = labels.empty() ? "" : "{" + labels + "}";
+    char val[30];
+
+	// counters are read one by one while other threads may update
+	// them, the count is derived from the buckets for the output to
+	// stay consistent, the sum may be slightly ahead
+
+    for(unsigned int i = 0; i <= num_bounds; ++i)
+    {
+	cumul += buckets[i].load(memory_order_relaxed);
+	output += name + "_bucket{" + labels + sep + "le=\"";
+	if(i < num_bounds)
+	{
+	    (void)snprintf(val, sizeof(val), "%g", (double)(bounds[i]) / 1000000.0);
+	    output += val;
+	}
+	else
+	    output += "+Inf";
+	output += "\"} " + webdar_tools_convert_to_string(cumul) + "\n";
+    }
+
+    (void)snprintf(val, sizeof(val), "%.6f", (double)(sum.load(memory_order_relaxed)) / 1000000.0);
+    output += name + "_sum" + lab + " " + val + "\n";
+    output += name + "_count" + lab + " " + webdar_tools_convert_to_string(cumul) + "\n";
+}
@@ -0,0 +1,79 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+#if HAVE_STDINT_H
+#include <stdint.h>
+#endif
+}
+
+    // C++ system header files
+#include <atomic>
+#include <string>
+
+    // webdar headers
+
+    /// lock-free histogram of durations
+
+    /// \note record() can be called concurrently by any number of threads
+    /// without lock, each bucket being an atomic counter. The bucket bounds
+    /// are fixed and spread on a logarithmic scale from 50 microseconds
+    /// to 10 seconds.
+
+class histogram
+{
+public:
+    histogram();
+    histogram(const histogram & ref) = delete;
+    histogram(histogram && ref) noexcept = delete;
+    histogram & operator = (const histogram & ref) = delete;
+    histogram & operator = (histogram && ref) noexcept = delete;
+    ~histogram() = default;
+
+	/// add a duration expressed in microseconds
+    void record(uint64_t microseconds);
+
+	/// append the histogram in Prometheus text format to output
+
+	/// \param[in,out] output where to add the bucket, sum and count lines
+	/// \param[in] name the metric name
+	/// \param[in] labels the labels to add to each line (without braces), may be empty
+    void render(std::string & output, const std::string & name, const std::string & labels) const;
+
+private:
+    static constexpr const unsigned int num_bounds = 17;
+    static const uint64_t bounds[num_bounds]; ///< upper bounds of the buckets in microseconds
+
+    std::atomic<uint64_t> buckets[num_bounds + 1]; ///< non cumulative counters, the last one for values above all bounds
+    std::atomic<uint64_t> sum;                     ///< sum of the recorded durations in microseconds
+
+};
+
+#endif
@@ -0,0 +1,596 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+
+}
+
+    // C++ system header files
+
+
+    // webdar headers
+#include "tokens.hpp"
+
+    //
+#include "hpack.hpp"
+
+using namespace std;
+
+    /// default (and max we accept) size of the dynamic tables (SETTINGS_HEADER_TABLE_SIZE)
+#define HPACK_TABLE_SIZE 4096
+
+    /// overhead counted for each entry of a dynamic table (RFC 7541 paragraph 4.1)
+#define HPACK_ENTRY_OVERHEAD 32
+
+    /// the static table (RFC 7541 appendix A), index 1 is the first entry
+static const struct
+{
+    const char *name;
+    const char *value;
+} static_table[] =
+{
+    { ":authority", "" },
+    { ":method", "GET" },
+    { ":method", "POST" },
+    { ":path", "/" },
+    { ":path", "/index.html" },
+    { ":scheme", "http" },
+    { ":scheme", "https" },
+    { ":status", "200" },
+    { ":status", "204" },
+    { ":status", "206" },
+    { ":status", "304" },
+    { ":status", "400" },
+    { ":status", "404" },
+    { ":status", "500" },
+    { "accept-charset", "" },
+    { "accept-encoding", "gzip, deflate" },
+    { "accept-language", "" },
+    { "accept-ranges", "" },
+    { "accept", "" },
+    { "access-control-allow-origin", "" },
+    { "age", "" },
+    { "allow", "" },
+    { "authorization", "" },
+    { "cache-control", "" },
+    { "content-disposition", "" },
+    { "content-encoding", "" },
+    { "content-language", "" },
+    { "content-length", "" },
+    { "content-location", "" },
+    { "content-range", "" },
+    { "content-type", "" },
+    { "cookie", "" },
+    { "date", "" },
+    { "etag", "" },
+    { "expect", "" },
+    { "expires", "" },
+    { "from", "" },
+    { "host", "" },
+    { "if-match", "" },
+    { "if-modified-since", "" },
+    { "if-none-match", "" },
+    { "if-range", "" },
+    { "if-unmodified-since", "" },
+    { "last-modified", "" },
+    { "link", "" },
+    { "location", "" },
+    { "max-forwards", "" },
+    { "proxy-authenticate", "" },
+    { "proxy-authorization", "" },
+    { "range", "" },
+    { "referer", "" },
+    { "refresh", "" },
+    { "retry-after", "" },
+    { "server", "" },
+    { "set-cookie", "" },
+    { "strict-transport-security", "" },
+    { "transfer-encoding", "" },
+    { "user-agent", "" },
+    { "vary", "" },
+    { "via", "" },
+    { "www-authenticate", "" }
+};
+
+static const uint32_t static_table_size = sizeof(static_table) / sizeof(static_table[0]);
+
+    /// Huffman code of each byte value, MSB aligned on bit 0 (RFC 7541 appendix B)
+static const uint32_t huffman_code[256] =
+{
+    0x1ff8, 0x7fffd8, 0xfffffe2, 0xfffffe3, 0xfffffe4, 0xfffffe5, 0xfffffe6, 0xfffffe7,
+    0xfffffe8, 0xffffea, 0x3ffffffc, 0xfffffe9, 0xfffffea, 0x3ffffffd, 0xfffffeb, 0xfffffec,
+    0xfffffed, 0xfffffee, 0xfffffef, 0xffffff0, 0xffffff1, 0xffffff2, 0x3ffffffe, 0xffffff3,
+    0xffffff4, 0xffffff5, 0xffffff6, 0xffffff7, 0xffffff8, 0xffffff9, 0xffffffa, 0xffffffb,
+    0x14, 0x3f8, 0x3f9, 0xffa, 0x1ff9, 0x15, 0xf8, 0x7fa,
+    0x3fa, 0x3fb, 0xf9, 0x7fb, 0xfa, 0x16, 0x17, 0x18,
+    0x0, 0x1, 0x2, 0x19, 0x1a, 0x1b, 0x1c, 0x1d,
+    0x1e, 0x1f, 0x5c, 0xfb, 0x7ffc, 0x20, 0xffb, 0x3fc,
+    0x1ffa, 0x21, 0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62,
+    0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
+    0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72,
+    0xfc, 0x73, 0xfd, 0x1ffb, 0x7fff0, 0x1ffc, 0x3ffc, 0x22,
+    0x7ffd, 0x3, 0x23, 0x4, 0x24, 0x5, 0x25, 0x26,
+    0x27, 0x6, 0x74, 0x75, 0x28, 0x29, 0x2a, 0x7,
+    0x2b, 0x76, 0x2c, 0x8, 0x9, 0x2d, 0x77, 0x78,
+    0x79, 0x7a, 0x7b, 0x7ffe, 0x7fc, 0x3ffd, 0x1ffd, 0xffffffc,
+    0xfffe6, 0x3fffd2, 0xfffe7, 0xfffe8, 0x3fffd3, 0x3fffd4, 0x3fffd5, 0x7fffd9,
+    0x3fffd6, 0x7fffda, 0x7fffdb, 0x7fffdc, 0x7fffdd, 0x7fffde, 0xffffeb, 0x7fffdf,
+    0xffffec, 0xffffed, 0x3fffd7, 0x7fffe0, 0xffffee, 0x7fffe1, 0x7fffe2, 0x7fffe3,
+    0x7fffe4, 0x1fffdc, 0x3fffd8, 0x7fffe5, 0x3fffd9, 0x7fffe6, 0x7fffe7, 0xffffef,
+    0x3fffda, 0x1fffdd, 0xfffe9, 0x3fffdb, 0x3fffdc, 0x7fffe8, 0x7fffe9, 0x1fffde,
+    0x7fffea, 0x3fffdd, 0x3fffde, 0xfffff0, 0x1fffdf, 0x3fffdf, 0x7fffeb, 0x7fffec,
+    0x1fffe0, 0x1fffe1, 0x3fffe0, 0x1fffe2, 0x7fffed, 0x3fffe1, 0x7fffee, 0x7fffef,
+    0xfffea, 0x3fffe2, 0x3fffe3, 0x3fffe4, 0x7ffff0, 0x3fffe5, 0x3fffe6, 0x7ffff1,
+    0x3ffffe0, 0x3ffffe1, 0xfffeb, 0x7fff1, 0x3fffe7, 0x7ffff2, 0x3fffe8, 0x1ffffec,
+    0x3ffffe2, 0x3ffffe3, 0x3ffffe4, 0x7ffffde, 0x7ffffdf, 0x3ffffe5, 0xfffff1, 0x1ffffed,
+    0x7fff2, 0x1fffe3, 0x3ffffe6, 0x7ffffe0, 0x7ffffe1, 0x3ffffe7, 0x7ffffe2, 0xfffff2,
+    0x1fffe4, 0x1fffe5, 0x3ffffe8, 0x3ffffe9, 0xffffffd, 0x7ffffe3, 0x7ffffe4, 0x7ffffe5,
+    0xfffec, 0xfffff3, 0xfffed, 0x1fffe6, 0x3fffe9, 0x1fffe7, 0x1fffe8, 0x7ffff3,
+    0x3fffea, 0x3fffeb, 0x1ffffee, 0x1ffffef, 0xfffff4, 0xfffff5, 0x3ffffea, 0x7ffff4,
+    0x3ffffeb, 0x7ffffe6, 0x3ffffec, 0x3ffffed, 0x7ffffe7, 0x7ffffe8, 0x7ffffe9, 0x7ffffea,
+    0x7ffffeb, 0xffffffe, 0x7ffffec, 0x7ffffed, 0x7ffffee, 0x7ffffef, 0x7fffff0, 0x3ffffee
+};
+
+static const unsigned char huffman_length[256] =
+{
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26
+};
+
+    /// node of the Huffman decoding tree
+struct huffman_node
+{
+    int16_t child[2]; ///< index of the next node for bit 0 and bit 1, -1 if none
+    int16_t symbol;   ///< the decoded byte if this is a leaf, else -1
+};
+
+static vector<huffman_node> build_huffman_tree();
+static const vector<huffman_node> & huffman_tree();
+
+hpack::hpack():
+    decoder_table(HPACK_TABLE_SIZE),
+    encoder_table(HPACK_TABLE_SIZE),
+    encoder_update(false)
+{
+}
+
+void hpack::decode(const string & block,
+		   vector<field> & fields,
+		   uint64_t max_list_size,
+		   uint32_t max_count)
+{
+    string::size_type pos = 0;
+    uint64_t list_size = 0;
+
+    fields.clear();
+
+    while(pos < block.size())
+    {
+	unsigned char first = block[pos];
+
+	if(max_count > 0 && fields.size() >= max_count && (first & 0xE0) != 0x20)
+	    throw exception_input("Too many header fields in HPACK header block", STATUS_CODE_REQUEST_HEADER_FIELDS_TOO_LARGE);
+
+	if((first & 0x80) != 0) // indexed header field
+	{
+	    field f = lookup(decode_integer(block, pos, 7));
+
+	    check_list_size(f, list_size, max_list_size);
+	    fields.push_back(f);
+	}
+	else if((first & 0xE0) == 0x20) // dynamic table size update
+	{
+	    uint64_t max;
+
+	    if(!fields.empty())
+		throw exception_range("HPACK dynamic table size update not at the beginning of a header block");
+	    max = decode_integer(block, pos, 5);
+	    if(max > HPACK_TABLE_SIZE)
+		throw exception_range("HPACK dynamic table size update above the allowed size");
+	    decoder_table.resize(max);
+	}
+	else // literal header field, with or without indexing
+	{
+	    bool indexing = (first & 0xC0) == 0x40;
+	    uint64_t index = decode_integer(block, pos, indexing ? 6 : 4);
+	    field f;
+
+	    if(index > 0)
+		f.first = lookup(index).first;
+	    else
+		decode_string(block, pos, f.first);
+	    decode_string(block, pos, f.second);
+	    check_list_size(f, list_size, max_list_size);
+	    if(indexing)
+		decoder_table.add(f);
+	    fields.push_back(f);
+	}
+    }
+}
+
+void hpack::encode(const vector<field> & fields, string & block)
+{
+    if(encoder_update)
+    {
+	encode_integer(encoder_table.get_max_size(), 5, 0x20, block);
+	encoder_update = false;
+    }
+
+    for(vector<field>::const_iterator it = fields.begin(); it != fields.end(); ++it)
+    {
+	uint32_t name_index = 0;
+	uint32_t index;
+	uint32_t dyn_name;
+	bool dyn_name_found = false;
+	bool found = false;
+
+	for(uint32_t i = 0; i < static_table_size && !found; ++i)
+	{
+	    if(it->first == static_table[i].name)
+	    {
+		if(name_index == 0)
+		    name_index = i + 1;
+		if(it->second == static_table[i].value)
+		{
+		    add_indexed(i + 1, block);
+		    found = true;
+		}
+	    }
+	}
+	if(found)
+	    continue;
+
+	if(encoder_table.find(*it, index, dyn_name, dyn_name_found))
+	{
+	    add_indexed(static_table_size + 1 + index, block);
+	    continue;
+	}
+
+	if(name_index == 0 && dyn_name_found)
+	    name_index = static_table_size + 1 + dyn_name;
+
+	if(it->first == "set-cookie")
+	    encode_integer(name_index, 4, 0x10, block); // never indexed
+	else if(worth_indexing(it->first))
+	    encode_integer(name_index, 6, 0x40, block); // with incremental indexing
+	else
+	    encode_integer(name_index, 4, 0x00, block); // without indexing
+
+	if(name_index == 0)
+	    encode_string(it->first, block);
+	encode_string(it->second, block);
+
+	if(it->first != "set-cookie" && worth_indexing(it->first))
+	    encoder_table.add(*it);
+    }
+}
+
+void hpack::set_encoder_table_size(uint32_t size)
+{
+    if(size > HPACK_TABLE_SIZE)
+	size = HPACK_TABLE_SIZE;
+	// we never use more than the default even if the peer allows it
+
+    if(size != encoder_table.get_max_size())
+    {
+	encoder_table.resize(size);
+	encoder_update = true;
+    }
+}
+
+void hpack::table::add(const field & f)
+{
+    uint32_t entry = f.first.size() + f.second.size() + HPACK_ENTRY_OVERHEAD;
+
+    if(entry > max_size)
+    {
+	    // an entry larger than the table empties it (RFC 7541 paragraph 4.4)
+	evict_down_to(0);
+	return;
+    }
+
+    evict_down_to(max_size - entry);
+    entries.push_front(f);
+    size += entry;
+}
+
+void hpack::table::resize(uint32_t max)
+{
+    max_size = max;
+    evict_down_to(max);
+}
+
+bool hpack::table::find(const field & f, uint32_t & index, uint32_t & name_index, bool & name_found) const
+{
+    name_found = false;
+
+    for(uint32_t i = 0; i < entries.size(); ++i)
+    {
+	if(entries[i].first == f.first)
+	{
+	    if(!name_found)
+	    {
+		name_index = i;
+		name_found = true;
+	    }
+	    if(entries[i].second == f.second)
+	    {
+		index = i;
+		return true;
+	    }
+	}
+    }
+
+    return false;
+}
+
+void hpack::table::evict_down_to(uint32_t max)
+{
+    while(size > max && !entries.empty())
+    {
+	size -= entries.back().first.size() + entries.back().second.size() + HPACK_ENTRY_OVERHEAD;
+	entries.pop_back();
+    }
+}
+
+hpack::field hpack::lookup(uint64_t index) const
+{
+    if(index == 0)
+	throw exception_range("HPACK index zero is not valid");
+
+    if(index <= static_table_size)
+	return field(static_table[index - 1].name, static_table[index - 1].value);
+
+    index -= static_table_size + 1;
+    if(index >= decoder_table.get_count())
+	throw exception_range("HPACK index out of the dynamic table");
+
+    return decoder_table.get(index);
+}
+
+void hpack::add_indexed(uint32_t index, string & block) const
+{
+    encode_integer(index, 7, 0x80, block);
+}
+
+uint64_t hpack::decode_integer(const string & block, string::size_type & pos, unsigned int prefix_bits)
+{
+    uint64_t mask = (1 << prefix_bits) - 1;
+    uint64_t ret;
+    unsigned int shift = 0;
+    unsigned char next;
+
+    if(pos >= block.size())
+	throw exception_range("truncated HPACK integer");
+
+    ret = (unsigned char)(block[pos++]) & mask;
+    if(ret < mask)
+	return ret;
+
+    do
+    {
+	if(pos >= block.size())
+	    throw exception_range("truncated HPACK integer");
+	if(shift > 28)
+	    throw exception_range("HPACK integer too large");
+	next = block[pos++];
+	ret += (uint64_t)(next & 0x7F) << shift;
+	shift += 7;
+    }
+    while((next & 0x80) != 0);
+
+    return ret;
+}
+
+void hpack::check_list_size(const field & f, uint64_t & list_size, uint64_t max_list_size)
+{
+	// field size as defined by RFC 7541 paragraph 4.1
+    list_size += f.first.size() + f.second.size() + 32;
+    if(max_list_size > 0 && list_size > max_list_size)
+	throw exception_input("Decoded HPACK header list too large", STATUS_CODE_REQUEST_HEADER_FIELDS_TOO_LARGE);
+}
+
+void hpack::decode_string(const string & block, string::size_type & pos, string & value)
+{
+    bool huffman;
+    uint64_t len;
+
+    if(pos >= block.size())
+	throw exception_range("truncated HPACK string");
+
+    huffman = ((unsigned char)(block[pos]) & 0x80) != 0;
+    len = decode_integer(block, pos, 7);
+    if(len > block.size() - pos)
+	throw exception_range("truncated HPACK string");
+
+    if(huffman)
+	huffman_decode(block.c_str() + pos, len, value);
+    else
+	value.assign(block, pos, len);
+    pos += len;
+}
+
+void hpack::huffman_decode(const char *data, string::size_type size, string & value)
+{
+    const vector<huffman_node> & tree = huffman_tree();
+    int16_t node = 0;
+    unsigned int depth = 0;    // bits read since the last decoded symbol
+    bool only_ones = true;     // whether these bits are all set (padding)
+
+    value.clear();
+    value.reserve(size * 8 / 5);
+
+    for(string::size_type i = 0; i < size; ++i)
+    {
+	unsigned char byte = data[i];
+
+	for(int bit = 7; bit >= 0; --bit)
+	{
+	    unsigned int b = (byte >> bit) & 1;
+
+	    node = tree[node].child[b];
+	    if(node < 0)
+		throw exception_range("invalid Huffman code in HPACK string");
+	    ++depth;
+	    if(b == 0)
+		only_ones = false;
+
+	    if(tree[node].symbol >= 0)
+	    {
+		value += (char)(tree[node].symbol);
+		node = 0;
+		depth = 0;
+		only_ones = true;
+	    }
+	}
+    }
+
+	// padding is the most significant bits of the EOS symbol,
+	// that's to say less than 8 bits all set (RFC 7541 paragraph 5.2)
+    if(depth > 7 || !only_ones)
+	throw exception_range("invalid Huffman padding in HPACK string");
+}
+
+void hpack::encode_integer(uint64_t value, unsigned int prefix_bits, unsigned char flags, string & block)
+{
+    uint64_t mask = (1 << prefix_bits) - 1;
+
+    if(value < mask)
+    {
+	block += (char)(flags | value);
+	return;
+    }
+
+    block += (char)(flags | mask);
+    value -= mask;
+    while(value >= 0x80)
+    {
+	block += (char)((value & 0x7F) | 0x80);
+	value >>= 7;
+    }
+    block += (char)(value);
+}
+
+void hpack::encode_string(const string & value, string & block)
+{
+    uint64_t bits = 0;
+    uint64_t acc = 0;
+    unsigned int pending = 0;
+
+    for(string::const_iterator it = value.begin(); it != value.end(); ++it)
+	bits += huffman_length[(unsigned char)(*it)];
+
+    if((bits + 7) / 8 >= value.size())
+    {
+	    // Huffman coding does not make it shorter
+	encode_integer(value.size(), 7, 0x00, block);
+	block += value;
+	return;
+    }
+
+    encode_integer((bits + 7) / 8, 7, 0x80, block);
+    for(string::const_iterator it = value.begin(); it != value.end(); ++it)
+    {
+	unsigned char c = *it;
+
+	acc = (acc << huffman_length[c]) | huffman_code[c];
+	pending += huffman_length[c];
+	while(pending >= 8)
+	{
+	    pending -= 8;
+	    block += (char)(acc >> pending);
+	}
+	acc &= (1 << pending) - 1;
+    }
+
+    if(pending > 0) // padding with the most significant bits of EOS
+	block += (char)((acc << (8 - pending)) | (0xFF >> pending));
+}
+
+bool hpack::worth_indexing(const string & name)
+{
+	// these change at each answer and would only
+	// evict the useful entries from the dynamic table
+    return name != "date"
+	&& name != "expires"
+	&& name != "last-modified"
+	&& name != "etag"
+	&& name != "content-length"
+	&& name != "set-cookie";
+}
+
+static vector<huffman_node> build_huffman_tree()
+{
+    vector<huffman_node> ret;
+    huffman_node empty;
+
+    empty.child[0] = empty.child[1] = -1;
+    empty.symbol = -1;
+    ret.push_back(empty); // the root
+
+    for(unsigned int sym = 0; sym < 256; ++sym)
+    {
+	int16_t node = 0;
+
+	for(int bit = huffman_length[sym] - 1; bit >= 0; --bit)
+	{
+	    unsigned int b = (huffman_code[sym] >> bit) & 1;
+
+	    if(ret[node].child[b] < 0)
+	    {
+		ret[node].child[b] = ret.size();
+		ret.push_back(empty);
+	    }
+	    node = ret[node].child[b];
+	}
+	ret[node].symbol = sym;
+    }
+
+    return ret;
+}
+
+static const vector<huffman_node> & huffman_tree()
+{
+    static const vector<huffman_node> tree = build_huffman_tree();
+	// built once, the initialization of local static
+	// variables is thread safe since C++11
+
+    return tree;
+}
@@ -0,0 +1,133 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef HPACK_HPP
+#define HPACK_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+#if HAVE_STDINT_H
+#include <stdint.h>
+#endif
+}
+
+    // C++ system header files
+#include <string>
+#include <deque>
+#include <vector>
+#include <utility>
+
+    // webdar headers
+#include "exceptions.hpp"
+
+    /// HPACK header compression context of an HTTP/2 connection (RFC 7541)
+
+    /// \note the object holds the two dynamic tables of a connection, the one
+    /// used to decode the header blocks received from the peer and the one used
+    /// to encode the header blocks we send. Decoding errors are connection errors
+    /// (COMPRESSION_ERROR) reported by throwing exception_range.
+
+class hpack
+{
+public:
+	/// a header field as a (name, value) pair
+    typedef std::pair<std::string, std::string> field;
+
+	/// constructor, both dynamic tables have the default 4096 bytes size
+    hpack();
+    hpack(const hpack & ref) = default;
+    hpack(hpack && ref) noexcept = default;
+    hpack & operator = (const hpack & ref) = default;
+    hpack & operator = (hpack && ref) noexcept = default;
+    ~hpack() = default;
+
+	/// decode a whole header block received from the peer
+
+	/// \param[in] block the header block (fragments already concatenated)
+	/// \param[out] fields the decoded header list, in the received order
+	/// \param[in] max_list_size max size of the decoded header list, counted as defined for
+	/// SETTINGS_MAX_HEADER_LIST_SIZE (name and value lengths plus 32 per field), zero for no limit
+	/// \param[in] max_count max number of fields of the decoded header list, zero for no limit
+	/// \note a few bytes referring to the dynamic table can expand to a much larger header list,
+	/// once a limit is exceeded decoding stops and exception_input is thrown with
+	/// STATUS_CODE_REQUEST_HEADER_FIELDS_TOO_LARGE, the dynamic table is then out of sync
+	/// with the peer's and the connection cannot be used any further
+    void decode(const std::string & block,
+		std::vector<field> & fields,
+		uint64_t max_list_size = 0,
+		uint32_t max_count = 0);
+
+	/// encode a header list and append the result to block
+
+	/// \note the fields which value is likely to change from an answer to the next
+	/// are not added to the dynamic table, Set-Cookie is never indexed
+    void encode(const std::vector<field> & fields, std::string & block);
+
+	/// the max size of the dynamic table the peer lets us use for encoding (SETTINGS_HEADER_TABLE_SIZE)
+    void set_encoder_table_size(uint32_t size);
+
+private:
+
+	/// a dynamic table, newest entries first
+    class table
+    {
+    public:
+	table(uint32_t max): max_size(max), size(0) {};
+
+	void add(const field & f);
+	void resize(uint32_t max);
+	uint32_t get_max_size() const { return max_size; };
+	uint32_t get_count() const { return entries.size(); };
+	const field & get(uint32_t index) const { return entries[index]; };
+
+	    /// look for a field, index is zero based, name_index set to the first entry with the same name
+	bool find(const field & f, uint32_t & index, uint32_t & name_index, bool & name_found) const;
+
+    private:
+	std::deque<field> entries;
+	uint32_t max_size;
+	uint32_t size;
+
+	void evict_down_to(uint32_t max);
+    };
+
+    table decoder_table;      ///< entries added by the peer's encoder
+    table encoder_table;      ///< entries we add when encoding
+    bool encoder_update;      ///< whether a dynamic table size update has to start the next encoded block
+
+    field lookup(uint64_t index) const;
+    void add_indexed(uint32_t index, std::string & block) const;
+
+    static void check_list_size(const field & f, uint64_t & list_size, uint64_t max_list_size);
+    static uint64_t decode_integer(const std::string & block, std::string::size_type & pos, unsigned int prefix_bits);
+    static void decode_string(const std::string & block, std::string::size_type & pos, std::string & value);
+    static void huffman_decode(const char *data, std::string::size_type size, std::string & value);
+    static void encode_integer(uint64_t value, unsigned int prefix_bits, unsigned char flags, std::string & block);
+    static void encode_string(const std::string & value, std::string & block);
+    static bool worth_indexing(const std::string & name);
+};
+
+#endif
@@ -667,9 +667,11 @@ string html_bibliotheque::inherited_get_body_part(const chemin & path,
 	    {
 		try
 		{
-		    troncon tronc = req.get_body_of_multipart(0);
-		    istringstream str(string(tronc.begin, tronc.end));
-		    json data = json::parse(str);
+		    unique_ptr<istream> str = req.get_body_of_multipart(0);
+
+		    if(!str)
+			throw WEBDAR_BUG;
+		    json data = json::parse(*str);
 
 		    biblio->load_json(data);
 		    autosave.set_value_as_bool(biblio->get_autosave_status());
@@ -284,7 +284,7 @@ string html_datetime::inherited_get_body_part(const chemin & path,
     if(err || annees < 70)
     {
 	year.set_value("1970");
-	if(req.get_method() == "POST")
+	if(req.get_method_id() == http_token::method_post)
 	{
 	    request tmpreq = req;
 	    tmpreq.change_method("GET");
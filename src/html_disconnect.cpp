@@ -33,6 +33,7 @@ extern "C"
 
     // webdar headers
 #include "webdar_css_style.hpp"
+#include "static_object_library.hpp"
 
     //
 #include "html_disconnect.hpp"
@@ -53,7 +54,7 @@ const string html_disconnect::css_quit_box = "html_disco_quit_box";
 bool html_disconnect::default_basic_auth = true;
 
 html_disconnect::html_disconnect():
-    logo((chemin(STATIC_PATH_ID) + chemin(STATIC_TITLE_LOGO)).display(false), "Webdar logo"),
+    logo(static_object_library::get_url(STATIC_TITLE_LOGO), "Webdar logo"),
     title_vers(libdar::tools_printf("Version %s", WEBDAR_VERSION), event_version),
     quit("Disconnect", event_disconn)
 {
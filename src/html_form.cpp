@@ -99,7 +99,7 @@ string html_form::inherited_get_body_part(const chemin & path,
     if(!enctype.empty())
 	ret += " enctype=\""+enctype+"\"";
     ret += ">\n";
-    if( ! req.get_uri().get_path().is_the_beginning_of(get_path()) && req.get_method() == "POST")
+    if( ! req.get_uri().get_path().is_the_beginning_of(get_path()) && req.get_method_id() == http_token::method_post)
     {
 	request tmp = req;
 	tmp.change_method("GET");
@@ -108,7 +108,7 @@ string html_form::inherited_get_body_part(const chemin & path,
     else
     {
 	ret += get_body_part_from_all_children(path, req);
-	if(req.get_method() == "POST")
+	if(req.get_method_id() == http_token::method_post)
 	    act(changed);
     }
     ret += "<input " + get_button_css_classes() + " type=\"submit\" value=\"" + go_mesg + "\" />\n";
@@ -228,7 +228,7 @@ string html_form_input::inherited_get_body_part(const chemin & path,
 	// first we extract informations from the returned form in
 	// the body of the request
 
-    if(req.get_method() == "POST"
+    if(req.get_method_id() == http_token::method_post
        && path.empty()
        && enabled
        && !value_set)
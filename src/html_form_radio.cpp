@@ -235,7 +235,7 @@ void html_form_radio::new_css_library_available()
 
 void html_form_radio::update_field_from_request(const request & req)
 {
-    if(req.get_method() == "POST" && ! value_set)
+    if(req.get_method_id() == http_token::method_post && ! value_set)
     {
 	map<string, string> bd = req.get_body_form();
 	map<string, string>::const_iterator it = bd.find(get_path().namify());
@@ -66,9 +66,17 @@ string html_libdar_running_page::inherited_get_body_part(const chemin & path,
     string body = get_body_part_from_children_as_a_block(path, req);
 
     if(enable_refresh)
+    {
 	set_refresh_redirection(1, req.get_uri().url_path_part());
+	set_event_stream(web_ui->get_progress_feed_url(), web_ui->get_progress_feed_id());
+	set_status_poll(web_ui->get_progress_status_url(), web_ui->get_progress_feed_id());
+    }
     else
+    {
 	set_refresh_redirection(0, ""); // disable refresh
+	set_event_stream("", "");
+	set_status_poll("", "");
+    }
 
     return get_body_part_given_the_body(path, req, body);
 }
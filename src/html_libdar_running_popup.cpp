@@ -94,9 +94,17 @@ string html_libdar_running_popup::inherited_get_body_part(const chemin & path,
     ret = html_popup::inherited_get_body_part(path, req);
 
     if(enable_refresh)
+    {
 	page->set_refresh_redirection(1, req.get_uri().url_path_part());
+	page->set_event_stream(web_ui->get_progress_feed_url(), web_ui->get_progress_feed_id());
+	page->set_status_poll(web_ui->get_progress_status_url(), web_ui->get_progress_feed_id());
+    }
     else
+    {
 	page->set_refresh_redirection(0, ""); // disable refresh
+	page->set_event_stream("", "");
+	page->set_status_poll("", "");
+    }
 
     return ret;
 }
@@ -117,6 +125,17 @@ void html_libdar_running_popup::on_event(const string & event_name)
     }
     else if(event_name == html_web_user_interaction::libdar_has_finished)
     {
+	html_page* page = nullptr;
+
+	    // once hidden we no more update the page, the event
+	    // stream of our ended libdar thread must not be kept
+	closest_ancestor_of_type(page);
+	if(page != nullptr)
+	{
+	    page->set_event_stream("", "");
+	    page->set_status_poll("", "");
+	}
+
 	my_body_part_has_changed();
 	set_visible(false); // nothing more to show
 	act(libdar_has_finished); // propagating the event
@@ -0,0 +1,233 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+
+}
+
+    // C++ system header files
+
+
+    // webdar headers
+#include "webdar_css_style.hpp"
+#include "webdar_tools.hpp"
+
+    //
+#include "html_log_viewer.hpp"
+
+    // number of lines shown at once
+#define LOG_VIEWER_PAGE 100
+
+using namespace std;
+
+const string html_log_viewer::event_first = "html_log_viewer_first";
+const string html_log_viewer::event_previous = "html_log_viewer_previous";
+const string html_log_viewer::event_next = "html_log_viewer_next";
+const string html_log_viewer::event_last = "html_log_viewer_last";
+
+html_log_viewer::html_log_viewer():
+    first(0),
+    search_from(0),
+    search_next(0),
+    search_end(true),
+    h_fs("Full log"),
+    h_form("Search"),
+    h_pattern("Only show lines containing", html_form_input::text, "", "", webdar_css_style::width_100vw),
+    b_first("First", event_first),
+    b_previous("Previous", event_previous),
+    b_next("Next", event_next),
+    b_last("Last", event_last)
+{
+	// adoption tree
+    h_form.adopt(&h_pattern);
+    h_fs.adopt(&h_status);
+    h_fs.adopt(&h_lines);
+    h_fs.adopt(&h_form);
+    h_fs.adopt(&b_first);
+    h_fs.adopt(&b_previous);
+    h_fs.adopt(&b_next);
+    h_fs.adopt(&b_last);
+    adopt(&h_fs);
+
+	// events
+    h_pattern.record_actor_on_event(this, html_form_input::changed);
+    b_first.record_actor_on_event(this, event_first);
+    b_previous.record_actor_on_event(this, event_previous);
+    b_next.record_actor_on_event(this, event_next);
+    b_last.record_actor_on_event(this, event_last);
+
+	// css
+    h_status.add_css_class(webdar_css_style::text_bold);
+    webdar_css_style::normal_button(b_first);
+    webdar_css_style::normal_button(b_previous);
+    webdar_css_style::normal_button(b_next);
+    webdar_css_style::normal_button(b_last);
+}
+
+void html_log_viewer::set_spool(const shared_ptr<log_spool> & ref)
+{
+    spool = ref;
+    first = 0;
+    search_from = 0;
+    search_previous.clear();
+    my_body_part_has_changed();
+}
+
+void html_log_viewer::on_event(const string & event_name)
+{
+    uint64_t num = spool ? spool->get_num_lines() : 0;
+
+    if(event_name == html_form_input::changed)
+    {
+	pattern = h_pattern.get_value();
+	search_from = 0;
+	search_previous.clear();
+    }
+    else if(event_name == event_first)
+    {
+	first = 0;
+	search_from = 0;
+	search_previous.clear();
+    }
+    else if(event_name == event_previous)
+    {
+	if(pattern.empty())
+	    first = first > LOG_VIEWER_PAGE ? first - LOG_VIEWER_PAGE : 0;
+	else if(!search_previous.empty())
+	{
+	    search_from = search_previous.back();
+	    search_previous.pop_back();
+	}
+    }
+    else if(event_name == event_next)
+    {
+	if(pattern.empty())
+	{
+	    if(first + LOG_VIEWER_PAGE < num)
+		first += LOG_VIEWER_PAGE;
+	}
+	else if(!search_end)
+	{
+	    search_previous.push_back(search_from);
+	    search_from = search_next;
+	}
+    }
+    else if(event_name == event_last)
+	first = num > LOG_VIEWER_PAGE ? num - LOG_VIEWER_PAGE : 0;
+    else
+	throw WEBDAR_BUG;
+
+    my_body_part_has_changed();
+}
+
+string html_log_viewer::inherited_get_body_part(const chemin & path,
+						const request & req)
+{
+    update_page();
+    return get_body_part_from_all_children(path, req);
+}
+
+void html_log_viewer::new_css_library_available()
+{
+    unique_ptr<css_library> & csslib = lookup_css_library();
+    if(!csslib)
+	throw WEBDAR_BUG;
+    webdar_css_style::update_library(*csslib);
+}
+
+void html_log_viewer::update_page()
+{
+    string status;
+    string text;
+
+    if(!spool)
+    {
+	h_status.clear();
+	h_status.add_text(0, "No log has been recorded");
+	h_lines.clear();
+	h_form.set_visible(false);
+	b_first.set_visible(false);
+	b_previous.set_visible(false);
+	b_next.set_visible(false);
+	b_last.set_visible(false);
+	return;
+    }
+
+    uint64_t num = spool->get_num_lines();
+
+    if(pattern.empty())
+    {
+	vector<string> page;
+
+	if(first >= num)
+	    first = num > LOG_VIEWER_PAGE ? num - LOG_VIEWER_PAGE : 0;
+	spool->read_lines(first, LOG_VIEWER_PAGE, page);
+
+	for(unsigned int i = 0; i < page.size(); ++i)
+	    text += webdar_tools_convert_to_string(first + i + 1) + ": " + webdar_tools_html_display(page[i]) + "<br />\n";
+
+	if(num == 0)
+	    status = "The log is empty";
+	else
+	    status = "Lines " + webdar_tools_convert_to_string(first + 1)
+		+ " to " + webdar_tools_convert_to_string(first + page.size())
+		+ " of " + webdar_tools_convert_to_string(num);
+
+	b_previous.set_visible(first > 0);
+	b_next.set_visible(first + page.size() < num);
+	b_last.set_visible(first + page.size() < num);
+    }
+    else
+    {
+	vector<log_spool::match> found;
+
+	search_next = search_from;
+	search_end = spool->grep(pattern, search_next, LOG_VIEWER_PAGE, found);
+
+	for(vector<log_spool::match>::iterator it = found.begin(); it != found.end(); ++it)
+	    text += webdar_tools_convert_to_string(it->num + 1) + ": " + webdar_tools_html_display(it->line) + "<br />\n";
+
+	status = webdar_tools_convert_to_string(found.size())
+	    + " line(s) containing \"" + webdar_tools_html_display(pattern) + "\" from line "
+	    + webdar_tools_convert_to_string(search_from + 1)
+	    + " to " + webdar_tools_convert_to_string(search_next)
+	    + " of " + webdar_tools_convert_to_string(num);
+
+	b_previous.set_visible(!search_previous.empty());
+	b_next.set_visible(!search_end);
+	b_last.set_visible(false);
+    }
+
+    if(spool->get_lost() > 0)
+	status += " (" + webdar_tools_convert_to_string(spool->get_lost()) + " message(s) could not be recorded)";
+
+    h_status.clear();
+    h_status.add_text(0, status);
+    h_lines.clear();
+    h_lines.add_text(0, text);
+    h_form.set_visible(true);
+    b_first.set_visible(true);
+}
@@ -0,0 +1,121 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef HTML_LOG_VIEWER_HPP
+#define HTML_LOG_VIEWER_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+#if HAVE_STDINT_H
+#include <stdint.h>
+#endif
+}
+
+    // C++ system header files
+#include <string>
+#include <vector>
+#include <memory>
+
+    // webdar headers
+#include "body_builder.hpp"
+#include "actor.hpp"
+#include "html_form.hpp"
+#include "html_form_input.hpp"
+#include "html_form_fieldset.hpp"
+#include "html_text.hpp"
+#include "html_button.hpp"
+#include "log_spool.hpp"
+
+    /// html component showing the full log of a libdar job page by page
+
+    /// the lines are read from a log_spool at each display, only one page of
+    /// lines is held in memory. When a search string is given, only the lines
+    /// containing it are shown, the search being done by the log_spool.
+    /** \verbatim
+	+-h_fs------------------------------------+
+	| h_status                                |
+	| h_lines                                 |
+	|+-h_form--------------------------------+|
+	|| h_pattern                             ||
+	|+---------------------------------------+|
+	| first  previous  next  last             |
+	+-----------------------------------------+
+	\endverbatim **/
+
+class html_log_viewer : public body_builder, public actor
+{
+public:
+    html_log_viewer();
+    html_log_viewer(const html_log_viewer & ref) = delete;
+    html_log_viewer(html_log_viewer && ref) noexcept = delete;
+    html_log_viewer & operator = (const html_log_viewer & ref) = delete;
+    html_log_viewer & operator = (html_log_viewer && ref) noexcept = delete;
+    ~html_log_viewer() = default;
+
+	/// set the log to display, an empty pointer for none
+    void set_spool(const std::shared_ptr<log_spool> & ref);
+
+	/// inherited from actor
+    virtual void on_event(const std::string & event_name) override;
+
+protected:
+	/// inherited from body_builder
+    virtual std::string inherited_get_body_part(const chemin & path,
+						const request & req) override;
+
+	/// inherited from body_builder
+    virtual void new_css_library_available() override;
+
+private:
+	// internal event names
+    static const std::string event_first;
+    static const std::string event_previous;
+    static const std::string event_next;
+    static const std::string event_last;
+
+    std::shared_ptr<log_spool> spool;
+    uint64_t first;                   ///< first line shown when browsing
+    std::string pattern;              ///< string searched for, empty when browsing
+    uint64_t search_from;             ///< line where the search of the current page starts
+    uint64_t search_next;             ///< line where the search of the next page starts
+    bool search_end;                  ///< whether the search of the current page reached the end of the log
+    std::vector<uint64_t> search_previous; ///< where the search of the previous pages started
+
+    html_form_fieldset h_fs;
+    html_text h_status;
+    html_text h_lines;
+    html_form h_form;
+    html_form_input h_pattern;
+    html_button b_first;
+    html_button b_previous;
+    html_button b_next;
+    html_button b_last;
+
+	/// fill h_lines and h_status with the lines of the current page
+    void update_page();
+};
+
+#endif
@@ -34,6 +34,7 @@ extern "C"
     // webdar headers
 #include "webdar_tools.hpp"
 #include "html_text.hpp"
+#include "static_object_library.hpp"
 
     //
 #include "html_page.hpp"
@@ -51,6 +52,8 @@ void html_page::set_title(const string & title)
 
 void html_page::set_refresh_redirection(unsigned int seconds, const string & url)
 {
+    redirect_delay = seconds;
+    redirect_url = url;
     if(url != "")
     {
 	redirect = "<meta http-equiv=\"refresh\" content=\"";
@@ -62,6 +65,18 @@ void html_page::set_refresh_redirection(unsigned int seconds, const string & url
 }
 
 
+void html_page::set_event_stream(const string & url, const string & id_prefix)
+{
+    stream_url = url;
+    stream_prefix = id_prefix;
+}
+
+void html_page::set_status_poll(const string & url, const string & id_prefix)
+{
+    poll_url = url;
+    poll_prefix = id_prefix;
+}
+
 string html_page::inherited_get_body_part(const chemin & path,
 					  const request & req)
 {
@@ -89,10 +104,23 @@ string html_page::get_body_part_given_the_body(const chemin & path,
     ret += "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">\n";
     ret += "<meta content=\"text/html; charset=ISO-8859-1\" http-equiv=\"content-type\">\n";
     ret += "<meta charset=\"UTF-8\">";
-    ret += "<link rel=\"icon\" type=\"image/x-icon\" href=\"" + (chemin(STATIC_PATH_ID) + chemin(STATIC_FAVICON)).display(false) + "\">";
+    ret += "<link rel=\"icon\" type=\"image/x-icon\" href=\"" + static_object_library::get_url(STATIC_FAVICON) + "\">";
 
     if(redirect != "")
-	ret += redirect + "\n";
+    {
+	if(stream_url != "")
+	{
+	    ret += "<noscript>" + redirect + "</noscript>\n";
+	    ret += get_event_stream_script();
+	}
+	else if(poll_url != "")
+	{
+	    ret += "<noscript>" + redirect + "</noscript>\n";
+	    ret += get_status_poll_script();
+	}
+	else
+	    ret += redirect + "\n";
+    }
 
     ret += "</head>\n<body";
 
@@ -106,3 +134,81 @@ string html_page::get_body_part_given_the_body(const chemin & path,
 
     return ret;
 }
+
+string html_page::get_event_stream_script() const
+{
+    string delay = webdar_tools_convert_to_string(redirect_delay * 1000);
+    string ret = "<script type=\"text/javascript\">\n";
+
+	// counters are updated in place, libdar messages are appended to the
+	// logs and the page is reloaded when the stream ends, the same way
+	// the refresh redirection would do it
+
+    ret += "(function() {\n";
+    ret += "  var prefix = \"" + stream_prefix + "\";\n";
+    ret += "  var reload = function(delay) { setTimeout(function() { window.location.replace(\"" + redirect_url + "\"); }, delay); };\n";
+    ret += "  if(!window.EventSource) { reload(" + delay + "); return; }\n";
+    ret += "  var stream = new EventSource(\"" + stream_url + "\");\n";
+    ret += "  stream.addEventListener(\"counter\", function(e) {\n";
+    ret += "    var sep = e.data.indexOf(\" \");\n";
+    ret += "    var field = document.getElementById(prefix + \"-\" + e.data.substring(0, sep));\n";
+    ret += "    if(field) field.textContent = e.data.substring(sep + 1);\n";
+    ret += "  });\n";
+    ret += "  stream.addEventListener(\"message\", function(e) {\n";
+    ret += "    var logs = document.getElementById(prefix + \"-log\");\n";
+    ret += "    if(!logs) return;\n";
+    ret += "    logs.appendChild(document.createTextNode(e.data));\n";
+    ret += "    logs.appendChild(document.createElement(\"br\"));\n";
+    ret += "    while(logs.childNodes.length > 2 * parseInt(logs.getAttribute(\"data-lines\"))) logs.removeChild(logs.firstChild);\n";
+    ret += "  });\n";
+    ret += "  stream.addEventListener(\"reload\", function(e) { stream.close(); reload(0); });\n";
+    ret += "  stream.onerror = function() { stream.close(); reload(" + delay + "); };\n";
+    ret += "})();\n";
+    ret += "</script>\n";
+
+    return ret;
+}
+
+string html_page::get_status_poll_script() const
+{
+    string delay = webdar_tools_convert_to_string(redirect_delay * 1000);
+    string ret = "<script type=\"text/javascript\">\n";
+
+	// same updates as the event stream, but each snapshot is a short
+	// request which does not hold a server thread between two polls
+
+    ret += "(function() {\n";
+    ret += "  var prefix = \"" + poll_prefix + "\";\n";
+    ret += "  var url = \"" + poll_url + "\";\n";
+    ret += "  var base = url.substring(0, url.lastIndexOf(\"/\") + 1);\n";
+    ret += "  var seq = url.substring(base.length);\n";
+    ret += "  var reload = function(delay) { setTimeout(function() { window.location.replace(\"" + redirect_url + "\"); }, delay); };\n";
+    ret += "  if(!window.fetch) { reload(" + delay + "); return; }\n";
+    ret += "  var poll = function() {\n";
+    ret += "    fetch(base + seq, { credentials: \"same-origin\", cache: \"no-store\" })\n";
+    ret += "    .then(function(r) { if(!r.ok) throw new Error(r.statusText); return r.json(); })\n";
+    ret += "    .then(function(st) {\n";
+    ret += "      if(st.reload) { reload(0); return; }\n";
+    ret += "      for(var name in st.counters) {\n";
+    ret += "        var field = document.getElementById(prefix + \"-\" + name);\n";
+    ret += "        if(field) field.textContent = st.counters[name];\n";
+    ret += "      }\n";
+    ret += "      var logs = document.getElementById(prefix + \"-log\");\n";
+    ret += "      if(logs) {\n";
+    ret += "        for(var i = 0; i < st.messages.length; ++i) {\n";
+    ret += "          logs.appendChild(document.createTextNode(st.messages[i]));\n";
+    ret += "          logs.appendChild(document.createElement(\"br\"));\n";
+    ret += "        }\n";
+    ret += "        while(logs.childNodes.length > 2 * parseInt(logs.getAttribute(\"data-lines\"))) logs.removeChild(logs.firstChild);\n";
+    ret += "      }\n";
+    ret += "      seq = st.seq;\n";
+    ret += "      setTimeout(poll, " + delay + ");\n";
+    ret += "    })\n";
+    ret += "    .catch(function() { reload(" + delay + "); });\n";
+    ret += "  };\n";
+    ret += "  setTimeout(poll, " + delay + ");\n";
+    ret += "})();\n";
+    ret += "</script>\n";
+
+    return ret;
+}
@@ -44,7 +44,7 @@ extern "C"
 class html_page : public html_level
 {
 public:
-    html_page(const std::string & title = "") { x_title = title; store_css_library(); };
+    html_page(const std::string & title = "") { x_title = title; redirect_delay = 0; store_css_library(); };
     html_page(const html_page & ref) = delete;
     html_page(html_page && ref) noexcept = delete;
     html_page & operator = (const html_page & ref) = delete;
@@ -72,6 +72,23 @@ public:
 	/// get current deridection url
     const std::string & get_refresh_redirection() const { return redirect; };
 
+	/// replace the refresh redirection by an event stream when the browser runs javascript
+
+	/// \param[in] url the URL of the event stream (see class progress_feed), an empty string disables it
+	/// \param[in] id_prefix the prefix of the HTML id of the components the events update
+	/// \note the refresh redirection set by set_refresh_redirection() is kept for browsers
+	/// without javascript and is followed by the script once the stream asks for a reload
+	/// or fails. The event stream is ignored if no refresh redirection is set.
+    void set_event_stream(const std::string & url, const std::string & id_prefix);
+
+	/// replace the refresh redirection by periodic polls of a status snapshot when the browser runs javascript
+
+	/// \param[in] url the URL of the first snapshot (see progress_feed::status()), an empty string disables it
+	/// \param[in] id_prefix the prefix of the HTML id of the components the snapshots update
+	/// \note the polls take place every refresh delay and are only used when no event stream is set,
+	/// the refresh redirection is followed once a snapshot asks for a reload or a poll fails.
+    void set_status_poll(const std::string & url, const std::string & id_prefix);
+
 protected:
 	/// inherited from body_builder
     virtual std::string inherited_get_body_part(const chemin & path,
@@ -86,6 +103,18 @@ protected:
 private:
     std::string x_title;
     std::string redirect;
+    unsigned int redirect_delay; ///< refresh delay in seconds
+    std::string redirect_url;    ///< refresh target
+    std::string stream_url;      ///< event stream URL or empty string
+    std::string stream_prefix;   ///< id prefix of the components updated by the event stream
+    std::string poll_url;        ///< status snapshot URL or empty string
+    std::string poll_prefix;     ///< id prefix of the components updated by the status snapshots
+
+	/// the script reading the event stream
+    std::string get_event_stream_script() const;
+
+	/// the script polling the status snapshots
+    std::string get_status_poll_script() const;
 };
 
 
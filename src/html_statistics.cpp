@@ -43,6 +43,9 @@ using namespace std;
 html_statistics::html_statistics()
 {
     table = nullptr;
+    stats.reset(new (nothrow) libdar::statistics());
+    if(!stats)
+	throw exception_memory();
 
 	// css
 
@@ -73,7 +76,7 @@ html_statistics::html_statistics()
 
 void html_statistics::clear_counters()
 {
-    stats.clear();
+    stats->clear();
     update_html_counters();
 }
 
@@ -195,56 +198,83 @@ void html_statistics::unbuild()
 }
 
 
+void html_statistics::read_counters(const libdar::statistics & stats, map<string, string> & counters)
+{
+    counters.clear();
+    counters["treated"] = libdar::deci(stats.get_treated()).human();
+    counters["hard_links"] = libdar::deci(stats.get_hard_links()).human();
+    counters["skipped"] = libdar::deci(stats.get_skipped()).human();
+    counters["ignored"] = libdar::deci(stats.get_ignored()).human();
+    counters["tooold"] = libdar::deci(stats.get_tooold()).human();
+    counters["errored"] = libdar::deci(stats.get_errored()).human();
+    counters["deleted"] = libdar::deci(stats.get_deleted()).human();
+    counters["ea_treated"] = libdar::deci(stats.get_ea_treated()).human();
+    counters["byte_amount"] = libdar::deci(stats.get_byte_amount()).human();
+    counters["total"] = libdar::deci(stats.total()).human();
+}
+
 void html_statistics::update_html_counters()
 {
+    map<string, string> val;
+
+    read_counters(*stats, val);
+
     if(treated_lbl.get_body_part() != "")
     {
 	treated_count.clear();
-	treated_count.add_text(0, libdar::deci(stats.get_treated()).human());
+	treated_count.add_text(0, counter_html("treated", val["treated"]));
     }
     if(hard_links_lbl.get_body_part() != "")
     {
 	hard_links_count.clear();
-	hard_links_count.add_text(0, libdar::deci(stats.get_hard_links()).human());
+	hard_links_count.add_text(0, counter_html("hard_links", val["hard_links"]));
     }
     if(skipped_lbl.get_body_part() != "")
     {
 	skipped_count.clear();
-	skipped_count.add_text(0, libdar::deci(stats.get_skipped()).human());
+	skipped_count.add_text(0, counter_html("skipped", val["skipped"]));
     }
     if(ignored_lbl.get_body_part() != "")
     {
 	ignored_count.clear();
-	ignored_count.add_text(0, libdar::deci(stats.get_ignored()).human());
+	ignored_count.add_text(0, counter_html("ignored", val["ignored"]));
     }
     if(tooold_lbl.get_body_part() != "")
     {
 	tooold_count.clear();
-	tooold_count.add_text(0, libdar::deci(stats.get_tooold()).human());
+	tooold_count.add_text(0, counter_html("tooold", val["tooold"]));
     }
     if(errored_lbl.get_body_part() != "")
     {
 	errored_count.clear();
-	errored_count.add_text(0, libdar::deci(stats.get_errored()).human());
+	errored_count.add_text(0, counter_html("errored", val["errored"]));
     }
     if(deleted_lbl.get_body_part() != "")
     {
 	deleted_count.clear();
-	deleted_count.add_text(0, libdar::deci(stats.get_deleted()).human());
+	deleted_count.add_text(0, counter_html("deleted", val["deleted"]));
     }
     if(ea_treated_lbl.get_body_part() != "")
     {
 	ea_treated_count.clear();
-	ea_treated_count.add_text(0, libdar::deci(stats.get_ea_treated()).human());
+	ea_treated_count.add_text(0, counter_html("ea_treated", val["ea_treated"]));
     }
     if(byte_amount_lbl.get_body_part() != "")
     {
 	byte_amount_count.clear();
-	byte_amount_count.add_text(0, libdar::deci(stats.get_byte_amount()).human());
+	byte_amount_count.add_text(0, counter_html("byte_amount", val["byte_amount"]));
     }
     if(total_lbl.get_body_part() != "")
     {
 	total_count.clear();
-	total_count.add_text(0, libdar::deci(stats.total()).human());
+	total_count.add_text(0, counter_html("total", val["total"]));
     }
 }
+
+string html_statistics::counter_html(const string & name, const string & value) const
+{
+    if(id_prefix.empty())
+	return value;
+    else
+	return "<span id=\"" + id_prefix + "-" + name + "\">" + value + "</span>";
+}
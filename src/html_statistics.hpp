@@ -33,6 +33,8 @@ extern "C"
 
     // C++ system header files
 #include <string>
+#include <memory>
+#include <map>
 #include <dar/libdar.hpp>
 
 
@@ -69,7 +71,20 @@ public:
     void set_total_label(const std::string & label) { total_lbl.clear(); total_lbl.add_text(0, label); unbuild(); };
 
 	/// the address of the object to be updated by libdar
-    libdar::statistics *get_libdar_statistics() { return & stats; };
+    libdar::statistics *get_libdar_statistics() { return stats.get(); };
+
+	/// the object updated by libdar, for other threads to read it concurrently
+    std::shared_ptr<libdar::statistics> get_shared_statistics() { return stats; };
+
+	/// set the prefix of the HTML id given to the counters
+
+	/// \note a counter is identified by the prefix, a dash and the counter name used by
+	/// read_counters(), for the browser to update it in place. An empty prefix (the default)
+	/// gives no id to the counters
+    void set_counter_id_prefix(const std::string & prefix) { id_prefix = prefix; };
+
+	/// provides the human readable value of the libdar counters by counter name
+    static void read_counters(const libdar::statistics & stats, std::map<std::string, std::string> & counters);
 
 
 protected:
@@ -85,7 +100,8 @@ protected:
 
 
 private:
-    libdar::statistics stats;
+    std::shared_ptr<libdar::statistics> stats;
+    std::string id_prefix;
 
     html_table *table;
 
@@ -119,6 +135,9 @@ private:
 
 	/// update html filed from libdar "stats" data structure
     void update_html_counters();
+
+	/// the html code of a counter value
+    std::string counter_html(const std::string & name, const std::string & value) const;
 };
 
 #endif
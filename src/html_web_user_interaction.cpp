@@ -68,12 +68,16 @@ html_web_user_interaction::html_web_user_interaction(unsigned int x_warn_size):
     force_close("Immediately stop libdar", force_end_libdar),
     finish("Close", close_libdar_screen),
     ignore_event(false),
-    managed_thread(nullptr)
+    managed_thread(nullptr),
+    rendered_seq(0)
 {
     lib_data.reset(new (nothrow) web_user_interaction(x_warn_size));
     if(!lib_data)
 	throw exception_memory();
 
+    feed = progress_feed::create(lib_data, stats.get_shared_statistics());
+    stats.set_counter_id_prefix(feed->get_id());
+
 	// status fields
 
     h_pause.add_choice("undefined", "please answer yes or no");
@@ -92,6 +96,7 @@ html_web_user_interaction::html_web_user_interaction(unsigned int x_warn_size):
     h_gtstr_fs.adopt(&h_get_string);
     h_form.adopt(&h_gtstr_fs);
     h_global.adopt(&h_logs);
+    h_global.adopt(&full_log);
     h_global.adopt(&h_form);
     h_global.adopt(&stats);
     h_global.adopt(&ask_close);
@@ -150,6 +155,7 @@ html_web_user_interaction::~html_web_user_interaction()
 		    // no exception propagation (destructor context)
 	    }
 	}
+	feed->close();
     }
     catch(...)
     {
@@ -184,10 +190,13 @@ void html_web_user_interaction::run_and_control_thread(libthreadar::thread* arg)
 	throw WEBDAR_BUG;
     }
 
+    lib_data->start_spool();
+
     all_threads_pending.lock();
     try
     {
 	managed_thread = arg;
+	feed->set_controlled_thread(arg);
 
 	set_visible(true);
 	if(! get_visible_recursively())
@@ -253,6 +262,41 @@ bool html_web_user_interaction::is_libdar_running() const
     return ret;
 }
 
+string html_web_user_interaction::get_progress_feed_url() const
+{
+    string ret;
+
+    bind_feed_to_session();
+	// when all event streams are taken the page polls
+	// the status snapshot instead (get_progress_status_url())
+    if(progress_feed::get_enabled()
+       && progress_feed::stream_available()
+       && is_libdar_running())
+	ret = feed->get_url(rendered_seq);
+
+    return ret;
+}
+
+string html_web_user_interaction::get_progress_status_url() const
+{
+    string ret;
+
+    bind_feed_to_session();
+    if(is_libdar_running())
+	ret = feed->get_status_url(rendered_seq);
+
+    return ret;
+}
+
+void html_web_user_interaction::bind_feed_to_session() const
+{
+    chemin path = get_path();
+
+	// the first member of the path is the session ID (see session::set_session_id())
+    if(!path.empty())
+	feed->set_session_ID(path.front());
+}
+
 string html_web_user_interaction::inherited_get_body_part(const chemin & path,
 							  const request & req)
 {
@@ -464,6 +508,8 @@ void html_web_user_interaction::set_mode(mode_type m)
 	ask_close.set_visible(true);
 	force_close.set_visible(false);
 	finish.set_visible(false);
+	full_log.set_visible(false);
+	full_log.set_spool(nullptr);
 	set_visible(true);
 	was_interrupted = false;
 	check_clean_status();
@@ -485,6 +531,8 @@ void html_web_user_interaction::set_mode(mode_type m)
 	ask_close.set_visible(false);
 	force_close.set_visible(false);
 	finish.set_visible(true);
+	full_log.set_spool(lib_data->get_spool());
+	full_log.set_visible(true);
 	if(!autohide || (was_interrupted && hide_unless_interrupted))
 	{
 	    act(dont_refresh);
@@ -517,11 +565,15 @@ void html_web_user_interaction::update_html_from_libdar_status()
     ignore_event = true; // we're about to change our own component which may trigger events, we ignore them here
     try
     {
-	list<string> logs = lib_data->get_warnings();
+	list<string> logs = lib_data->get_warnings(rendered_seq);
 	string msg;
 	bool echo;
 
+	    // the id lets the browser append the messages received from the progress feed
+
 	h_warnings.clear();
+	h_warnings.add_text(0, "<div id=\"" + feed->get_id() + "-log\" data-lines=\""
+			    + webdar_tools_convert_to_string(lib_data->get_warning_list_size()) + "\">");
 	for(list<string>::iterator it = logs.begin();
 	    it != logs.end();
 	    ++it)
@@ -529,6 +581,13 @@ void html_web_user_interaction::update_html_from_libdar_status()
 	    h_warnings.add_text(0, *it);
 	    h_warnings.add_nl();
 	}
+	h_warnings.add_text(0, "</div>");
+	if(lib_data->get_dropped_messages() > 0)
+	{
+	    h_warnings.add_text(0, "[" + webdar_tools_convert_to_string(lib_data->get_dropped_messages())
+				+ " message(s) from libdar could not be recorded]");
+	    h_warnings.add_nl();
+	}
 
 	if(lib_data->pending_pause(msg))
 	{
@@ -591,6 +650,7 @@ void html_web_user_interaction::update_controlled_thread_status()
 
 		all_threads_pending.broadcast(); // awaking all thread waiting this thread to end
 		managed_thread = nullptr;
+		feed->set_controlled_thread(nullptr);
 		if(real_exception)
 		    was_interrupted = true;
 		set_mode(finished);
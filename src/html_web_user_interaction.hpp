@@ -47,7 +47,9 @@ extern "C"
 #include "html_text.hpp"
 #include "html_button.hpp"
 #include "html_statistics.hpp"
+#include "html_log_viewer.hpp"
 #include "web_user_interaction.hpp"
+#include "progress_feed.hpp"
 
 
     /// body_builder component, providing an html interface to libdar::user_interaction
@@ -62,6 +64,9 @@ extern "C"
 	|+-h_logs----------------------------------+|
 	|| h_warnings (libdar messages/warnings    ||
 	|+-----------------------------------------+|
+	|+-----------------------------------------+|
+	|| full_log (once libdar has finished)     ||
+	|+-----------------------------------------+|
 	|+-h_form----------------------------------+|
 	||+-h_inter-------------------------------+||
 	||| h_inter_text (question from libdar)   |||
@@ -210,6 +215,22 @@ public:
 	/// whether libdar thread has been aborted (to be checked by the caller upon libdar_has_finished event)
     bool has_libdar_been_aborted() const { return was_interrupted; };
 
+	/// the URL of the event stream reporting the progression of the running libdar thread
+
+	/// \return an empty string if no thread is running, if event streams are disabled or
+	/// if the max number of streams is reached, in which case the page has to poll or be refreshed
+	/// \note the URL is only valid after the component has been rendered
+    std::string get_progress_feed_url() const;
+
+	/// the URL of the JSON progression snapshot of the running libdar thread
+
+	/// \return an empty string if no thread is running, the page then has nothing to poll
+	/// \note used in place of get_progress_feed_url() when event streams are disabled or all taken
+    std::string get_progress_status_url() const;
+
+	/// the prefix of the HTML id of the components updated by the event stream or the status polls
+    const std::string & get_progress_feed_id() const { return feed->get_id(); };
+
 
 protected:
 	/// inherited from body_builder, called by the webdar thread
@@ -254,6 +275,8 @@ private:
     bool ignore_event;      ///< if true the on_event() method does not take any action
 
     libthreadar::thread* managed_thread; // the thread object we manage (or nullptr if none is managed)
+    std::shared_ptr<progress_feed> feed;  ///< publishes libdar progression to other threads
+    unsigned int rendered_seq;            ///< sequence number of the last libdar message rendered
     mutable libthreadar::condition all_threads_pending;
 
 	// body_builder fields
@@ -265,6 +288,7 @@ private:
     html_form h_form;             ///< html_form for the previous/above html fields
     html_text h_warnings;         ///< shows the list of warnings/message from libdar
     html_form_fieldset h_logs;    ///< wraps the h_warnings
+    html_log_viewer full_log;     ///< shows all the messages of the job once it has finished
     html_form_fieldset h_global;  ///< wraps the whole output from libdar (before stats ans buttons)
 
     html_statistics stats;        ///< holds a libdar::statistics for progressive report of libdar operations on archives
@@ -274,6 +298,9 @@ private:
     html_button finish;           ///< button that shows to let the user read last logs before closing
 
     void adjust_visibility();
+
+	/// record in the feed the session this object is displayed in, for conversation to check the feed reader
+    void bind_feed_to_session() const;
     void check_libdata() { if(!lib_data) throw WEBDAR_BUG; };
     void set_mode(mode_type m);
     void update_html_from_libdar_status();
@@ -0,0 +1,1025 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+}
+
+    // C++ system header files
+#include <algorithm>
+
+    // webdar headers
+#include "webdar_tools.hpp"
+#include "tokens.hpp"
+#include "request.hpp"
+
+    //
+#include "http2_mux.hpp"
+
+using namespace std;
+
+    /// what the client sends first on the connection (RFC 9113 paragraph 3.4)
+#define H2_PREFACE "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+#define H2_PREFACE_SIZE 24
+
+    /// frame types
+#define H2_DATA 0x0
+#define H2_HEADERS 0x1
+#define H2_PRIORITY 0x2
+#define H2_RST_STREAM 0x3
+#define H2_SETTINGS 0x4
+#define H2_PUSH_PROMISE 0x5
+#define H2_PING 0x6
+#define H2_GOAWAY 0x7
+#define H2_WINDOW_UPDATE 0x8
+#define H2_CONTINUATION 0x9
+
+    /// frame flags
+#define H2_FLAG_END_STREAM 0x1
+#define H2_FLAG_ACK 0x1
+#define H2_FLAG_END_HEADERS 0x4
+#define H2_FLAG_PADDED 0x8
+#define H2_FLAG_PRIORITY 0x20
+
+    /// error codes
+#define H2_NO_ERROR 0x0
+#define H2_PROTOCOL_ERROR 0x1
+#define H2_FLOW_CONTROL_ERROR 0x3
+#define H2_STREAM_CLOSED 0x5
+#define H2_FRAME_SIZE_ERROR 0x6
+#define H2_REFUSED_STREAM 0x7
+#define H2_COMPRESSION_ERROR 0x9
+#define H2_ENHANCE_YOUR_CALM 0xb
+
+    /// settings
+#define H2_SETTINGS_HEADER_TABLE_SIZE 0x1
+#define H2_SETTINGS_ENABLE_PUSH 0x2
+#define H2_SETTINGS_MAX_CONCURRENT_STREAMS 0x3
+#define H2_SETTINGS_INITIAL_WINDOW_SIZE 0x4
+#define H2_SETTINGS_MAX_FRAME_SIZE 0x5
+#define H2_SETTINGS_MAX_HEADER_LIST_SIZE 0x6
+
+    /// size of a frame header
+#define H2_FRAME_HEADER 9
+
+    /// max frame payload size, we keep the default for what we receive
+#define H2_MAX_FRAME 16384
+
+    /// max frame payload size allowed by the protocol
+#define H2_MAX_FRAME_LIMIT 16777215
+
+    /// initial flow control window size defined by the protocol
+#define H2_DEFAULT_WINDOW 65535
+
+    /// max flow control window size
+#define H2_MAX_WINDOW 0x7FFFFFFF
+
+    /// flow control window we give to the peer for each stream and for the connection
+#define H2_WINDOW (1 << 20)
+
+    /// max number of streams the peer can open concurrently
+#define H2_MAX_STREAMS 100
+
+    /// max amount of request bodies held on a connection, in number of max stream body sizes
+#define H2_BUFFERED_BODIES 4
+
+    /// max size of a header block (HEADERS and CONTINUATION frames)
+#define H2_MAX_HEADER_BLOCK (256*1024)
+
+    /// max size of a decoded header list when the request header size is not limited
+#define H2_MAX_HEADER_LIST (1024*1024)
+
+    /// pseudo-header fields a request may have besides its header fields (RFC 9113 paragraph 8.3.1)
+#define H2_PSEUDO_HEADERS 4
+
+static uint32_t read_uint32(const char *ptr);
+static void write_uint32(uint32_t val, char *ptr);
+static string to_lower(const string & val);
+static bool is_connection_specific(const string & name);
+static bool is_valid_field(const hpack::field & f);
+
+http2_mux::http2_mux(proto_connexion & conn, const shared_ptr<central_report> & log):
+    source(conn),
+    rep(log),
+    preface_received(false),
+    last_stream(0),
+    continuation(0),
+    send_window(H2_DEFAULT_WINDOW),
+    peer_initial_window(H2_DEFAULT_WINDOW),
+    recv_window(H2_WINDOW),
+    owed(0),
+    buffered(0),
+    peer_max_frame(H2_MAX_FRAME),
+    goaway_sent(false),
+    goaway_received(false)
+{
+    char settings[18];
+    char increment[4];
+
+    if(!log)
+	throw WEBDAR_BUG;
+
+	// a body is held in memory here, whatever its type
+    max_stream_body = max(request::get_max_body_size(), request::get_multipart_memory_limit());
+
+	// the header limits of the request class (-H option) apply to the decoded header
+	// list, before the request is translated and parsed with these limits again
+    max_header_list = request::get_max_header_size();
+    if(max_header_list == 0)
+	max_header_list = H2_MAX_HEADER_LIST;
+    max_header_fields = request::get_max_header_count();
+    if(max_header_fields > 0)
+	max_header_fields += H2_PSEUDO_HEADERS;
+
+	// our connection preface
+
+    settings[0] = 0;
+    settings[1] = H2_SETTINGS_MAX_CONCURRENT_STREAMS;
+    write_uint32(H2_MAX_STREAMS, settings + 2);
+    settings[6] = 0;
+    settings[7] = H2_SETTINGS_INITIAL_WINDOW_SIZE;
+    write_uint32(H2_WINDOW, settings + 8);
+    settings[12] = 0;
+    settings[13] = H2_SETTINGS_MAX_HEADER_LIST_SIZE;
+    write_uint32(max_header_list, settings + 14);
+    send_frame(H2_SETTINGS, 0, 0, settings, sizeof(settings));
+
+	// the connection window can only be changed by a WINDOW_UPDATE frame
+
+    write_uint32(H2_WINDOW - H2_DEFAULT_WINDOW, increment);
+    send_frame(H2_WINDOW_UPDATE, 0, 0, increment, sizeof(increment));
+}
+
+bool http2_mux::request_available()
+{
+    do
+    {
+	while(process_frame())
+	    ;
+    }
+    while(ready.empty() && fill(false));
+
+    return !ready.empty();
+}
+
+void http2_mux::wait_for_request()
+{
+    while(ready.empty())
+    {
+	if(goaway_received && streams.empty())
+	    throw exception_range("peer has closed the HTTP/2 connection");
+
+	if(!process_frame())
+	    (void)fill(true);
+    }
+}
+
+uint32_t http2_mux::pop_request(string & text)
+{
+    uint32_t ret;
+    map<uint32_t, stream>::iterator it;
+
+    if(ready.empty())
+	throw WEBDAR_BUG;
+
+    ret = ready.front();
+    ready.pop_front();
+
+    it = streams.find(ret);
+    if(it == streams.end() || it->second.state != complete)
+	throw WEBDAR_BUG;
+
+    it->second.state = answering;
+    text.swap(it->second.body);
+    it->second.body.clear();
+    release_body(it->second);
+
+    return ret;
+}
+
+void http2_mux::send_answer(uint32_t stream_id, const answer & ans)
+{
+    size_t size = ans.get_body_size();
+
+    if(streams.find(stream_id) == streams.end())
+	return; // reset by the peer meanwhile
+
+    encode_header(ans, size == 0, stream_id);
+    if(size == 0)
+    {
+	close_stream(stream_id);
+	return;
+    }
+
+    if(ans.has_file_body())
+    {
+	char buffer[H2_MAX_FRAME];
+	int fd = ans.get_file_body()->get_fd();
+	off_t offset = 0;
+	ssize_t lu;
+
+	while(size > 0 && streams.find(stream_id) != streams.end())
+	{
+	    lu = pread(fd, buffer, size < sizeof(buffer) ? size : sizeof(buffer), offset);
+	    if(lu < 0)
+	    {
+		if(errno == EINTR)
+		    continue;
+		throw exception_system("Error met while reading file to send: ", errno);
+	    }
+	    if(lu == 0)
+		throw exception_range("file to send is shorter than expected");
+	    offset += lu;
+	    size -= lu;
+	    send_data(stream_id, buffer, lu, size == 0);
+	}
+    }
+    else
+	send_data(stream_id, ans.get_body().c_str(), size, true);
+}
+
+void http2_mux::send_header(uint32_t stream_id, const answer & ans)
+{
+    if(streams.find(stream_id) == streams.end())
+	return; // reset by the peer meanwhile
+
+    encode_header(ans, false, stream_id);
+}
+
+void http2_mux::send_data(uint32_t stream_id, const char *data, size_t size, bool end_stream)
+{
+    map<uint32_t, stream>::iterator it;
+    size_t allowed;
+    unsigned char flags;
+
+    if(size == 0 && !end_stream)
+	return;
+
+    while(true)
+    {
+	it = streams.find(stream_id);
+	if(it == streams.end())
+	    return; // reset by the peer meanwhile
+
+	allowed = size;
+	if(allowed > peer_max_frame)
+	    allowed = peer_max_frame;
+	if((int64_t)allowed > send_window)
+	    allowed = send_window > 0 ? send_window : 0;
+	if((int64_t)allowed > it->second.send_window)
+	    allowed = it->second.send_window > 0 ? it->second.send_window : 0;
+
+	if(allowed == 0 && size > 0)
+	{
+		// waiting for the peer to give more room
+		// with WINDOW_UPDATE or SETTINGS frames
+	    if(!process_frame())
+		(void)fill(true);
+	    continue;
+	}
+
+	flags = end_stream && allowed == size ? H2_FLAG_END_STREAM : 0;
+	send_frame(H2_DATA, flags, stream_id, data, allowed);
+	send_window -= allowed;
+	it->second.send_window -= allowed;
+	data += allowed;
+	size -= allowed;
+
+	if(flags != 0)
+	    close_stream(stream_id);
+	if(size == 0)
+	    return;
+    }
+}
+
+void http2_mux::shutdown()
+{
+    char payload[8];
+
+    if(goaway_sent)
+	return;
+
+    goaway_sent = true;
+    write_uint32(last_stream, payload);
+    write_uint32(H2_NO_ERROR, payload + 4);
+    send_frame(H2_GOAWAY, 0, 0, payload, sizeof(payload));
+}
+
+bool http2_mux::fill(bool blocking)
+{
+    char buffer[H2_MAX_FRAME];
+    unsigned int lu;
+
+    try
+    {
+	lu = source.read(buffer, sizeof(buffer), blocking);
+    }
+    catch(exception_range & e)
+    {
+	if(blocking)
+	    throw;
+	return false; // no data available
+    }
+
+    inbuf.append(buffer, lu);
+    return true;
+}
+
+bool http2_mux::process_frame()
+{
+    uint32_t length;
+    unsigned char type;
+    unsigned char flags;
+    uint32_t id;
+    string payload;
+
+    if(!preface_received)
+    {
+	if(inbuf.size() < H2_PREFACE_SIZE)
+	    return false;
+	if(inbuf.compare(0, H2_PREFACE_SIZE, H2_PREFACE) != 0)
+	    connection_error(H2_PROTOCOL_ERROR, "invalid connection preface");
+	inbuf.erase(0, H2_PREFACE_SIZE);
+	preface_received = true;
+	return true;
+    }
+
+    if(inbuf.size() < H2_FRAME_HEADER)
+	return false;
+
+    length = read_uint32(inbuf.c_str()) >> 8;
+    if(length > H2_MAX_FRAME)
+	connection_error(H2_FRAME_SIZE_ERROR, "frame larger than allowed");
+    if(inbuf.size() < H2_FRAME_HEADER + length)
+	return false;
+
+    type = inbuf[3];
+    flags = inbuf[4];
+    id = read_uint32(inbuf.c_str() + 5) & 0x7FFFFFFF;
+    payload.assign(inbuf, H2_FRAME_HEADER, length);
+    inbuf.erase(0, H2_FRAME_HEADER + length);
+
+    if(continuation != 0 && (type != H2_CONTINUATION || id != continuation))
+	connection_error(H2_PROTOCOL_ERROR, "CONTINUATION frame expected");
+
+    switch(type)
+    {
+    case H2_DATA:
+	process_data(id, flags, payload);
+	break;
+    case H2_HEADERS:
+	process_headers(id, flags, payload);
+	break;
+    case H2_PRIORITY:
+	if(id == 0)
+	    connection_error(H2_PROTOCOL_ERROR, "PRIORITY frame on stream zero");
+	break; // all streams are served in the order they complete
+    case H2_RST_STREAM:
+	if(id == 0)
+	    connection_error(H2_PROTOCOL_ERROR, "RST_STREAM frame on stream zero");
+	if(length != 4)
+	    connection_error(H2_FRAME_SIZE_ERROR, "invalid RST_STREAM frame size");
+	close_stream(id);
+	break;
+    case H2_SETTINGS:
+	process_settings(id, flags, payload);
+	break;
+    case H2_PUSH_PROMISE:
+	connection_error(H2_PROTOCOL_ERROR, "PUSH_PROMISE frame sent by a client");
+	break;
+    case H2_PING:
+	if(id != 0)
+	    connection_error(H2_PROTOCOL_ERROR, "PING frame on a stream");
+	if(length != 8)
+	    connection_error(H2_FRAME_SIZE_ERROR, "invalid PING frame size");
+	if((flags & H2_FLAG_ACK) == 0)
+	    send_frame(H2_PING, H2_FLAG_ACK, 0, payload.c_str(), payload.size());
+	break;
+    case H2_GOAWAY:
+	if(id != 0)
+	    connection_error(H2_PROTOCOL_ERROR, "GOAWAY frame on a stream");
+	goaway_received = true;
+	break;
+    case H2_WINDOW_UPDATE:
+	process_window_update(id, payload);
+	break;
+    case H2_CONTINUATION:
+	if(continuation == 0)
+	    connection_error(H2_PROTOCOL_ERROR, "unexpected CONTINUATION frame");
+	process_continuation(id, flags, payload);
+	break;
+    default:
+	break; // unknown frame types must be ignored
+    }
+
+    return true;
+}
+
+void http2_mux::process_data(uint32_t id, unsigned char flags, const string & payload)
+{
+    map<uint32_t, stream>::iterator it;
+    string::size_type begin = 0;
+    string::size_type end = payload.size();
+    char increment[4];
+
+    if(id == 0)
+	connection_error(H2_PROTOCOL_ERROR, "DATA frame on stream zero");
+
+    if((flags & H2_FLAG_PADDED) != 0)
+    {
+	if(end == 0 || (unsigned char)(payload[0]) >= end)
+	    connection_error(H2_PROTOCOL_ERROR, "invalid padding in DATA frame");
+	begin = 1;
+	end -= (unsigned char)(payload[0]);
+    }
+
+	// the whole payload counts for flow control (RFC 9113 paragraph 6.9), the
+	// data is either dropped or held under the limits checked below, which
+	// bound the memory used and let the connection window be refilled at once
+
+    recv_window -= (int64_t)(payload.size());
+    if(recv_window < 0)
+	connection_error(H2_FLOW_CONTROL_ERROR, "DATA frame exceeding the connection window");
+    owed += payload.size();
+    give_back_window();
+
+    it = streams.find(id);
+    if(it == streams.end() || it->second.state != receiving_body)
+    {
+	if(id > last_stream)
+	    connection_error(H2_PROTOCOL_ERROR, "DATA frame on an idle stream");
+	if(it != streams.end())
+	    reset_stream(id, H2_STREAM_CLOSED);
+	    // else the stream is closed, frames sent before our RST_STREAM
+	    // was received have to be ignored (RFC 9113 paragraph 5.4.2)
+	return;
+    }
+
+    it->second.recv_window -= (int64_t)(payload.size());
+    if(it->second.recv_window < 0)
+    {
+	reset_stream(id, H2_FLOW_CONTROL_ERROR);
+	return;
+    }
+
+    if(it->second.body.size() + (end - begin) > max_stream_body
+       || buffered + (end - begin) > max_stream_body * H2_BUFFERED_BODIES)
+    {
+	refuse_body(id);
+	return;
+    }
+
+    it->second.body.append(payload, begin, end - begin);
+    it->second.held += end - begin;
+    buffered += end - begin;
+
+    if((flags & H2_FLAG_END_STREAM) != 0)
+	stream_complete(id);
+    else if(!payload.empty())
+    {
+	    // the body is bounded by max_stream_body, the stream window can be refilled
+	write_uint32(payload.size(), increment);
+	send_frame(H2_WINDOW_UPDATE, 0, id, increment, sizeof(increment));
+	it->second.recv_window += payload.size();
+    }
+}
+
+void http2_mux::process_headers(uint32_t id, unsigned char flags, const string & payload)
+{
+    map<uint32_t, stream>::iterator it;
+    string::size_type begin = 0;
+    string::size_type end = payload.size();
+
+    if(id == 0)
+	connection_error(H2_PROTOCOL_ERROR, "HEADERS frame on stream zero");
+
+    if((flags & H2_FLAG_PADDED) != 0)
+    {
+	if(end == 0 || (unsigned char)(payload[0]) >= end)
+	    connection_error(H2_PROTOCOL_ERROR, "invalid padding in HEADERS frame");
+	begin = 1;
+	end -= (unsigned char)(payload[0]);
+    }
+
+    if((flags & H2_FLAG_PRIORITY) != 0)
+    {
+	if(end - begin < 5)
+	    connection_error(H2_FRAME_SIZE_ERROR, "invalid HEADERS frame size");
+	begin += 5; // stream dependency and weight are ignored
+    }
+
+    it = streams.find(id);
+    if(it != streams.end())
+    {
+	    // trailer fields ending the request body
+	if(it->second.state != receiving_body || (flags & H2_FLAG_END_STREAM) == 0)
+	    connection_error(H2_PROTOCOL_ERROR, "unexpected HEADERS frame");
+	it->second.state = receiving_header;
+	it->second.end_stream = true;
+	it->second.block.assign(payload, begin, end - begin);
+    }
+    else
+    {
+	stream st;
+
+	if((id & 1) == 0 || id <= last_stream)
+	    connection_error(H2_PROTOCOL_ERROR, "invalid stream identifier");
+	last_stream = id;
+
+	st.state = receiving_header;
+	st.end_stream = (flags & H2_FLAG_END_STREAM) != 0;
+	st.block.assign(payload, begin, end - begin);
+	st.held = 0;
+	st.send_window = peer_initial_window;
+	st.recv_window = H2_WINDOW;
+	streams[id] = st;
+    }
+
+    if((flags & H2_FLAG_END_HEADERS) != 0)
+	header_block_complete(id);
+    else
+	continuation = id;
+}
+
+void http2_mux::process_continuation(uint32_t id, unsigned char flags, const string & payload)
+{
+    map<uint32_t, stream>::iterator it = streams.find(id);
+
+    if(it == streams.end())
+	throw WEBDAR_BUG;
+
+    it->second.block += payload;
+    if(it->second.block.size() > H2_MAX_HEADER_BLOCK)
+	connection_error(H2_ENHANCE_YOUR_CALM, "header block too large");
+
+    if((flags & H2_FLAG_END_HEADERS) != 0)
+    {
+	continuation = 0;
+	header_block_complete(id);
+    }
+}
+
+void http2_mux::process_settings(uint32_t id, unsigned char flags, const string & payload)
+{
+    if(id != 0)
+	connection_error(H2_PROTOCOL_ERROR, "SETTINGS frame on a stream");
+
+    if((flags & H2_FLAG_ACK) != 0)
+    {
+	if(!payload.empty())
+	    connection_error(H2_FRAME_SIZE_ERROR, "SETTINGS acknowledgment with a payload");
+	return;
+    }
+
+    if(payload.size() % 6 != 0)
+	connection_error(H2_FRAME_SIZE_ERROR, "invalid SETTINGS frame size");
+
+    for(string::size_type pos = 0; pos < payload.size(); pos += 6)
+    {
+	unsigned int ident = ((unsigned char)(payload[pos]) << 8) | (unsigned char)(payload[pos + 1]);
+	uint32_t value = read_uint32(payload.c_str() + pos + 2);
+
+	switch(ident)
+	{
+	case H2_SETTINGS_HEADER_TABLE_SIZE:
+	    compression.set_encoder_table_size(value);
+	    break;
+	case H2_SETTINGS_ENABLE_PUSH:
+	    if(value > 1)
+		connection_error(H2_PROTOCOL_ERROR, "invalid SETTINGS_ENABLE_PUSH value");
+	    break; // we never push
+	case H2_SETTINGS_INITIAL_WINDOW_SIZE:
+	    if(value > H2_MAX_WINDOW)
+		connection_error(H2_FLOW_CONTROL_ERROR, "invalid SETTINGS_INITIAL_WINDOW_SIZE value");
+	    for(map<uint32_t, stream>::iterator it = streams.begin(); it != streams.end(); ++it)
+		it->second.send_window += (int64_t)(value) - peer_initial_window;
+	    peer_initial_window = value;
+	    break;
+	case H2_SETTINGS_MAX_FRAME_SIZE:
+	    if(value < H2_MAX_FRAME || value > H2_MAX_FRAME_LIMIT)
+		connection_error(H2_PROTOCOL_ERROR, "invalid SETTINGS_MAX_FRAME_SIZE value");
+	    peer_max_frame = value;
+	    break;
+	default:
+	    break; // other and unknown settings are ignored
+	}
+    }
+
+    send_frame(H2_SETTINGS, H2_FLAG_ACK, 0, nullptr, 0);
+}
+
+void http2_mux::process_window_update(uint32_t id, const string & payload)
+{
+    uint32_t increment;
+
+    if(payload.size() != 4)
+	connection_error(H2_FRAME_SIZE_ERROR, "invalid WINDOW_UPDATE frame size");
+
+    increment = read_uint32(payload.c_str()) & 0x7FFFFFFF;
+
+    if(id == 0)
+    {
+	if(increment == 0)
+	    connection_error(H2_PROTOCOL_ERROR, "null WINDOW_UPDATE increment");
+	send_window += increment;
+	if(send_window > H2_MAX_WINDOW)
+	    connection_error(H2_FLOW_CONTROL_ERROR, "connection window too large");
+    }
+    else
+    {
+	map<uint32_t, stream>::iterator it = streams.find(id);
+
+	if(it == streams.end())
+	    return; // stream already closed
+
+	if(increment == 0)
+	    reset_stream(id, H2_PROTOCOL_ERROR);
+	else
+	{
+	    it->second.send_window += increment;
+	    if(it->second.send_window > H2_MAX_WINDOW)
+		reset_stream(id, H2_FLOW_CONTROL_ERROR);
+	}
+    }
+}
+
+void http2_mux::header_block_complete(uint32_t id)
+{
+    map<uint32_t, stream>::iterator it = streams.find(id);
+    vector<hpack::field> fields;
+
+    if(it == streams.end())
+	throw WEBDAR_BUG;
+
+	// the block must be decoded even if the stream is refused,
+	// for the dynamic table to stay in sync with the peer's
+
+    try
+    {
+	compression.decode(it->second.block, fields, max_header_list, max_header_fields);
+    }
+    catch(exception_range & e)
+    {
+	connection_error(H2_COMPRESSION_ERROR, e.get_message());
+    }
+    catch(exception_input & e)
+    {
+	    // decoding stopped, the dynamic table is no more in sync with the peer's
+	connection_error(H2_ENHANCE_YOUR_CALM, e.get_message());
+    }
+    it->second.block.clear();
+
+    if(it->second.fields.empty())
+    {
+	it->second.fields.swap(fields);
+	if(goaway_sent || streams.size() > H2_MAX_STREAMS)
+	{
+	    reset_stream(id, H2_REFUSED_STREAM);
+	    return;
+	}
+	if(it->second.end_stream)
+	    stream_complete(id);
+	else
+	    it->second.state = receiving_body;
+    }
+    else
+	stream_complete(id); // trailer fields are ignored
+}
+
+void http2_mux::refuse_body(uint32_t id)
+{
+    answer ans;
+
+	// the request is answered before it is complete, then the peer is
+	// asked to stop sending its body without error (RFC 9113 paragraph 8.1)
+
+    ans.set_status(STATUS_CODE_REQUEST_ENTITY_TOO_LARGE);
+    ans.set_reason("Request body too large");
+    encode_header(ans, true, id);
+    reset_stream(id, H2_NO_ERROR);
+}
+
+void http2_mux::release_body(stream & st)
+{
+    buffered -= st.held;
+    st.held = 0;
+}
+
+void http2_mux::give_back_window()
+{
+    char increment[4];
+
+	// gathering the credit of several frames saves WINDOW_UPDATE frames
+
+    if(owed < H2_MAX_FRAME)
+	return;
+
+    write_uint32(owed, increment);
+    send_frame(H2_WINDOW_UPDATE, 0, 0, increment, sizeof(increment));
+    recv_window += owed;
+    owed = 0;
+}
+
+void http2_mux::stream_complete(uint32_t id)
+{
+    map<uint32_t, stream>::iterator it = streams.find(id);
+
+    if(it == streams.end())
+	throw WEBDAR_BUG;
+
+    if(!translate(it->second))
+    {
+	reset_stream(id, H2_PROTOCOL_ERROR);
+	return;
+    }
+
+    it->second.state = complete;
+    ready.push_back(id);
+}
+
+bool http2_mux::translate(stream & st)
+{
+    string method;
+    string path;
+    string authority;
+    string header;
+    string cookie;
+    string text;
+    bool regular = false;
+    bool host = false;
+
+    for(vector<hpack::field>::const_iterator it = st.fields.begin(); it != st.fields.end(); ++it)
+    {
+	if(!is_valid_field(*it))
+	    return false;
+
+	if(it->first[0] == ':')
+	{
+	    if(regular)
+		return false; // pseudo-header fields must come first
+	    if(it->first == ":method")
+		method = it->second;
+	    else if(it->first == ":path")
+		path = it->second;
+	    else if(it->first == ":authority")
+		authority = it->second;
+	    else if(it->first != ":scheme")
+		return false;
+	}
+	else
+	{
+	    regular = true;
+	    if(is_connection_specific(it->first))
+		return false;
+	    else if(it->first == "cookie")
+	    {
+		    // the browser may split the cookies in several fields (RFC 9113 paragraph 8.2.3)
+		if(!cookie.empty())
+		    cookie += "; ";
+		cookie += it->second;
+	    }
+	    else if(it->first == "te"
+		    || it->first == "expect"
+		    || it->first == "content-length")
+		continue; // the body has already been received as a whole
+	    else
+	    {
+		if(it->first == "host")
+		    host = true;
+		header += it->first + ": " + it->second + "\r\n";
+	    }
+	}
+    }
+
+    if(method.empty()
+       || path.empty()
+       || method.find(' ') != string::npos
+       || path.find(' ') != string::npos)
+	return false;
+
+    text.reserve(method.size() + path.size() + authority.size() + header.size() + cookie.size() + st.body.size() + 80);
+    text = method + " " + path + " HTTP/1.1\r\n";
+    if(!host && !authority.empty())
+	text += string("host: ") + authority + "\r\n";
+    text += header;
+    if(!cookie.empty())
+	text += string("cookie: ") + cookie + "\r\n";
+    if(!st.body.empty() || method == "POST" || method == "PUT")
+	text += string("content-length: ") + webdar_tools_convert_to_string(st.body.size()) + "\r\n";
+    text += "\r\n";
+    text += st.body;
+
+    st.body.swap(text);
+    st.fields.clear();
+
+    return true;
+}
+
+void http2_mux::encode_header(const answer & ans, bool end_stream, uint32_t stream_id)
+{
+    vector<hpack::field> fields;
+    string key, val;
+    string block;
+    string::size_type pos = 0;
+    bool first = true;
+
+    fields.push_back(hpack::field(":status", webdar_tools_convert_to_string(ans.get_status_code())));
+
+    ans.reset_read_next_attribute();
+    while(ans.read_next_attribute(key, val))
+    {
+	key = to_lower(key);
+	if(!is_connection_specific(key))
+	    fields.push_back(hpack::field(key, val));
+    }
+
+    compression.encode(fields, block);
+
+	// the header block is sent in frames that must not be
+	// interleaved with other frames of the connection
+
+    do
+    {
+	string::size_type chunk = block.size() - pos;
+	unsigned char flags = 0;
+
+	if(chunk > peer_max_frame)
+	    chunk = peer_max_frame;
+	if(pos + chunk == block.size())
+	    flags |= H2_FLAG_END_HEADERS;
+	if(first && end_stream)
+	    flags |= H2_FLAG_END_STREAM;
+
+	send_frame(first ? H2_HEADERS : H2_CONTINUATION, flags, stream_id, block.c_str() + pos, chunk);
+	pos += chunk;
+	first = false;
+    }
+    while(pos < block.size());
+}
+
+void http2_mux::send_frame(unsigned char type, unsigned char flags, uint32_t stream_id, const char *payload, size_t size)
+{
+    char head[H2_FRAME_HEADER];
+    struct iovec vec[2];
+
+    if(size > H2_MAX_FRAME_LIMIT)
+	throw WEBDAR_BUG;
+
+    write_uint32(size << 8, head);
+    head[3] = type;
+    head[4] = flags;
+    write_uint32(stream_id, head + 5);
+
+    vec[0].iov_base = (void *)(head);
+    vec[0].iov_len = sizeof(head);
+    vec[1].iov_base = (void *)(payload);
+    vec[1].iov_len = size;
+    source.write_vector(vec, 2);
+}
+
+void http2_mux::reset_stream(uint32_t stream_id, uint32_t error_code)
+{
+    char code[4];
+
+    if(rep->is_reported(debug))
+	rep->report(debug, string("resetting HTTP/2 stream ")
+		    + webdar_tools_convert_to_string(stream_id)
+		    + " with error code "
+		    + webdar_tools_convert_to_string(error_code));
+
+    write_uint32(error_code, code);
+    send_frame(H2_RST_STREAM, 0, stream_id, code, sizeof(code));
+    close_stream(stream_id);
+}
+
+void http2_mux::connection_error(uint32_t error_code, const string & message)
+{
+    if(!goaway_sent)
+    {
+	char payload[8];
+
+	goaway_sent = true;
+	write_uint32(last_stream, payload);
+	write_uint32(error_code, payload + 4);
+	try
+	{
+	    send_frame(H2_GOAWAY, 0, 0, payload, sizeof(payload));
+	}
+	catch(exception_bug & e)
+	{
+	    throw;
+	}
+	catch(exception_base & e)
+	{
+		// the connection is to be closed anyway
+	}
+    }
+
+    throw exception_range(string("HTTP/2 protocol error: ") + message);
+}
+
+void http2_mux::close_stream(uint32_t stream_id)
+{
+    deque<uint32_t>::iterator it = find(ready.begin(), ready.end(), stream_id);
+    map<uint32_t, stream>::iterator st = streams.find(stream_id);
+
+    if(it != ready.end())
+	ready.erase(it);
+    if(st != streams.end())
+    {
+	release_body(st->second);
+	streams.erase(st);
+    }
+}
+
+static uint32_t read_uint32(const char *ptr)
+{
+    const unsigned char *p = (const unsigned char *)(ptr);
+
+    return ((uint32_t)(p[0]) << 24) | ((uint32_t)(p[1]) << 16) | ((uint32_t)(p[2]) << 8) | (uint32_t)(p[3]);
+}
+
+static void write_uint32(uint32_t val, char *ptr)
+{
+    ptr[0] = (val >> 24) & 0xFF;
+    ptr[1] = (val >> 16) & 0xFF;
+    ptr[2] = (val >> 8) & 0xFF;
+    ptr[3] = val & 0xFF;
+}
+
+static string to_lower(const string & val)
+{
+    string ret = val;
+
+    for(string::iterator it = ret.begin(); it != ret.end(); ++it)
+	if(*it >= 'A' && *it <= 'Z')
+	    *it += 'a' - 'A';
+
+    return ret;
+}
+
+static bool is_connection_specific(const string & name)
+{
+	// these fields are not used in HTTP/2 (RFC 9113 paragraph 8.2.2)
+    return name == "connection"
+	|| name == "keep-alive"
+	|| name == "proxy-connection"
+	|| name == "transfer-encoding"
+	|| name == "upgrade";
+}
+
+static bool is_valid_field(const hpack::field & f)
+{
+	// checking field names and values cannot break the
+	// HTTP/1.1 syntax the request is translated to
+
+    if(f.first.empty())
+	return false;
+
+    for(string::size_type i = 0; i < f.first.size(); ++i)
+    {
+	char c = f.first[i];
+
+	if(c <= ' ' || c == 0x7F || (c >= 'A' && c <= 'Z') || (c == ':' && i > 0))
+	    return false;
+    }
+
+    for(string::const_iterator it = f.second.begin(); it != f.second.end(); ++it)
+	if(*it == '\0' || *it == '\r' || *it == '\n')
+	    return false;
+
+    return true;
+}
@@ -0,0 +1,187 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef HTTP2_MUX_HPP
+#define HTTP2_MUX_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+#if HAVE_STDINT_H
+#include <stdint.h>
+#endif
+}
+
+    // C++ system header files
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <memory>
+
+    // webdar headers
+#include "exceptions.hpp"
+#include "proto_connexion.hpp"
+#include "central_report.hpp"
+#include "answer.hpp"
+#include "hpack.hpp"
+
+    /// HTTP/2 framing layer of a connection (RFC 9113)
+
+    /// the streams opened by the browser on the connection are received
+    /// concurrently, but handled in sequence by the thread owning this object:
+    /// each completed request is queued and translated in HTTP/1.1 syntax
+    /// so the request class can parse it, the answers are sent back as
+    /// HEADERS and DATA frames on the stream of the request. While an answer
+    /// is sent, the frames received meanwhile are processed, which includes
+    /// the flow control updates and the requests of the other streams.
+    ///
+    /// the request bodies are held in memory until their request is handed to the
+    /// caller: a stream's body must stay under the memory a request may use over
+    /// HTTP/1.1 (see request::get_max_body_size() and request::get_multipart_memory_limit())
+    /// and all the held bodies under a few times that amount. A body that would exceed
+    /// these limits gets a 413 answer and its stream is reset, the flow control windows
+    /// are refilled as the received data is either held under these limits or dropped.
+    ///
+    /// \note protocol errors on the connection are reported with a GOAWAY frame
+    /// and exception_range is thrown, the connection must then be closed.
+
+class http2_mux
+{
+public:
+	/// constructor
+
+	/// \param[in] conn the connection the ALPN negotiated "h2" on
+	/// \param[in] log where to report protocol errors
+	/// \note conn must survive this object
+    http2_mux(proto_connexion & conn, const std::shared_ptr<central_report> & log);
+
+    http2_mux(const http2_mux & ref) = delete;
+    http2_mux(http2_mux && ref) noexcept = delete;
+    http2_mux & operator = (const http2_mux & ref) = delete;
+    http2_mux & operator = (http2_mux && ref) noexcept = delete;
+    ~http2_mux() = default;
+
+	/// whether a whole request has been received, reading without blocking the frames available
+    bool request_available();
+
+	/// wait until a whole request has been received
+
+	/// \note the time limit is the one set on the connection with proto_connexion::set_read_timeout()
+    void wait_for_request();
+
+	/// provides the next received request translated in HTTP/1.1 syntax
+
+	/// \param[out] text the request line, header and body of the request
+	/// \return the stream ID the answer has to be sent on
+    uint32_t pop_request(std::string & text);
+
+	/// whether the stream is still open on our side (it has not been reset by the peer)
+    bool is_stream_open(uint32_t stream_id) const { return streams.find(stream_id) != streams.end(); };
+
+	/// send a whole answer
+    void send_answer(uint32_t stream_id, const answer & ans);
+
+	/// send the header of an answer which body will be sent by pieces with send_data()
+    void send_header(uint32_t stream_id, const answer & ans);
+
+	/// send a piece of the body of an answer
+
+	/// \param[in] stream_id the stream of the answer
+	/// \param[in] data the body bytes to send
+	/// \param[in] size amount of bytes to send
+	/// \param[in] end_stream whether this is the last piece of the body
+	/// \note if the peer has reset the stream meanwhile, data is silently dropped
+    void send_data(uint32_t stream_id, const char *data, size_t size, bool end_stream);
+
+	/// tell the peer no more stream will be handled on this connection (GOAWAY frame)
+    void shutdown();
+
+private:
+
+	/// state of a stream from the reception point of view
+    enum stream_state
+    {
+	receiving_header,  ///< waiting for CONTINUATION frames
+	receiving_body,    ///< waiting for DATA frames
+	complete,          ///< whole request received, waiting for its turn
+	answering          ///< request handed to the caller, answer being sent
+    };
+
+	/// a stream opened by the peer
+    struct stream
+    {
+	stream_state state;
+	bool end_stream;                  ///< END_STREAM flag received with the HEADERS frame
+	std::string block;                ///< header block fragments
+	std::vector<hpack::field> fields; ///< decoded request header
+	std::string body;                 ///< request body, then whole request once translated
+	uint64_t held;                    ///< amount of body bytes counted in http2_mux::buffered
+	int64_t send_window;              ///< flow control window for sending on this stream
+	int64_t recv_window;              ///< flow control window the peer has for sending on this stream
+    };
+
+    proto_connexion & source;             ///< the underlying connection
+    std::shared_ptr<central_report> rep;  ///< where to log
+    hpack compression;                    ///< header compression context
+    std::map<uint32_t, stream> streams;   ///< the streams not yet closed
+    std::deque<uint32_t> ready;           ///< the completed requests in reception order
+    std::string inbuf;                    ///< received bytes not yet processed
+    bool preface_received;                ///< whether the client connection preface has been read
+    uint32_t last_stream;                 ///< highest stream ID opened by the peer
+    uint32_t continuation;                ///< stream expecting CONTINUATION frames, zero if none
+    int64_t send_window;                  ///< connection flow control window for sending
+    int64_t peer_initial_window;          ///< initial window of the streams for sending
+    int64_t recv_window;                  ///< connection flow control window the peer has for sending
+    uint32_t owed;                        ///< received bytes not yet given back to the connection window
+    uint64_t buffered;                    ///< request body bytes held by the streams
+    uint64_t max_stream_body;             ///< max body size of a stream
+    uint32_t max_header_list;             ///< max size of a decoded header list (SETTINGS_MAX_HEADER_LIST_SIZE)
+    uint32_t max_header_fields;           ///< max number of fields of a decoded header list, zero for no limit
+    uint32_t peer_max_frame;              ///< max frame payload size the peer accepts
+    bool goaway_sent;                     ///< whether we told the peer to stop opening streams
+    bool goaway_received;                 ///< whether the peer will not open new streams
+
+    bool fill(bool blocking);
+    bool process_frame();
+    void process_data(uint32_t id, unsigned char flags, const std::string & payload);
+    void process_headers(uint32_t id, unsigned char flags, const std::string & payload);
+    void process_continuation(uint32_t id, unsigned char flags, const std::string & payload);
+    void process_settings(uint32_t id, unsigned char flags, const std::string & payload);
+    void process_window_update(uint32_t id, const std::string & payload);
+    void header_block_complete(uint32_t id);
+    void refuse_body(uint32_t id);
+    void release_body(stream & st);
+    void give_back_window();
+    void stream_complete(uint32_t id);
+    bool translate(stream & st);
+    void encode_header(const answer & ans, bool end_stream, uint32_t stream_id);
+    void send_frame(unsigned char type, unsigned char flags, uint32_t stream_id, const char *payload, size_t size);
+    void reset_stream(uint32_t stream_id, uint32_t error_code);
+    void connection_error(uint32_t error_code, const std::string & message);
+    void close_stream(uint32_t stream_id);
+};
+
+#endif
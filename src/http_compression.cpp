@@ -0,0 +1,249 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_STRING_H
+#include <string.h>
+#endif
+
+#if HAVE_STRINGS_H
+#include <strings.h>
+#endif
+
+#if HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+}
+
+    // C++ system header files
+#include <vector>
+#include <cstdlib>
+
+    // webdar headers
+#include "exceptions.hpp"
+#include "webdar_tools.hpp"
+
+    //
+#include "http_compression.hpp"
+
+using namespace std;
+
+#if HAVE_ZLIB_H && HAVE_LIBZ
+#define WEBDAR_ZLIB 1
+#endif
+
+    /// default compression level (zlib scale from 1 to 9)
+#define DEFAULT_COMPRESSION_LEVEL 6
+
+    /// answers smaller than this are not worth compressing
+#define DEFAULT_COMPRESSION_THRESHOLD 1024
+
+    /// quality value (q=...) of a list element of a Accept-Encoding header
+static double get_qvalue(const string & params);
+
+#ifdef WEBDAR_ZLIB
+unsigned int http_compression::comp_level = DEFAULT_COMPRESSION_LEVEL;
+#else
+unsigned int http_compression::comp_level = 0;
+#endif
+unsigned int http_compression::comp_threshold = DEFAULT_COMPRESSION_THRESHOLD;
+bool http_compression::comp_dynamic = false;
+
+bool http_compression::is_available()
+{
+#ifdef WEBDAR_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+void http_compression::set_parameters(unsigned int level, unsigned int threshold)
+{
+    if(level > 9)
+	throw exception_range("compression level must be in the range 0 to 9");
+    if(level > 0 && !is_available())
+	throw exception_feature("HTTP compression (webdar has been built without zlib)");
+
+    comp_level = level;
+    comp_threshold = threshold;
+}
+
+http_compression::coding http_compression::negotiate(const string & accept_encoding)
+{
+    vector<string> items;
+    double q_gzip = -1;    // -1 means not listed
+    double q_deflate = -1;
+    double q_any = -1;
+
+    if(!is_available())
+	return identity;
+
+    webdar_tools_split_by(',', accept_encoding, items);
+    for(vector<string>::iterator it = items.begin(); it != items.end(); ++it)
+    {
+	string name, params;
+
+	webdar_tools_split_in_two(';', *it, name, params);
+	name = webdar_tools_remove_leading_spaces(name);
+	while(!name.empty() && (name.back() == ' ' || name.back() == '\t'))
+	    name.pop_back();
+
+	if(strcasecmp(name.c_str(), get_name(gzip)) == 0
+	   || strcasecmp(name.c_str(), "x-gzip") == 0)
+	    q_gzip = get_qvalue(params);
+	else if(strcasecmp(name.c_str(), get_name(deflate)) == 0)
+	    q_deflate = get_qvalue(params);
+	else if(name == "*")
+	    q_any = get_qvalue(params);
+    }
+
+    if(q_gzip < 0)
+	q_gzip = q_any;
+    if(q_deflate < 0)
+	q_deflate = q_any;
+
+	// gzip is preferred to deflate at equal quality, as some
+	// browsers had troubles with the zlib framing of deflate
+
+    if(q_gzip > 0 && q_gzip >= q_deflate)
+	return gzip;
+    if(q_deflate > 0)
+	return deflate;
+    return identity;
+}
+
+bool http_compression::is_compressible(const string & content_type)
+{
+    static const char *types[] =
+    {
+	"text/",
+	"application/json",
+	"application/javascript",
+	"application/xml",
+	"image/svg+xml",
+	nullptr
+    };
+
+    for(const char **ptr = types; *ptr != nullptr; ++ptr)
+    {
+	if(strncasecmp(content_type.c_str(), *ptr, strlen(*ptr)) == 0)
+	    return true;
+    }
+
+    return false;
+}
+
+const char *http_compression::get_name(coding c)
+{
+    switch(c)
+    {
+    case identity:
+	return "identity";
+    case gzip:
+	return "gzip";
+    case deflate:
+	return "deflate";
+    default:
+	throw WEBDAR_BUG;
+    }
+}
+
+string http_compression::compress(const string & data, coding c, unsigned int level)
+{
+#ifdef WEBDAR_ZLIB
+    z_stream strm;
+    string ret;
+    int window_bits;
+    int err;
+
+    switch(c)
+    {
+    case identity:
+	return data;
+    case gzip:
+	window_bits = 15 + 16; // gzip header and trailer (RFC 1952)
+	break;
+    case deflate:
+	window_bits = 15;      // zlib framing (RFC 1950), as expected by HTTP's "deflate"
+	break;
+    default:
+	throw WEBDAR_BUG;
+    }
+
+    if(level < 1 || level > 9)
+	throw WEBDAR_BUG;
+
+    (void)memset(&strm, 0, sizeof(strm));
+    err = deflateInit2(&strm, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY);
+    if(err != Z_OK)
+	throw exception_range(string("failed initializing zlib: ") + (strm.msg != nullptr ? strm.msg : to_string(err)));
+
+    try
+    {
+	ret.resize(deflateBound(&strm, data.size()));
+
+	strm.next_in = (Bytef *)(data.c_str());
+	strm.avail_in = data.size();
+	strm.next_out = (Bytef *)(&ret[0]);
+	strm.avail_out = ret.size();
+
+	err = ::deflate(&strm, Z_FINISH);
+	if(err != Z_STREAM_END)
+	    throw exception_range(string("failed compressing data: ") + (strm.msg != nullptr ? strm.msg : to_string(err)));
+	ret.resize(strm.total_out);
+    }
+    catch(...)
+    {
+	(void)deflateEnd(&strm);
+	throw;
+    }
+    (void)deflateEnd(&strm);
+
+    return ret;
+#else
+    if(c != identity)
+	throw exception_feature("HTTP compression (webdar has been built without zlib)");
+    return data;
+#endif
+}
+
+static double get_qvalue(const string & params)
+{
+    vector<string> split;
+
+    webdar_tools_split_by(';', params, split);
+    for(vector<string>::iterator it = split.begin(); it != split.end(); ++it)
+    {
+	string key, val;
+
+	webdar_tools_split_in_two('=', webdar_tools_remove_leading_spaces(*it), key, val);
+	if(key == "q" || key == "Q")
+	    return atof(val.c_str());
+    }
+
+    return 1.0;
+}
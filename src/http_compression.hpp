@@ -0,0 +1,93 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef HTTP_COMPRESSION_HPP
+#define HTTP_COMPRESSION_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+
+}
+
+    // C++ system header files
+#include <string>
+
+    // webdar headers
+
+
+    /// class http_compression gathers the routines used for HTTP Content-Encoding (RFC 7231 paragraph 3.1.2)
+
+    /// the gzip and deflate content codings are supported when webdar is linked with zlib,
+    /// the identity coding is always available.
+
+class http_compression
+{
+public:
+    enum coding { identity, gzip, deflate };
+
+	/// whether zlib support has been compiled in
+    static bool is_available();
+
+	/// set the compression level (0 disables compression) and the minimum body size to compress
+    static void set_parameters(unsigned int level, unsigned int threshold);
+
+	/// the compression level set by set_parameters() (zero means no compression)
+    static unsigned int get_level() { return comp_level; };
+
+	/// the min body size for an answer to be compressed on the fly
+    static unsigned int get_threshold() { return comp_threshold; };
+
+	/// whether answers built per request (not only static objects) are compressed on the fly
+
+	/// \note this is off by default: compressing pages that carry secrets of an authenticated
+	/// session along with data an attacker can inject exposes them to the BREACH attack
+    static void set_dynamic(bool mode) { comp_dynamic = mode; };
+
+	/// whether set_dynamic() has enabled compressing answers on the fly
+    static bool get_dynamic() { return comp_dynamic; };
+
+	/// choose the content coding to use based on a Accept-Encoding header value
+
+	/// \param[in] accept_encoding the value of the Accept-Encoding header of the request
+	/// \return the preferred coding of the client among those supported
+    static coding negotiate(const std::string & accept_encoding);
+
+	/// whether a Content-Type designates a data type worth compressing
+    static bool is_compressible(const std::string & content_type);
+
+	/// the content-coding token as used in Content-Encoding and Accept-Encoding headers
+    static const char *get_name(coding c);
+
+	/// compress data using the given coding and level
+    static std::string compress(const std::string & data, coding c, unsigned int level);
+
+private:
+    static unsigned int comp_level;
+    static unsigned int comp_threshold;
+    static bool comp_dynamic;
+};
+
+#endif
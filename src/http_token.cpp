@@ -0,0 +1,239 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_STDINT_H
+#include <stdint.h>
+#endif
+}
+
+    // C++ system header files
+
+
+    // webdar headers
+#include "exceptions.hpp"
+
+    //
+#include "http_token.hpp"
+
+using namespace std;
+
+    // number of slots of the perfect hash tables (a power of two)
+#define TOKEN_HEADER_SLOTS 256
+#define TOKEN_METHOD_SLOTS 32
+
+    // max seed tried when looking for a perfect hash function
+#define TOKEN_MAX_SEED 10000
+
+namespace
+{
+	// names indexed by the enum values, the unknown value at index zero has no name
+
+    constexpr const char *method_names[] =
+    {
+	nullptr,
+	"GET",
+	"HEAD",
+	"POST",
+	"PUT",
+	"DELETE",
+	"OPTIONS",
+	"TRACE",
+	"CONNECT",
+	"PATCH"
+    };
+
+    constexpr const char *header_names[] =
+    {
+	nullptr,
+	"Content-Length",
+	"If-Modified-Since",
+	"Last-Modified",
+	"Content-Type",
+	"Date",
+	"Expires",
+	"Server",
+	"WWW-Authenticate",
+	"Authorization",
+	"Set-Cookie",
+	"Cookie",
+	"Location",
+	"Connection",
+	"Transfer-Encoding",
+	"Host",
+	"Expect",
+	"Content-Encoding",
+	"Accept-Encoding",
+	"Vary",
+	"ETag",
+	"If-None-Match",
+	"Cache-Control",
+	"Retry-After",
+	"Accept",
+	"Accept-Language",
+	"User-Agent",
+	"Referer",
+	"Origin",
+	"Upgrade",
+	"Upgrade-Insecure-Requests",
+	"Keep-Alive",
+	"Pragma",
+	"TE",
+	"Content-Disposition",
+	"Sec-Fetch-Site",
+	"Sec-Fetch-Mode",
+	"Sec-Fetch-Dest",
+	"Sec-Fetch-User"
+    };
+
+    constexpr unsigned int method_count = sizeof(method_names) / sizeof(method_names[0]);
+    constexpr unsigned int header_count = sizeof(header_names) / sizeof(header_names[0]);
+
+    static_assert(method_count == http_token::method_patch + 1, "method_names does not match http_token::method");
+    static_assert(header_count == http_token::hdr_sec_fetch_user + 1, "header_names does not match http_token::header");
+
+    constexpr unsigned int name_length(const char *name)
+    {
+	unsigned int ret = 0;
+
+	while(name[ret] != '\0')
+	    ++ret;
+
+	return ret;
+    }
+
+    constexpr unsigned char fold_case(unsigned char c, bool fold)
+    {
+	return fold && c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+    }
+
+	// FNV-1a mixed with a seed, the seed being chosen for the hash to be perfect on the known names
+    constexpr uint32_t token_hash(const char *name, unsigned int len, uint32_t seed, bool fold)
+    {
+	uint32_t ret = 2166136261U ^ (seed * 2654435761U);
+
+	for(unsigned int i = 0; i < len; ++i)
+	{
+	    ret ^= fold_case(name[i], fold);
+	    ret *= 16777619U;
+	}
+
+	return ret ^ (ret >> 15);
+    }
+
+    template <unsigned int SLOTS> struct perfect_table
+    {
+	uint32_t seed;          ///< seed of the hash, zero if no perfect hash was found
+	unsigned char id[SLOTS]; ///< enum value of the name hashed to that slot, zero for none
+    };
+
+    template <unsigned int SLOTS, unsigned int COUNT>
+    constexpr perfect_table<SLOTS> build_table(const char * const (&names)[COUNT], bool fold)
+    {
+	perfect_table<SLOTS> ret = { 0, {} };
+
+	for(uint32_t seed = 1; seed < TOKEN_MAX_SEED; ++seed)
+	{
+	    bool collision = false;
+
+	    for(unsigned int i = 0; i < SLOTS; ++i)
+		ret.id[i] = 0;
+
+	    for(unsigned int i = 1; i < COUNT && !collision; ++i)
+	    {
+		unsigned int slot = token_hash(names[i], name_length(names[i]), seed, fold) % SLOTS;
+
+		if(ret.id[slot] != 0)
+		    collision = true;
+		else
+		    ret.id[slot] = i;
+	    }
+
+	    if(!collision)
+	    {
+		ret.seed = seed;
+		return ret;
+	    }
+	}
+
+	return ret;
+    }
+
+    constexpr perfect_table<TOKEN_METHOD_SLOTS> method_table = build_table<TOKEN_METHOD_SLOTS>(method_names, false);
+    constexpr perfect_table<TOKEN_HEADER_SLOTS> header_table = build_table<TOKEN_HEADER_SLOTS>(header_names, true);
+
+    static_assert(method_table.seed != 0, "no perfect hash found for method names, increase TOKEN_METHOD_SLOTS");
+    static_assert(header_table.seed != 0, "no perfect hash found for header names, increase TOKEN_HEADER_SLOTS");
+
+    bool same_name(const char *known, const string & name, bool fold)
+    {
+	string::const_iterator it = name.begin();
+
+	while(*known != '\0' && it != name.end() && fold_case(*known, fold) == fold_case(*it, fold))
+	{
+	    ++known;
+	    ++it;
+	}
+
+	return *known == '\0' && it == name.end();
+    }
+}
+
+http_token::method http_token::method_of(const string & name)
+{
+    unsigned int id = method_table.id[token_hash(name.data(), name.size(), method_table.seed, false) % TOKEN_METHOD_SLOTS];
+
+    if(id != 0 && same_name(method_names[id], name, false))
+	return method(id);
+    else
+	return method_unknown;
+}
+
+http_token::header http_token::header_of(const string & name)
+{
+    unsigned int id = header_table.id[token_hash(name.data(), name.size(), header_table.seed, true) % TOKEN_HEADER_SLOTS];
+
+    if(id != 0 && same_name(header_names[id], name, true))
+	return header(id);
+    else
+	return hdr_unknown;
+}
+
+const char *http_token::method_name(method val)
+{
+    if(val == method_unknown || val >= method_count)
+	throw WEBDAR_BUG;
+
+    return method_names[val];
+}
+
+const char *http_token::header_name(header val)
+{
+    if(val == hdr_unknown || val >= header_count)
+	throw WEBDAR_BUG;
+
+    return header_names[val];
+}
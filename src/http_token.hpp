@@ -0,0 +1,122 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef HTTP_TOKEN_HPP
+#define HTTP_TOKEN_HPP
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+
+}
+
+    // C++ system header files
+#include <string>
+
+    // webdar headers
+
+
+    /// identifiers of the HTTP methods and header field names webdar knows about
+
+    /// \note a name is turned into its identifier by a single lookup in a perfect hash
+    /// table computed at compilation time, followed by a single name comparison. Comparing
+    /// identifiers afterward avoids comparing strings and building temporary ones.
+    /// \note method names are case sensitive (RFC 7230 paragraph 3.1.1) header
+    /// field names are not (RFC 7230 paragraph 3.2)
+
+class http_token
+{
+public:
+    enum method
+    {
+	method_unknown,          ///< method not in the list below
+	method_get,
+	method_head,
+	method_post,
+	method_put,
+	method_delete,
+	method_options,
+	method_trace,
+	method_connect,
+	method_patch
+    };
+
+    enum header
+    {
+	hdr_unknown,             ///< header not in the list below, to be looked up by name
+	hdr_content_length,
+	hdr_if_modified_since,
+	hdr_last_modified,
+	hdr_content_type,
+	hdr_date,
+	hdr_expires,
+	hdr_server,
+	hdr_www_authenticate,
+	hdr_authorization,
+	hdr_set_cookie,
+	hdr_cookie,
+	hdr_location,
+	hdr_connection,
+	hdr_transfer_encoding,
+	hdr_host,
+	hdr_expect,
+	hdr_content_encoding,
+	hdr_accept_encoding,
+	hdr_vary,
+	hdr_etag,
+	hdr_if_none_match,
+	hdr_cache_control,
+	hdr_retry_after,
+	hdr_accept,
+	hdr_accept_language,
+	hdr_user_agent,
+	hdr_referer,
+	hdr_origin,
+	hdr_upgrade,
+	hdr_upgrade_insecure_requests,
+	hdr_keep_alive,
+	hdr_pragma,
+	hdr_te,
+	hdr_content_disposition,
+	hdr_sec_fetch_site,
+	hdr_sec_fetch_mode,
+	hdr_sec_fetch_dest,
+	hdr_sec_fetch_user
+    };
+
+	/// identifier of a method name, method_unknown if not known
+    static method method_of(const std::string & name);
+
+	/// identifier of a header field name (case insensitive), hdr_unknown if not known
+    static header header_of(const std::string & name);
+
+	/// name of a known method
+    static const char *method_name(method val);
+
+	/// name of a known header field
+    static const char *header_name(header val);
+
+};
+
+#endif
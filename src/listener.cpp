@@ -33,6 +33,10 @@ extern "C"
 #include <sys/socket.h>
 #endif
 
+#if HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
 #if HAVE_NETINET_IP_H
 #include <netinet/ip.h>
 #endif
@@ -60,6 +64,14 @@ extern "C"
 #if HAVE_ERRNO_H
 #include <errno.h>
 #endif
+
+#if HAVE_SCHED_H
+#include <sched.h>
+#endif
+
+#if HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 }
 
     // C++ system header files
@@ -78,6 +90,9 @@ extern "C"
 
 using namespace std;
 
+    /// max time in seconds accept() waits before returning without new connection
+#define LISTENER_TICK 1
+
 static struct in_addr string_to_network_IPv4(const string & ip);
 static struct in6_addr string_to_network_IPv6(const string & ip);
 static string network_IPv4_to_string(const struct in_addr & ip);
@@ -85,9 +100,11 @@ static string network_IPv6_to_string(const struct in6_addr & ip);
 
 listener::listener(const shared_ptr<central_report> & log,
 		   const shared_ptr<const authentication> & auth,
-		   unique_ptr<ssl_context> & ciphering,
+		   const shared_ptr<ssl_context> & ciphering,
 		   shared_ptr<server_pool> & pool,
-		   unsigned int port)
+		   unsigned int port,
+		   bool reuse_port,
+		   int cpu)
 {
 #ifdef LIBTHREADAR_STACK_FEATURE
     set_stack_size(DEFAULT_STACK_SIZE);
@@ -95,7 +112,7 @@ listener::listener(const shared_ptr<central_report> & log,
 
     try
     {
-	init(log, auth, ciphering, pool, "::1", port);
+	init(log, auth, ciphering, pool, "::1", port, reuse_port, cpu);
     }
     catch(exception_bug & e)
     {
@@ -103,27 +120,31 @@ listener::listener(const shared_ptr<central_report> & log,
     }
     catch(...)
     {
-	init(log, auth, ciphering, pool, "127.0.0.1", port);
+	init(log, auth, ciphering, pool, "127.0.0.1", port, reuse_port, cpu);
 	    // no throw;
     }
 }
 
 listener::listener(const shared_ptr<central_report> & log,
 		   const shared_ptr<const authentication> & auth,
-		   unique_ptr<ssl_context> & ciphering,
+		   const shared_ptr<ssl_context> & ciphering,
 		   shared_ptr<server_pool> & pool,
 		   const string & ip,
-		   unsigned int port)
+		   unsigned int port,
+		   bool reuse_port,
+		   int cpu)
 {
-    init(log, auth, ciphering, pool, ip, port);
+    init(log, auth, ciphering, pool, ip, port, reuse_port, cpu);
 }
 
 void listener::init(const shared_ptr<central_report> & log,
 		    const shared_ptr<const authentication> & auth,
-		    unique_ptr<ssl_context> & ciphering,
+		    const shared_ptr<ssl_context> & ciphering,
 		    shared_ptr<server_pool> & pool,
 		    const string & ip,
-		    unsigned int port)
+		    unsigned int port,
+		    bool reuse_port,
+		    int cpu)
 {
     sigset_t sigs;
 
@@ -145,7 +166,8 @@ void listener::init(const shared_ptr<central_report> & log,
     rep = log;
     src = auth;
     sockfd = -1;
-    ssl_ctx = std::move(ciphering);
+    ssl_ctx = ciphering;
+    cpu_index = cpu;
     srv = pool;
 
     try
@@ -166,7 +188,7 @@ void listener::init(const shared_ptr<central_report> & log,
 	    ptr = (struct sockaddr *)(&sin6);
 	    ptr_len = sizeof(sin6);
 
-	    set_sockfd(AF_INET6);
+	    set_sockfd(AF_INET6, reuse_port);
 	    rep->report(debug, "listener object: IPv6 socket datastructure setup done");
 	}
 	catch(exception_bug & e)
@@ -183,7 +205,7 @@ void listener::init(const shared_ptr<central_report> & log,
 	    ptr = (struct sockaddr *)(&sin);
 	    ptr_len = sizeof(sin);
 
-	    set_sockfd(AF_INET);
+	    set_sockfd(AF_INET, reuse_port);
 		// no throw
 	    rep->report(debug, "listener object: IPv4 socket datastructure setup done");
 	}
@@ -207,7 +229,7 @@ void listener::init(const shared_ptr<central_report> & log,
     }
 }
 
-void listener::set_sockfd(int domain)
+void listener::set_sockfd(int domain, bool reuse_port)
 {
     sockfd = socket(domain, SOCK_STREAM, IPPROTO_TCP);
     if(sockfd < 0)
@@ -215,9 +237,45 @@ void listener::set_sockfd(int domain)
     int val = 1;
     if(setsockopt(sockfd, SOL_SOCKET, SO_KEEPALIVE, &val, sizeof(val)) != 0)
 	throw exception_system("Error activating TCP keepalive on socket", errno);
+    if(reuse_port)
+    {
+#ifdef SO_REUSEPORT
+	if(setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &val, sizeof(val)) != 0)
+	    throw exception_system("Error activating port sharing on socket", errno);
+#else
+	throw exception_feature("port sharing between listeners (SO_REUSEPORT)");
+#endif
+    }
+
+	// accept() returns periodically even if no connection comes
+	// for the connections waiting in the server_pool to be expired
+    struct timeval tick;
+    tick.tv_sec = LISTENER_TICK;
+    tick.tv_usec = 0;
+    if(setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tick, sizeof(tick)) != 0)
+	throw exception_system("Error setting timeout on listening socket", errno);
+
     famille = domain;
 }
 
+void listener::pin_on_cpu()
+{
+#if HAVE_SCHED_H && HAVE_PTHREAD_H && defined(CPU_SET)
+    cpu_set_t cpus;
+    int ret;
+
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu_index, &cpus);
+    ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if(ret != 0)
+	rep->report(warning, string("listener object: failed pinning thread on CPU ") + webdar_tools_convert_to_string(cpu_index) + ": " + strerror(ret));
+    else
+	rep->report(debug, string("listener object: thread pinned on CPU ") + webdar_tools_convert_to_string(cpu_index));
+#else
+    rep->report(warning, "listener object: CPU pinning is not supported on this system");
+#endif
+}
+
 void listener::inherited_run()
 {
     int ret = 0;
@@ -229,9 +287,13 @@ void listener::inherited_run()
     string ip;
     unsigned int port;
     unique_ptr<proto_connexion> con;
+    bool tick = false;
 
     rep->report(debug, "listener object: started in its own thread");
 
+    if(cpu_index >= 0)
+	pin_on_cpu();
+
     switch(famille)
     {
     case AF_INET6:
@@ -251,9 +313,20 @@ void listener::inherited_run()
     while(true)
     {
 	cancellation_checkpoint();
-	rep->report(info, "listener object: waiting for incoming connections on " + l_ip + " port " + l_port);
+	if(!tick)
+	    rep->report(info, "listener object: waiting for incoming connections on " + l_ip + " port " + l_port);
+	tick = false;
 	(void)memset(addr, 0, addrlen);
 	ret = accept(sockfd, addr, &addrlen);
+
+	if(ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+	{
+		// no connection has come during LISTENER_TICK
+	    srv->expire_waiting_connections();
+	    tick = true;
+	    continue;
+	}
+
 	rep->report(debug, "listener object: exiting from accept(), a new connection has come on " + l_ip + " port " + l_port + "?");
 
 	if(ret < 0)
@@ -275,8 +348,6 @@ void listener::inherited_run()
 		rep->report(err, "listener object: exiting from accept(), a new connection has come: NO, sleeping 1s");
 		sleep(1);
 		break;
-	    case EAGAIN:
-		throw WEBDAR_BUG;
 	    case EBADF:
 		throw WEBDAR_BUG;
 	    case EINVAL:
@@ -292,6 +363,17 @@ void listener::inherited_run()
 	}
 
 	rep->report(debug, "listener object: exiting from accept(), a new connection has come: YES");
+
+	    // the accepted socket inherits the timeout of the listening socket
+	struct timeval no_timeout;
+	no_timeout.tv_sec = 0;
+	no_timeout.tv_usec = 0;
+	if(setsockopt(ret, SOL_SOCKET, SO_RCVTIMEO, &no_timeout, sizeof(no_timeout)) != 0)
+	{
+	    rep->report(err, string("listener object: failed resetting the timeout of the new connection: ") + strerror(errno));
+	    close(ret);
+	    continue;
+	}
 	if(addrlen > addrlen_ref) // addr is truncated
 	    throw WEBDAR_BUG;
 
@@ -313,8 +395,11 @@ void listener::inherited_run()
 
 	if(ssl_ctx)
 	{
+	    if(rep->is_reported(debug))
+		rep->report(debug, string("listener object: ") + ssl_ctx->get_session_stats());
 	    rep->report(debug, "listener object: creating a new \"ssl_connexion\" object");
 	    con.reset(new (nothrow) ssl_connexion(ret, ssl_ctx->get_context(), ip, port));
+		// the TLS handshake will be done by the thread serving the connection
 	}
 	else
 	{
@@ -326,12 +411,9 @@ void listener::inherited_run()
 	    throw exception_memory();
 	else
 	{
-	    rep->report(debug, "listener object: creating a server thread to answer requests received from the new connection");
+	    rep->report(debug, "listener object: handing the new connection to a server thread");
 	    if(!srv->run_new_server(src, con))
-	    {
-		rep->report(warning, "failed to create a new server maximum connection reached");
-		con.reset();
-	    }
+		rep->report(warning, "maximum connection reached, new connection refused with a 503 answer");
 	    else
 	    {
 		if(con)
@@ -43,6 +43,10 @@
     /// Upon new proto_connexion, it builds proto_connexion objects
     /// and assign it to a new server object that will
     /// manage incoming request on this proto_connexion accordingly
+    ///
+    /// several listeners can share the same address and port (SO_REUSEPORT),
+    /// the kernel then balances the incoming connections between them, each
+    /// possibly feeding its own server_pool and running on its own CPU.
 
 
 class listener : public libthreadar::thread_signal
@@ -50,16 +54,20 @@ class listener : public libthreadar::thread_signal
 public:
     listener(const std::shared_ptr<central_report> & log,        ///< where to send reports, used but also passed to the generated server objects
 	     const std::shared_ptr<const authentication> & auth, ///< where to request for authentications (passed to generated server objects)
-	     std::unique_ptr<ssl_context> & ciphering,           ///< if emtpy, a connexion object is provided to the generated server objects else a ssl_connexion is passed instead
+	     const std::shared_ptr<ssl_context> & ciphering,     ///< if emtpy, a connexion object is provided to the generated server objects else a ssl_connexion is passed instead
 	     std::shared_ptr<server_pool> & pool,                ///< the server_pool which will create and manage servers objects for us
-	     unsigned int port                                   ///< listen on localhost IPv4 or IPv6
+	     unsigned int port,                                  ///< listen on localhost IPv4 or IPv6
+	     bool reuse_port = false,                            ///< whether other listeners may be bound to the same address and port (SO_REUSEPORT)
+	     int cpu = -1                                        ///< if positive or zero, the CPU the listener thread is pinned on
 	);
     listener(const std::shared_ptr<central_report> & log,        ///< where to send reports, used but also passed to the generated server objects
 	     const std::shared_ptr<const authentication> & auth, ///< where to request for authentications (passed to generated server objects)
-	     std::unique_ptr<ssl_context> & ciphering,           ///< if emtpy, a connexion object is provided to the generated server objects else a ssl_connexion is passed instead
+	     const std::shared_ptr<ssl_context> & ciphering,     ///< if emtpy, a connexion object is provided to the generated server objects else a ssl_connexion is passed instead
 	     std::shared_ptr<server_pool> & pool,                ///< the server_pool which will create and manage servers objects for us
 	     const std::string & ip,                             ///< interface to listen on
-	     unsigned int port                                   ///< port to listen on
+	     unsigned int port,                                  ///< port to listen on
+	     bool reuse_port = false,                            ///< whether other listeners may be bound to the same address and port (SO_REUSEPORT)
+	     int cpu = -1                                        ///< if positive or zero, the CPU the listener thread is pinned on
 	);
     listener(const listener & ref) = delete;
     listener(listener && ref) noexcept = delete;
@@ -82,16 +90,20 @@ private:
     int famille;                               ///< domain familly of the socket
     std::string l_ip;                          ///< listening IP address
     std::string l_port;                        ///< listening port
-    std::unique_ptr<ssl_context> ssl_ctx;      ///< ciphering context
+    std::shared_ptr<ssl_context> ssl_ctx;      ///< ciphering context (shared with the other listeners of the same address)
+    int cpu_index;                             ///< CPU to pin the listener thread on, or -1
     std::shared_ptr<server_pool> srv;          ///< current servers
 
-    void set_sockfd(int domain);
+    void set_sockfd(int domain, bool reuse_port);
     void init(const std::shared_ptr<central_report> & log,
 	      const std::shared_ptr<const authentication> & auth,
-	      std::unique_ptr<ssl_context> & ciphering,
+	      const std::shared_ptr<ssl_context> & ciphering,
 	      std::shared_ptr<server_pool> & pool,
 	      const std::string & ip,
-	      unsigned int port);
+	      unsigned int port,
+	      bool reuse_port,
+	      int cpu);
+    void pin_on_cpu();
 };
 
 
@@ -0,0 +1,312 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#if HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+}
+
+    // C++ system header files
+
+
+    // webdar headers
+#include "exceptions.hpp"
+
+    //
+#include "log_spool.hpp"
+
+    // one line out of SPOOL_INDEX_STEP has its offset recorded in memory
+#define SPOOL_INDEX_STEP 64
+    // size of the blocks read from the spool file
+#define SPOOL_READ_BLOCK 65536
+    // max amount of data a call to grep() scans
+#define SPOOL_GREP_MAX_BYTES (64*1024*1024)
+
+using namespace std;
+
+log_spool::log_spool():
+    size(0),
+    lines(0),
+    lost(0),
+    broken(false)
+{
+    const char *tmpdir = getenv("TMPDIR");
+    string dir = tmpdir != nullptr && *tmpdir != '\0' ? tmpdir : "/tmp";
+    string pattern;
+    vector<char> name;
+
+    pattern = dir + "/webdar-log-XXXXXX";
+    name.assign(pattern.begin(), pattern.end());
+    name.push_back('\0');
+
+    fd = mkstemp(&name[0]);
+    if(fd < 0)
+	throw exception_system(string("Cannot create the log spool file in ") + dir + ": ", errno);
+
+	// the file vanishes once closed
+    (void)unlink(&name[0]);
+    (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    index.push_back(0);
+}
+
+log_spool::~log_spool()
+{
+    if(fd >= 0)
+	close(fd);
+}
+
+void log_spool::append(const string & msg)
+{
+    string data;
+    vector<uint64_t> starts; // offset in data of each line
+
+    starts.push_back(0);
+    for(string::const_iterator it = msg.begin(); it != msg.end(); ++it)
+    {
+	data += *it;
+	if(*it == '\n' && it + 1 != msg.end())
+	    starts.push_back(data.size());
+    }
+    if(data.empty() || data[data.size() - 1] != '\n')
+	data += '\n';
+
+    control.lock();
+    try
+    {
+	const char *ptr = data.c_str();
+	uint64_t remains = data.size();
+	ssize_t wrote;
+
+	while(remains > 0 && !broken)
+	{
+	    wrote = write(fd, ptr, remains);
+	    if(wrote < 0)
+	    {
+		if(errno == EINTR)
+		    continue;
+		break;
+	    }
+	    ptr += wrote;
+	    remains -= wrote;
+	}
+
+	if(remains > 0)
+	{
+	    ++lost;
+		// removing the partially written message for
+		// the file to stay consistent with the index
+	    if(!broken && ptr != data.c_str())
+		broken = ftruncate(fd, size) < 0 || lseek(fd, size, SEEK_SET) < 0;
+	}
+	else
+	{
+	    for(vector<uint64_t>::iterator it = starts.begin(); it != starts.end(); ++it)
+	    {
+		if(lines % SPOOL_INDEX_STEP == 0 && lines > 0)
+		    index.push_back(size + *it);
+		++lines;
+	    }
+	    size += data.size();
+	}
+    }
+    catch(...)
+    {
+	control.unlock();
+	throw;
+    }
+    control.unlock();
+}
+
+uint64_t log_spool::get_num_lines() const
+{
+    uint64_t ret;
+
+    control.lock();
+    ret = lines;
+    control.unlock();
+
+    return ret;
+}
+
+uint64_t log_spool::get_lost() const
+{
+    uint64_t ret;
+
+    control.lock();
+    ret = lost;
+    control.unlock();
+
+    return ret;
+}
+
+void log_spool::read_lines(uint64_t first, unsigned int count, vector<string> & page) const
+{
+    uint64_t offset;
+    uint64_t num;
+    uint64_t end;
+    string buffer;
+    string::size_type start = 0;
+    string line;
+
+    page.clear();
+    locate(first, offset, num, end);
+
+    while(page.size() < count)
+    {
+	if(!cut_line(buffer, start, line))
+	{
+	    if(offset >= end)
+		break;
+	    fill(offset, end, buffer, start);
+	}
+	else
+	{
+	    if(num >= first)
+		page.push_back(line);
+	    ++num;
+	}
+    }
+}
+
+bool log_spool::grep(const string & pattern,
+		     uint64_t & from,
+		     unsigned int max,
+		     vector<match> & found) const
+{
+    uint64_t offset;
+    uint64_t num;
+    uint64_t end;
+    uint64_t scanned = 0;
+    string buffer;
+    string::size_type start = 0;
+    match tmp;
+
+    found.clear();
+    locate(from, offset, num, end);
+
+    while(found.size() < max && scanned < SPOOL_GREP_MAX_BYTES)
+    {
+	if(!cut_line(buffer, start, tmp.line))
+	{
+	    if(offset >= end)
+	    {
+		from = num;
+		return true;
+	    }
+	    fill(offset, end, buffer, start);
+	}
+	else
+	{
+	    if(num >= from)
+	    {
+		scanned += tmp.line.size() + 1;
+		if(tmp.line.find(pattern) != string::npos)
+		{
+		    tmp.num = num;
+		    found.push_back(tmp);
+		}
+	    }
+	    ++num;
+	}
+    }
+
+    from = num;
+    return false;
+}
+
+void log_spool::locate(uint64_t line, uint64_t & offset, uint64_t & num, uint64_t & end) const
+{
+    control.lock();
+    try
+    {
+	uint64_t i = line / SPOOL_INDEX_STEP;
+
+	if(i >= index.size())
+	    i = index.size() - 1;
+	offset = index[i];
+	num = i * SPOOL_INDEX_STEP;
+	end = size;
+    }
+    catch(...)
+    {
+	control.unlock();
+	throw;
+    }
+    control.unlock();
+}
+
+void log_spool::fill(uint64_t & offset, uint64_t end, string & buffer, string::size_type & start) const
+{
+    uint64_t wanted = end - offset < SPOOL_READ_BLOCK ? end - offset : SPOOL_READ_BLOCK;
+    string::size_type used;
+    ssize_t got;
+
+    buffer.erase(0, start);
+    start = 0;
+    used = buffer.size();
+    buffer.resize(used + wanted);
+
+    do
+    {
+	got = pread(fd, &buffer[used], wanted, offset);
+    }
+    while(got < 0 && errno == EINTR);
+
+    if(got < 0)
+	throw exception_system("Cannot read the log spool file: ", errno);
+    if(got == 0)
+	throw WEBDAR_BUG; // the file is shorter than what has been written
+
+    buffer.resize(used + got);
+    offset += got;
+}
+
+bool log_spool::cut_line(string & buffer, string::size_type & start, string & line)
+{
+    string::size_type eol = buffer.find('\n', start);
+
+    if(eol == string::npos)
+	return false;
+
+    line.assign(buffer, start, eol - start);
+    start = eol + 1;
+
+    return true;
+}
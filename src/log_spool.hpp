@@ -0,0 +1,125 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef LOG_SPOOL_HPP
+#define LOG_SPOOL_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+#if HAVE_STDINT_H
+#include <stdint.h>
+#endif
+}
+
+    // C++ system header files
+#include <string>
+#include <vector>
+#include <libthreadar/libthreadar.hpp>
+
+    // webdar headers
+
+
+    /// class log_spool records all the messages of a libdar job in a temporary file
+
+    /// messages are appended as lines to a file created in $TMPDIR (or /tmp) and
+    /// unlinked at once, the file vanishes when the object is destroyed. The offset of
+    /// one line out of SPOOL_INDEX_STEP (see log_spool.cpp) is kept in memory, which lets
+    /// read a page of lines from any line number by reading the file from the closest
+    /// indexed line, the whole log being never held in memory.
+    ///
+    /// \note append() can be called concurrently with the read methods from any thread
+
+class log_spool
+{
+public:
+	/// a line found by grep()
+    struct match
+    {
+	uint64_t num;     ///< line number, starting from zero
+	std::string line; ///< content of the line
+    };
+
+    log_spool();
+    log_spool(const log_spool & ref) = delete;
+    log_spool(log_spool && ref) noexcept = delete;
+    log_spool & operator = (const log_spool & ref) = delete;
+    log_spool & operator = (log_spool && ref) noexcept = delete;
+    ~log_spool();
+
+	/// record a message, a message with line breaks leads to several lines
+
+	/// \note if the spool file cannot be written, the message is lost
+	/// and counted, the libdar thread calling this method is not interrupted
+    void append(const std::string & msg);
+
+	/// number of lines recorded so far
+    uint64_t get_num_lines() const;
+
+	/// number of messages that could not be written to the spool file
+    uint64_t get_lost() const;
+
+	/// read a page of lines
+
+	/// \param[in] first number of the first line to read, starting from zero
+	/// \param[in] count max number of lines to read
+	/// \param[out] page the lines read, less than count at the end of the spool
+    void read_lines(uint64_t first, unsigned int count, std::vector<std::string> & page) const;
+
+	/// look for the lines containing a string
+
+	/// \param[in] pattern the string to look for
+	/// \param[in,out] from number of the line where to start the search, updated to the line
+	/// where to continue the search
+	/// \param[in] max max number of matching lines to return
+	/// \param[out] found the matching lines
+	/// \return true if the end of the spool has been reached
+	/// \note the amount of data read by a call is limited, a call may return
+	/// less than max lines without having reached the end of the spool
+    bool grep(const std::string & pattern,
+	      uint64_t & from,
+	      unsigned int max,
+	      std::vector<match> & found) const;
+
+private:
+    int fd;                        ///< the unlinked spool file
+    mutable libthreadar::mutex control; ///< protects the fields below
+    uint64_t size;                 ///< bytes written to the file
+    uint64_t lines;                ///< lines written to the file
+    uint64_t lost;                 ///< messages that could not be written
+    bool broken;                   ///< the file could not be restored after a write error, nothing more is written
+    std::vector<uint64_t> index;   ///< offset of lines 0, SPOOL_INDEX_STEP, 2*SPOOL_INDEX_STEP...
+
+	/// provides the offset and number of the indexed line closest before the given line, and the size of the file
+    void locate(uint64_t line, uint64_t & offset, uint64_t & num, uint64_t & end) const;
+
+	/// read the next block of the file at the end of buffer, dropping the data before start
+    void fill(uint64_t & offset, uint64_t end, std::string & buffer, std::string::size_type & start) const;
+
+	/// extract the line of buffer beginning at start, false if buffer holds no whole line there
+    static bool cut_line(std::string & buffer, std::string::size_type & start, std::string & line);
+};
+
+#endif
@@ -0,0 +1,72 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_STRING_H
+#include <string.h>
+#endif
+}
+
+    // C++ system header files
+
+
+    // webdar headers
+
+
+    //
+#include "memory_connexion.hpp"
+
+using namespace std;
+
+memory_connexion::memory_connexion(const string & data, const string & peerip, unsigned int peerport):
+    proto_connexion(peerip, peerport),
+    content(data),
+    offset(0)
+{
+}
+
+unsigned int memory_connexion::read_impl(char *a, unsigned int size, bool blocking)
+{
+    string::size_type left = content.size() - offset;
+
+    if(left == 0)
+    {
+	if(blocking)
+	{
+	    set_status(not_connected);
+	    throw exception_range("reached end of data in memory");
+	}
+	else
+	    return 0;
+    }
+
+    if(size > left)
+	size = left;
+    (void)memcpy(a, content.c_str() + offset, size);
+    offset += size;
+
+    return size;
+}
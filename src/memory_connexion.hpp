@@ -0,0 +1,77 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef MEMORY_CONNEXION_HPP
+#define MEMORY_CONNEXION_HPP
+
+#include "my_config.h"
+
+    // C++ system header files
+#include <string>
+
+    // webdar headers
+#include "exceptions.hpp"
+#include "proto_connexion.hpp"
+
+    /// proto_connexion reading from a string held in memory
+
+    /// \note used to let the request class parse the HTTP/2 requests once
+    /// translated in HTTP/1.1 syntax. Written data is discarded.
+
+class memory_connexion : public proto_connexion
+{
+public:
+
+	/// constructor
+
+	/// \param[in] data the bytes to provide for reading
+	/// \param[in] peerip IP of the peer this data came from
+	/// \param[in] peerport port of the peer this data came from
+    memory_connexion(const std::string & data, const std::string & peerip, unsigned int peerport);
+
+	/// forbidding copy constuctor and assignment operator
+    memory_connexion(const memory_connexion & ref) = delete;
+    memory_connexion(memory_connexion && ref) noexcept = delete;
+    memory_connexion & operator = (const memory_connexion & ref) = delete;
+    memory_connexion & operator = (memory_connexion && ref) noexcept = delete;
+
+	/// destructor
+    ~memory_connexion() = default;
+
+	/// inherited from proto_connexion
+    virtual int get_socket() const override { return -1; };
+
+protected:
+
+	/// inherited from proto_connexion
+    virtual void write_impl(const char *a, unsigned int size) override {};
+
+    	/// inherited from proto_connexion
+    virtual unsigned int read_impl(char *a, unsigned int size, bool blocking) override;
+
+private:
+    std::string content;           ///< the data to read
+    std::string::size_type offset; ///< amount of data already read
+};
+
+#endif
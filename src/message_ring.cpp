@@ -0,0 +1,166 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_STRING_H
+#include <string.h>
+#endif
+}
+
+    // C++ system header files
+
+
+    // webdar headers
+#include "exceptions.hpp"
+
+    //
+#include "message_ring.hpp"
+
+    // smallest capacity of a ring
+#define MESSAGE_RING_MIN_CAPACITY 16
+
+using namespace std;
+
+message_ring::message_ring(unsigned int min_capacity):
+    head(0),
+    base(0),
+    dropped(0),
+    overwritten(0)
+{
+    uint64_t capacity = MESSAGE_RING_MIN_CAPACITY;
+
+    while(capacity < min_capacity)
+	capacity <<= 1;
+    mask = capacity - 1;
+
+    slots.reset(new (nothrow) slot[capacity]);
+    if(!slots)
+	throw exception_memory();
+
+    for(uint64_t i = 0; i < capacity; ++i)
+    {
+	slots[i].seq.store(0, memory_order_relaxed);
+	slots[i].len.store(0, memory_order_relaxed);
+    }
+}
+
+void message_ring::push(const string & msg)
+{
+    uint64_t num = head.fetch_add(1, memory_order_relaxed) + 1;
+    slot & sl = slots[num & mask];
+    uint64_t cur = sl.seq.load(memory_order_relaxed);
+    unsigned int len = msg.size() < slot_size ? msg.size() : slot_size;
+
+	// the slot must hold an older message that is not being written
+
+    if((cur & 1) != 0
+       || cur >= 2*num
+       || !sl.seq.compare_exchange_strong(cur, 2*num - 1, memory_order_acquire, memory_order_relaxed))
+    {
+	dropped.fetch_add(1, memory_order_relaxed);
+	return;
+    }
+    atomic_thread_fence(memory_order_release);
+
+    if(cur != 0)
+	overwritten.fetch_add(1, memory_order_relaxed);
+
+    (void)memcpy(sl.text, msg.c_str(), len);
+    sl.len.store(len, memory_order_relaxed);
+    sl.seq.store(2*num, memory_order_release);
+}
+
+list<string> message_ring::read_last(unsigned int count, uint64_t & seq) const
+{
+    list<string> ret;
+    uint64_t to = head.load(memory_order_acquire);
+    uint64_t from = base.load(memory_order_relaxed);
+
+    if(count > mask + 1)
+	count = mask + 1;
+    if(to > count && to - count > from)
+	from = to - count;
+
+    seq = read_range(from, to, ret);
+
+    return ret;
+}
+
+list<string> message_ring::read_since(uint64_t & seq) const
+{
+    list<string> ret;
+    uint64_t to = head.load(memory_order_acquire);
+    uint64_t from = base.load(memory_order_relaxed);
+
+    if(seq > from)
+	from = seq;
+    if(to > mask + 1 && to - (mask + 1) > from)
+	from = to - (mask + 1); // older messages have been overwritten
+
+    seq = read_range(from, to, ret);
+
+    return ret;
+}
+
+uint64_t message_ring::read_range(uint64_t from, uint64_t to, list<string> & out) const
+{
+    uint64_t gap = 0; // first message not readable yet, zero if none
+
+    for(uint64_t num = from + 1; num <= to; ++num)
+    {
+	const slot & sl = slots[num & mask];
+	uint64_t before = sl.seq.load(memory_order_acquire);
+
+	if(before == 2*num)
+	{
+	    unsigned int len = sl.len.load(memory_order_relaxed);
+	    string msg(sl.text, len < slot_size ? len : slot_size);
+
+	    atomic_thread_fence(memory_order_acquire);
+	    if(sl.seq.load(memory_order_relaxed) == before)
+		out.push_back(msg);
+		// else the message has been overwritten while we copied it
+	    gap = 0;
+	}
+	else if(before == 2*num - 1)
+	    return (gap > 0 ? gap : num) - 1;
+	    // message num is still being written, the next read will start from it
+	else if(before < 2*num)
+	{
+		// message num has been dropped or its producer has not
+		// started writing it yet: it is skipped if a later
+		// message has already been written
+	    if(gap == 0)
+		gap = num;
+	}
+	else
+	    gap = 0;
+	    // (before > 2*num) the message has been overwritten,
+	    // and so would have been any older one missing
+    }
+
+    return gap > 0 ? gap - 1 : to;
+}
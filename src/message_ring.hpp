@@ -0,0 +1,124 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef MESSAGE_RING_HPP
+#define MESSAGE_RING_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+#if HAVE_STDINT_H
+#include <stdint.h>
+#endif
+}
+
+    // C++ system header files
+#include <atomic>
+#include <memory>
+#include <string>
+#include <list>
+
+    // webdar headers
+
+    /// lock-free bounded ring of text messages
+
+    /// any number of threads can push() messages concurrently without lock, while
+    /// any number of threads read them: reading does not remove messages, the newest
+    /// message overwrites the oldest one once the ring is full. Slots are allocated
+    /// once at construction time, messages longer than slot_size are truncated.
+    ///
+    /// Each message gets a sequence number, the first message pushed has the number 1.
+    /// Each slot records the sequence number of the message it holds (a seqlock), which
+    /// lets readers detect a message overwritten while they copied it.
+    ///
+    /// \note a producer that would overwrite a slot another producer is still writing
+    /// (the ring has been wrapped meanwhile) drops its message, see get_dropped(). Readers
+    /// skip a message not written yet as soon as a later one has been written.
+
+class message_ring
+{
+public:
+	/// max length of a message
+    static const unsigned int slot_size = 1024;
+
+	/// constructor
+
+	/// \param[in] min_capacity minimum number of messages the ring can hold, the
+	/// real capacity is the next power of two
+    message_ring(unsigned int min_capacity);
+    message_ring(const message_ring & ref) = delete;
+    message_ring(message_ring && ref) noexcept = delete;
+    message_ring & operator = (const message_ring & ref) = delete;
+    message_ring & operator = (message_ring && ref) noexcept = delete;
+    ~message_ring() = default;
+
+	/// add a message (lock-free, can be called concurrently from any thread)
+    void push(const std::string & msg);
+
+	/// provides the last messages
+
+	/// \param[in] count max number of messages to return
+	/// \param[out] seq sequence number of the last message returned (or of the message before the first
+	/// one still being written)
+    std::list<std::string> read_last(unsigned int count, uint64_t & seq) const;
+
+	/// provides the messages pushed after the given one
+
+	/// \param[in,out] seq sequence number of the last message already read, updated as with read_last()
+	/// \note messages overwritten since the previous read are skipped
+    std::list<std::string> read_since(uint64_t & seq) const;
+
+	/// forget the messages pushed so far (sequence numbers keep increasing)
+    void clear() { base.store(head.load()); };
+
+	/// number of messages the ring can hold
+    unsigned int get_capacity() const { return mask + 1; };
+
+	/// number of messages dropped because their slot was still being written
+    uint64_t get_dropped() const { return dropped.load(std::memory_order_relaxed); };
+
+	/// number of messages overwritten by newer ones
+    uint64_t get_overwritten() const { return overwritten.load(std::memory_order_relaxed); };
+
+private:
+    struct slot
+    {
+	std::atomic<uint64_t> seq;     ///< 2*n when holding message n, odd while being written, zero if empty
+	std::atomic<unsigned int> len; ///< length of the message
+	char text[slot_size];          ///< message
+    };
+
+    std::unique_ptr<slot[]> slots;
+    uint64_t mask;                      ///< capacity - 1
+    std::atomic<uint64_t> head;         ///< number of messages pushed so far
+    std::atomic<uint64_t> base;         ///< number of messages pushed when clear() was last called
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> overwritten;
+
+	/// read messages with sequence number in ]from, to] and returns the number of the last one read
+    uint64_t read_range(uint64_t from, uint64_t to, std::list<std::string> & out) const;
+};
+
+#endif
@@ -0,0 +1,145 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+
+}
+
+    // C++ system header files
+#include <vector>
+
+    // webdar headers
+#include "exceptions.hpp"
+#include "tokens.hpp"
+#include "webdar_tools.hpp"
+#include "session.hpp"
+#include "server_pool.hpp"
+
+    //
+#include "metrics.hpp"
+
+using namespace std;
+
+histogram metrics::table[num_kinds][num_phases];
+
+static void add_gauge(string & output, const string & name, const string & help, unsigned int val);
+
+void metrics::record(kind k, phase p, chrono::steady_clock::duration d)
+{
+    if(k >= num_kinds || p >= num_phases)
+	throw WEBDAR_BUG;
+
+    table[k][p].record(chrono::duration_cast<chrono::microseconds>(d).count());
+}
+
+answer metrics::give_answer()
+{
+    answer ret;
+    string body;
+    server_pool::gauges pools = server_pool::get_gauges();
+    vector<session::session_summary> sessions = session::get_summary();
+    unsigned int jobs = 0;
+
+    for(vector<session::session_summary>::iterator it = sessions.begin();
+	it != sessions.end();
+	++it)
+    {
+	if(it->libdar_running)
+	    ++jobs;
+    }
+
+    body += "# HELP webdar_request_duration_seconds Time spent processing requests, by kind of answer and phase\n";
+    body += "# TYPE webdar_request_duration_seconds histogram\n";
+    for(unsigned int k = 0; k < num_kinds; ++k)
+	for(unsigned int p = 0; p < num_phases; ++p)
+	    table[k][p].render(body,
+			       "webdar_request_duration_seconds",
+			       string("kind=\"") + kind_name(kind(k)) + "\",phase=\"" + phase_name(phase(p)) + "\"");
+
+    add_gauge(body, "webdar_servers", "Number of server threads", pools.servers);
+    add_gauge(body, "webdar_servers_idle", "Number of server threads waiting for a connection", pools.idle);
+    add_gauge(body, "webdar_connections_queued", "Number of connections waiting for a busy server", pools.queued);
+    add_gauge(body, "webdar_connections_parked", "Number of connections held by reactors (event driven mode)", pools.parked);
+    add_gauge(body, "webdar_sessions", "Number of sessions", sessions.size());
+    add_gauge(body, "webdar_libdar_jobs", "Number of running libdar jobs", jobs);
+
+    ret.set_status(STATUS_CODE_OK);
+    ret.set_reason("ok");
+    ret.set_attribute(http_token::hdr_content_type, "text/plain; version=0.0.4");
+    ret.set_attribute(http_token::hdr_cache_control, "no-store");
+    ret.add_body(body);
+
+    return ret;
+}
+
+const char *metrics::kind_name(kind k)
+{
+    switch(k)
+    {
+    case kind_static:
+	return "static";
+    case kind_challenge:
+	return "challenge";
+    case kind_choose:
+	return "choose";
+    case kind_session:
+	return "session";
+    case kind_metrics:
+	return "metrics";
+    case kind_feed:
+	return "feed";
+    case kind_status:
+	return "status";
+    case kind_other:
+	return "other";
+    default:
+	throw WEBDAR_BUG;
+    }
+}
+
+const char *metrics::phase_name(phase p)
+{
+    switch(p)
+    {
+    case phase_read:
+	return "read";
+    case phase_acquire:
+	return "acquire";
+    case phase_render:
+	return "render";
+    case phase_write:
+	return "write";
+    default:
+	throw WEBDAR_BUG;
+    }
+}
+
+static void add_gauge(string & output, const string & name, const string & help, unsigned int val)
+{
+    output += "# HELP " + name + " " + help + "\n";
+    output += "# TYPE " + name + " gauge\n";
+    output += name + " " + webdar_tools_convert_to_string(val) + "\n";
+}
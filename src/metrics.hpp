@@ -0,0 +1,90 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+
+}
+
+    // C++ system header files
+#include <chrono>
+
+    // webdar headers
+#include "answer.hpp"
+#include "histogram.hpp"
+
+    /// class metrics gathers request timings and provides them in Prometheus text format
+
+    /// \note the time spent by each request is split in phases (reading the request,
+    /// acquiring the session, building the answer, sending the answer) and recorded
+    /// in histograms depending on the kind of answer. Recording does not lock and can
+    /// be done concurrently from any thread. The histograms are served with a few gauges
+    /// (servers, queued connections, sessions and running libdar jobs) under METRICS_PATH_ID.
+
+class metrics
+{
+public:
+	/// the kind of answer a request received
+    enum kind
+    {
+	kind_static,     ///< static object
+	kind_challenge,  ///< authentication request
+	kind_choose,     ///< session selection page
+	kind_session,    ///< answer from a session
+	kind_metrics,    ///< the metrics themselves
+	kind_feed,       ///< progress feed event stream (only the read phase is recorded)
+	kind_status,     ///< progress status snapshot
+	kind_other,      ///< anything else (disconnected page, errors...)
+	num_kinds
+    };
+
+	/// phases of the processing of a request
+    enum phase
+    {
+	phase_read,      ///< from the first byte received to the whole request parsed
+	phase_acquire,   ///< waiting for the session to be available
+	phase_render,    ///< building the answer (session acquisition excluded)
+	phase_write,     ///< sending the answer
+	num_phases
+    };
+
+	/// record the duration of a phase
+    static void record(kind k, phase p, std::chrono::steady_clock::duration d);
+
+	/// provides the metrics in Prometheus text format as an HTTP answer
+    static answer give_answer();
+
+private:
+    static histogram table[num_kinds][num_phases];
+
+    static const char *kind_name(kind k);
+    static const char *phase_name(phase p);
+};
+
+#endif
@@ -0,0 +1,176 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#if HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+}
+
+    // C++ system header files
+#include <new>
+#include <fstream>
+#include <sstream>
+
+    // webdar headers
+#include "exceptions.hpp"
+#include "webdar_tools.hpp"
+#include "environment.hpp"
+
+    //
+#include "mime_part.hpp"
+
+using namespace std;
+
+mime_part::mime_part():
+    fd(-1),
+    size(0)
+{
+}
+
+mime_part::~mime_part()
+{
+    if(fd >= 0)
+    {
+	(void)close(fd);
+	(void)unlink(filename.c_str());
+    }
+}
+
+void mime_part::add_header(const string & key, const string & value)
+{
+    headers[webdar_tools_to_canonical_case(key)] = value;
+}
+
+bool mime_part::find_header(const string & key, string & value) const
+{
+    map<string, string>::const_iterator it = headers.find(webdar_tools_to_canonical_case(key));
+
+    if(it != headers.end())
+    {
+	value = it->second;
+	return true;
+    }
+    else
+	return false;
+}
+
+void mime_part::append(const char *a, unsigned int amount)
+{
+    if(a == nullptr)
+	throw WEBDAR_BUG;
+
+    if(is_spooled())
+	write_to_file(a, amount);
+    else
+	content.append(a, amount);
+    size += amount;
+}
+
+void mime_part::spool()
+{
+    if(is_spooled())
+	return;
+
+    string model = global_envir.get_value_with_default("TMPDIR", "/tmp") + "/webdar-upload-XXXXXX";
+    unique_ptr<char[]> tmpl(new (nothrow) char[model.size() + 1]);
+
+    if(!tmpl)
+	throw exception_memory();
+    model.copy(tmpl.get(), model.size());
+    tmpl[model.size()] = '\0';
+
+	// the file must not be inherited by child processes
+#if HAVE_MKOSTEMP
+    fd = mkostemp(tmpl.get(), O_CLOEXEC);
+#else
+    fd = mkstemp(tmpl.get());
+#endif
+    if(fd < 0)
+	throw exception_system(string("Cannot create temporary file to store uploaded data using ") + model, errno);
+#if !HAVE_MKOSTEMP
+    (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
+    filename = tmpl.get();
+
+    write_to_file(content.c_str(), content.size());
+    content.clear();
+    content.shrink_to_fit();
+}
+
+unique_ptr<istream> mime_part::get_content() const
+{
+    unique_ptr<istream> ret;
+
+    if(is_spooled())
+    {
+	unique_ptr<ifstream> tmp(new (nothrow) ifstream(filename, ios::in | ios::binary));
+
+	if(!tmp)
+	    throw exception_memory();
+	if(!tmp->is_open())
+	    throw exception_range(string("Cannot reopen temporary file containing uploaded data: ") + filename);
+	ret = std::move(tmp);
+    }
+    else
+    {
+	ret.reset(new (nothrow) istringstream(content));
+	if(!ret)
+	    throw exception_memory();
+    }
+
+    return ret;
+}
+
+void mime_part::write_to_file(const char *a, unsigned int amount)
+{
+    ssize_t wrote;
+
+    while(amount > 0)
+    {
+	wrote = write(fd, a, amount);
+	if(wrote < 0)
+	{
+	    if(errno == EINTR)
+		continue;
+	    throw exception_system(string("Error writing uploaded data to temporary file ") + filename, errno);
+	}
+	a += wrote;
+	amount -= wrote;
+    }
+}
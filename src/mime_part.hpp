@@ -0,0 +1,98 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef MIME_PART_HPP
+#define MIME_PART_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+
+}
+
+    // C++ system header files
+#include <string>
+#include <map>
+#include <memory>
+#include <istream>
+
+    // webdar headers
+
+
+    /// class mime_part holds the headers and the content of a part of a multipart body (RFC 2046)
+
+    /// the content is kept in memory unless spool() is called, in which case it is
+    /// moved to a temporary file, file where any further appended data will go. This
+    /// temporary file is removed when the object is destroyed.
+
+class mime_part
+{
+public:
+    mime_part();
+    mime_part(const mime_part & ref) = delete;
+    mime_part(mime_part && ref) noexcept = delete;
+    mime_part & operator = (const mime_part & ref) = delete;
+    mime_part & operator = (mime_part && ref) noexcept = delete;
+    ~mime_part();
+
+	/// add a header to the part (key is case insensitive)
+    void add_header(const std::string & key, const std::string & value);
+
+	/// lookup for a header of the part
+    bool find_header(const std::string & key, std::string & value) const;
+
+	/// all headers of the part, keys are in canonical case
+    const std::map<std::string, std::string> & get_headers() const { return headers; };
+
+	/// add data at the end of the part's content
+    void append(const char *a, unsigned int size);
+
+	/// move the content to a temporary file, any further appended data will also go there
+    void spool();
+
+	/// whether the content is stored in a temporary file
+    bool is_spooled() const { return fd >= 0; };
+
+	/// amount of memory used by the content
+    unsigned int memory_used() const { return content.size(); };
+
+	/// total size of the content
+    unsigned long long get_size() const { return size; };
+
+	/// provides a stream to read the content from its beginning
+    std::unique_ptr<std::istream> get_content() const;
+
+private:
+    std::map<std::string, std::string> headers; ///< headers of the part
+    std::string content;     ///< content of the part when not spooled
+    std::string filename;    ///< temporary file used when spooled
+    int fd;                  ///< file descriptor of the temporary file, -1 if not spooled
+    unsigned long long size; ///< total size of the content
+
+    void write_to_file(const char *a, unsigned int size);
+
+};
+
+#endif
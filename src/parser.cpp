@@ -25,28 +25,47 @@
 #include "date.hpp"
 #include "parser.hpp"
 #include "tokens.hpp"
+#include "http_compression.hpp"
 
 using namespace std;
 
+unsigned int parser::idle_timeout = DEFAULT_IDLE_TIMEOUT;
 
 parser::parser(unique_ptr<proto_connexion> & input,
-	       const shared_ptr<central_report> & log): req(log)
+	       const shared_ptr<central_report> & log): req(log), rep(log)
 {
-    if(!input)
+    if(!log)
 	throw WEBDAR_BUG;
 
-    if(!log)
+    reset(input);
+}
+
+void parser::reset(unique_ptr<proto_connexion> & input)
+{
+    if(!input)
 	throw WEBDAR_BUG;
 
     if(input->get_status() != proto_connexion::connected)
 	throw exception_range("connection is already closed cannot read from it");
 
+    close();
+    req.clear();
+    protocol_checked = false;
+    h2_stream = 0;
     answered = true;
+    persistent = true;
+    streaming = false;
+    chunked = false;
+    last_syscalls = 0;
+    streamed_status = 0;
+    streamed_size = 0;
     source = std::move(input);
 }
 
 void parser::close()
 {
+    h2_req.reset();
+    h2.reset(); // refers to the proto_connexion, must be destroyed first
     source.reset();
 	// this should invoke the destructor on the pointed to proto_connexion object
 }
@@ -57,6 +76,20 @@ bool parser::get_next_request_uri(uri & url)
 	throw WEBDAR_BUG;
     valid_source();
 
+    if(h2)
+    {
+	if(!h2_req)
+	{
+	    if(!h2->request_available())
+		return false;
+	    load_http2_request();
+	}
+	if(!req.try_reading(*h2_req))
+	    return false; // malformed, will be answered by get_request()
+	url = req.get_uri();
+	return true;
+    }
+
     if(req.try_reading(*source))
     {
 	url = req.get_uri();
@@ -66,6 +99,49 @@ bool parser::get_next_request_uri(uri & url)
 	return false;
 }
 
+void parser::wait_for_request()
+{
+    valid_source();
+    detect_protocol();
+
+	// with HTTP/2 the limit is sliding, it also applies to the
+	// frames awaited while sending answers (flow control)
+    source->set_read_timeout(idle_timeout, bool(h2));
+    try
+    {
+	if(h2)
+	{
+	    if(!h2_req)
+		h2->wait_for_request();
+	}
+	else
+	    (void)source->read_test_first(true);
+    }
+    catch(exception_input & e)
+    {
+	    // idle timeout, nothing to answer as no request has come
+	if(h2)
+	{
+	    try
+	    {
+		h2->shutdown();
+	    }
+	    catch(exception_bug & e)
+	    {
+		throw;
+	    }
+	    catch(exception_base & e)
+	    {
+		    // closing the connection anyway
+	    }
+	}
+	close();
+	throw exception_range("connection closed after idle timeout");
+    }
+    if(!h2)
+	source->set_read_timeout(0, false);
+}
+
 const request & parser::get_request()
 {
     if(!answered)
@@ -76,8 +152,32 @@ const request & parser::get_request()
 
     try
     {
-	req.clear();
-	req.read(*source);
+	    // req has been cleared after the last answer was sent, it
+	    // may already contain the method and URI of this new request
+	    // if get_next_request_uri() has been called meanwhile
+	if(h2)
+	{
+	    if(!h2_req)
+	    {
+		h2->wait_for_request();
+		load_http2_request();
+	    }
+
+	    try
+	    {
+		req.read(*h2_req);
+	    }
+	    catch(exception_range & e)
+	    {
+		    // the stream is complete, the connection can go on, but the
+		    // request is not: the 400 is sent by send_early_error() below
+		if(req.is_complete())
+		    throw WEBDAR_BUG;
+		throw exception_input("Malformed HTTP/2 request", STATUS_CODE_BAD_REQUEST);
+	    }
+	}
+	else
+	    req.read(*source);
     }
     catch(exception_signal & e)
     {
@@ -90,12 +190,15 @@ const request & parser::get_request()
 
 	err.set_status(e.get_error_code());
 	err.set_reason(e.get_message());
-	send_answer(err);
+	if(req.is_complete())
+	    send_answer(err); // the connection can go on
+	else
+	    send_early_error(err); // the rest of the request cannot be told from the next one
 	throw;
     }
     catch(exception_base & e)
     {
-	source.reset();
+	close();
 	throw;
     }
 
@@ -104,6 +207,20 @@ const request & parser::get_request()
     return req;
 }
 
+bool parser::request_header_available()
+{
+    static const char end_of_header[] = "\r\n\r\n";
+
+    if(!answered)
+	throw WEBDAR_BUG;
+    valid_source();
+
+    if(h2)
+	return h2_req || h2->request_available();
+
+    return source->look_ahead_for(end_of_header, sizeof(end_of_header) - 1);
+}
+
 void parser::send_answer(answer & ans)
 {
     if(answered)
@@ -115,9 +232,55 @@ void parser::send_answer(answer & ans)
 	if(!ans.is_valid())
 	    throw WEBDAR_BUG;
 	checks_main(req, ans);
-	ans.write(*source);
+	source->reset_write_syscalls();
+	if(h2)
+	    h2->send_answer(h2_stream, ans);
+	else
+	    ans.write(*source);
+	report_sent(ans.get_status_code(), ans.get_body_size());
+	answer_sent();
+    }
+    catch(exception_bug & e)
+    {
+	throw;
+    }
+    catch(exception_base & e)
+    {
+	close();
 	answered = true;
 	req.clear();
+	    // no throw
+    }
+}
+
+void parser::send_early_error(answer & ans)
+{
+    string val;
+
+    if(answered)
+	throw WEBDAR_BUG;
+    valid_source();
+
+    try
+    {
+	if(!ans.is_valid())
+	    throw WEBDAR_BUG;
+
+	ans.set_version(1, 1);
+	if(!ans.find_attribute(http_token::hdr_date, val))
+	    ans.set_attribute(http_token::hdr_date, date().get_canonical_format());
+	if(!h2)
+	{
+	    persistent = false;
+	    ans.set_attribute(http_token::hdr_connection, VAL_CONNECTION_CLOSE);
+	}
+	source->reset_write_syscalls();
+	if(h2)
+	    h2->send_answer(h2_stream, ans);
+	else
+	    ans.write(*source);
+	report_sent(ans.get_status_code(), ans.get_body_size());
+	answer_sent();
     }
     catch(exception_bug & e)
     {
@@ -125,16 +288,189 @@ void parser::send_answer(answer & ans)
     }
     catch(exception_base & e)
     {
-	source.reset();
+	close();
 	answered = true;
+	req.clear();
 	    // no throw
     }
 }
 
+void parser::send_answer_header(answer & ans)
+{
+    if(answered || streaming)
+	throw WEBDAR_BUG;
+    valid_source();
+
+    try
+    {
+	if(!ans.is_valid())
+	    throw WEBDAR_BUG;
+	checks_main(req, ans);
+	ans.drop_attribute(http_token::hdr_content_length);
+	chunked = !h2 && ans.get_min_version() >= 1;
+	if(chunked)
+	    ans.set_attribute(http_token::hdr_transfer_encoding, VAL_TRANSFER_ENCODING_CHUNKED);
+	else if(!h2)
+	{
+		// without chunked transfer coding, the end of body is
+		// signaled by closing the connection
+	    persistent = false;
+	    ans.set_attribute(http_token::hdr_connection, VAL_CONNECTION_CLOSE);
+	}
+	source->reset_write_syscalls();
+	streamed_status = ans.get_status_code();
+	streamed_size = 0;
+	if(h2)
+	    h2->send_header(h2_stream, ans);
+	else
+	    ans.write_header(*source);
+	streaming = true;
+    }
+    catch(exception_bug & e)
+    {
+	throw;
+    }
+    catch(exception_base & e)
+    {
+	close();
+	answered = true;
+	req.clear();
+	throw;
+    }
+}
+
+void parser::send_body_piece(const string & data)
+{
+    if(!streaming)
+	throw WEBDAR_BUG;
+    valid_source();
+
+    if(data.empty())
+	return; // an empty chunk would end the body
+
+    try
+    {
+	if(h2)
+	    h2->send_data(h2_stream, data.c_str(), data.size(), false);
+	else if(chunked)
+	    answer::write_chunk(*source, data);
+	else
+	{
+	    struct iovec vec;
+
+	    vec.iov_base = (void *)(data.c_str());
+	    vec.iov_len = data.size();
+	    source->write_vector(&vec, 1);
+	}
+	streamed_size += data.size();
+    }
+    catch(exception_bug & e)
+    {
+	throw;
+    }
+    catch(exception_base & e)
+    {
+	close();
+	streaming = false;
+	answered = true;
+	req.clear();
+	throw;
+    }
+}
+
+bool parser::streaming_interrupted()
+{
+    if(!streaming)
+	throw WEBDAR_BUG;
+    valid_source();
+
+    if(!h2)
+	return false;
+
+    try
+    {
+	return !h2->is_stream_open(h2_stream) || h2->request_available();
+    }
+    catch(exception_bug & e)
+    {
+	throw;
+    }
+    catch(exception_base & e)
+    {
+	close();
+	streaming = false;
+	answered = true;
+	req.clear();
+	throw;
+    }
+}
+
+void parser::end_of_body()
+{
+    if(!streaming)
+	throw WEBDAR_BUG;
+    streaming = false;
+
+    try
+    {
+	valid_source();
+	if(h2)
+	    h2->send_data(h2_stream, nullptr, 0, true);
+	else if(chunked)
+	    answer::write_last_chunk(*source);
+	report_sent(streamed_status, streamed_size);
+	answer_sent();
+    }
+    catch(exception_bug & e)
+    {
+	throw;
+    }
+    catch(exception_base & e)
+    {
+	close();
+	answered = true;
+	req.clear();
+	    // no throw
+    }
+}
+
+void parser::report_sent(unsigned int status, size_t body_size)
+{
+    if(!source)
+	throw WEBDAR_BUG;
+
+    last_syscalls = source->get_write_syscalls();
+    if(rep->is_reported(debug))
+	rep->report(debug, string("answer ")
+		    + webdar_tools_convert_to_string(status)
+		    + " to "
+		    + (req.is_complete() ? req.get_method() : string("incomplete request"))
+		    + " sent with a body of "
+		    + webdar_tools_convert_to_string(body_size)
+		    + " byte(s) using "
+		    + webdar_tools_convert_to_string(last_syscalls)
+		    + " system call(s)");
+}
+
+void parser::answer_sent()
+{
+    answered = true;
+    req.clear();
+    h2_req.reset();
+    if(!persistent)
+	close();
+}
+
 void parser::checks_main(const request & req, answer & ans)
 {
     checks_webdar(req, ans);
+    checks_rfc7232(req, ans);
+    checks_compression(req, ans);
     checks_rfc1945(req, ans);
+    if(h2)
+	checks_rfc9113(req, ans);
+    else
+	checks_rfc7230(req, ans);
 }
 
 void parser::checks_webdar(const request & req, answer & ans)
@@ -145,18 +481,20 @@ void parser::checks_webdar(const request & req, answer & ans)
     ans.set_version(req.get_maj_version(), req.get_min_version());
 
 	// adding a Date header if missing
-    if(!ans.find_attribute(HDR_DATE, val))
-	ans.set_attribute(HDR_DATE, date().get_canonical_format());
+    if(!ans.find_attribute(http_token::hdr_date, val))
+	ans.set_attribute(http_token::hdr_date, date().get_canonical_format());
 
-	// adding an Expires header if missing
-    if(!ans.find_attribute(HDR_EXPIRES, val))
-	ans.set_attribute(HDR_EXPIRES, date().get_canonical_format());
+	// adding an Expires header if missing, unless the
+	// answer already states how it may be cached
+    if(!ans.find_attribute(http_token::hdr_expires, val)
+       && !ans.find_attribute(http_token::hdr_cache_control, val))
+	ans.set_attribute(http_token::hdr_expires, date().get_canonical_format());
 
 	// adding a default text/html content type if not specified
-    if(ans.get_body().size() > 0)
+    if(ans.get_body_size() > 0)
     {
-	if(!ans.find_attribute(HDR_CONTENT_TYPE, val))
-	    ans.set_attribute(HDR_CONTENT_TYPE, "text/html");
+	if(!ans.find_attribute(http_token::hdr_content_type, val))
+	    ans.set_attribute(http_token::hdr_content_type, "text/html");
     }
 }
 
@@ -168,19 +506,21 @@ void parser::checks_rfc1945(const request & req, answer & ans)
 
 	// HEAD requests must not be answered with a body
 
-    if(req.get_method() == "HEAD")
+    if(req.get_method_id() == http_token::method_head)
 	ans.drop_body_keep_header();
 
 	// Conditional GET
 
-    if(req.get_method() == "GET" && req.find_attribute(HDR_IF_MODIFIED_SINCE, val))
+    if(req.get_method_id() == http_token::method_get
+       && !req.find_attribute(http_token::hdr_if_none_match, val) // If-None-Match takes precedence (RFC 7232 paragraph 3.3)
+       && req.find_attribute(http_token::hdr_if_modified_since, val))
     {
 	try
 	{
 	    date when = val;
 	    string lastmod;
 
-	    if(ans.find_attribute(HDR_LAST_MODIFIED, lastmod))
+	    if(ans.find_attribute(http_token::hdr_last_modified, lastmod))
 	    {
 		date last = lastmod;
 		if(last <= when && ans.get_status_code() == STATUS_CODE_OK)
@@ -211,8 +551,149 @@ void parser::checks_rfc1945(const request & req, answer & ans)
        || code  == STATUS_CODE_NOT_MODIFIED
        || (code > 99 && code < 200))
     {
-	if(ans.get_body().size() > 0)
+	if(ans.get_body_size() > 0)
 	    throw WEBDAR_BUG;
 	    // these responses must not include a body
     }
 }
+
+void parser::checks_rfc7232(const request & req, answer & ans)
+{
+    string inm;
+    string etag;
+
+	// If-None-Match conditional request (RFC 7232 paragraph 3.2)
+
+    if((req.get_method_id() == http_token::method_get || req.get_method_id() == http_token::method_head)
+       && ans.get_status_code() == STATUS_CODE_OK
+       && req.find_attribute(http_token::hdr_if_none_match, inm)
+       && ans.find_attribute(http_token::hdr_etag, etag)
+       && webdar_tools_etag_match(inm, etag))
+    {
+	ans.set_status(STATUS_CODE_NOT_MODIFIED);
+	ans.set_reason("not modified");
+	ans.add_body("");
+	    // the client already has this representation
+    }
+}
+
+void parser::checks_rfc7230(const request & req, answer & ans)
+{
+    unsigned int code = ans.get_status_code();
+
+	// persistent connections (RFC 7230 paragraph 6.3)
+
+    persistent = req.is_persistent();
+    if(!persistent)
+	ans.set_attribute(http_token::hdr_connection, VAL_CONNECTION_CLOSE);
+    else
+    {
+	if(req.get_min_version() == 0)
+	    ans.set_attribute(http_token::hdr_connection, VAL_CONNECTION_KEEP_ALIVE);
+	    // HTTP/1.1 connections are persistent by default
+    }
+
+	// message body length (RFC 7230 paragraph 3.3.2). Answers
+	// always carry a Content-Length (see answer::add_body()) except
+	// those that never have a body and must not have this header
+
+    if(code == STATUS_CODE_NO_CONTENT
+       || code == STATUS_CODE_NOT_MODIFIED
+       || (code > 99 && code < 200))
+	ans.drop_attribute(http_token::hdr_content_length);
+}
+
+void parser::checks_rfc9113(const request & req, answer & ans)
+{
+    unsigned int code = ans.get_status_code();
+
+	// connection management headers are not sent by http2_mux,
+	// the connection is persistent and each answer ends its stream
+
+    if(code == STATUS_CODE_NO_CONTENT
+       || code == STATUS_CODE_NOT_MODIFIED
+       || (code > 99 && code < 200))
+	ans.drop_attribute(http_token::hdr_content_length);
+}
+
+void parser::checks_compression(const request & req, answer & ans)
+{
+    string val;
+    shared_ptr<const string> encoded;
+    http_compression::coding coding;
+    bool on_the_fly;
+
+    if(http_compression::get_level() == 0)
+	return; // compression disabled
+
+    if(ans.get_status_code() != STATUS_CODE_OK)
+	return;
+
+    if(ans.has_file_body())
+	return; // sent as is from the file
+
+    if(ans.find_attribute(http_token::hdr_content_encoding, val))
+	return; // body already encoded by the responder
+
+    if(!ans.find_attribute(http_token::hdr_content_type, val)
+       || !http_compression::is_compressible(val))
+	return;
+
+    on_the_fly = http_compression::get_dynamic()
+	&& ans.get_body().size() >= http_compression::get_threshold();
+
+    if(!on_the_fly && !ans.has_encoded_body())
+	return;
+
+	// the answer depends on the Accept-Encoding header of the request
+    ans.add_attribute_member(http_token::hdr_vary, HDR_ACCEPT_ENCODING);
+
+    if(!req.find_attribute(http_token::hdr_accept_encoding, val))
+	return;
+
+    coding = http_compression::negotiate(val);
+    if(coding == http_compression::identity)
+	return;
+
+    if(!ans.find_encoded_body(coding, encoded))
+    {
+	if(!on_the_fly)
+	    return;
+
+	encoded = make_shared<const string>(http_compression::compress(ans.get_body(), coding, http_compression::get_level()));
+	if(encoded->size() >= ans.get_body().size())
+	    return; // not worth
+    }
+
+    ans.add_body(encoded); // this also updates Content-Length
+    ans.set_attribute(http_token::hdr_content_encoding, http_compression::get_name(coding));
+}
+
+void parser::detect_protocol()
+{
+    if(protocol_checked)
+	return;
+    protocol_checked = true;
+
+    if(source->get_application_protocol() == "h2")
+    {
+	h2.reset(new (nothrow) http2_mux(*source, rep));
+	if(!h2)
+	    throw exception_memory();
+	if(rep->is_reported(debug))
+	    rep->report(debug, string("HTTP/2 negotiated with ") + source->get_ip());
+    }
+}
+
+void parser::load_http2_request()
+{
+    string text;
+
+    if(!h2 || h2_req)
+	throw WEBDAR_BUG;
+
+    h2_stream = h2->pop_request(text);
+    h2_req.reset(new (nothrow) memory_connexion(text, source->get_ip(), source->get_port()));
+    if(!h2_req)
+	throw exception_memory();
+}
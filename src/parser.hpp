@@ -35,9 +35,18 @@
 #include "central_report.hpp"
 #include "request.hpp"
 #include "answer.hpp"
+#include "http2_mux.hpp"
+#include "memory_connexion.hpp"
+
+    /// default max time a connection can stay without request (seconds)
+#define DEFAULT_IDLE_TIMEOUT 120
 
     /// parser class is given a connection object and format the incoming byte flow in structured request objects
 
+    /// \note if HTTP/2 has been negotiated with the peer (ALPN), the frames are handled by an
+    /// http2_mux object and the requests of the different streams are provided in sequence,
+    /// each answer being sent back on the stream of its request
+
 class parser
 {
 public:
@@ -60,6 +69,19 @@ public:
 	/// destructor
     ~parser() { close(); };
 
+	/// drop the current connection if any and start over with a new one
+
+	/// \param[in] input is the new proto_connexion to read data from, same
+	/// responsibility transfer as with the constructor
+	/// \note this lets a long-lived server thread reuse the same parser
+	/// object from a TCP connection to the next
+    void reset(std::unique_ptr<proto_connexion> & input);
+
+	/// whether the connection uses HTTP/2
+
+	/// \note only known once wait_for_request() has been called
+    bool is_http2() const { return bool(h2); };
+
 	/// provides visibility on the connection status
     proto_connexion::status get_status() const { if(!source) return proto_connexion::not_connected; return source->get_status(); };
 
@@ -69,24 +91,103 @@ public:
 	/// \return false if not enough data is available to provide the uri
     bool get_next_request_uri(uri & val);
 
+	/// whether a whole request header has been received (without blocking)
+
+	/// \note returns also true if the reception buffer is full
+	/// \note may throw exception_range if the connection has been closed
+    bool request_header_available();
+
+	/// whether some data has been received and not yet read
+    bool has_pending_data() const { return source && source->has_pending_data(); };
+
+	/// provides the file descriptor of the underlying socket
+    int get_socket() const { valid_source(); return source->get_socket(); };
+
+	/// wait until some data of the next request has been received
+
+	/// \note may throw exception_range if the connection has been closed or if
+	/// no data has been received within the idle timeout (see set_idle_timeout())
+    void wait_for_request();
+
 	/// provides the next request
     const request & get_request();
 
-	/// modify the answer to conform to RFC 1945 before sending it
+	/// modify the answer to conform to RFC 1945 and RFC 7230 before sending it
+
+	/// \note the connection is closed once the answer has been sent if the
+	/// request did not ask for a persistent connection
     void send_answer(answer & ans);
 
+	/// send the header of an answer which body will be provided by pieces
+
+	/// \note the body of ans is ignored, the body is then sent calling send_body_piece()
+	/// any number of time, then end_of_body() must be called. For HTTP/1.1 requests the
+	/// chunked transfer coding is used, for HTTP/1.0 the end of the body is signaled by
+	/// closing the connection. With HTTP/2 each piece is sent in DATA frames.
+    void send_answer_header(answer & ans);
+
+	/// send a piece of the body of the answer which header was sent by send_answer_header()
+    void send_body_piece(const std::string & data);
+
+	/// ends the body of the answer which header was sent by send_answer_header()
+    void end_of_body();
+
+	/// whether the answer being streamed should be given up (non blocking call)
+
+	/// \note with HTTP/2 this is the case when the peer has reset the stream or when
+	/// another request waits behind it on the connection. With HTTP/1.x a peer that
+	/// has gone is only detected when send_body_piece() fails
+    bool streaming_interrupted();
+
 	/// closes the current connection
     void close();
 
+	/// number of system calls used to send the last answer
+    unsigned int get_last_write_syscalls() const { return last_syscalls; };
+
+	/// set the max time in seconds a connection can stay without request, zero for no limit
+    static void set_idle_timeout(unsigned int seconds) { idle_timeout = seconds; };
+
+	/// the max time in seconds a connection can stay without request, zero for no limit
+    static unsigned int get_idle_timeout() { return idle_timeout; };
+
 private:
     bool answered;             //< whether last request was answered or not
+    bool persistent;           //< whether the connection is kept after the current answer
+    bool streaming;            //< whether the current answer body is being sent by pieces
+    bool chunked;              //< whether the streamed body uses the chunked transfer coding
     std::unique_ptr<proto_connexion> source; //< the proto_connexion to the client
+    bool protocol_checked;     //< whether the negotiated application protocol has been looked at
+    std::unique_ptr<http2_mux> h2; //< the HTTP/2 framing layer if this protocol is used
+    std::unique_ptr<memory_connexion> h2_req; //< the current HTTP/2 request translated in HTTP/1.1 syntax
+    uint32_t h2_stream;        //< the stream the current HTTP/2 request has been received on
     request req;               //< value of the last request
+    std::shared_ptr<central_report> rep; //< where to log messages
+    unsigned int last_syscalls; //< number of system calls used to send the last answer
+    unsigned int streamed_status; //< status code of the answer being streamed
+    size_t streamed_size;      //< amount of body bytes streamed so far
 
+    static unsigned int idle_timeout; //< max time waiting for the next request (seconds)
+
+    void detect_protocol();
+    void load_http2_request();
     void valid_source() const { if(!source || source->get_status() != proto_connexion::connected) throw exception_range("socket disconnected"); };
+
+	/// send the answer to a request that could not be read entirely
+
+	/// \note the version, method and header of such request are unknown or incomplete,
+	/// the answer is sent as HTTP/1.1 without the checks relying on them and the
+	/// connection is closed afterward (the HTTP/2 stream is just ended)
+    void send_early_error(answer & ans);
     void checks_main(const request & req, answer & ans);
     void checks_webdar(const request & req, answer & ans);
     void checks_rfc1945(const request & req, answer & ans);
+    void checks_rfc7232(const request & req, answer & ans);
+    void checks_compression(const request & req, answer & ans);
+    void checks_rfc7230(const request & req, answer & ans);
+    void checks_rfc9113(const request & req, answer & ans);
+    void report_sent(unsigned int status, size_t body_size);
+    void answer_sent();
 };
 
 
@@ -0,0 +1,356 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+
+}
+
+    // C++ system header files
+
+
+    // webdar headers
+#include "exceptions.hpp"
+#include "tokens.hpp"
+#include "chemin.hpp"
+#include "webdar_tools.hpp"
+#include "html_statistics.hpp"
+#include "jsoner.hpp"
+
+    //
+#include "progress_feed.hpp"
+
+#define FEED_ID_WIDTH 24
+#define DEFAULT_MAX_STREAMS 4
+
+using namespace std;
+
+bool progress_feed::enabled = true;
+unsigned int progress_feed::max_streams = DEFAULT_MAX_STREAMS;
+unsigned int progress_feed::streams = 0;
+libthreadar::mutex progress_feed::lock_feeds;
+map<string, shared_ptr<progress_feed> > progress_feed::feeds;
+
+progress_feed::progress_feed(const shared_ptr<web_user_interaction> & x_ui,
+			     const shared_ptr<libdar::statistics> & x_stats):
+    ui(x_ui),
+    stats(x_stats),
+    managed(nullptr),
+    closed(false)
+{
+    if(!ui || !stats)
+	throw WEBDAR_BUG;
+}
+
+string progress_feed::get_url(unsigned int msg_seq) const
+{
+    chemin ret(FEED_PATH_ID);
+
+    ret += chemin(id);
+    ret += chemin(webdar_tools_convert_to_string(msg_seq));
+
+    return ret.display(false);
+}
+
+string progress_feed::get_status_url(unsigned int msg_seq) const
+{
+    chemin ret(STATUS_PATH_ID);
+
+    ret += chemin(id);
+    ret += chemin(webdar_tools_convert_to_string(msg_seq));
+
+    return ret.display(false);
+}
+
+void progress_feed::set_session_ID(const string & sessid)
+{
+    control.lock();
+    try
+    {
+	session_ID = sessid;
+    }
+    catch(...)
+    {
+	control.unlock();
+	throw;
+    }
+    control.unlock();
+}
+
+string progress_feed::get_session_ID() const
+{
+    string ret;
+
+    control.lock();
+    try
+    {
+	ret = session_ID;
+    }
+    catch(...)
+    {
+	control.unlock();
+	throw;
+    }
+    control.unlock();
+
+    return ret;
+}
+
+void progress_feed::set_controlled_thread(libthreadar::thread* arg)
+{
+    control.lock();
+    managed = arg;
+    control.unlock();
+}
+
+bool progress_feed::next_events(cursor & cur, string & events)
+{
+    list<string> messages;
+    map<string, string> counters;
+
+    events.clear();
+
+    if(must_reload())
+    {
+	events = event("reload", "");
+	return false;
+    }
+
+    html_statistics::read_counters(*stats, counters);
+    for(map<string, string>::iterator it = counters.begin();
+	it != counters.end();
+	++it)
+    {
+	string & last = cur.counters[it->first];
+
+	if(last != it->second)
+	{
+	    events += event("counter", it->first + " " + it->second);
+	    last = it->second;
+	}
+    }
+
+    messages = ui->get_warnings_since(cur.msg_seq);
+    for(list<string>::iterator it = messages.begin();
+	it != messages.end();
+	++it)
+	events += event("message", *it);
+
+    return true;
+}
+
+string progress_feed::status(unsigned int msg_seq)
+{
+    json ret;
+    list<string> messages;
+    map<string, string> counters;
+
+    if(must_reload())
+    {
+	ret["reload"] = true;
+	return ret.dump();
+    }
+
+    ret["reload"] = false;
+
+    html_statistics::read_counters(*stats, counters);
+    ret["counters"] = json::object();
+    for(map<string, string>::iterator it = counters.begin();
+	it != counters.end();
+	++it)
+	ret["counters"][it->first] = it->second;
+
+    messages = ui->get_warnings_since(msg_seq);
+    ret["messages"] = json::array();
+    for(list<string>::iterator it = messages.begin();
+	it != messages.end();
+	++it)
+	ret["messages"].push_back(*it);
+
+    ret["seq"] = msg_seq;
+
+    try
+    {
+	    // libdar messages may hold file names that are not valid UTF-8
+	return ret.dump(-1, ' ', false, json::error_handler_t::replace);
+    }
+    catch(json::exception & e)
+    {
+	throw exception_json("building progress status", e);
+    }
+}
+
+void progress_feed::close()
+{
+    control.lock();
+    closed = true;
+    managed = nullptr;
+    control.unlock();
+
+    lock_feeds.lock();
+    try
+    {
+	feeds.erase(id);
+    }
+    catch(...)
+    {
+	lock_feeds.unlock();
+	throw;
+    }
+    lock_feeds.unlock();
+}
+
+shared_ptr<progress_feed> progress_feed::create(const shared_ptr<web_user_interaction> & x_ui,
+						const shared_ptr<libdar::statistics> & x_stats)
+{
+    shared_ptr<progress_feed> ret(new (nothrow) progress_feed(x_ui, x_stats));
+
+    if(!ret)
+	throw exception_memory();
+
+    lock_feeds.lock();
+    try
+    {
+	do
+	{
+	    ret->id = webdar_tools_generate_random_string(FEED_ID_WIDTH);
+	}
+	while(feeds.find(ret->id) != feeds.end());
+
+	feeds[ret->id] = ret;
+    }
+    catch(...)
+    {
+	lock_feeds.unlock();
+	throw;
+    }
+    lock_feeds.unlock();
+
+    return ret;
+}
+
+shared_ptr<progress_feed> progress_feed::find(const string & id)
+{
+    shared_ptr<progress_feed> ret;
+    map<string, shared_ptr<progress_feed> >::iterator it;
+
+    lock_feeds.lock();
+    try
+    {
+	it = feeds.find(id);
+	if(it != feeds.end())
+	    ret = it->second;
+    }
+    catch(...)
+    {
+	lock_feeds.unlock();
+	throw;
+    }
+    lock_feeds.unlock();
+
+    return ret;
+}
+
+bool progress_feed::stream_available()
+{
+    bool ret;
+
+    lock_feeds.lock();
+    ret = streams < max_streams;
+    lock_feeds.unlock();
+
+    return ret;
+}
+
+bool progress_feed::acquire_stream()
+{
+    bool ret;
+
+    lock_feeds.lock();
+    ret = streams < max_streams;
+    if(ret)
+	++streams;
+    lock_feeds.unlock();
+
+    return ret;
+}
+
+void progress_feed::release_stream()
+{
+    lock_feeds.lock();
+    if(streams == 0)
+    {
+	lock_feeds.unlock();
+	throw WEBDAR_BUG;
+    }
+    --streams;
+    lock_feeds.unlock();
+}
+
+bool progress_feed::must_reload()
+{
+    bool running;
+    bool ended;
+
+    control.lock();
+    try
+    {
+	ended = closed;
+	running = managed != nullptr && managed->is_running();
+    }
+    catch(...)
+    {
+	control.unlock();
+	throw;
+    }
+    control.unlock();
+
+	// the page shows the state of libdar that has changed
+	// and must be rendered again by the session
+
+    return ended || !running || ui->has_libdar_pending();
+}
+
+string progress_feed::event(const string & name, const string & data)
+{
+    string ret = "event: " + name + "\n";
+    string line;
+
+	// a line break in data would end the field, each line
+	// gets its own data field, the browser joins them back
+
+    for(string::const_iterator it = data.begin(); it != data.end(); ++it)
+    {
+	if(*it == '\n')
+	{
+	    ret += "data: " + line + "\n";
+	    line.clear();
+	}
+	else if(*it != '\r')
+	    line += *it;
+    }
+
+    return ret + "data: " + line + "\n\n";
+}
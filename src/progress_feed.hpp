@@ -0,0 +1,173 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef PROGRESS_FEED_HPP
+#define PROGRESS_FEED_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+
+}
+
+    // C++ system header files
+#include <string>
+#include <map>
+#include <memory>
+#include <libthreadar/libthreadar.hpp>
+#include <dar/libdar.hpp>
+
+    // webdar headers
+#include "web_user_interaction.hpp"
+
+    /// class progress_feed publishes the progression of a libdar job as a stream of server-sent events
+
+    /// a progress_feed object is created by an html_web_user_interaction and shares with it
+    /// the web_user_interaction and the libdar::statistics objects libdar updates. Any thread can
+    /// then read the counters and the messages from libdar without acquiring the session, which
+    /// lets a conversation stream them to the browser (text/event-stream) while the session stays
+    /// available to the other requests. The events sent are:
+    /// - "counter" with the counter name and its new value when a counter has changed,
+    /// - "message" for each new message from libdar,
+    /// - "reload" when the page has to be fully refreshed (libdar has ended or asks a question).
+    ///
+    /// feeds are registered in a class table by a random identifier which is part of the URL
+    /// (see get_url()). They stay registered until close() is called. A feed is only given
+    /// to the owner of the session it has been rendered in (see get_session_ID()).
+    ///
+    /// when event streams are disabled (event driven mode, where a stream would hold a worker
+    /// thread as long as libdar runs), the page polls a JSON snapshot of the same information
+    /// instead (see get_status_url() and status()), which still does not acquire the session.
+class progress_feed
+{
+public:
+	/// the position of a stream in the feed
+    struct cursor
+    {
+	unsigned int msg_seq;                        ///< sequence number of the last message sent
+	std::map<std::string, std::string> counters; ///< last counter values sent
+    };
+
+    progress_feed(const progress_feed & ref) = delete;
+    progress_feed(progress_feed && ref) noexcept = delete;
+    progress_feed & operator = (const progress_feed & ref) = delete;
+    progress_feed & operator = (progress_feed && ref) noexcept = delete;
+    ~progress_feed() = default;
+
+	/// the identifier of this feed in the class table
+    const std::string & get_id() const { return id; };
+
+	/// the URL of the event stream
+
+	/// \param[in] msg_seq sequence number of the last libdar message already displayed
+    std::string get_url(unsigned int msg_seq) const;
+
+	/// the URL of the JSON status snapshot
+
+	/// \param[in] msg_seq sequence number of the last libdar message already displayed
+	/// \note the sequence number is the last component of the URL, the poller replaces it
+	/// by the "seq" field of the last snapshot received
+    std::string get_status_url(unsigned int msg_seq) const;
+
+	/// record the session the feed reports for, only its owner is allowed to read the feed
+    void set_session_ID(const std::string & sessid);
+
+	/// the session the feed reports for, an empty string if not yet known
+    std::string get_session_ID() const;
+
+	/// set the libdar thread which end triggers a "reload" event, nullptr when no thread runs
+
+	/// \note the thread object must exist until it is unset from this feed
+    void set_controlled_thread(libthreadar::thread* arg);
+
+	/// provide the events since the given cursor position (non blocking)
+
+	/// \param[in,out] cur the stream position in the feed, updated by the call
+	/// \param[out] events the events in text/event-stream format, possibly empty
+	/// \return false once the stream has to end, a "reload" event being then part of the events
+    bool next_events(cursor & cur, std::string & events);
+
+	/// provide a snapshot of the progression in JSON format (non blocking)
+
+	/// \param[in] msg_seq sequence number of the last libdar message already displayed
+	/// \return the object {"reload":bool,"seq":num,"counters":{name:value...},"messages":[...]}
+	/// giving all the counters and the messages after msg_seq, or only "reload" set to true when
+	/// the page has to be fully refreshed, the same way next_events() would end the stream
+    std::string status(unsigned int msg_seq);
+
+	/// unregister the feed, the streams reading it end with a "reload" event
+    void close();
+
+	/// create and register a new feed
+    static std::shared_ptr<progress_feed> create(const std::shared_ptr<web_user_interaction> & x_ui,
+						 const std::shared_ptr<libdar::statistics> & x_stats);
+
+	/// lookup a registered feed, returns an empty pointer if none has this identifier
+    static std::shared_ptr<progress_feed> find(const std::string & id);
+
+	/// whether pages should use event streams rather than polling the status snapshot
+    static void set_enabled(bool mode) { enabled = mode; };
+
+	/// whether event streams are enabled
+    static bool get_enabled() { return enabled; };
+
+	/// max number of event streams served at the same time, each holds a server thread
+    static void set_max_streams(unsigned int num) { max_streams = num; };
+
+	/// whether a new event stream would be accepted at this time
+    static bool stream_available();
+
+	/// account for a new event stream, returns false if max_streams are already running
+    static bool acquire_stream();
+
+	/// account for the end of an event stream previously accepted by acquire_stream()
+    static void release_stream();
+
+	/// build an event in text/event-stream format
+    static std::string event(const std::string & name, const std::string & data);
+
+private:
+    progress_feed(const std::shared_ptr<web_user_interaction> & x_ui,
+		  const std::shared_ptr<libdar::statistics> & x_stats);
+
+	/// whether the page has to be rendered again by the session (libdar ended, asks a question or the feed is closed)
+    bool must_reload();
+
+    std::string id;                         ///< identifier in the class table
+    std::shared_ptr<web_user_interaction> ui;  ///< where libdar messages are stored
+    std::shared_ptr<libdar::statistics> stats; ///< libdar counters
+    mutable libthreadar::mutex control;     ///< protects the fields below
+    libthreadar::thread* managed;           ///< the libdar thread, nullptr if none
+    std::string session_ID;                 ///< the session the feed belongs to
+    bool closed;                            ///< whether the feed has been unregistered
+
+    static bool enabled;
+    static unsigned int max_streams;
+    static unsigned int streams;           ///< number of event streams running, protected by lock_feeds
+    static libthreadar::mutex lock_feeds;
+    static std::map<std::string, std::shared_ptr<progress_feed> > feeds;
+};
+
+#endif
@@ -36,9 +36,17 @@ extern "C"
 #if HAVE_STRING_H
 #include <string.h>
 #endif
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 }
 
+    // C++ system header files
+#include <vector>
+
     // webdar headers
+#include "tokens.hpp"
 
 #include "proto_connexion.hpp"
 
@@ -61,9 +69,12 @@ proto_connexion::proto_connexion(const string & peerip, unsigned int peerport)
     buffer = nullptr;
     already_read = 0;
     data_size = 0;
+    read_deadline = 0;
+    read_sliding = 0;
     out_buf_size = BUFFER_SIZE;
     out_buf = nullptr;
     last_unwrote = 0;
+    write_syscalls = 0;
 
     try
     {
@@ -123,6 +134,61 @@ char proto_connexion::read_test_second(bool blocking)
     return buffer[already_read + 1];
 }
 
+unsigned int proto_connexion::read(char *a, unsigned int size, bool blocking)
+{
+    unsigned int ret = 0;
+
+    if(a == nullptr)
+	throw WEBDAR_BUG;
+    if(size == 0)
+	return 0;
+
+    if(already_read == data_size
+       && size >= buffer_size
+       && get_status() == connected)
+    {
+	    // no buffered data and large read:
+	    // avoiding the copy through our buffer
+
+	ret = read_impl(a, size, blocking);
+	if(ret == 0)
+	    throw exception_range("no more data available from connection");
+	data_received();
+    }
+    else
+    {
+	if(already_read == data_size)
+	    fill_buffer(blocking);
+	if(already_read == data_size)
+	    throw exception_range("no more data available from connection");
+
+	ret = data_size - already_read;
+	if(ret > size)
+	    ret = size;
+	(void)memcpy(a, buffer + already_read, ret);
+	already_read += ret;
+    }
+
+    return ret;
+}
+
+const char *proto_connexion::get_unread(unsigned int & size, bool blocking)
+{
+    if(already_read == data_size)
+	fill_buffer(blocking);
+    if(already_read == data_size)
+	throw exception_range("no more data available from connection");
+
+    size = data_size - already_read;
+    return buffer + already_read;
+}
+
+void proto_connexion::skip(unsigned int size)
+{
+    if(size > data_size - already_read)
+	throw WEBDAR_BUG;
+    already_read += size;
+}
 
 void proto_connexion::write(const char *a, unsigned int size)
 {
@@ -150,10 +216,170 @@ void proto_connexion::flush_write()
     }
 }
 
+void proto_connexion::write_vector(const struct iovec *vec,
+				   unsigned int count,
+				   const shared_ptr<const string> & owner)
+{
+    vector<struct iovec> all;
+    bool owned = owner && count > 0 && vec[count - 1].iov_len > 0;
+
+    if(get_status() != connected)
+	throw exception_range("Connexion closed will not be able to send data");
+
+    if(count > 0 && vec == nullptr)
+	throw WEBDAR_BUG;
+
+    all.reserve(count + 1);
+
+    if(last_unwrote > 0)
+    {
+	struct iovec pending;
+
+	pending.iov_base = out_buf;
+	pending.iov_len = last_unwrote;
+	all.push_back(pending);
+    }
+
+    for(unsigned int i = 0; i < count; ++i)
+	if(vec[i].iov_len > 0)
+	    all.push_back(vec[i]);
+
+    if(!all.empty())
+    {
+	write_vector_impl(&(all[0]), all.size(), owned ? owner : shared_ptr<const string>());
+	last_unwrote = 0;
+    }
+}
+
+void proto_connexion::write_file(const struct iovec *vec, unsigned int count, int fd, off_t offset, size_t size)
+{
+    vector<struct iovec> all;
+
+    if(get_status() != connected)
+	throw exception_range("Connexion closed will not be able to send data");
+
+    if(count > 0 && vec == nullptr)
+	throw WEBDAR_BUG;
+
+    all.reserve(count + 1);
+
+    if(last_unwrote > 0)
+    {
+	struct iovec pending;
+
+	pending.iov_base = out_buf;
+	pending.iov_len = last_unwrote;
+	all.push_back(pending);
+    }
+
+    for(unsigned int i = 0; i < count; ++i)
+	if(vec[i].iov_len > 0)
+	    all.push_back(vec[i]);
+
+    send_file_impl(all.empty() ? nullptr : &(all[0]), all.size(), fd, offset, size);
+    last_unwrote = 0;
+}
+
+bool proto_connexion::look_ahead_for(const char *seq, unsigned int size)
+{
+    if(seq == nullptr || size == 0)
+	throw WEBDAR_BUG;
+
+    if(data_size < buffer_size || already_read > 0)
+	fill_buffer(false);
+
+    if(already_read == data_size)
+	return false;
+
+    if(already_read == 0 && data_size == buffer_size)
+	return true;
+
+    return memmem(buffer + already_read, data_size - already_read, seq, size) != nullptr;
+}
+
+void proto_connexion::write_vector_impl(const struct iovec *vec,
+					unsigned int count,
+					const shared_ptr<const string> & owner)
+{
+    size_t total = 0;
+
+    for(unsigned int i = 0; i < count; ++i)
+	total += vec[i].iov_len;
+
+    if(count == 1 || total > out_buf_size)
+    {
+	for(unsigned int i = 0; i < count; ++i)
+	    write_impl((const char *)(vec[i].iov_base), vec[i].iov_len);
+    }
+    else
+    {
+	    // small pieces are gathered to be sent at once
+	string tmp;
+
+	tmp.reserve(total);
+	for(unsigned int i = 0; i < count; ++i)
+	    tmp.append((const char *)(vec[i].iov_base), vec[i].iov_len);
+	write_impl(tmp.c_str(), tmp.size());
+    }
+}
+
+void proto_connexion::send_file_impl(const struct iovec *vec, unsigned int count, int fd, off_t offset, size_t size)
+{
+    ssize_t lu;
+
+    if(count > 0)
+	write_vector_impl(vec, count, shared_ptr<const string>());
+
+	// the output buffer is empty at this time, we use it to read the file
+    while(size > 0)
+    {
+	lu = pread(fd, out_buf, size < out_buf_size ? size : out_buf_size, offset);
+	if(lu < 0)
+	{
+	    if(errno == EINTR)
+		continue;
+	    throw exception_system("Error met while reading file to send: ", errno);
+	}
+	if(lu == 0)
+	    throw exception_range("file to send is shorter than expected");
+	write_impl(out_buf, lu);
+	offset += lu;
+	size -= lu;
+    }
+}
+
+void proto_connexion::set_read_timeout(unsigned int seconds, bool sliding)
+{
+    if(seconds == 0)
+    {
+	read_deadline = 0;
+	read_sliding = 0;
+    }
+    else
+    {
+	read_deadline = time(nullptr) + seconds;
+	read_sliding = sliding ? seconds : 0;
+    }
+}
+
+int proto_connexion::get_read_wait() const
+{
+    time_t now;
+
+    if(read_deadline == 0)
+	return -1;
+
+    now = time(nullptr);
+    if(now >= read_deadline)
+	throw exception_input("Timeout while waiting for data from the client", STATUS_CODE_REQUEST_TIME_OUT);
+
+    return (read_deadline - now) * 1000;
+}
+
 void proto_connexion::fill_buffer(bool blocking)
 {
     if(data_size < buffer_size
-       || already_read == data_size) // there is some room to receive more data in the buffer
+       || already_read > 0) // there is some room to receive more data in the buffer
     {
 	if(get_status() == proto_connexion::connected)
 	{
@@ -175,7 +401,13 @@ void proto_connexion::fill_buffer(bool blocking)
 
 	    try
 	    {
-		data_size += read_impl(buffer + data_size, buffer_size - data_size, blocking);
+		unsigned int lu = read_impl(buffer + data_size, buffer_size - data_size, blocking);
+
+		if(lu > 0)
+		{
+		    data_size += lu;
+		    data_received();
+		}
 	    }
 	    catch(exception_bug & e)
 	    {
@@ -185,6 +417,12 @@ void proto_connexion::fill_buffer(bool blocking)
 	    {
 		throw;
 	    }
+	    catch(exception_input & e)
+	    {
+		    // read timeout, the request will not complete
+		    // even with the data already received
+		throw;
+	    }
 	    catch(exception_base & e)
 	    {
 		if(already_read == data_size) // no more data in buffer
@@ -25,9 +25,24 @@
 #define PROTO_CONNEXION_HPP
 
 #include "my_config.h"
+extern "C"
+{
+#if HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
+#if HAVE_TIME_H
+#include <time.h>
+#endif
+}
 
     // C++ system header files
 #include <string>
+#include <memory>
 
     // webdar headers
 #include "exceptions.hpp"
@@ -73,6 +88,27 @@ public:
 	/// from the reading buffer / throw exception if not available
     char read_test_second(bool blocking);
 
+	/// extracts up to size bytes at once / exception thrown if no data is available
+
+	/// \param[out] a where to store the read data
+	/// \param[in] size max amount of byte to read
+	/// \param[in] blocking whether to wait for data if none is available
+	/// \return the amount of bytes read, which may be less than size but never zero
+	/// \note large reads are done directly into a, bypassing the internal buffer
+    unsigned int read(char *a, unsigned int size, bool blocking);
+
+	/// gives in place access to the received data not yet read / exception thrown if not available
+
+	/// \param[out] size amount of bytes available at the returned address
+	/// \param[in] blocking whether to wait for data if none is available
+	/// \return the address of the next byte to read in the internal buffer
+	/// \note the returned address is only valid up to the next non const call
+	/// on this object. Data seen this way stays unread until skip() is called
+    const char *get_unread(unsigned int & size, bool blocking);
+
+	/// removes from the reading buffer bytes inspected thanks to get_unread()
+    void skip(unsigned int size);
+
 	/// write data
 
 	/// param[in] a data to write
@@ -82,18 +118,116 @@ public:
 	/// flush pending writings if any
     void flush_write();
 
+	/// write at once data scattered in several memory areas
+
+	/// \param[in] vec the memory areas to send in sequence
+	/// \param[in] count number of entries in vec
+	/// \param[in] owner if not null, holds the memory of the last entry of vec, which
+	/// may then be referred to by the lower layer after this call returns (zero-copy)
+	/// \note data pending from write() is sent first. The lower layer is given all
+	/// the data at once, which avoids copying it in the output buffer and lets it
+	/// be sent with a single system call
+    void write_vector(const struct iovec *vec,
+		      unsigned int count,
+		      const std::shared_ptr<const std::string> & owner = std::shared_ptr<const std::string>());
+
+	/// write data scattered in memory followed by a portion of an opened file
+
+	/// \param[in] vec the memory areas to send first
+	/// \param[in] count number of entries in vec
+	/// \param[in] fd file descriptor of the file to send
+	/// \param[in] offset position in the file of the first byte to send
+	/// \param[in] size amount of byte to send from the file
+	/// \note data pending from write() is sent first
+    void write_file(const struct iovec *vec, unsigned int count, int fd, off_t offset, size_t size);
+
+	/// set a time limit to the next blocking read operations
+
+	/// \param[in] seconds the time limit, zero for no limit
+	/// \param[in] sliding if false the limit applies to all the next reads taken together,
+	/// else it applies to the wait for each new piece of data
+	/// \note when the limit is reached, exception_input is thrown with the
+	/// STATUS_CODE_REQUEST_TIME_OUT error code
+    void set_read_timeout(unsigned int seconds, bool sliding);
+
+	/// number of system calls used to send data since the last reset
+    unsigned int get_write_syscalls() const { return write_syscalls; };
+
+	/// reset the system call counter of the writing operations
+    void reset_write_syscalls() { write_syscalls = 0; };
+
+	/// whether some data has been received and not yet read
+
+	/// \note this considers both the local buffer and the buffering
+	/// that may exist in the lower layer (see read_pending_impl())
+    bool has_pending_data() const { return already_read < data_size || read_pending_impl(); };
+
+	/// fetch without blocking the available data and look for a sequence of bytes
+
+	/// \param[in] seq is the sequence of byte to look for in the not yet read data
+	/// \param[in] size is the length of seq
+	/// \return true if the sequence has been found or if the reading buffer is full, in
+	/// which case no more data can be looked ahead
+	/// \note throws an exception_range if the connection has been closed and no more
+	/// data is available for reading
+    bool look_ahead_for(const char *seq, unsigned int size);
+
+	/// provides the file descriptor of the underlying socket (used for event multiplexing)
+    virtual int get_socket() const = 0;
+
+	/// whether data can be sent without having first to exchange with the peer
+
+	/// \note this is not the case of a TLS connection which handshake has not completed
+    virtual bool can_write_now() const { return true; };
+
+	/// the application protocol negotiated with the peer (ALPN), empty string if none
+
+	/// \note for a TLS connection this completes the handshake if not already done
+    virtual std::string get_application_protocol() { return ""; };
+
 
 protected:
 
 	/// implementation of the low level (without buffering) writing operation
     virtual void write_impl(const char *a, unsigned int size) = 0;
 
+	/// implementation of the low level gathering write operation
+
+	/// \param[in] vec the memory areas to send in sequence, none is empty
+	/// \param[in] count number of entries in vec
+	/// \param[in] owner if not null, holds the memory of the last entry of vec and
+	/// can be kept by the implementation up to the time the data has been sent
+	/// \note the default implementation relies on write_impl()
+    virtual void write_vector_impl(const struct iovec *vec,
+				   unsigned int count,
+				   const std::shared_ptr<const std::string> & owner);
+
+	/// implementation of the low level file sending operation
+
+	/// \note the default implementation reads the file and relies on write_vector_impl()
+	/// and write_impl()
+    virtual void send_file_impl(const struct iovec *vec, unsigned int count, int fd, off_t offset, size_t size);
+
     	/// implementation of the low level (without buffering) reading operation
     virtual unsigned int read_impl(char *a, unsigned int size, bool blocking) = 0;
 
+	/// whether the lower layer holds some received data that will not be signaled by the socket
+
+	/// \note this is the case of a TLS layer having already deciphered a record
+    virtual bool read_pending_impl() const { return false; };
+
 	/// let inherited class modifying the object status
     void set_status(status st) { etat = st; };
 
+	/// to be called by inherited class for each system call sending data
+    void count_write_syscall() { ++write_syscalls; };
+
+	/// to be used by inherited class before waiting for data in blocking mode
+
+	/// \return the time left to wait in milliseconds, -1 if not limited
+	/// \note throws exception_input if the time limit set by set_read_timeout() has been reached
+    int get_read_wait() const;
+
 private:
     status etat;       //< proto_connexion status
     std::string ip;    //< IP of the peer host
@@ -104,14 +238,20 @@ private:
     char *buffer;              //< temporary area used for parsing, reading data FROM network
     unsigned int already_read; //< amount of data already read
     unsigned int data_size;    //< total of data in buffer, already read or not
+    time_t read_deadline;      //< time limit of blocking reads, zero for no limit
+    unsigned int read_sliding; //< if not zero, read_deadline is pushed that many seconds further at each data reception
 
 	// output buffer
     unsigned out_buf_size;     //< allocated space for the output buffer (out_buf)
     char *out_buf;             //< temporary areas used to gather bytes for writing
     unsigned int last_unwrote; //< amount of byte pending for writing
+    unsigned int write_syscalls; //< number of system calls used for writing since last reset
 
 	/// manages to get (read) data in buffer and set relative variables acordingly
     void fill_buffer(bool blocking);
+
+	/// push the read deadline further after data reception if the read timeout is sliding
+    void data_received() { if(read_sliding > 0) read_deadline = time(nullptr) + read_sliding; };
 };
 
 #endif
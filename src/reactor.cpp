@@ -0,0 +1,575 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    // C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#if HAVE_STRING_H
+#include <string.h>
+#endif
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+
+#if HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
+#if HAVE_TIME_H
+#include <time.h>
+#endif
+}
+
+    // C++ system header files
+#include <new>
+
+    // webdar headers
+#include "exceptions.hpp"
+#include "global_parameters.hpp"
+
+    //
+#include "reactor.hpp"
+
+using namespace std;
+
+    /// max number of events fetched at once by epoll_wait()
+static const int MAX_EVENTS = 64;
+
+static void set_thread_signal_mask(libthreadar::thread & obj);
+
+reactor::reactor(const shared_ptr<central_report> & log,
+		 unsigned int num_workers):
+    rep(log),
+    epollfd(-1),
+    verrou(1),
+    in_service(0),
+    stopping(false)
+{
+#ifdef LIBTHREADAR_STACK_FEATURE
+    set_stack_size(DEFAULT_STACK_SIZE);
+#endif
+
+    if(!log)
+	throw WEBDAR_BUG;
+    if(num_workers < 1)
+	throw WEBDAR_BUG;
+
+#if HAVE_SYS_EPOLL_H
+    epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if(epollfd < 0)
+	throw exception_system("Error creating epoll file descriptor", errno);
+#else
+    throw exception_feature("event driven mode (epoll) on this system");
+#endif
+
+    try
+    {
+	set_thread_signal_mask(*this);
+
+	for(unsigned int i = 0; i < num_workers; ++i)
+	{
+	    unique_ptr<worker> tmp(new (nothrow) worker(*this));
+
+	    if(!tmp)
+		throw exception_memory();
+	    set_thread_signal_mask(*tmp);
+	    tmp->run();
+	    workers.push_back(std::move(tmp));
+	}
+
+	run();
+	    // launching the I/O thread
+    }
+    catch(...)
+    {
+	stop_workers();
+	workers.clear();
+	close(epollfd);
+	epollfd = -1;
+	throw;
+    }
+}
+
+reactor::~reactor()
+{
+    try
+    {
+	cancel();
+    }
+    catch(...)
+    {
+	    // no throw
+    }
+
+    try
+    {
+	join();
+    }
+    catch(...)
+    {
+	    // no throw
+    }
+
+    try
+    {
+	stop_workers();
+    }
+    catch(...)
+    {
+	    // no throw
+    }
+
+    workers.clear();
+	// the worker destructors join the threads
+
+    parked.clear();
+    parked_since.clear();
+    ready.clear();
+	// this closes the remaining connections
+
+    if(epollfd >= 0)
+	close(epollfd);
+}
+
+void reactor::park(unique_ptr<conversation> & conv)
+{
+    bool is_ready = false;
+
+    if(!conv)
+	throw WEBDAR_BUG;
+
+    if(conv->has_pending_data())
+	is_ready = check_ready(conv);
+
+    verrou.lock();
+    try
+    {
+	dispatch(conv, is_ready);
+    }
+    catch(...)
+    {
+	verrou.unlock();
+	throw;
+    }
+    verrou.unlock();
+}
+
+unsigned int reactor::expire_idle(unsigned int seconds)
+{
+    deque<unique_ptr<conversation> > expired;
+    time_t limit = time(nullptr) - seconds;
+
+    verrou.lock();
+    try
+    {
+	map<int, time_t>::iterator it = parked_since.begin();
+
+	while(it != parked_since.end())
+	{
+	    if(it->second <= limit)
+	    {
+		map<int, unique_ptr<conversation> >::iterator pit = parked.find(it->first);
+
+		if(pit == parked.end())
+		    throw WEBDAR_BUG;
+#if HAVE_SYS_EPOLL_H
+		(void)epoll_ctl(epollfd, EPOLL_CTL_DEL, it->first, nullptr);
+#endif
+		expired.push_back(std::move(pit->second));
+		parked.erase(pit);
+		it = parked_since.erase(it);
+	    }
+	    else
+		++it;
+	}
+    }
+    catch(...)
+    {
+	verrou.unlock();
+	throw;
+    }
+    verrou.unlock();
+
+    if(!expired.empty())
+	rep->report(debug, "reactor object: closing " + to_string(expired.size()) + " idle connection(s)");
+
+    return expired.size();
+	// the connections are closed here, out of the critical section
+}
+
+unsigned int reactor::get_connection_count()
+{
+    unsigned int ret = 0;
+
+    verrou.lock();
+    try
+    {
+	ret = parked.size() + ready.size() + in_service;
+    }
+    catch(...)
+    {
+	verrou.unlock();
+	throw;
+    }
+    verrou.unlock();
+
+    return ret;
+}
+
+void reactor::inherited_run()
+{
+#if HAVE_SYS_EPOLL_H
+    struct epoll_event events[MAX_EVENTS];
+    int num;
+
+    rep->report(debug, "reactor object: I/O thread started");
+
+    while(true)
+    {
+	cancellation_checkpoint();
+	num = epoll_wait(epollfd, events, MAX_EVENTS, -1);
+	if(num < 0)
+	{
+	    if(errno == EINTR)
+		continue; // likely a cancellation request
+	    else
+		throw exception_system("Error met while waiting for network events", errno);
+	}
+
+	for(int i = 0; i < num; ++i)
+	    event_on(events[i].data.fd);
+    }
+#else
+    throw WEBDAR_BUG;
+#endif
+}
+
+void reactor::signaled_inherited_cancel()
+{
+    stop_workers();
+}
+
+reactor::worker::worker(reactor & owner): home(owner)
+{
+#ifdef LIBTHREADAR_STACK_FEATURE
+    set_stack_size(DEFAULT_STACK_SIZE);
+#endif
+}
+
+void reactor::worker::inherited_run()
+{
+    unique_ptr<conversation> conv;
+
+    while(true)
+    {
+	cancellation_checkpoint();
+	conv = home.fetch_ready();
+	if(conv)
+	{
+	    serve(conv);
+	    home.give_back(conv);
+	}
+    }
+}
+
+void reactor::worker::signaled_inherited_cancel()
+{
+    home.wake_up_workers();
+}
+
+void reactor::worker::serve(unique_ptr<conversation> & conv)
+{
+    if(!conv)
+	throw WEBDAR_BUG;
+
+    try
+    {
+	    // answering all the requests already received, if the browser
+	    // pipelined several of them, then releasing the session if
+	    // any for the conversation to be parked
+
+	do
+	{
+	    conv->answer_next_request();
+	}
+	while(conv->get_status() == proto_connexion::connected
+	      && conv->next_request_available());
+
+	conv->release_session();
+    }
+    catch(exception_bug & e)
+    {
+	conv.reset();
+	throw;
+    }
+    catch(exception_range & e)
+    {
+	home.rep->report(notice, string("Connection ending: ") + e.get_message());
+	conv.reset();
+    }
+    catch(exception_base & e)
+    {
+	home.rep->report(err, string("Connection ending upon error: ") + e.get_message());
+	conv.reset();
+    }
+}
+
+void reactor::watch(unique_ptr<conversation> & conv)
+{
+#if HAVE_SYS_EPOLL_H
+    struct epoll_event ev;
+    int fd;
+
+    if(!conv)
+	throw WEBDAR_BUG;
+
+    fd = conv->get_socket();
+    if(parked.find(fd) != parked.end())
+	throw WEBDAR_BUG;
+
+    (void)memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    ev.data.fd = fd;
+
+    parked[fd] = std::move(conv);
+    parked_since[fd] = time(nullptr);
+	// must be done before epoll_ctl() as the I/O thread
+	// will look for the conversation as soon as an event
+	// occurs on that socket
+
+    if(epoll_ctl(epollfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+	int tmp = errno;
+
+	parked.erase(fd); // this closes the connection
+	parked_since.erase(fd);
+	throw exception_system("Error adding a connection to the epoll set", tmp);
+    }
+#else
+    throw WEBDAR_BUG;
+#endif
+}
+
+void reactor::dispatch(unique_ptr<conversation> & conv, bool is_ready)
+{
+    if(!conv)
+	return; // conversation has been dropped
+
+    if(stopping || conv->get_status() != proto_connexion::connected)
+	conv.reset();
+    else
+    {
+	if(is_ready)
+	{
+	    ready.push_back(std::move(conv));
+	    verrou.signal(); // awaking a worker
+	}
+	else
+	    watch(conv);
+    }
+}
+
+bool reactor::check_ready(unique_ptr<conversation> & conv)
+{
+    bool ret = false;
+
+    try
+    {
+	ret = conv->request_header_available();
+    }
+    catch(exception_bug & e)
+    {
+	throw;
+    }
+    catch(exception_signal & e)
+    {
+	ret = false; // will be checked again at next event
+    }
+    catch(exception_base & e)
+    {
+	rep->report(debug, string("reactor object: connection closed: ") + e.get_message());
+	conv.reset();
+    }
+
+    return ret;
+}
+
+unique_ptr<conversation> reactor::fetch_ready()
+{
+    unique_ptr<conversation> ret;
+
+    verrou.lock();
+    try
+    {
+	if(ready.empty() && !stopping)
+	    verrou.wait();
+
+	if(!ready.empty() && !stopping)
+	{
+	    ret = std::move(ready.front());
+	    ready.pop_front();
+	    ++in_service;
+	}
+    }
+    catch(...)
+    {
+	verrou.unlock();
+	throw;
+    }
+    verrou.unlock();
+
+    return ret;
+}
+
+void reactor::give_back(unique_ptr<conversation> & conv)
+{
+    bool is_ready = false;
+
+    if(conv
+       && conv->get_status() == proto_connexion::connected
+       && conv->has_pending_data())
+	is_ready = check_ready(conv);
+
+    verrou.lock();
+    try
+    {
+	if(in_service == 0)
+	    throw WEBDAR_BUG;
+	--in_service;
+	dispatch(conv, is_ready);
+    }
+    catch(...)
+    {
+	verrou.unlock();
+	throw;
+    }
+    verrou.unlock();
+}
+
+void reactor::event_on(int fd)
+{
+    unique_ptr<conversation> conv;
+    bool is_ready = false;
+
+    verrou.lock();
+    try
+    {
+	map<int, unique_ptr<conversation> >::iterator it = parked.find(fd);
+
+	if(it != parked.end())
+	{
+	    conv = std::move(it->second);
+	    parked.erase(it);
+	    parked_since.erase(fd);
+#if HAVE_SYS_EPOLL_H
+	    (void)epoll_ctl(epollfd, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+	}
+	    // else the connection has been closed by expire_idle()
+	    // after epoll_wait() returned
+    }
+    catch(...)
+    {
+	verrou.unlock();
+	throw;
+    }
+    verrou.unlock();
+
+    if(!conv)
+	return;
+
+	// looking at the received data without holding the lock
+    is_ready = check_ready(conv);
+
+    verrou.lock();
+    try
+    {
+	dispatch(conv, is_ready);
+    }
+    catch(...)
+    {
+	verrou.unlock();
+	throw;
+    }
+    verrou.unlock();
+}
+
+void reactor::stop_workers()
+{
+    verrou.lock();
+    try
+    {
+	stopping = true;
+	verrou.broadcast();
+    }
+    catch(...)
+    {
+	verrou.unlock();
+	throw;
+    }
+    verrou.unlock();
+
+    for(vector<unique_ptr<worker> >::iterator it = workers.begin();
+	it != workers.end();
+	++it)
+    {
+	if(*it)
+	    (*it)->cancel();
+    }
+}
+
+void reactor::wake_up_workers()
+{
+    verrou.lock();
+    try
+    {
+	verrou.broadcast();
+    }
+    catch(...)
+    {
+	verrou.unlock();
+	throw;
+    }
+    verrou.unlock();
+}
+
+static void set_thread_signal_mask(libthreadar::thread & obj)
+{
+    sigset_t sigs;
+
+    if(sigfillset(&sigs) != 0)
+	throw exception_system("failed creating a full signal set", errno);
+    if(sigdelset(&sigs, THREAD_SIGNAL) != 0)
+	throw exception_system("failed removing the THREAD_SIGNAL from signal set", errno);
+    obj.set_signal_mask(sigs);
+}
@@ -0,0 +1,161 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef REACTOR_HPP
+#define REACTOR_HPP
+
+#include "my_config.h"
+
+    // C system header files
+extern "C"
+{
+
+}
+
+    // C++ system header files
+#include <map>
+#include <deque>
+#include <ctime>
+#include <vector>
+#include <memory>
+#include <libthreadar/libthreadar.hpp>
+
+    // webdar headers
+#include "central_report.hpp"
+#include "conversation.hpp"
+
+    /// class reactor multiplexes idle connections on a single thread (event-driven mode)
+
+    /// in the thread-per-connection mode (class server) a thread is pending on each
+    /// connection, most of the time waiting for the browser to send its next request.
+    /// Here instead, idle connections are parked in an epoll(7) set watched by the reactor's
+    /// own thread (the I/O thread). When a whole request header has been received on a parked
+    /// connection, this connexion (and its conversation object) is handed to one of the
+    /// worker threads of the reactor, which reads and answers the request(s) available
+    /// then gives the conversation back to the reactor to be parked again.
+    /// \note the request body if any is read by the worker thread.
+
+class reactor : public libthreadar::thread_signal
+{
+public:
+	/// constructor
+
+	/// \param[in] log where to send reports
+	/// \param[in] num_workers number of worker threads answering requests for this reactor
+    reactor(const std::shared_ptr<central_report> & log,
+	    unsigned int num_workers);
+    reactor(const reactor & ref) = delete;
+    reactor(reactor && ref) noexcept = delete;
+    reactor & operator = (const reactor & ref) = delete;
+    reactor & operator = (reactor && ref) noexcept = delete;
+    ~reactor();
+
+	/// give a connection to the reactor
+
+	/// \note the conversation object passes under the responsibility of the reactor
+	/// \note the conversation must not hold any session (see conversation::release_session())
+    void park(std::unique_ptr<conversation> & conv);
+
+	/// number of connections under the responsibility of this reactor (parked, queued or being answered)
+    unsigned int get_connection_count();
+
+	/// close the connections parked for more than the given number of seconds
+
+	/// \return the number of connections closed
+    unsigned int expire_idle(unsigned int seconds);
+
+protected:
+
+	/// inherited from libthreadar::thread
+    virtual void inherited_run() override;
+
+	/// inherited from libthreadar::thread_signal
+    virtual void signaled_inherited_cancel() override;
+
+private:
+
+	/// worker thread answering requests of conversations the reactor has found ready
+    class worker: public libthreadar::thread_signal
+    {
+    public:
+	worker(reactor & owner);
+	worker(const worker & ref) = delete;
+	worker(worker && ref) noexcept = delete;
+	worker & operator = (const worker & ref) = delete;
+	worker & operator = (worker && ref) noexcept = delete;
+	~worker() { cancel(); join(); };
+
+    protected:
+	virtual void inherited_run() override;
+	virtual void signaled_inherited_cancel() override;
+
+    private:
+	reactor & home;
+
+	    /// answer the available request(s) of the given conversation
+	void serve(std::unique_ptr<conversation> & conv);
+    };
+
+    std::shared_ptr<central_report> rep;                   ///< where to send reports
+    int epollfd;                                           ///< the epoll file descriptor
+    libthreadar::condition verrou;                         ///< protects the following fields
+    std::map<int, std::unique_ptr<conversation> > parked;  ///< idle connections indexed by their socket
+    std::map<int, time_t> parked_since;                    ///< when each connection of parked has been parked
+    std::deque<std::unique_ptr<conversation> > ready;      ///< connections having a request to answer
+    unsigned int in_service;                               ///< number of conversations held by workers
+    bool stopping;                                         ///< whether the reactor is ending
+    std::vector<std::unique_ptr<worker> > workers;         ///< the worker threads
+
+	/// add a conversation to the parked ones and watch its socket (verrou must be held by caller)
+    void watch(std::unique_ptr<conversation> & conv);
+
+	/// queue the conversation for the workers if ready, else park it (verrou must be held by caller)
+
+	/// \note the conversation is dropped if the reactor is stopping or the connection is closed
+    void dispatch(std::unique_ptr<conversation> & conv, bool is_ready);
+
+	/// whether a whole request header is available without blocking
+
+	/// \note the conversation is dropped (conv is reset) if the connection has been closed
+    bool check_ready(std::unique_ptr<conversation> & conv);
+
+	/// called by a worker thread to obtain a conversation to work on
+
+	/// \return an empty pointer if no conversation is available (wake up for cancellation)
+    std::unique_ptr<conversation> fetch_ready();
+
+	/// called by a worker when it has finished with a conversation
+    void give_back(std::unique_ptr<conversation> & conv);
+
+	/// handle the event met on the given socket
+    void event_on(int fd);
+
+	/// stop and wake up all worker threads
+    void stop_workers();
+
+	/// wake up all worker pending on fetch_ready()
+    void wake_up_workers();
+
+};
+
+#endif
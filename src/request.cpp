@@ -25,19 +25,46 @@
 #include <string.h>
 
 #include "request.hpp"
+#include "mime_part.hpp"
 #include "exceptions.hpp"
 #include "webdar_tools.hpp"
 
 using namespace std;
 
+    /// multipart parts bigger than that are stored in a temporary file
+#define DEFAULT_MULTIPART_SPOOL_THRESHOLD 65536
+
+    /// max amount of memory used by the parts of a multipart body of a request
+#define DEFAULT_MULTIPART_MEMORY_LIMIT 1048576
+
+    /// max size of a line of header inside a multipart body
+#define MAX_MULTIPART_HEADER_LINE 8192
+
+    /// max size of a chunk size line or of a trailer line of a chunked body
+#define MAX_CHUNK_LINE 8192
+
+unsigned int request::multipart_memory_limit = DEFAULT_MULTIPART_MEMORY_LIMIT;
+unsigned int request::header_timeout = DEFAULT_HEADER_TIMEOUT;
+unsigned int request::body_timeout = DEFAULT_BODY_TIMEOUT;
+unsigned int request::max_header_count = DEFAULT_MAX_HEADER_COUNT;
+unsigned int request::max_header_size = DEFAULT_MAX_HEADER_SIZE;
+unsigned int request::max_body_size = DEFAULT_MAX_BODY_SIZE;
+unsigned int request::max_multipart_size = DEFAULT_MAX_MULTIPART_SIZE;
+
+static bool list_contains(const string & list, const char *token);
+static string list_last(const string & list, unsigned int & count);
+
 
 void request::clear()
 {
     status = init;
     cached_method = "";
+    method_id = http_token::method_unknown;
+    cached_uri = "";
     coordinates.clear();
     attributes.clear();
     body = "";
+    multipart = false;
     clear_multipart();
 }
 
@@ -49,11 +76,17 @@ bool request::try_reading(proto_connexion & input)
 
 void request::read(proto_connexion & input)
 {
-    string key;
-    string val, valorig;
+    string val;
+    unsigned int header_count = 0;
+    unsigned int header_size = 0;
 
+    multipart = false;
     clear_multipart();
 
+	// the time limit runs from now, the caller has waited for
+	// the first bytes of the request without this limit
+    input.set_read_timeout(header_timeout, false);
+
 	///////////////////////////////////////////
 	// reading the first line of the request
 	//
@@ -65,8 +98,10 @@ void request::read(proto_connexion & input)
 
 	// VERSION field
 
-    if(!get_word(input, true, true, val))
+    if(!get_word(input, true, true, val, request_line_room()))
 	throw WEBDAR_BUG;
+    if(max_header_size > 0 && cached_method.size() + cached_uri.size() + val.size() > max_header_size)
+	throw exception_input("Request line too long", STATUS_CODE_BAD_REQUEST);
     if(val == "")
 	val = "HTTP/0.9";
     set_version(val);
@@ -79,29 +114,70 @@ void request::read(proto_connexion & input)
 
     while(!is_empty_line(input)) // which would mean the end of the header
     {
-	if(!get_token(input, true, true, key))
+	if(max_header_count > 0 && ++header_count > max_header_count)
+	    throw exception_input("Too many header fields in request", STATUS_CODE_REQUEST_HEADER_FIELDS_TOO_LARGE);
+	    // one byte more than the room left, zero would mean no limit
+	if(!get_token(input, true, true, field_name, max_header_size > 0 ? max_header_size - header_size + 1 : 0))
 	    throw WEBDAR_BUG;
-	if(key == "")
+	if(field_name.empty())
 	{
 	    string mesg = "non RFC1945 conformant message header: empty string as entity-header field name";
 	    clog->report(debug, mesg);
 	    throw exception_range(mesg);
 	}
+	header_size += field_name.size();
+	if(max_header_size > 0 && header_size > max_header_size)
+	    throw exception_input("Request header fields too large", STATUS_CODE_REQUEST_HEADER_FIELDS_TOO_LARGE);
 	skip_over(input, ':');
-	skip_over(input, ' ');
-	val = up_to_eol_with_LWS(input);
-	if(find_attribute(key, valorig))
-	    add_attribute(key, valorig + ',' + val);
-	else
-	    add_attribute(key, val);
+	skip_blanks(input);
+	    // one byte more than the room left, zero would mean no limit
+	up_to_eol_with_LWS(input, field_value, max_header_size > 0 ? max_header_size - header_size + 1 : 0);
+	header_size += field_value.size();
+	if(max_header_size > 0 && header_size > max_header_size)
+	    throw exception_input("Request header fields too large", STATUS_CODE_REQUEST_HEADER_FIELDS_TOO_LARGE);
+	attributes.append(field_name, ",", field_value);
     }
     skip_line(input); // we now point to the beginning of the body
+    input.set_read_timeout(body_timeout, true);
 
 	///////////////////////////////////////////
 	// reading the body
 	//
 
-    if(find_attribute(HDR_CONTENT_LENGTH, val))
+    if(maj_vers == 1 && min_vers >= 1
+       && find_attribute(http_token::hdr_expect, val)
+       && strcasecmp(val.c_str(), VAL_EXPECT_CONTINUE) == 0
+       && (find_attribute(http_token::hdr_content_length, val) || find_attribute(http_token::hdr_transfer_encoding, val)))
+    {
+	    // the client waits for our approval before sending the body (RFC 7231 paragraph 5.1.1)
+	static const char continue_line[] = "HTTP/1.1 100 Continue\r\n\r\n";
+
+	input.write(continue_line, sizeof(continue_line) - 1);
+	input.flush_write();
+    }
+
+    if(find_attribute(http_token::hdr_transfer_encoding, val))
+    {
+	unsigned int count;
+
+	    // RFC 7230 paragraph 3.3.3: Transfer-Encoding overrides Content-Length,
+	    // without chunked as final coding the body length cannot be known
+	if(strcasecmp(list_last(val, count).c_str(), VAL_TRANSFER_ENCODING_CHUNKED) != 0)
+	    throw exception_input("Transfer-Encoding of request without chunked as final coding", STATUS_CODE_BAD_REQUEST);
+	    // RFC 7230 paragraph 3.3.1: other transfer codings are not implemented
+	if(count > 1)
+	    throw exception_input("Unsupported Transfer-Encoding in request: " + val, STATUS_CODE_NOT_IMPLEMENTED);
+
+	body = up_to_end_of_chunks(input);
+	if(is_multipart_type())
+	{
+	    multipart = true;
+	    body = "";
+	    mp_error = "Multipart body must be sent with a Content-Length";
+	    mp_error_code = STATUS_CODE_LENGTH_REQUIRED;
+	}
+    }
+    else if(find_attribute(http_token::hdr_content_length, val))
     {
 	int size;
 	try
@@ -118,11 +194,32 @@ void request::read(proto_connexion & input)
 	    clog->report(debug, mesg);
 	    throw exception_range(mesg);
 	}
-	body = up_to_length(input, size);
+
+	if(size < 0)
+	{
+	    string mesg = string("Negative value given to ") + HDR_CONTENT_LENGTH + ": " + val;
+	    clog->report(debug, mesg);
+	    throw exception_range(mesg);
+	}
+
+	if(is_multipart_type())
+	{
+		// parts may be spooled to temporary files, the whole body is
+		// refused before any of it is stored
+	    if(max_multipart_size > 0 && (unsigned int)(size) > max_multipart_size)
+		throw exception_input("Multipart request body too large", STATUS_CODE_REQUEST_ENTITY_TOO_LARGE);
+
+	    multipart = true;
+	    body = "";
+	    read_multipart(input, size);
+	}
+	else
+	    body = up_to_length(input, size);
     }
     else
 	body = "";
 
+    input.set_read_timeout(0, false);
     status = completed;
 
     extract_cookies();
@@ -143,6 +240,16 @@ void request::read(proto_connexion & input)
 	throw exception_input(mesg, STATUS_CODE_NOT_IMPLEMENTED);
     }
 
+	// HTTP/1.1 requests must provide the Host header (RFC 7230 paragraph 5.4)
+
+    if(min_vers >= 1 && !find_attribute(http_token::hdr_host, val))
+    {
+	string mesg = "HTTP/1.1 request without Host header";
+
+	clog->report(debug, mesg);
+	throw exception_input(mesg, STATUS_CODE_BAD_REQUEST);
+    }
+
 
 	// URI scheme
 
@@ -158,7 +265,7 @@ void request::read(proto_connexion & input)
 
 	// HTTP method control
 
-    if(cached_method != "GET" && cached_method != "POST" && cached_method != "HEAD")
+    if(method_id != http_token::method_get && method_id != http_token::method_post && method_id != http_token::method_head)
     {
 	string mesg = "The received request using an unknown method: ";
 	mesg += cached_method;
@@ -169,6 +276,23 @@ void request::read(proto_connexion & input)
 
 }
 
+bool request::is_persistent() const
+{
+    string val;
+    bool has_connection = find_attribute(http_token::hdr_connection, val);
+
+    if(status != completed)
+	throw WEBDAR_BUG;
+
+    if(maj_vers != 1)
+	return false;
+
+    if(min_vers >= 1) // persistent unless told otherwise
+	return !has_connection || !list_contains(val, VAL_CONNECTION_CLOSE);
+    else // HTTP/1.0 not persistent unless asked for
+	return has_connection && list_contains(val, VAL_CONNECTION_KEEP_ALIVE);
+}
+
 map<string,string> request::get_body_form() const
 {
     string tmp, aux;
@@ -176,7 +300,7 @@ map<string,string> request::get_body_form() const
     vector<string>::iterator it;
     map<string, string> ret;
 
-    if(!find_attribute(HDR_CONTENT_TYPE, tmp))
+    if(!find_attribute(http_token::hdr_content_type, tmp))
 	return ret;
     if(webdar_tools_to_canonical_case(tmp)
        != webdar_tools_to_canonical_case(VAL_CONTENT_TYPE_FORM))
@@ -195,43 +319,33 @@ map<string,string> request::get_body_form() const
 
 void request::add_cookie(const string & key, const string & value) const
 {
-    const_cast<request *>(this)->cookies[key] = value;
+    const_cast<request *>(this)->cookies.set(key, value);
 }
 
 bool request::find_cookie(const string & key, string & value) const
 {
-    map<string, string>::const_iterator it = cookies.find(key);
-
-    if(it != cookies.end())
-    {
-	value = it->second;
-	return true;
-    }
-    else
-	return false;
+    return cookies.find(key, value);
 }
 
 bool request::find_attribute(const string & key, string & value) const
 {
-    string lkey = webdar_tools_to_canonical_case(key);
-    map<string, string>::const_iterator it = attributes.find(lkey);
+    if(status < reading_all)
+	throw WEBDAR_BUG;
+
+    return attributes.find(key, value);
+}
 
+bool request::find_attribute(http_token::header key, string & value) const
+{
     if(status < reading_all)
 	throw WEBDAR_BUG;
 
-    if(it != attributes.end())
-    {
-	value = it->second;
-	return true;
-    }
-    else
-	return false;
+    return attributes.find(key, value);
 }
 
 unsigned int request::get_multipart_number() const
 {
-    string tmp, tmp2;
-    string boundary;
+    string tmp;
 
 	// according to RFC1521 the header "MIME-Version: 1.0"
 	// should be looked for, however it seems that several
@@ -245,255 +359,457 @@ unsigned int request::get_multipart_number() const
 				  STATUS_CODE_EXPECTATION_FAILED);
     }
 
-	// parsing the Content-Type to obtain the boundary string
-
     if(!find_attribute("Content-Type", tmp))
 	throw exception_input("Missing Content-Type field in request header",
 			      STATUS_CODE_EXPECTATION_FAILED);
-    else
-    {
-	static const char* expected_type = "multipart/";
 
-	if(tmp.size() <= strlen(expected_type)
-	   || strncasecmp(tmp.c_str(), expected_type, strlen(expected_type)) != 0)
-	    throw exception_input(libdar::tools_printf("Content-Type is not of type %s", expected_type),
-				  STATUS_CODE_EXPECTATION_FAILED);
+    if(!multipart)
+	throw exception_input(libdar::tools_printf("Content-Type is not of type %s", VAL_CONTENT_TYPE_MULTIPART),
+			      STATUS_CODE_EXPECTATION_FAILED);
 
-	vector<string> splitted;
+	// error met while the body was received
 
-	webdar_tools_split_by(';', tmp, splitted);
-	if(splitted.size() <= 1)
-	    throw exception_input("Missing boundary field information in multipart Content-Type",
-				  STATUS_CODE_EXPECTATION_FAILED);
+    if(!mp_error.empty())
+	throw exception_input(mp_error, mp_error_code);
 
-	vector<string>::iterator it = splitted.begin();
-	++it; // skipping the "multipart/" part of the header value
+	// "Content-Transfer-Encoding" not (yet?) implemented. See RFC1521 paragraph 5.
 
-	if(it == splitted.end())
-	    throw WEBDAR_BUG; // splitted.size() > 1, this should not occur
+    if(find_attribute("Content-Transfer-Encoding", tmp))
+	throw exception_input("Content-Transfer-Encoding not implemented",
+			      STATUS_CODE_EXPECTATION_FAILED);
 
-	do
+    if(mp_parts.empty())
+	throw exception_input("Body does not contain any multi-part data",
+			      STATUS_CODE_EXPECTATION_FAILED);
+
+    return mp_parts.size();
+}
+
+const map<string, string> & request::get_header_of_multipart(unsigned int num) const
+{
+    if(num >= mp_parts.size())
+	throw WEBDAR_BUG;
+    if(!mp_parts[num])
+	throw WEBDAR_BUG;
+
+    return mp_parts[num]->get_headers();
+}
+
+unique_ptr<istream> request::get_body_of_multipart(unsigned int num) const
+{
+    if(num >= mp_parts.size())
+	throw WEBDAR_BUG;
+    if(!mp_parts[num])
+	throw WEBDAR_BUG;
+
+    return mp_parts[num]->get_content();
+}
+
+void request::fake_valid_request()
+{
+    clear();
+    status = completed;
+    maj_vers = 1;
+    min_vers = 0;
+}
+
+void request::extract_cookies()
+{
+    string key, val;
+    bool found = find_attribute(http_token::hdr_cookie, val);
+    cookies.clear();
+
+    if(found)
+    {
+	vector<string> comma_sep;
+	vector<string>::iterator it;
+	vector<string> tmp;
+	vector<string> semi_col_sep;
+
+	webdar_tools_split_by(',', val, comma_sep);
+	for(it = comma_sep.begin(); it != comma_sep.end(); ++it)
 	{
-		// we can reuse tmp here as its content is now stored in the splitted vector
-	    webdar_tools_split_in_two('=', *it, tmp, tmp2);
-	    tmp = webdar_tools_remove_leading_spaces(tmp);
-	    if(strcasecmp(tmp.c_str(), "boundary") == 0)
-		boundary = tmp2; // which ends the while loop
-	    ++it;
+	    webdar_tools_split_by(';', *it, tmp);
+	    webdar_tools_concat_vectors(semi_col_sep, tmp);
 	}
-	while(it != splitted.end() && boundary.empty());
+	for(it = semi_col_sep.begin(); it != semi_col_sep.end(); ++it)
+	{
+	    webdar_tools_split_in_two('=', *it, key, val);
+	    cookies.set(key, val);
+	}
+	attributes.erase(http_token::hdr_cookie);
+    }
+}
 
-	if(boundary.empty())
-	    throw exception_input("Missing boundary field information in multipart Content-Type",
-				  STATUS_CODE_EXPECTATION_FAILED);
+void request::up_to_crlf(proto_connexion & input, string *line, unsigned int max)
+{
+    const char *ptr;
+    const char *cr;
+    unsigned int size;
+    bool loop = true;
+
+    while(loop)
+    {
+	ptr = input.get_unread(size, true);
+	cr = (const char *)memchr(ptr, '\r', size);
 
-	if(*(boundary.begin()) == '"' && *(boundary.rbegin()) == '"')
+	if(line != nullptr
+	   && max > 0
+	   && line->size() + (cr == nullptr ? size : cr - ptr) > max)
 	{
-	    if(boundary.size() > 2)
-	    {
-		    // removing enclosing quotes
+		// leaving the rest of the line unread, the
+		// caller will find the line too long
+	    size = max + 1 - line->size();
+	    line->append(ptr, size);
+	    input.skip(size);
+	    return;
+	}
+
+	if(cr == nullptr)
+	{
+	    if(line != nullptr)
+		line->append(ptr, size);
+	    input.skip(size);
+	}
+	else
+	{
+	    unsigned int len = cr - ptr;
+
+	    if(line != nullptr)
+		line->append(ptr, len);
+	    input.skip(len);
 
-		boundary.pop_back();
-		boundary.erase(boundary.begin());
+		// the CR may be the last byte of the buffer,
+		// so we let the proto_connexion fetch the next one
+	    if(input.read_test_second(true) == '\n')
+	    {
+		input.skip(2);
+		loop = false;
 	    }
 	    else
-		throw exception_input("Invalid boundary value: quoted empty string",
-				      STATUS_CODE_EXPECTATION_FAILED);
+	    {
+		if(line != nullptr)
+		    *line += '\r';
+		input.skip(1);
+	    }
 	}
-
-	boundary = "--" + boundary;
     }
-	// boundary is now known
-
-
-	// "Content-Transfer-Encoding" not (yet?) implemented. See RFC1521 paragraph 5.
+}
 
-    if(find_attribute("Content-Transfer-Encoding", tmp))
-	throw exception_input("Content-Transfer-Encoding not implemented",
-			      STATUS_CODE_EXPECTATION_FAILED);
+void request::skip_blanks(proto_connexion & input)
+{
+    const char *ptr;
+    unsigned int size;
+    unsigned int offset;
 
-	// analysing the body as a multipart structured data
+    try
+    {
+	do
+	{
+	    ptr = input.get_unread(size, true);
+	    offset = 0;
+	    while(offset < size && (ptr[offset] == ' ' || ptr[offset] == '\t'))
+		++offset;
+	    input.skip(offset);
+	}
+	while(offset == size);
+    }
+    catch(exception_bug & e)
+    {
+	throw;
+    }
+    catch(exception_input & e)
+    {
+	throw; // timeout
+    }
+    catch(exception_base & e)
+    {
+	    // we ignore here any end of connection
+    }
+}
 
-	// split body from boundary occurence -
-	// - the first occurence is not be preceeded by \r\n unlike the others
-	// - the last occurence is followed by two dashes (--)
+string request::get_multipart_boundary() const
+{
+    string tmp, tmp2;
+    string boundary;
+    vector<string> splitted;
 
-    deque<troncon> parts = webdar_tools_split_by_substring(boundary, troncon(body));
+    if(!find_attribute("Content-Type", tmp))
+	throw WEBDAR_BUG; // multipart should not have been set
 
-    if(parts.empty())
-	throw exception_input("Body does not contain any multi-part data",
+    webdar_tools_split_by(';', tmp, splitted);
+    if(splitted.size() <= 1)
+	throw exception_input("Missing boundary field information in multipart Content-Type",
 			      STATUS_CODE_EXPECTATION_FAILED);
-    else
-    {
-	parts.pop_front();
-	    // dropping the preample part (any char before the first boundary)
-    }
 
-    if(parts.empty())
-	throw exception_input("Body does not contain any multi-part data",
-			      STATUS_CODE_EXPECTATION_FAILED);
+    vector<string>::iterator it = splitted.begin();
+    ++it; // skipping the "multipart/" part of the header value
+
+    if(it == splitted.end())
+	throw WEBDAR_BUG; // splitted.size() > 1, this should not occur
 
-	// check and dropping the the epilogue (which always exists because of the -- added
-	// to the last boundary:
-    if(strncmp(string(parts.rbegin()->begin, parts.rbegin()->end).c_str(), "--", 2) == 0)
+    do
     {
-	    // this is a well formated last boundary (with the added -- after it)
-	parts.pop_back(); // dropping the epilogue for the available parts
+	webdar_tools_split_in_two('=', *it, tmp, tmp2);
+	tmp = webdar_tools_remove_leading_spaces(tmp);
+	if(strcasecmp(tmp.c_str(), "boundary") == 0)
+	    boundary = tmp2; // which ends the while loop
+	++it;
     }
-    else
-	throw exception_input("Badly formated last boundary, missing the two dashes",
-			      STATUS_CODE_EXPECTATION_FAILED);
+    while(it != splitted.end() && boundary.empty());
 
-	// removing the initial CRLF (\r\n) at the beginning of all parts
-	// as the bondary is always followed by CRLF (except for the last delimiter
-	// which has been addressed with the epligue above).
-    if(parts.empty())
-	throw exception_input("Body does not contain any multi-part data",
+    if(boundary.empty())
+	throw exception_input("Missing boundary field information in multipart Content-Type",
 			      STATUS_CODE_EXPECTATION_FAILED);
 
-    for(deque<troncon>::iterator it = parts.begin(); it != parts.end(); ++it)
+    if(*(boundary.begin()) == '"' && *(boundary.rbegin()) == '"')
     {
-	int num = 2;
-
-	while(num > 0 && it->begin != it->end)
+	if(boundary.size() > 2)
 	{
-	    --num;
-	    ++(it->begin);
-	}
+		// removing enclosing quotes
 
-	if(num > 0)
-	    throw exception_input("Badly formated multipart, missing CR+LF after boundary",
+	    boundary.pop_back();
+	    boundary.erase(boundary.begin());
+	}
+	else
+	    throw exception_input("Invalid boundary value: quoted empty string",
 				  STATUS_CODE_EXPECTATION_FAILED);
     }
 
-	// now analysing each part
-	// the expected stucture is a list of field: value one per line
-	// we expect to find the field "
-	// followed by an empty line
-	// followed by the data
+    return "--" + boundary;
+}
 
-    static const string newline = "\r\n";
-    static const string header_sep = ": ";
+void request::read_multipart(proto_connexion & input, unsigned int length)
+{
+    enum { preamble, delimiter, part_header, part_body, epilogue } state = preamble;
+    string first_delim;  // delimiter not preceeded by CR LF, before the first part
+    string delim;        // delimiter ending a part
+    string pending;      // data received and not yet analysed
+    string::size_type pos;
+    shared_ptr<mime_part> current;
+    unsigned int mem_used = 0;
+    const char *ptr;
+    unsigned int size;
+    bool progress;
 
-    mp_headers.clear();
-    mp_body.clear();
+    try
+    {
+	first_delim = get_multipart_boundary();
+    }
+    catch(exception_input & e)
+    {
+	mp_error = e.get_message();
+	mp_error_code = e.get_error_code();
+	state = epilogue; // the body will be read but not analysed
+    }
+    delim = "\r\n" + first_delim;
+
+	// the body is analysed as it arrives, only the
+	// end of the received data that may contain the beginning of
+	// a delimiter or of a header line is kept in pending between
+	// two readings, the content of parts goes to the mime_part objects
+	// which store it into temporary files when it becomes large
 
-    for(deque<troncon>::iterator it = parts.begin(); it != parts.end(); ++it)
+    while(length > 0)
     {
-	troncon tmp(*it);
-	string::const_iterator offset;
-	bool finished = false;
-	mp_header_map headers;
+	ptr = input.get_unread(size, true);
+	if(size > length)
+	    size = length;
 
-	do
+	if(state == epilogue)
 	{
-	    offset = webdar_tools_seek_to_substring(newline, tmp);
-	    if(offset == tmp.end) // no newline found and still no body found
-		throw exception_input("Missing empty newline in multipart to signal the start of a multi-part body",
-				      STATUS_CODE_EXPECTATION_FAILED);
+	    input.skip(size);
+	    length -= size;
+	    continue;
+	}
 
-	    if(offset == tmp.begin) // empty new line, we have reached the body!
-	    {
-		tmp.begin = offset + newline.size();
-		mp_body.push_back(tmp);
-		finished = true;
-	    }
-	    else // still in header part, hitting an end of line
+	pending.append(ptr, size);
+	input.skip(size);
+	length -= size;
+
+	try
+	{
+	    do
 	    {
-		troncon header_line(tmp.begin, offset);
-		tmp.begin = offset + newline.size();
-
-		string::const_iterator sep = webdar_tools_seek_to_substring(header_sep, header_line);
-		if(sep == header_line.end)
-		    throw exception_input("Invalid header in multipart, missing colon (:) on a line",
-					  STATUS_CODE_EXPECTATION_FAILED);
-		headers[troncon(header_line.begin, sep)] = troncon(sep + header_sep.size(), header_line.end);
+		progress = false;
+
+		switch(state)
+		{
+		case preamble:
+		    pos = pending.find(first_delim);
+		    if(pos != string::npos)
+		    {
+			pending.erase(0, pos + first_delim.size());
+			state = delimiter;
+			progress = true;
+		    }
+		    else
+		    {
+			if(pending.size() >= first_delim.size())
+			    pending.erase(0, pending.size() - first_delim.size() + 1);
+		    }
+		    break;
+		case delimiter:
+		    if(pending.size() < 2)
+			break;
+		    if(pending.compare(0, 2, "--") == 0)
+		    {
+			state = epilogue;
+			pending.clear();
+			break;
+		    }
+		    pos = pending.find("\r\n");
+		    if(pos == string::npos)
+		    {
+			if(pending.size() > MAX_MULTIPART_HEADER_LINE)
+			    throw exception_input("Badly formated multipart, missing CR+LF after boundary",
+						  STATUS_CODE_EXPECTATION_FAILED);
+			break;
+		    }
+		    if(pending.find_first_not_of(" \t") < pos) // only transport padding is allowed
+			throw exception_input("Badly formated multipart, missing CR+LF after boundary",
+					      STATUS_CODE_EXPECTATION_FAILED);
+		    pending.erase(0, pos + 2);
+		    current.reset(new (nothrow) mime_part());
+		    if(!current)
+			throw exception_memory();
+		    mp_parts.push_back(current);
+		    state = part_header;
+		    progress = true;
+		    break;
+		case part_header:
+		    pos = pending.find("\r\n");
+		    if(pos == string::npos)
+		    {
+			if(pending.size() > MAX_MULTIPART_HEADER_LINE)
+			    throw exception_input("Too long header line in multipart",
+						  STATUS_CODE_REQUEST_ENTITY_TOO_LARGE);
+			break;
+		    }
+		    if(pos == 0) // empty new line, we have reached the body!
+			state = part_body;
+		    else
+		    {
+			string::size_type sep = pending.find(':');
+
+			if(sep >= pos)
+			    throw exception_input("Invalid header in multipart, missing colon (:) on a line",
+						  STATUS_CODE_EXPECTATION_FAILED);
+			current->add_header(pending.substr(0, sep),
+					    webdar_tools_remove_leading_spaces(pending.substr(sep + 1, pos - sep - 1)));
+		    }
+		    pending.erase(0, pos + 2);
+		    progress = true;
+		    break;
+		case part_body:
+		    pos = pending.find(delim);
+		    if(pos != string::npos)
+		    {
+			store_multipart_data(*current, pending.c_str(), pos, mem_used);
+			pending.erase(0, pos + delim.size());
+			state = delimiter;
+			progress = true;
+		    }
+		    else
+		    {
+			    // keeping what could be the beginning of a delimiter
+			if(pending.size() >= delim.size())
+			{
+			    pos = pending.size() - delim.size() + 1;
+			    store_multipart_data(*current, pending.c_str(), pos, mem_used);
+			    pending.erase(0, pos);
+			}
+		    }
+		    break;
+		case epilogue:
+		    pending.clear();
+		    break;
+		default:
+		    throw WEBDAR_BUG;
+		}
 	    }
+	    while(progress);
+	}
+	catch(exception_input & e)
+	{
+	    mp_error = e.get_message();
+	    mp_error_code = e.get_error_code();
+	    state = epilogue;
+	    pending.clear();
+	}
+	catch(exception_system & e)
+	{
+	    mp_error = e.get_message();
+	    mp_error_code = STATUS_CODE_INTERNAL_SERVER_ERROR;
+	    state = epilogue;
+	    pending.clear();
 	}
-	while(!finished);
-	mp_headers.push_back(headers);
     }
 
-    if(mp_headers.size() != mp_body.size())
-	throw WEBDAR_BUG;
-
-    return mp_headers.size();
-}
-
-map<troncon,troncon> request::get_header_of_multipart(unsigned int num) const
-{
-    if(num >= mp_headers.size())
-	throw WEBDAR_BUG;
-
-    return mp_headers[num];
+    if(state != epilogue)
+    {
+	mp_error = "Badly formated last boundary, missing the two dashes";
+	mp_error_code = STATUS_CODE_EXPECTATION_FAILED;
+    }
 }
 
-troncon request::get_body_of_multipart(unsigned int num) const
+bool request::is_multipart_type() const
 {
-    if(num >= mp_body.size())
-	throw WEBDAR_BUG;
+    string val;
 
-    return mp_body[num];
-}
-
-void request::fake_valid_request()
-{
-    clear();
-    status = completed;
-    maj_vers = 1;
-    min_vers = 0;
+    return find_attribute(http_token::hdr_content_type, val)
+	&& val.size() > strlen(VAL_CONTENT_TYPE_MULTIPART)
+	&& strncasecmp(val.c_str(), VAL_CONTENT_TYPE_MULTIPART, strlen(VAL_CONTENT_TYPE_MULTIPART)) == 0;
 }
 
-void request::extract_cookies()
+void request::store_multipart_data(mime_part & part, const char *a, unsigned int size, unsigned int & mem_used)
 {
-    string key, val;
-    bool found = find_attribute(HDR_COOKIE, val);
-    cookies.clear();
+    if(size == 0)
+	return;
 
-    if(found)
+    if(!part.is_spooled()
+       && (part.memory_used() + size > DEFAULT_MULTIPART_SPOOL_THRESHOLD
+	   || size > multipart_memory_limit - mem_used))
     {
-	vector<string> comma_sep;
-	vector<string>::iterator it;
-	vector<string> tmp;
-	vector<string> semi_col_sep;
-
-	webdar_tools_split_by(',', val, comma_sep);
-	for(it = comma_sep.begin(); it != comma_sep.end(); ++it)
-	{
-	    webdar_tools_split_by(';', *it, tmp);
-	    webdar_tools_concat_vectors(semi_col_sep, tmp);
-	}
-	for(it = semi_col_sep.begin(); it != semi_col_sep.end(); ++it)
-	{
-	    webdar_tools_split_in_two('=', *it, key, val);
-	    cookies[key] = val;
-	}
-	drop_attribute(HDR_COOKIE);
+	mem_used -= part.memory_used();
+	part.spool();
     }
+
+    if(!part.is_spooled())
+	mem_used += size;
+    part.append(a, size);
 }
 
 bool request::read_method_uri(proto_connexion & input, bool blocking)
 {
     string tmp;
-    string cached_uri;
 
     if(status > uri_read)
 	throw WEBDAR_BUG;
 
+    if(request_line_exceeded(blocking))
+	return false;
+
     if(status == init)
     {
-	if(get_token(input, cached_method == "", blocking, tmp))
+	if(get_token(input, cached_method == "", blocking, tmp, request_line_room()))
 	    status = method_read;
 	cached_method += tmp;
+	if(request_line_exceeded(blocking))
+	    return false;
+	if(status == method_read)
+	    method_id = http_token::method_of(cached_method);
     }
 
     if(status == method_read)
     {
 	if(status != uri_read)
 	{
-	    if(get_word(input, cached_uri == "", blocking, tmp))
+	    if(get_word(input, cached_uri == "", blocking, tmp, request_line_room()))
 		status = uri_read;
 	    cached_uri += tmp;
+	    if(request_line_exceeded(blocking))
+		return false;
 
 	    if(status == uri_read)
 		coordinates.read(cached_uri);
@@ -516,12 +832,33 @@ bool request::read_method_uri(proto_connexion & input, bool blocking)
     return status == uri_read;
 }
 
-void request::drop_attribute(const string & key)
+unsigned int request::request_line_room() const
 {
-    map<string, string>::iterator it = attributes.find(key);
+    unsigned int used = cached_method.size() + cached_uri.size();
+
+    if(max_header_size == 0)
+	return 0;
 
-    if(it != attributes.end())
-	attributes.erase(it);
+    if(used > max_header_size)
+	throw WEBDAR_BUG; // request_line_exceeded() should have been checked
+
+	// one byte more than the room left, zero would mean no limit
+    return max_header_size - used + 1;
+}
+
+bool request::request_line_exceeded(bool blocking) const
+{
+    if(max_header_size == 0
+       || cached_method.size() + cached_uri.size() <= max_header_size)
+	return false;
+
+    if(!blocking)
+	return true; // read() will report it
+
+    if(status == init || cached_uri.empty())
+	throw exception_input("Request method too long", STATUS_CODE_NOT_IMPLEMENTED);
+    else
+	throw exception_input("Request URI too long", STATUS_CODE_REQUEST_URI_TOO_LARGE);
 }
 
 bool request::is_empty_line(proto_connexion & input)
@@ -536,6 +873,10 @@ bool request::is_empty_line(proto_connexion & input)
     {
 	throw;
     }
+    catch(exception_input & e)
+    {
+	throw; // timeout
+    }
     catch(exception_base & e)
     {
 	ret = false;
@@ -551,14 +892,16 @@ string request::up_to_eol(proto_connexion & input)
 
     try
     {
-	while(input.read_test_first(true) != '\r' || input.read_test_second(true) != '\n')
-	    ret += input.read_one(true);
-	skip_line(input);
+	up_to_crlf(input, &ret);
     }
     catch(exception_bug & e)
     {
 	throw;
     }
+    catch(exception_input & e)
+    {
+	throw; // timeout
+    }
     catch(exception_base & e)
     {
 	    // we ignore here any end of connection
@@ -572,8 +915,15 @@ string request::up_to_eof(proto_connexion & input)
 
     try
     {
+	const char *ptr;
+	unsigned int size;
+
 	while(true)
-	    ret += input.read_one(true);
+	{
+	    ptr = input.get_unread(size, true);
+	    ret.append(ptr, size);
+	    input.skip(size);
+	}
     }
     catch(exception_bug & e)
     {
@@ -591,13 +941,33 @@ void request::skip_over(proto_connexion & input, char a)
 {
     try
     {
-	while(input.read_one(true) != a)
-	    ;
+	const char *ptr;
+	const char *found;
+	const char *eol;
+	unsigned int size;
+
+	do
+	{
+	    ptr = input.get_unread(size, true);
+	    found = (const char *)memchr(ptr, a, size);
+	    eol = (const char *)memchr(ptr, '\r', found == nullptr ? size : found - ptr);
+	    if(eol != nullptr)
+		input.skip(eol - ptr); // stopping at end of line
+	    else if(found != nullptr)
+		input.skip(found - ptr + 1);
+	    else
+		input.skip(size);
+	}
+	while(found == nullptr && eol == nullptr);
     }
     catch(exception_bug & e)
     {
 	throw;
     }
+    catch(exception_input & e)
+    {
+	throw; // timeout
+    }
     catch(exception_base & e)
     {
 	    // we ignore here any end of connection
@@ -605,66 +975,131 @@ void request::skip_over(proto_connexion & input, char a)
 }
 
 
-string request::up_to_length(proto_connexion & input, unsigned int length)
+string request::up_to_end_of_chunks(proto_connexion & input)
 {
     string ret;
+    string line;
+    string::size_type ext;
+    unsigned int size;
 
-	/// TO BE IMPROVED ADDING A READ CALL WITH INPUT BUFFER TO PROTO_CONNEXION CLASS
-    while(length > 0)
+    do
+    {
+	    // chunk-size [ chunk-ext ] CRLF (RFC 7230 paragraph 4.1)
+
+	line.clear();
+	up_to_crlf(input, &line, MAX_CHUNK_LINE);
+	if(line.size() > MAX_CHUNK_LINE)
+	    throw exception_range("Too long chunk size line in chunked body");
+	ext = line.find(';');
+	if(ext != string::npos)
+	    line.erase(ext);
+	while(!line.empty() && (line.back() == ' ' || line.back() == '\t'))
+	    line.pop_back();
+	if(line.empty() || line.size() > 8)
+	    throw exception_range(string("Invalid chunk size line in chunked body: ") + line);
+	size = webdar_tools_convert_hexa_to_int(line);
+
+	if(size > 0)
+	{
+	    append_body(input, ret, size);
+
+	    line.clear();
+	    up_to_crlf(input, &line, MAX_CHUNK_LINE);
+	    if(!line.empty())
+		throw exception_range("Missing CR LF after chunk data in chunked body");
+	}
+    }
+    while(size > 0);
+
+	// trailer part is ignored, up to the final empty line
+
+    do
     {
-	ret += input.read_one(true);
-	--length;
+	line.clear();
+	up_to_crlf(input, &line, MAX_CHUNK_LINE);
+	if(line.size() > MAX_CHUNK_LINE)
+	    throw exception_range("Too long trailer line in chunked body");
     }
+    while(!line.empty());
 
     return ret;
 }
 
-void request::skip_line(proto_connexion & input)
+string request::up_to_length(proto_connexion & input, unsigned int length)
 {
-    bool loop = true;
-    char a;
+    string ret;
+
+    append_body(input, ret, length);
+
+    return ret;
+}
 
+void request::append_body(proto_connexion & input, string & ret, unsigned int length)
+{
+    const char *ptr;
+    unsigned int size;
+
+	// the length is given by the client, memory is only
+	// committed as the announced data is really received
+
+    if(length > max_body_size || ret.size() > max_body_size - length)
+	throw exception_input("Request body too large", STATUS_CODE_REQUEST_ENTITY_TOO_LARGE);
+
+    while(length > 0)
+    {
+	ptr = input.get_unread(size, true);
+	if(size > length)
+	    size = length;
+	ret.append(ptr, size);
+	input.skip(size);
+	length -= size;
+    }
+}
+
+void request::skip_line(proto_connexion & input)
+{
     try
     {
-	while(loop)
-	{
-	    a = input.read_one(true);
-	    if(a == '\r')
-	    {
-		if(input.read_test_first(true) == '\n')
-		{
-		    a = input.read_one(true);
-		    loop = false;
-		}
-	    }
-	}
+	up_to_crlf(input, nullptr);
     }
     catch(exception_bug & e)
     {
 	throw;
     }
+    catch(exception_input & e)
+    {
+	throw; // timeout
+    }
     catch(exception_base & e)
     {
 	    // we ignore here any end of connection
     }
 }
 
-string request::up_to_eol_with_LWS(proto_connexion & input)
+void request::up_to_eol_with_LWS(proto_connexion & input, string & ret, unsigned int max)
 {
-    string ret;
     bool loop = false;
 
+    ret.clear();
+
     try
     {
 	do
 	{
 	    loop = false;
-	    ret += up_to_eol(input);
+	    if(max > 0)
+	    {
+		    // up_to_crlf() stops early if ret grows beyond max
+		up_to_crlf(input, &ret, max);
+		if(ret.size() > max)
+		    break;
+	    }
+	    else
+		ret += up_to_eol(input);
 	    if(input.read_test_first(true) == ' ' || input.read_test_first(true) == '\t')
 	    {
 		loop = true;
-		while(input.read_test_first(true) == ' ' || input.read_test_first(true) == '\t')
-		    (void)input.read_one(true);
+		skip_blanks(input);
 		ret += ' '; // "All LWS including folding, have the same semantics as SP"
 	    }
 	}
@@ -679,50 +1114,71 @@ string request::up_to_eol_with_LWS(proto_connexion & input)
 	    // nothing done, as we reached end of file
 	    // we return the data read so far
     }
-
-    return ret;
 }
 
 
-bool request::get_token(proto_connexion & input, bool initial, bool blocking, string & token)
+bool request::get_token(proto_connexion & input, bool initial, bool blocking, string & token, unsigned int max)
 {
     bool ret = true;
     bool loop = true;
-    char a;
+    const char *ptr;
+    unsigned int size;
+    unsigned int offset;
     token = "";
 
     try
     {
 	while(loop)
 	{
-	    a = input.read_test_first(blocking);
+	    ptr = input.get_unread(size, blocking);
+	    offset = 0;
 
-	    if((a == ' ' || a == '\t') && initial)
-		a = input.read_one(blocking);
-	    else
+	    if(initial)
 	    {
-		    // token is built of any char except CTLs or tspecials
-		    // tspecials are:  ()<>@,;:\"/[]?={} space and tab
-		    // as defined by RFC 1945 paragraph 2.2 "Basic Rules".
-		if(a < 127 && a > 31
-		   && a != '(' && a != ')' && a != '<' && a != '>'
-		   && a != '@' && a != ',' && a != ';' && a != ':'
-		   && a != '\\' && a != '"' && a != '/' && a != '['
-		   && a != ']' && a != '?' && a != '=' && a != '{'
-		   && a != '}' && a != ' ' && a != '\t')
-		{
-		    token += input.read_one(blocking);
-		    initial = false;
-		}
-		else
-		    loop = false;
+		while(offset < size && (ptr[offset] == ' ' || ptr[offset] == '\t'))
+		    ++offset;
+		input.skip(offset);
+		ptr += offset;
+		size -= offset;
+		offset = 0;
+	    }
+
+	    while(offset < size && is_token_char(ptr[offset]))
+		++offset;
+
+	    if(max > 0 && token.size() + offset > max)
+	    {
+		    // leaving the rest of the token unread, the
+		    // caller will find the token too long
+		offset = max + 1 - token.size();
+		token.append(ptr, offset);
+		input.skip(offset);
+		return true;
+	    }
+
+	    if(offset > 0)
+	    {
+		token.append(ptr, offset);
+		input.skip(offset);
+		initial = false;
 	    }
+
+	    if(offset < size)
+		loop = false; // a non token char has been met
 	}
     }
     catch(exception_bug & e)
     {
 	throw;
     }
+    catch(exception_input & e)
+    {
+	    // timeout, the request cannot be completed
+	if(!blocking)
+	    ret = false;
+	else
+	    throw;
+    }
     catch(exception_base & e)
     {
 	if(!blocking)
@@ -735,7 +1191,7 @@ bool request::get_token(proto_connexion & input, bool initial, bool blocking, st
     return ret;
 }
 
-bool request::get_word(proto_connexion & input, bool initial, bool blocking, string & word)
+bool request::get_word(proto_connexion & input, bool initial, bool blocking, string & word, unsigned int max)
 {
     string tmp;
     char ctmp;
@@ -749,12 +1205,14 @@ bool request::get_word(proto_connexion & input, bool initial, bool blocking, str
 	do
 	{
 	    loop = false;
-	    ret = get_token(input, initial, blocking, tmp);
+	    ret = get_token(input, initial, blocking, tmp, max > 0 ? max - word.size() + 1 : 0);
 	    if(tmp != "")
 	    {
 		initial = false;
 		word += tmp;
 	    }
+	    if(max > 0 && word.size() > max)
+		break; // the caller will find the word too long
 	    if(ret)
 	    {
 		try
@@ -765,6 +1223,12 @@ bool request::get_word(proto_connexion & input, bool initial, bool blocking, str
 		{
 		    throw;
 		}
+		catch(exception_input & e)
+		{
+		    if(blocking)
+			throw; // timeout
+		    break;
+		}
 		catch(...)
 		{
 			// EOF met
@@ -791,12 +1255,17 @@ bool request::get_word(proto_connexion & input, bool initial, bool blocking, str
 		}
 	    }
 	}
-	while(loop);
+	while(loop && (max == 0 || word.size() <= max));
     }
     catch(exception_bug & e)
     {
 	throw;
     }
+    catch(exception_input & e)
+    {
+	if(blocking || word == "")
+	    throw; // timeout
+    }
     catch(exception_base & e)
     {
 	if(word == "")
@@ -849,3 +1318,44 @@ void request::set_version(const string & version)
 
     min_vers = webdar_tools_convert_to_int(string(it, version.end()));
 }
+
+static bool list_contains(const string & list, const char *token)
+{
+    vector<string> items;
+
+    webdar_tools_split_by(',', list, items);
+    for(vector<string>::iterator it = items.begin(); it != items.end(); ++it)
+    {
+	string val = webdar_tools_remove_leading_spaces(*it);
+
+	while(!val.empty() && (val.back() == ' ' || val.back() == '\t'))
+	    val.pop_back();
+	if(strcasecmp(val.c_str(), token) == 0)
+	    return true;
+    }
+
+    return false;
+}
+
+static string list_last(const string & list, unsigned int & count)
+{
+    vector<string> items;
+    string ret;
+
+    count = 0;
+    webdar_tools_split_by(',', list, items);
+    for(vector<string>::iterator it = items.begin(); it != items.end(); ++it)
+    {
+	string val = webdar_tools_remove_leading_spaces(*it);
+
+	while(!val.empty() && (val.back() == ' ' || val.back() == '\t'))
+	    val.pop_back();
+	if(!val.empty()) // empty list elements are allowed (RFC 7230 paragraph 7)
+	{
+	    ret = val;
+	    ++count;
+	}
+    }
+
+    return ret;
+}
@@ -30,6 +30,8 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <deque>
+#include <istream>
 
     // webdar headers
 #include "uri.hpp"
@@ -38,6 +40,27 @@
 #include "tokens.hpp"
 #include "central_report.hpp"
 #include "connexion.hpp"
+#include "mime_part.hpp"
+#include "header_list.hpp"
+#include "http_token.hpp"
+
+    /// default max time to receive the whole header of a request (seconds)
+#define DEFAULT_HEADER_TIMEOUT 30
+
+    /// default max time between two pieces of the body of a request (seconds)
+#define DEFAULT_BODY_TIMEOUT 60
+
+    /// default max number of header fields in a request
+#define DEFAULT_MAX_HEADER_COUNT 100
+
+    /// default max total size of the header fields of a request
+#define DEFAULT_MAX_HEADER_SIZE 65536
+
+    /// default max size of a request body held in memory (multipart bodies excepted)
+#define DEFAULT_MAX_BODY_SIZE 1048576
+
+    /// default max size of a multipart request body, spooled to disk beyond the memory limit
+#define DEFAULT_MAX_MULTIPART_SIZE 67108864
 
     /// class holding fields of an HTTP request (method, URI, header, cookies, and so on)
 
@@ -45,7 +68,7 @@ class request
 {
 public:
 	/// The constructor
-    request(const std::shared_ptr<central_report> & log) { clear(); if(log) clog = log; else throw WEBDAR_BUG; };
+    request(const std::shared_ptr<central_report> & log): cookies(false) { clear(); if(log) clog = log; else throw WEBDAR_BUG; };
     request(const request & ref) = default;
     request(request && ref) noexcept = default;
     request & operator = (const request & ref) = default;
@@ -53,6 +76,8 @@ public:
     ~request() = default;
 
 	/// clear all fields of the request
+
+	/// \note the memory used by the header fields is kept for the next request read
     void clear();
 
 	/// try reading just enough data in order to determine the uri of the next request
@@ -77,15 +102,21 @@ public:
 	/// obtains the method of the read request
     const std::string & get_method() const { if(status < method_read) throw WEBDAR_BUG; return cached_method; };
 
+	/// obtains the method of the read request as identifier, method_unknown for other methods
+    http_token::method get_method_id() const { if(status < method_read) throw WEBDAR_BUG; return method_id; };
+
 	/// manually change the method of the request
-    void change_method(const std::string & val) { if(status < method_read) throw WEBDAR_BUG; cached_method = val; };
+    void change_method(const std::string & val) { if(status < method_read) throw WEBDAR_BUG; cached_method = val; method_id = http_token::method_of(val); };
 
 	/// change POST request to a GET request, No modification for others
-    void post_to_get() { if(status < method_read) throw WEBDAR_BUG; if(cached_method == "POST") cached_method = "GET"; };
+    void post_to_get() { if(status < method_read) throw WEBDAR_BUG; if(method_id == http_token::method_post) { cached_method = "GET"; method_id = http_token::method_get; } };
 
 	/// obtains the URI of the read request
     const uri & get_uri() const { if(status < uri_read) throw WEBDAR_BUG; return coordinates; };
 
+	/// whether the request has been read entirely (version, header and body are available)
+    bool is_complete() const { return status == completed; };
+
 	/// obtains the MAJOR version string of the read request
     int get_maj_version() const { if(status != completed) throw WEBDAR_BUG; return maj_vers; };
 
@@ -95,6 +126,12 @@ public:
 	/// obtain the body of the read request
     const std::string & get_body() const { if(status != completed) throw WEBDAR_BUG; return body; };
 
+	/// whether the connection can be kept open after this request has been answered
+
+	/// \note HTTP/1.1 connections are persistent unless the request has a "Connection: close"
+	/// header, HTTP/1.0 ones are not unless the request has a "Connection: keep-alive" header
+    bool is_persistent() const;
+
 	/// obtain the body splitted in as list of attribute-value pair
 	///
 	/// \note this call can be used to analyse POST request's body in response to a form
@@ -115,26 +152,78 @@ public:
 	/// raw request header header access
     bool find_attribute(const std::string & key, std::string & value) const;
 
+	/// request header access for known header fields
+    bool find_attribute(http_token::header key, std::string & value) const;
+
+
+	/// whether the body is a MIME multipart one, in which case get_body() returns an empty string
+
+	/// \note the multipart body is analysed while it is received and is only available
+	/// thanks to get_multipart_number(), get_header_of_multipart() and get_body_of_multipart()
+    bool is_multipart() const { if(status != completed) throw WEBDAR_BUG; return multipart; };
 
 	/// analyse body as a MIME multipart component (RFC 1521)
 
 	/// \return the number of multipart found in the body of the request
 	/// \note the request's header must have a header "Content-type: multipart/form-data; boundary=.....\r\n"
-	/// \note if the request is not properly formated or is not a multipart one, an exception_range is thrown
+	/// \note if the request is not properly formated or is not a multipart one, an exception_input is thrown
     unsigned int get_multipart_number() const;
 
 	/// obtains the headers of multiparts once get_multipart_number() has been executed
 
 	/// \param[in] num the part number of the multipart in this request, first part is starting at index zero
 	/// \return a map of key/value pair corresponding to the key/values pair found in the
-	/// header the multipart number "num" found in the body
-    std::map<troncon,troncon> get_header_of_multipart(unsigned int num) const; ///< first part is starting at index zero
+	/// header the multipart number "num" found in the body. Keys are in canonical case
+    const std::map<std::string, std::string> & get_header_of_multipart(unsigned int num) const; ///< first part is starting at index zero
 
 	/// obtains the body of multiparts once get_multipart_number() has been executed
 
 	/// \param[in] num the part number of the multipart in this request, first part is starting at index zero
-	/// \return the document inclosed in the multipart number "num" of the body
-    troncon get_body_of_multipart(unsigned int num) const;
+	/// \return a stream providing the document inclosed in the multipart number "num" of the body
+	/// \note large parts are not held in memory but in a temporary file
+    std::unique_ptr<std::istream> get_body_of_multipart(unsigned int num) const;
+
+	/// set the max amount of memory used to store the multipart bodies of a request
+
+	/// \note beyond that amount parts are stored in temporary files
+    static void set_multipart_memory_limit(unsigned int bytes) { multipart_memory_limit = bytes; };
+
+	/// set the max time in seconds to receive the whole header and between two pieces of body
+
+	/// \note zero means no limit, once reached exception_input is thrown with STATUS_CODE_REQUEST_TIME_OUT
+    static void set_timeouts(unsigned int header, unsigned int body) { header_timeout = header; body_timeout = body; };
+
+	/// set the max number of header fields and their max total size in bytes
+
+	/// \note once exceeded exception_input is thrown with STATUS_CODE_REQUEST_HEADER_FIELDS_TOO_LARGE
+    static void set_header_limits(unsigned int count, unsigned int size) { max_header_count = count; max_header_size = size; };
+
+	/// the max number of header fields of a request, zero for no limit
+    static unsigned int get_max_header_count() { return max_header_count; };
+
+	/// the max total size of the header fields of a request, zero for no limit
+    static unsigned int get_max_header_size() { return max_header_size; };
+
+	/// set the max size in bytes of a request body that is not a multipart one
+
+	/// \note such a body is held in memory, beyond that size exception_input is thrown with
+	/// STATUS_CODE_REQUEST_ENTITY_TOO_LARGE before the body is read
+    static void set_max_body_size(unsigned int bytes) { max_body_size = bytes; };
+
+	/// the max size in bytes of a request body that is not a multipart one
+    static unsigned int get_max_body_size() { return max_body_size; };
+
+	/// the max amount of memory used to store the multipart bodies of a request
+    static unsigned int get_multipart_memory_limit() { return multipart_memory_limit; };
+
+	/// set the max size in bytes of a multipart request body, zero for no limit
+
+	/// \note this bounds the disk space a request can fill with temporary files, beyond that
+	/// size exception_input is thrown with STATUS_CODE_REQUEST_ENTITY_TOO_LARGE before the body is read
+    static void set_max_multipart_size(unsigned int bytes) { max_multipart_size = bytes; };
+
+	/// the max size in bytes of a multipart request body, zero for no limit
+    static unsigned int get_max_multipart_size() { return max_multipart_size; };
 
 	/// set the fields in consistent state to mimic a valid request
 
@@ -145,35 +234,67 @@ private:
     enum { init, method_read, uri_read, reading_all, completed } status;
 
     std::string cached_method;    //< method already read from the next request
+    http_token::method method_id; //< identifier of cached_method once fully read
+    std::string cached_uri;       //< uri string already read from the next request
     uri coordinates;              //< uri spit in fields
     unsigned int maj_vers;        //< HTTP major version of the last request received
     unsigned int min_vers;        //< HTTP minor version of the last request received
-    std::map<std::string, std::string> attributes; //< request headers
-    std::map<std::string, std::string> cookies;    //< request cookies
+    header_list attributes;       //< request headers
+    header_list cookies;          //< request cookies
     std::string body;             //< request body if any
+    std::string field_name;       //< header field name being read, kept to reuse its memory
+    std::string field_value;      //< header field value being read, kept to reuse its memory
     std::shared_ptr<central_report> clog; //< central report logging
 
-	/// multipart pointers
-    typedef std::map<troncon, troncon> mp_header_map;
+	/// multipart body
+    bool multipart;                                   //< whether the body is a multipart one
+    std::deque<std::shared_ptr<mime_part> > mp_parts; //< parts of the multipart body
+    std::string mp_error;                             //< error met while reading the multipart body, if not empty
+    unsigned int mp_error_code;                       //< HTTP status code associated to mp_error
 
-    mutable std::deque<mp_header_map> mp_headers;
-    mutable std::deque<troncon> mp_body;
+    static unsigned int multipart_memory_limit;       //< max memory used for multipart bodies of a request
+    static unsigned int header_timeout;               //< max time to receive the whole header (seconds)
+    static unsigned int body_timeout;                 //< max time between two pieces of body (seconds)
+    static unsigned int max_header_count;             //< max number of header fields
+    static unsigned int max_header_size;              //< max total size of header fields (bytes)
+    static unsigned int max_body_size;                //< max size of a body held in memory (bytes)
+    static unsigned int max_multipart_size;           //< max size of a multipart body (bytes)
 
-    void clear_multipart() { mp_headers.clear(); mp_body.clear(); };
+    void clear_multipart() { mp_parts.clear(); mp_error.clear(); mp_error_code = 0; };
+
+	/// extract the boundary from the Content-Type header (returned with the leading two dashes)
+    std::string get_multipart_boundary() const;
+
+	/// whether the Content-Type header designates a multipart body
+    bool is_multipart_type() const;
+
+	/// read from input and analyse a multipart body of the given length
+    void read_multipart(proto_connexion & input, unsigned int length);
+
+	/// add data to a part, spooling it to a temporary file when too large
+    static void store_multipart_data(mime_part & part, const char *a, unsigned int size, unsigned int & mem_used);
 
 	/// try reading the method and uri from the connexion
+
+	/// \note the request line is bounded by max_header_size, once exceeded exception_input is
+	/// thrown in blocking mode (STATUS_CODE_NOT_IMPLEMENTED for the method,
+	/// STATUS_CODE_REQUEST_URI_TOO_LARGE for the URI), false is returned in non blocking mode
     bool read_method_uri(proto_connexion & input, bool blocking);
 
+	/// room left on the request line, zero if not limited (see up_to_crlf() for the max semantic)
+    unsigned int request_line_room() const;
+
+	/// whether the method and URI read so far exceed the limit of the request line
+
+	/// \note in blocking mode exception_input is thrown rather than returning true
+    bool request_line_exceeded(bool blocking) const;
+
 	// feed cookies fields from attributes and remove cookies from attributes
     void extract_cookies();
 
 	/// split the string argument in two intergers to fields maj_vers and min_vers
     void set_version(const std::string & version);
 
-    void add_attribute(const std::string & key, const std::string & value) { attributes.insert(std::pair<std::string, std::string>(webdar_tools_to_canonical_case(key), value)); };
-
-    void drop_attribute(const std::string & key);
-
 	/// true if next to read is end of line chars (CR LF)
     static bool is_empty_line(proto_connexion & input);
 
@@ -188,18 +309,62 @@ private:
 	/// \note Stops at end of line if the provided char is not found
     static void skip_over(proto_connexion & input, char a);
 
+	/// returns the body of the given length
+
+	/// \note the body is not allowed to exceed max_body_size
     static std::string up_to_length(proto_connexion & input, unsigned int length);
 
+	/// append length bytes of body to ret, growing it as data is received
+
+	/// \note throws exception_input with STATUS_CODE_REQUEST_ENTITY_TOO_LARGE if ret would
+	/// exceed max_body_size, before reading anything
+    static void append_body(proto_connexion & input, std::string & ret, unsigned int length);
+
+	/// returns the decoded body of a request using the chunked transfer encoding
+
+	/// \note the trailer part, if any, is read but ignored, the decoded body is
+	/// subject to the same max_body_size as a body given with a Content-Length
+    static std::string up_to_end_of_chunks(proto_connexion & input);
+
 	/// drops all data up to and including the next end of line (CR LF).
     static void skip_line(proto_connexion & input);
 
+	/// drops the spaces and tabs found next in the input
+    static void skip_blanks(proto_connexion & input);
+
+	/// scans the input buffer in place up to the next CR LF
+
+	/// \param[in] input where to read data from
+	/// \param[out] line if not nullptr, the data found before CR LF is appended to it
+	/// \param[in] max if not zero, stop once line holds more than max bytes, without consuming the rest of the line
+	/// \note the CR LF is consumed but not added to line. An exception is thrown
+	/// if the connection ends before CR LF has been found
+    static void up_to_crlf(proto_connexion & input, std::string *line, unsigned int max = 0);
+
+	/// whether the argument is a token char
+
+	/// \note token is built of any char except CTLs or tspecials
+	/// tspecials are:  ()<>@,;:\"/[]?={} space and tab
+	/// as defined by RFC 1945 paragraph 2.2 "Basic Rules".
+    static bool is_token_char(char a)
+    {
+	return a < 127 && a > 31
+	    && a != '(' && a != ')' && a != '<' && a != '>'
+	    && a != '@' && a != ',' && a != ';' && a != ':'
+	    && a != '\\' && a != '"' && a != '/' && a != '['
+	    && a != ']' && a != '?' && a != '=' && a != '{'
+	    && a != '}' && a != ' ' && a != '\t';
+    };
+
 	/// returns what remains on lines up to a real EOL (not LWS)
 
 	/// \note LWS is a CR+LF followed by any number of space or tab.
 	/// LWS allow a argument to be split over several lines. The spaces and tabs
 	/// following a CR+LF are not part of the argument.
 	/// this structure is used in header HTTP messages (RFC 1945)
-    static std::string up_to_eol_with_LWS(proto_connexion & input);
+	/// \note if max is not zero, the returned string is truncated after max + 1 bytes
+	/// \note the result is written to ret, which memory is reused
+    static void up_to_eol_with_LWS(proto_connexion & input, std::string & ret, unsigned int max = 0);
 
 	/// reads the next token from the socket
 	/// \param[in] initial defines whether we can skip space to reach the token start
@@ -208,11 +373,12 @@ private:
 	/// \return true if a complete token could be read on the current line, false
 	/// (in non blocking mode) if there is not enough data to define whether to token is
 	/// complete or not.
+	/// \param[in] max if not zero, stop once token holds more than max bytes, true is then returned
 	/// \note a token what defines the RFC 1945 at paragraph 2.2 "Basic Rules"
 	/// \note the reading of a token does fails if no more token are available on the current
 	/// line (CR, LF or CRLF met), true is returned in that case and token is set to an
 	/// empty string
-    static bool get_token(proto_connexion & input, bool initial, bool blocking, std::string & token);
+    static bool get_token(proto_connexion & input, bool initial, bool blocking, std::string & token, unsigned int max = 0);
 
 
 	/// read the next word from the socket
@@ -220,13 +386,14 @@ private:
 	/// \param[in] initial defines whether we can skip space to reach the word start
 	/// \param[in] blocking defines whether the reading is blocking or not
 	/// \param[out] word stores the read word
+	/// \param[in] max if not zero, stop once word holds more than max bytes, true is then returned
 	/// \return true if a complete word could be read on the current line, false
 	/// (in non blocking mode) if there is not enough data to define wheter the word is
 	/// complete or not.
 	/// \note a word is composed of token and the following characters '/' ':' '=' '@' '?'
 	/// \note the reading of a word fails if end of line is met, in that case true is returned
 	/// and word is set to an empty string
-    static bool get_word(proto_connexion & input, bool initial, bool blocking, std::string & word);
+    static bool get_word(proto_connexion & input, bool initial, bool blocking, std::string & word, unsigned int max = 0);
 
 };
 
@@ -38,6 +38,7 @@ extern "C"
 #include "environment.hpp"
 #include "html_text.hpp"
 #include "tooltip_messages.hpp"
+#include "static_object_library.hpp"
 
     //
 #include "saisie.hpp"
@@ -85,7 +86,7 @@ const string saisie::event_demo = "demo";
 
 saisie::saisie():
     archread(""),
-    licensing((chemin(STATIC_PATH_ID) + chemin(STATIC_OBJ_LICENSING)).display(false), "Webdar is released under the GNU Public License v3"),
+    licensing(static_object_library::get_url(STATIC_OBJ_LICENSING), "Webdar is released under the GNU Public License v3"),
     session_name("Session name",
 		 html_form_input::text,
 		 "",
@@ -94,7 +95,7 @@ saisie::saisie():
     about_fs(""),
     about_form("Change"),
     show_demo("Mini tuto", event_demo),
-    webdar_logo((chemin(STATIC_PATH_ID) + chemin(STATIC_LOGO)).display(false), "Webdar logo"),
+    webdar_logo(static_object_library::get_url(STATIC_LOGO), "Webdar logo"),
     go_extract("Restore", event_restore),
     go_compare("Compare", event_compare),
     go_test("Test", event_test),
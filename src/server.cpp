@@ -40,29 +40,17 @@ extern "C"
     // webdar headers
 #include "exceptions.hpp"
 #include "central_report.hpp"
-#include "responder.hpp"
 #include "server.hpp"
+#include "server_pool.hpp"
 #include "webdar_tools.hpp"
-#include "error_page.hpp"
-#include "challenge.hpp"
-#include "choose.hpp"
-#include "static_object_library.hpp"
 #include "global_parameters.hpp"
-#include "disconnected_page.hpp"
 
 using namespace std;
 
-static string get_session_ID_from(const request & req);
-
-bool server::default_basic_auth = true;
-
 server::server(const shared_ptr<central_report> & log,
-	       const shared_ptr<const authentication> & auth,
-	       unique_ptr<proto_connexion> & source) :
-    src(source, log),
-    can_keep_session(true),
-    locked_session(nullptr),
-    ignore_auth(default_basic_auth? no_ignore: ignore_auth_steady)
+	       server_pool & owner) :
+    pool(owner),
+    can_keep_session(true)
 {
 #ifdef LIBTHREADAR_STACK_FEATURE
     set_stack_size(DEFAULT_STACK_SIZE);
@@ -71,182 +59,42 @@ server::server(const shared_ptr<central_report> & log,
     if(!log)
 	throw WEBDAR_BUG;
     rep = log;
-    if(!auth)
-	throw WEBDAR_BUG;
-    authsrc = auth;
 }
 
 void server::inherited_run()
 {
+    shared_ptr<const authentication> auth;
+    unique_ptr<proto_connexion> source;
+
     try
     {
-	answer ans;
-	string session_ID = "";
-	uri url;
-	session *sess = nullptr;
-	challenge chal(authsrc);
-	session::session_summary info;
-	string user;
-	disconnected_page disconned;
-	choose chooser;
-	bool initial = true;
+	    // loop while the server_pool has connections for us
 
-	try
+	while(pool.fetch_connection(auth, source))
 	{
-		// outer while loop(while we are in the same TCP session)
-
-	    while(src.get_status() == proto_connexion::connected)
+	    try
 	    {
-		try
-		{
-			// inner while loop (split the flow, request by request)
-
-		    while(sess == nullptr ||
-			  (src.get_next_request_uri(url)
-			   && webdar_tools_get_session_ID_from_URI(url) == sess->get_session_ID()))
-		    {
-			cancellation_checkpoint();
-			try
-			{
-			    const request & req = src.get_request(); // pending for the next request to come
-			    ans.clear();
-
-				// extract session info if any
-			    session_ID = get_session_ID_from(req);
-
-			    if(session_ID == STATIC_PATH_ID)
-			    {
-				try
-				{
-				    const static_object *obj = nullptr;
-				    chemin tmp = req.get_uri().get_path();
+		cancellation_checkpoint();
 
-				    string objname = tmp.back();
-				    tmp.pop_back();
-				    if(tmp.front() != STATIC_PATH_ID)
-					throw WEBDAR_BUG;
-				    if(tmp.size() != 1)
-					throw exception_range("local exception to trigger an answer with STATUS_CODE_NOT_FOUND");
-				    obj = static_object_library::find_object(objname);
-				    if(obj == nullptr)
-					throw WEBDAR_BUG;
-				    ans = obj->give_answer();
-				}
-				catch(exception_range & e)
-				{
-				    ans.set_reason("unknown static object");
-				    ans.set_status(STATUS_CODE_NOT_FOUND);
-				}
-			    }
-			    else // not a path to a static object
-			    {
-				    // show the disconnected page with uri cleaned from session info
-				if(ignore_auth == ignore_auth_redir)
-				{
-				    ignore_auth = ignore_auth_steady;
-				    disconned.set_redirect(false);
-				    ans = disconned.give_answer(req);
-				}
-				    // check whether the session is authenticated
-				else if(!chal.is_an_authoritative_request(req, user)
-					|| ignore_auth == ignore_auth_steady)
-				{
-					// ask for user authentication
-				    ans = chal.give_answer(req);
-				    ignore_auth = no_ignore;
-				}
-				else // session authenticated for user "user"
-				{
-				    chooser.set_owner(user);
-
-				    if(!session::get_session_info(session_ID, info)
-				       || info.locked
-				       || info.owner != user)
-				    {
-					    // session in URL is not valid for that user
-
-					    // try creating a first session if just connected
-					    // and no other session was created so far for that
-					    // user, then go to that session (refresh in the provided answer)
-					if(!initial
-					   || !session::create_new_session(user,
-									   true,
-									   req,
-									   ans))
-
-					{
-						// else display the list of available sessions for that user
-
-					    initial = false;
-					    ans = chooser.give_answer(req);
-					    if(chooser.disconnection_requested() && !default_basic_auth)
-					    {
-						ignore_auth = ignore_auth_redir;
-						disconned.set_redirect(true);
-						ans = disconned.give_answer(req);
-					    }
-					}
-				    }
-				    else // this is a valid session for that user
-				    {
-					if(sess != nullptr && sess->get_session_ID() != session_ID)
-					    throw WEBDAR_BUG;
-
-					if(sess == nullptr)
-					{
-					    sess = session::acquire_session(session_ID);
-					    if(sess == nullptr)
-						throw WEBDAR_BUG;
-					}
-					    // obtaining the answer from the session object
-					ans = sess->give_answer(req);
-					if(sess->disconnection_requested() && !default_basic_auth)
-					{
-					    ignore_auth = ignore_auth_redir;
-					    disconned.set_redirect(true);
-					    ans = disconned.give_answer(req);
-					}
-				    }
-				}
-			    }
-
-				// send back the anwser
-			    src.send_answer(ans);
-			}
-			catch(exception_signal & e)
-			{
-				// nothing to do
-			}
-			catch(exception_input & e)
-			{
-				// nothing to do
-			}
-
-		    } // end of the inner while loop
-
-			// release the lock for the current session
-		    if(sess != nullptr)
-		    {
-			session::release_session(sess);
-			sess = nullptr;
-		    }
-		}
-		catch(...)
+		if(!conv)
 		{
-			// release the lock for the current session
-		    if(sess != nullptr)
-		    {
-			session::release_session(sess);
-			sess = nullptr;
-		    }
-		    src.close();
-		    throw;
+		    conv.reset(new (nothrow) conversation(rep, auth, source));
+		    if(!conv)
+			throw exception_memory();
 		}
-	    } // end of outler while loop
-	}
-	catch(exception_range & e)
-	{
-	    rep->report(notice, string("Server thread ending: ") + e.get_message());
+		else
+		    conv->reset(auth, source);
+
+		serve_connection();
+	    }
+	    catch(exception_range & e)
+	    {
+		rep->report(notice, string("Server thread ending connection: ") + e.get_message());
+	    }
+
+	    if(conv)
+		conv->close();
+	    source.reset();
 	}
     }
     catch(...)
@@ -257,6 +105,30 @@ void server::inherited_run()
     end_all_peers();
 }
 
+void server::serve_connection()
+{
+	// loop while we are in the same TCP session
+
+    while(conv->get_status() == proto_connexion::connected)
+    {
+	try
+	{
+	    cancellation_checkpoint();
+	    conv->answer_next_request(); // pending for the next request to come
+
+		// we keep the session acquired only if the next request
+		// is already there and addresses the same session
+	    if(!conv->next_request_for_same_session())
+		conv->release_session();
+	}
+	catch(...)
+	{
+	    conv->close();
+	    throw;
+	}
+    }
+}
+
 void server::end_all_peers()
 {
     reference* ptr = nullptr;
@@ -266,9 +138,3 @@ void server::end_all_peers()
 	break_peer_with(ptr);
 	// there should only be at most one peer: the server_pool that if we have been created by such object
 }
-
-
-static string get_session_ID_from(const request & req)
-{
-    return webdar_tools_get_session_ID_from_URI(req.get_uri());
-}
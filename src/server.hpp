@@ -31,22 +31,24 @@
 #include <libthreadar/libthreadar.hpp>
 
     // webdar headers
-#include "parser.hpp"
 #include "central_report.hpp"
-#include "session.hpp"
 #include "authentication.hpp"
-#include "choose.hpp"
+#include "conversation.hpp"
 #include "reference.hpp"
 
+class server_pool;
+
     /// class server for TCP session management
 
     /// thread object that read request from the provided proto_connexion, send them to the
     /// appropriated session, managing authentication and sending back the answer to the browser
     /// at the other end of the proto_connexion.
 
-    /// \note relies on a parser object to split byte flow into structured requests, challenge object
-    /// for authentication validation of requests, and session class to find and interrogate
-    /// the proper session. Server are spaws when an new TCP connection is received, while sessions
+    /// \note relies on a conversation object that holds a parser object to split byte flow into structured
+    /// requests, challenge object for authentication validation of requests, and session class to find and
+    /// interrogate the proper session. Server are long-lived worker threads of a server_pool: once a TCP
+    /// connection is closed, the server asks its server_pool for the next connection to handle, reusing
+    /// its conversation object, and only ends when the server_pool has no more need for it. Sessions
     /// objects stay alive accross TCP connections and are tear down on by user action on through the web
     /// interface.
 
@@ -54,9 +56,12 @@ class server: public libthreadar::thread_signal,
 	      public reference // this inheritance is used to notify server_pool objects
 {
 public:
+	/// constructor
+
+	/// \param[in] creport where to send logs
+	/// \param[in] owner the server_pool this object fetches connections from, it must survive this object
     server(const std::shared_ptr<central_report> & creport,
-	   const std::shared_ptr<const authentication> & auth,
-	   std::unique_ptr<proto_connexion> & source);
+	   server_pool & owner);
     server(const server & ref) = delete;
     server(server && ref) noexcept = delete;
     server & operator = (const server & ref) = delete;
@@ -68,7 +73,7 @@ public:
 
 
 	/// wether to emulate user logout while using basic authentication (see also class html_disconnect)
-    static void force_disconnection_at_end_of_session(bool val) { default_basic_auth = ! val; };
+    static void force_disconnection_at_end_of_session(bool val) { conversation::force_disconnection_at_end_of_session(val); };
 
 
 protected:
@@ -80,24 +85,14 @@ protected:
 
 private:
 
-    enum auth_consideration
-    {
-	ignore_auth_redir,  ///< user has just disconnected and will be redirected to steady page
-	ignore_auth_steady, ///< user has to be redirected to the steady page
-	no_ignore           ///< user has authenticated and can access webdar
-    };
-
-    parser src;                          ///< this object manages the given proto_connexion in constructor
+    server_pool & pool;                  ///< where to fetch connections from
+    std::unique_ptr<conversation> conv;  ///< the connection and its state we are in charge of (reused from a connection to the next)
     std::shared_ptr<central_report> rep; ///< where do logs should go
-    std::shared_ptr<const authentication> authsrc; ///< object to consult for user authentications
     bool can_keep_session;               ///< whether another object asked interacting with the session we use
-    session* locked_session;             ///< the current session we use (we have acquired its mutex)
-    auth_consideration ignore_auth;      ///< how to consider authentication info in request
 
+    void serve_connection();
     void end_all_peers();
 
-    static bool default_basic_auth;     ///< if true, no disconnection is provided (unless browser is restarted)
-
 };
 
 #endif
@@ -31,6 +31,9 @@ extern "C"
 #if HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 }
 
     // C++ system header files
@@ -42,17 +45,32 @@ extern "C"
 
     // webdar headers
 #include "global_parameters.hpp"
+#include "answer.hpp"
+#include "tokens.hpp"
+#include "webdar_tools.hpp"
+#include "parser.hpp"
 
     //
 #include "server_pool.hpp"
 
 using namespace std;
 
+unsigned int server_pool::max_waiting = 32;
+unsigned int server_pool::wait_deadline = 5;
+
 server_pool::server_pool(const unsigned int pool_size,
-			 const shared_ptr<central_report> & creport):
+			 const shared_ptr<central_report> & creport,
+			 unsigned int io_threads,
+			 unsigned int workers_per_io,
+			 unsigned int prespawn,
+			 unsigned int max_idle_servers):
     max_server(pool_size),
+    min_server(prespawn),
+    max_idle(max_idle_servers),
+    idle_server(0),
     log(creport),
-    verrou(1)
+    next_reactor(0),
+    verrou(2)
 {
 #ifdef LIBTHREADAR_STACK_FEATURE
     set_stack_size(DEFAULT_STACK_SIZE);
@@ -62,13 +80,94 @@ server_pool::server_pool(const unsigned int pool_size,
 	throw WEBDAR_BUG;
     if(max_server < 1)
 	throw WEBDAR_BUG;
+    if(io_threads > 0 && workers_per_io < 1)
+	throw WEBDAR_BUG;
+
+    for(unsigned int i = 0; i < io_threads; ++i)
+    {
+	unique_ptr<reactor> tmp(new (nothrow) reactor(log, workers_per_io));
+
+	if(!tmp)
+	    throw exception_memory();
+	reactors.push_back(std::move(tmp));
+    }
+
+    answer ans;
+
+    ans.set_status(STATUS_CODE_SERVICE_UNAVAILABLE);
+    ans.set_reason("Service Unavailable");
+    ans.set_version(1, 1);
+    ans.set_attribute(http_token::hdr_retry_after, webdar_tools_convert_to_string(wait_deadline));
+    ans.set_attribute(http_token::hdr_connection, VAL_CONNECTION_CLOSE);
+    ans.set_attribute(http_token::hdr_content_type, "text/plain");
+    ans.add_body("Webdar is too busy to answer, please retry later\n");
+    unavailable = ans.render();
+
+    if(min_server > max_server)
+	min_server = max_server;
+    if(max_idle < min_server)
+	max_idle = min_server;
+
     run();
 	// this launches the local thread (see inherited_run()) for sever
 	// object destruction handling
+
+    if(reactors.empty())
+    {
+	try
+	{
+	    verrou.lock();
+	    try
+	    {
+		for(unsigned int i = 0; i < min_server; ++i)
+		    spawn_server();
+	    }
+	    catch(...)
+	    {
+		verrou.unlock();
+		throw;
+	    }
+	    verrou.unlock();
+	}
+	catch(...)
+	{
+		// the local thread takes care of the servers
+		// already created, we must wait for it to end
+		// as they refer to this object
+	    cancel();
+	    try
+	    {
+		join();
+	    }
+	    catch(...)
+	    {
+		    // we propagate the original exception
+	    }
+	    throw;
+	}
+    }
+
+    instances_lock.lock();
+    try
+    {
+	instances.insert(this);
+    }
+    catch(...)
+    {
+	instances_lock.unlock();
+	cancel();
+	join();
+	throw;
+    }
+    instances_lock.unlock();
 }
 
 server_pool::~server_pool()
 {
+    instances_lock.lock();
+    instances.erase(this);
+    instances_lock.unlock();
+
     try
     {
 	cancel();
@@ -110,41 +209,48 @@ bool server_pool::run_new_server(const shared_ptr<const authentication> & auth,
 	    // be performed
     }
 
+    expire_waiting_connections();
+
     verrou.lock();
 
     try
     {
 	    //////////
-	    // creating a new server object if allowed
-	    // and adding it to the list
+	    // handing the connection to an idle server
+	    // or creating a new server object if allowed
 
-	if(size() >= max_server)
-	    ret = false;
-	else
+	if(!reactors.empty())
+	    ret = park_connection(auth, source);
+	else if(idle_server > pending.size())
 	{
-	    sigset_t sigs;
-	    server *tmp = new (nothrow) server(log, auth, source);
-
-	    if(tmp == nullptr)
-		throw exception_memory();
-	    peer_with(tmp);
-		// we only record the allocated address relying on the
-		// peering mechanism of class reference (!)
-
-	    if(sigfillset(&sigs) != 0)
-		throw exception_system("failed creating a full signal set", errno);
-	    if(sigdelset(&sigs, THREAD_SIGNAL) != 0)
-		throw exception_system("failed removing the THREAD_SIGNAL from signal set", errno);
-
-	    tmp->set_signal_mask(sigs);
-	    tmp->run();
-		// we run the object now. The peering we have setup
-		// will end once the thread will be about to end, and
-		// we will then be notified of receiving a call to
-		// broken_peering_from()
-
+	    pending.push_back(waiting_connection{ auth, std::move(source), time(nullptr) });
+	    verrou.signal(cond_servers);
+	    ret = true;
+	}
+	else if(size() < max_server)
+	{
+	    pending.push_back(waiting_connection{ auth, std::move(source), time(nullptr) });
+	    try
+	    {
+		spawn_server();
+	    }
+	    catch(...)
+	    {
+		source = std::move(pending.back().source);
+		pending.pop_back();
+		throw;
+	    }
+	    ret = true;
+	}
+	else if(pending.size() < idle_server + max_waiting)
+	{
+		// all servers are busy, the connection
+		// waits for one to become available
+	    pending.push_back(waiting_connection{ auth, std::move(source), time(nullptr) });
 	    ret = true;
 	}
+	else
+	    ret = false;
     }
     catch(...)
     {
@@ -154,6 +260,96 @@ bool server_pool::run_new_server(const shared_ptr<const authentication> & auth,
 
     verrou.unlock();
 
+    if(!ret)
+	refuse(source);
+
+    return ret;
+}
+
+void server_pool::expire_waiting_connections()
+{
+    deque<unique_ptr<proto_connexion> > expired;
+    time_t limit = time(nullptr) - wait_deadline;
+    unsigned int idle_timeout = parser::get_idle_timeout();
+
+    verrou.lock();
+    try
+    {
+	    // in event driven mode the idle connections are parked
+	    // in the reactors, no parser is there to apply the idle
+	    // timeout while waiting for their next request
+
+	if(idle_timeout > 0)
+	{
+	    for(vector<unique_ptr<reactor> >::iterator it = reactors.begin();
+		it != reactors.end();
+		++it)
+	    {
+		if(!*it)
+		    throw WEBDAR_BUG;
+		(void)(*it)->expire_idle(idle_timeout);
+	    }
+	}
+
+	    // the oldest connections are at the front of the
+	    // queue, those that an idle server is about to pick
+	    // up are not considered
+
+	while(pending.size() > idle_server
+	      && pending.front().since <= limit)
+	{
+	    expired.push_back(std::move(pending.front().source));
+	    pending.pop_front();
+	}
+    }
+    catch(...)
+    {
+	verrou.unlock();
+	throw;
+    }
+    verrou.unlock();
+
+	// sending the answers out of the critical section
+
+    while(!expired.empty())
+    {
+	refuse(expired.front());
+	expired.pop_front();
+    }
+}
+
+void server_pool::set_wait_queue(unsigned int max_conn, unsigned int deadline)
+{
+    if(deadline < 1)
+	throw WEBDAR_BUG;
+    max_waiting = max_conn;
+    wait_deadline = deadline;
+}
+
+server_pool::gauges server_pool::get_gauges()
+{
+    gauges ret;
+
+    ret.clear();
+    instances_lock.lock();
+    try
+    {
+	for(set<server_pool*>::iterator it = instances.begin();
+	    it != instances.end();
+	    ++it)
+	{
+	    if(*it == nullptr)
+		throw WEBDAR_BUG;
+	    (*it)->add_gauges(ret);
+	}
+    }
+    catch(...)
+    {
+	instances_lock.unlock();
+	throw;
+    }
+    instances_lock.unlock();
+
     return ret;
 }
 
@@ -182,7 +378,7 @@ void server_pool::inherited_run()
 
 		if(max_server > 0
 		   || size() > 0)
-		    verrou.wait(); // release the lock and wait for a signal()
+		    verrou.wait(cond_pool); // release the lock and wait for a signal()
 	    }
 	    catch(libthreadar::thread::cancel_except & e)
 	    {
@@ -202,9 +398,11 @@ void server_pool::inherited_run()
     }
     catch(...)
     {
+	drop_reactors();
 	verrou.unlock();
 	throw;
     }
+    drop_reactors();
     verrou.unlock();
 }
 
@@ -214,8 +412,17 @@ void server_pool::signaled_inherited_cancel()
     try
     {
 	cancel_all_servers(); // ask all servers to end
+	for(vector<unique_ptr<reactor> >::iterator it = reactors.begin();
+	    it != reactors.end();
+	    ++it)
+	{
+	    if(*it)
+		(*it)->cancel();
+	}
 	max_server = 0; // ask inherited_thread to end asap
-	verrou.signal(); // awake the thread.
+	pending.clear(); // closing the connections no server has picked up yet
+	verrou.broadcast(cond_servers); // idle servers will end
+	verrou.signal(cond_pool); // awake the thread.
 	    // in case no server are running, the thread
 	    // would stay pending on verrou waiting for
 	    // a signal() forever
@@ -242,7 +449,7 @@ void server_pool::broken_peering_from(reference* obj)
 	    throw WEBDAR_BUG; // was not a server object as peer!
 
 	dying_ones.push_back(dying_server);
-	verrou.signal(); // wake up inherited_run() for cleanup of the object
+	verrou.signal(cond_pool); // wake up inherited_run() for cleanup of the object
 	    // we cannot do this here because broken_peering_from
 	    // is called indirectly from the inherited_run() thread of
 	    // the server 'dying_server'
@@ -255,6 +462,32 @@ void server_pool::broken_peering_from(reference* obj)
     verrou.unlock();
 }
 
+void server_pool::add_gauges(gauges & val)
+{
+    verrou.lock();
+    try
+    {
+	val.servers += size();
+	val.idle += idle_server;
+	if(pending.size() > idle_server)
+	    val.queued += pending.size() - idle_server;
+	for(vector<unique_ptr<reactor> >::iterator it = reactors.begin();
+	    it != reactors.end();
+	    ++it)
+	{
+	    if(!*it)
+		throw WEBDAR_BUG;
+	    val.parked += (*it)->get_connection_count();
+	}
+    }
+    catch(...)
+    {
+	verrou.unlock();
+	throw;
+    }
+    verrou.unlock();
+}
+
 void server_pool::cancel_all_servers()
 {
     reference* ptr = nullptr;
@@ -268,3 +501,159 @@ void server_pool::cancel_all_servers()
 	srv->cancel();
     }
 }
+
+bool server_pool::fetch_connection(shared_ptr<const authentication> & auth,
+				   unique_ptr<proto_connexion> & source)
+{
+    bool ret = false;
+
+    verrou.lock();
+
+    try
+    {
+	    // a server that is not part of the prespawned ones
+	    // ends if enough servers are already idle
+
+	if(max_server > 0
+	   && (!pending.empty()
+	       || idle_server < max_idle
+	       || size() <= min_server))
+	{
+	    ++idle_server;
+	    try
+	    {
+		while(pending.empty() && max_server > 0)
+		    verrou.wait(cond_servers);
+	    }
+	    catch(...)
+	    {
+		--idle_server;
+		throw;
+	    }
+	    --idle_server;
+
+	    if(max_server > 0)
+	    {
+		auth = pending.front().auth;
+		source = std::move(pending.front().source);
+		pending.pop_front();
+		ret = true;
+	    }
+	}
+    }
+    catch(...)
+    {
+	verrou.unlock();
+	throw;
+    }
+
+    verrou.unlock();
+
+    return ret;
+}
+
+void server_pool::spawn_server()
+{
+    sigset_t sigs;
+    server *tmp = new (nothrow) server(log, *this);
+
+    if(tmp == nullptr)
+	throw exception_memory();
+    peer_with(tmp);
+	// we only record the allocated address relying on the
+	// peering mechanism of class reference (!)
+
+    if(sigfillset(&sigs) != 0)
+	throw exception_system("failed creating a full signal set", errno);
+    if(sigdelset(&sigs, THREAD_SIGNAL) != 0)
+	throw exception_system("failed removing the THREAD_SIGNAL from signal set", errno);
+
+    tmp->set_signal_mask(sigs);
+    tmp->run();
+	// we run the object now. The peering we have setup
+	// will end once the thread will be about to end, and
+	// we will then be notified of receiving a call to
+	// broken_peering_from()
+}
+
+void server_pool::refuse(unique_ptr<proto_connexion> & source) const
+{
+    if(!source)
+	throw WEBDAR_BUG;
+
+    try
+    {
+	    // a TLS connection would first need a handshake,
+	    // which is too long to be done here, it is just closed
+
+	if(source->can_write_now())
+	{
+	    struct iovec vec;
+
+	    vec.iov_base = (void *)(unavailable.c_str());
+	    vec.iov_len = unavailable.size();
+	    source->write_vector(&vec, 1);
+	}
+    }
+    catch(exception_range & e)
+    {
+	    // the peer has already closed the connection
+    }
+    catch(exception_system & e)
+    {
+	    // the connection has been reset by the peer
+    }
+    source.reset();
+}
+
+bool server_pool::park_connection(const shared_ptr<const authentication> & auth,
+				  unique_ptr<proto_connexion> & source)
+{
+    unsigned int count = 0;
+    unique_ptr<conversation> conv;
+
+    for(vector<unique_ptr<reactor> >::iterator it = reactors.begin();
+	it != reactors.end();
+	++it)
+    {
+	if(!*it)
+	    throw WEBDAR_BUG;
+	count += (*it)->get_connection_count();
+    }
+
+    if(count >= max_server)
+	return false;
+
+    conv.reset(new (nothrow) conversation(log, auth, source));
+    if(!conv)
+	throw exception_memory();
+
+    if(next_reactor >= reactors.size())
+	next_reactor = 0;
+    reactors[next_reactor]->park(conv);
+    ++next_reactor;
+
+    return true;
+}
+
+void server_pool::drop_reactors()
+{
+    vector<unique_ptr<reactor> > tmp;
+
+	// run_new_server() must not see the reactors disappearing
+	// while it is using them, thus the swap under verrou. The
+	// reactor destructors then stop their threads and close
+	// the connections they still hold
+    tmp.swap(reactors);
+    verrou.unlock();
+    try
+    {
+	tmp.clear();
+    }
+    catch(...)
+    {
+	verrou.lock();
+	throw;
+    }
+    verrou.lock();
+}
@@ -28,10 +28,14 @@
 #include "my_config.h"
 extern "C"
 {
-
+#if HAVE_TIME_H
+#include <time.h>
+#endif
 }
 
     // C++ system header files
+#include <deque>
+#include <set>
 #include <libthreadar/libthreadar.hpp>
 
     // webdar headers
@@ -40,23 +44,87 @@ extern "C"
 #include "authentication.hpp"
 #include "proto_connexion.hpp"
 #include "server.hpp"
+#include "reactor.hpp"
 
     /// class managing a pool of server objects
 
+    /// \note server objects are long-lived worker threads: the connections
+    /// given to run_new_server() are queued and picked up by an idle server
+    /// which resets its state from a connection to the next. A new server is
+    /// only created when no idle server is available, up to pool_size servers.
+    /// The prespawn first servers are created at construction time and never
+    /// end, while the others end when completing a connection if max_idle
+    /// servers are already waiting for a new connection.
+    /// \note when all servers are busy, a bounded number of connections can
+    /// wait for a server to become available, up to a deadline. Connections
+    /// that cannot be served this way receive a pre-rendered "503 Service
+    /// Unavailable" answer with a Retry-After header and are closed.
+    /// \note when created with io_threads > 0, the server_pool does not create
+    /// a server thread per connection but hands the connections to a set
+    /// of reactor objects (event driven mode) each having its own pool of
+    /// worker threads. The pool_size is then the max number of connections
+    /// (idle or not) held by all reactors.
+
 class server_pool : public libthreadar::thread_signal, public reference
 {
 public:
     server_pool(const unsigned int pool_size,
-		const std::shared_ptr<central_report> & log);
+		const std::shared_ptr<central_report> & log,
+		unsigned int io_threads = 0,
+		unsigned int workers_per_io = 0,
+		unsigned int prespawn = 0,
+		unsigned int max_idle = 0);
     server_pool(const server_pool & ref) = delete;
     server_pool(server_pool && ref) noexcept = delete;
     server_pool & operator = (const server_pool & ref) = delete;
     server_pool & operator = (server_pool && ref) noexcept = delete;
     virtual ~server_pool();
 
+	/// hand a new connection to a server
+
+	/// \return false if the connection has been refused, it has then been
+	/// answered with the "503 Service Unavailable" answer if possible and
+	/// closed (source is reset in any case)
     bool run_new_server(const std::shared_ptr<const authentication> & auth,
 			std::unique_ptr<proto_connexion> & source);
 
+	/// refuse the connections that have been waiting for a server beyond the deadline
+
+	/// \note to be called periodically, the refused connections receive
+	/// the "503 Service Unavailable" answer
+	/// \note in event driven mode this also closes the connections parked without
+	/// request for longer than the idle timeout (see parser::set_idle_timeout())
+    void expire_waiting_connections();
+
+	/// set the max number of connections waiting for a server and the time they can wait (in seconds)
+
+	/// \note the deadline is also the Retry-After value sent with the 503 answer
+	/// \note to be called before creating server_pool objects
+    static void set_wait_queue(unsigned int max_conn, unsigned int deadline);
+
+	/// gauges of the existing server_pool objects
+    struct gauges
+    {
+	unsigned int servers;  ///< number of server threads
+	unsigned int idle;     ///< number of server threads waiting for a connection
+	unsigned int queued;   ///< number of connections waiting for a busy server
+	unsigned int parked;   ///< number of connections held by reactors (event driven mode)
+	void clear() { servers = idle = queued = parked = 0; };
+    };
+
+	/// provides the gauges summed over all the existing server_pool objects
+    static gauges get_gauges();
+
+	/// used by server objects to obtain the next connection to handle
+
+	/// \param[out] auth the authentication base to use for the connection
+	/// \param[out] source the connection to handle
+	/// \return false if the calling server should end, true if auth and source have been set
+	/// \note this call is blocking until a connection is available or the server_pool is
+	/// stopping or has no more need for the calling server
+    bool fetch_connection(std::shared_ptr<const authentication> & auth,
+			  std::unique_ptr<proto_connexion> & source);
+
 	// run() method (inherited from libthreadar::thread_signal to be used
 	// to run the server_pool.
 
@@ -75,9 +143,27 @@ protected:
 
 
 private:
+    static constexpr const unsigned int cond_pool = 0;    ///< verrou condition index the pool thread waits on
+    static constexpr const unsigned int cond_servers = 1; ///< verrou condition index idle servers wait on
+
+	/// a connection waiting for a server to handle it
+    struct waiting_connection
+    {
+	std::shared_ptr<const authentication> auth;
+	std::unique_ptr<proto_connexion> source;
+	time_t since;   ///< when the connection has been received
+    };
+
     unsigned int max_server;             ///< max allowed number of concurrent thread
+    unsigned int min_server;             ///< number of servers that never end
+    unsigned int max_idle;               ///< max number of idle servers waiting for a connection
+    unsigned int idle_server;            ///< number of servers waiting in fetch_connection()
+    std::deque<waiting_connection> pending; ///< connections waiting for a server
+    std::string unavailable;             ///< pre-rendered answer sent to the refused connections
     std::shared_ptr<central_report> log; ///< the central report
     std::deque<server*> dying_ones;      ///< list of server object that have to be deleted
+    std::vector<std::unique_ptr<reactor> > reactors; ///< empty unless in event driven mode
+    unsigned int next_reactor;           ///< round robin index in reactors
     libthreadar::condition verrou;       ///< manages access inherited reference class fields
 	/// \note this mutex (a condition is a particular mutex) is necessary
 	/// because the reference class fields
@@ -87,8 +173,21 @@ private:
 	/// objects may request server creation on the same server_pool.
 	/// \note the condition extension of this mutex is used by the destructor
 	/// to be notified when all server object are deleted (broken_peering_from())
+	/// and by idle servers to be notified of a new pending connection
 
     void cancel_all_servers(); ///< must be called from within a critical section on verrou
+    void spawn_server();       ///< must be called from within a critical section on verrou
+    void refuse(std::unique_ptr<proto_connexion> & source) const; ///< must not be called from within a critical section on verrou
+
+    void add_gauges(gauges & val); ///< must not be called from within a critical section on verrou
+
+    static unsigned int max_waiting;   ///< max number of connections waiting for a busy server
+    static libthreadar::mutex instances_lock;  ///< protects instances
+    static std::set<server_pool*> instances;   ///< the existing server_pool objects (for get_gauges())
+    static unsigned int wait_deadline; ///< max time a connection can wait for a server (seconds)
+    bool park_connection(const std::shared_ptr<const authentication> & auth,
+			 std::unique_ptr<proto_connexion> & source); ///< must be called from within a critical section on verrou
+    void drop_reactors(); ///< must be called from within a critical section on verrou, which is released meanwhile
 
 };
 
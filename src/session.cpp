@@ -29,6 +29,7 @@ extern "C"
 }
 
     // C++ system header files
+#include <functional>
 #include <libthreadar/libthreadar.hpp>
 
     // webdar headers
@@ -95,24 +96,14 @@ void session::on_event(const string & event_name)
     //  class fields and methods implementation
     //
 
-libthreadar::mutex session::lock_running;
-map<string, session::table> session::running_session;
+session::shard session::shards[session::num_shards];
 
 unsigned int session::get_num_session()
 {
     unsigned int ret = 0;
 
-    lock_running.lock();
-    try
-    {
-	ret = running_session.size();
-    }
-    catch(...)
-    {
-        lock_running.unlock();
-	throw;
-    }
-    lock_running.unlock();
+    for(unsigned int i = 0; i < num_shards; ++i)
+	ret += snapshot(shards[i])->size();
 
     return ret;
 }
@@ -120,23 +111,17 @@ unsigned int session::get_num_session()
 unsigned int session::get_num_session(const string & user)
 {
     unsigned int ret = 0;
-    map<string, table>::iterator it;
 
-    lock_running.lock();
-    try
+    for(unsigned int i = 0; i < num_shards; ++i)
     {
-	for(it = running_session.begin(); it != running_session.end(); ++it)
+	shared_ptr<const registry> cur = snapshot(shards[i]);
+
+	for(registry::const_iterator it = cur->begin(); it != cur->end(); ++it)
 	{
-	    if(it->second.owner == user)
+	    if(it->second->owner == user)
 		++ret;
 	}
     }
-    catch(...)
-    {
-        lock_running.unlock();
-	throw;
-    }
-    lock_running.unlock();
 
     return ret;
 }
@@ -145,117 +130,93 @@ unsigned int session::get_num_session(const string & user)
 vector<session::session_summary> session::get_summary()
 {
     vector<session_summary> ret;
-    map<string, table>::iterator it;
-    session_summary tmp;
 
-    lock_running.lock();
-    try
-    {
-	it = running_session.begin();
-	while(it != running_session.end())
-	{
-	    if(it->second.reference == nullptr)
-		throw WEBDAR_BUG;
-	    tmp = publish(it);
-	    ret.push_back(tmp);
-	    ++it;
-	}
-    }
-    catch(...)
+    for(unsigned int i = 0; i < num_shards; ++i)
     {
-	lock_running.unlock();
-	throw;
+	shared_ptr<const registry> cur = snapshot(shards[i]);
+
+	for(registry::const_iterator it = cur->begin(); it != cur->end(); ++it)
+	    ret.push_back(publish(it->first, *(it->second)));
     }
-    lock_running.unlock();
 
     return ret;
 }
 
 bool session::get_session_info(const string & session_ID, session_summary & val)
 {
-    bool ret = false;
-    map<string, table>::iterator it;
-
-    lock_running.lock();
-    try
-    {
-	it = running_session.find(session_ID);
-	if(it != running_session.end())
-	{
-	    val = publish(it);
-	    if(val.session_ID != session_ID)
-		throw WEBDAR_BUG;
-	    ret = true;
-	}
+    shared_ptr<table> entry = lookup(session_ID);
 
-    }
-    catch(...)
+    if(entry)
     {
-	lock_running.unlock();
-	throw;
+	val = publish(session_ID, *entry);
+	return true;
     }
-    lock_running.unlock();
-
-    return ret;
+    else
+	return false;
 }
 
 string session::create_new(const string & owner)
 {
-    table entry;
+    shared_ptr<table> entry(new (nothrow) table());
     string sessID;
-    session *obj = new (nothrow) session();
     unsigned int collision = 0;
     unsigned id_width = INITIAL_SESSION_ID_WIDTH;
+    bool inserted = false;
 
-    if(obj == nullptr)
+    if(!entry)
 	throw exception_range("Cannot create a new session, lack of memory to do so");
-    else
-	obj->wui.set_username(owner);
+    entry->reference = new (nothrow) session();
+    if(entry->reference == nullptr)
+	throw exception_range("Cannot create a new session, lack of memory to do so");
+    entry->owner = owner;
+    entry->reference->wui.set_username(owner);
 
-    try
+	// looking whether the new session_ID is not already used
+    do
     {
-	entry.clear();
+	sessID = webdar_tools_generate_random_string(id_width);
+	shard & sh = shard_of(sessID);
 
-	lock_running.lock();
+	sh.lock.lock();
 	try
 	{
-		// looking whether the new session_ID is not already used
-	    do
+	    shared_ptr<const registry> cur = snapshot(sh);
+
+	    if(cur->find(sessID) == cur->end())
 	    {
-		sessID = webdar_tools_generate_random_string(id_width);
-		    // OK, this may lead to an endless loop if all sessions
-		    // are used so we count up to MAX_FAILURE and then
-		    // increase the session_ID length by one
-		++collision;
-		if(collision > MAX_COLLISION)
-		{
-		    collision = 0;
-		    ++id_width;
-		    if(id_width > MAXIMUM_SESSION_ID_WIDTH)
-			throw exception_range("Cannot allocate new session, namespace full");
-		}
+		shared_ptr<registry> next(new (nothrow) registry(*cur));
+
+		if(!next)
+		    throw exception_memory();
+		entry->reference->set_session_id(sessID);
+		(*next)[sessID] = entry;
+		atomic_store(&sh.current, shared_ptr<const registry>(next));
+		inserted = true;
 	    }
-	    while(running_session.find(sessID) != running_session.end());
-
-	    obj->set_session_id(sessID);
-	    entry.owner = owner;
-	    entry.reference = obj;
-
-	    running_session[sessID] = entry;
 	}
 	catch(...)
 	{
-	    lock_running.unlock();
+	    sh.lock.unlock();
 	    throw;
 	}
-	lock_running.unlock();
-    }
-    catch(...)
-    {
-	if(obj != nullptr)
-	    delete obj;
-	throw;
+	sh.lock.unlock();
+
+	if(!inserted)
+	{
+		// OK, this may lead to an endless loop if all sessions
+		// are used so we count up to MAX_FAILURE and then
+		// increase the session_ID length by one
+	    ++collision;
+	    if(collision > MAX_COLLISION)
+	    {
+		collision = 0;
+		++id_width;
+		if(id_width > MAXIMUM_SESSION_ID_WIDTH)
+		    throw exception_range("Cannot allocate new session, namespace full");
+	    }
+	}
     }
+    while(!inserted);
 
     return sessID;
 }
@@ -263,27 +224,23 @@ string session::create_new(const string & owner)
 session *session::acquire_session(const string & session_ID)
 {
     session *ret = nullptr;
-    map<string,table>::iterator it;
-
-    lock_running.lock();
+    shared_ptr<table> entry = lookup(session_ID);
 
-    try
+    if(entry)
     {
-	it = running_session.find(session_ID);
-	if(it != running_session.end() && !(it->second.closing))
+	    // ref_given is incremented before checking the closing flag while
+	    // close_session() sets the closing flag before checking ref_given,
+	    // so either we see the session closing, or it sees us referring to it
+	++(entry->ref_given);
+	if(entry->closing)
+	    give_back(session_ID, entry);
+	else
 	{
-	    if(it->second.reference == nullptr)
+	    if(entry->reference == nullptr)
 		throw WEBDAR_BUG;
-	    ret = it->second.reference;
-	    ++(it->second.ref_given);
+	    ret = entry->reference;
 	}
     }
-    catch(...)
-    {
-	lock_running.unlock();
-	throw;
-    }
-    lock_running.unlock();
 
     if(ret != nullptr)
     {
@@ -297,111 +254,118 @@ session *session::acquire_session(const string & session_ID)
 
 void session::release_session(session *sess)
 {
-    map<string,table>::iterator it;
+    shared_ptr<table> entry;
 
     if(sess == nullptr)
 	throw WEBDAR_BUG;
 
-    lock_running.lock();
-    try
-    {
-	it = running_session.begin();
+    entry = lookup(sess->session_ID);
 
-	while(it != running_session.end() && it->second.reference != sess)
-	    ++it;
+	// checks
+    if(!entry || entry->reference != sess)
+	throw WEBDAR_BUG; // releasing an unknown session !?!
+    sess->check_caller();
 
-	    // checks
-	if(it == running_session.end())
-	    throw WEBDAR_BUG; // releasing an unknown session !?!
-	sess->check_caller();
+	// all check passed, we can proceed
+    sess->lock_wui.unlock();
+    give_back(sess->session_ID, entry);
+}
 
-	    // all check passed, we can proceed
-	--(it->second.ref_given);
-	sess->lock_wui.unlock();
-	if(it->second.ref_given == 0 && it->second.closing)
-	{
-	    if(it->second.reference == nullptr)
-		throw WEBDAR_BUG;
-	    if(it->second.reference->has_working_server())
-		throw WEBDAR_BUG;
-	    delete it->second.reference;
-	    running_session.erase(it);
-	}
-    }
-    catch(...)
+
+bool session::close_session(const string & session_ID)
+{
+    shared_ptr<table> entry = lookup(session_ID);
+
+    if(!entry)
+	return false;
+
+    if(!entry->closing.exchange(true))
     {
-	lock_running.unlock();
-	throw;
+	if(entry->ref_given == 0)
+	    remove(session_ID, entry);
+	    // else the object will be destroyed when no more reference will point it
     }
-    lock_running.unlock();
+	// else this session end has already been asked
+
+    return true; // session will be destroyed as soon as possible
 }
 
+session::shard & session::shard_of(const string & session_ID)
+{
+    return shards[hash<string>()(session_ID) % num_shards];
+}
 
-bool session::close_session(const string & session_ID)
+shared_ptr<session::table> session::lookup(const string & session_ID)
+{
+    shared_ptr<const registry> cur = snapshot(shard_of(session_ID));
+    registry::const_iterator it = cur->find(session_ID);
+
+    if(it != cur->end())
+	return it->second;
+    else
+	return shared_ptr<table>();
+}
+
+void session::give_back(const string & session_ID, const shared_ptr<table> & entry)
+{
+    if(!entry)
+	throw WEBDAR_BUG;
+
+    if(--(entry->ref_given) == 0 && entry->closing)
+	remove(session_ID, entry);
+}
+
+void session::remove(const string & session_ID, const shared_ptr<table> & entry)
 {
-    lock_running.lock();
-    map<string, table>::iterator it;
-    bool ret = false;
+    shard & sh = shard_of(session_ID);
 
+	// the session object is deleted by the caller when releasing
+	// its reference to the entry, not while holding the shard lock
+
+    sh.lock.lock();
     try
     {
-	it = running_session.find(session_ID);
-	if(it != running_session.end())
+	shared_ptr<const registry> cur = snapshot(sh);
+	registry::const_iterator it = cur->find(session_ID);
+
+	    // the entry may have already been removed by a concurrent thread
+	if(it != cur->end() && it->second == entry)
 	{
-	    if(!it->second.closing)
-	    {
-		it->second.closing = true;
-		if(it->second.ref_given == 0)
-		{
-		    if(it->second.reference != nullptr)
-		    {
-			try
-			{
-			    delete it->second.reference;
-			}
-			catch(...)
-			{
-			    running_session.erase(it);
-			    throw;
-			}
-			    running_session.erase(it);
-		    }
-		    else
-			throw WEBDAR_BUG;
-		}
-		    // else the object will be destroyed when no more reference will point it
-		ret = true; // session will be destroyed as soon as possible
-	    }
-	    else
-		ret = true; // this session end has already been asked
+	    shared_ptr<registry> next;
+
+	    if(entry->reference == nullptr)
+		throw WEBDAR_BUG;
+	    if(entry->reference->has_working_server())
+		throw WEBDAR_BUG;
+
+	    next.reset(new (nothrow) registry(*cur));
+	    if(!next)
+		throw exception_memory();
+	    next->erase(session_ID);
+	    atomic_store(&sh.current, shared_ptr<const registry>(next));
 	}
-	else
-	    ret = false;
     }
     catch(...)
     {
-	lock_running.unlock();
+	sh.lock.unlock();
 	throw;
     }
-
-    lock_running.unlock();
-
-    return ret;
+    sh.lock.unlock();
 }
 
-session::session_summary session::publish(map<string, table>::iterator it)
+session::session_summary session::publish(const string & session_ID, const table & entry)
 {
     session_summary ret;
 
-    if(it->second.reference == nullptr)
+    if(entry.reference == nullptr)
 	throw WEBDAR_BUG;
     ret.clear();
-    ret.owner = it->second.owner;
-    ret.session_ID = it->first;
-    ret.session_name = it->second.reference->wui.get_session_name(); // yes session name is stored and managed in the GUI component
-    ret.locked = it->second.reference->has_working_server();
-    ret.libdar_running = it->second.reference->wui.is_libdar_running(); // yes an access without locking the object but read only and on an atomic field
-    ret.closing = it->second.closing;
+    ret.owner = entry.owner;
+    ret.session_ID = session_ID;
+    ret.session_name = entry.reference->wui.get_session_name(); // yes session name is stored and managed in the GUI component
+    ret.locked = entry.reference->has_working_server();
+    ret.libdar_running = entry.reference->wui.is_libdar_running(); // yes an access without locking the object but read only and on an atomic field
+    ret.closing = entry.closing;
 
     return ret;
 }
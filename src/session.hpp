@@ -32,6 +32,9 @@ extern "C"
 
     // C++ system header files
 #include <list>
+#include <map>
+#include <memory>
+#include <atomic>
 #include <libthreadar/libthreadar.hpp>
 
     // webdar headers
@@ -156,18 +159,50 @@ private:
 	//
 
 	/// wraps a session object with some metadata
+
+	/// \note entries are shared between the table snapshots and the threads having looked
+	/// them up, the session object is deleted with the last reference to its entry
     struct table
     {
-	std::string owner;      ///< to whom the session is
-	session *reference;     ///< object reference
-	unsigned int ref_given; ///< number of time the reference to that object has been given
-	bool closing;           ///< if true the reference must not be given any longer
-	void clear() { owner = ""; reference = nullptr; ref_given = 0; closing = false; };
+	std::string owner;                   ///< to whom the session is
+	session *reference;                  ///< object reference, owned by the entry
+	std::atomic<unsigned int> ref_given; ///< number of time the reference to that object has been given (or is being given)
+	std::atomic<bool> closing;           ///< if true the reference must not be given any longer
+
+	table(): reference(nullptr), ref_given(0), closing(false) {};
+	table(const table & ref) = delete;
+	table(table && ref) = delete;
+	table & operator = (const table & ref) = delete;
+	table & operator = (table && ref) = delete;
+	~table() { if(reference != nullptr) delete reference; };
     };
 
-    static libthreadar::mutex lock_running;       ///< control access to runnng_session static table
-    static std::map<std::string, table> running_session;     ///< list of existing sessions
-    static session_summary publish(std::map<std::string, table>::iterator it);
+	/// sessions of a shard indexed by session ID
+    typedef std::map<std::string, std::shared_ptr<table> > registry;
+
+	/// a part of the session table, the shard of a session depends on its session ID
+
+	/// \note the registry is never modified once published, lookups read the current one
+	/// with std::atomic_load() without taking the lock, which is only used to serialize
+	/// the creation and removal of sessions (that replace the registry by a modified copy)
+    struct shard
+    {
+	libthreadar::mutex lock;                 ///< serializes the registry replacements
+	std::shared_ptr<const registry> current; ///< current registry, to be accessed with std::atomic_load/store
+
+	shard(): current(std::make_shared<const registry>()) {};
+    };
+
+    static constexpr unsigned int num_shards = 16;
+
+    static shard shards[num_shards];          ///< the session table
+
+    static shard & shard_of(const std::string & session_ID);
+    static std::shared_ptr<const registry> snapshot(const shard & sh) { return std::atomic_load(&sh.current); };
+    static std::shared_ptr<table> lookup(const std::string & session_ID);
+    static void give_back(const std::string & session_ID, const std::shared_ptr<table> & entry); ///< decrements ref_given and removes a closing entry not referred any more
+    static void remove(const std::string & session_ID, const std::shared_ptr<table> & entry); ///< removes entry from the table if still present
+    static session_summary publish(const std::string & session_ID, const table & entry);
     static std::string create_new(const std::string & owner); /// returns the session_ID of the newly created session
 };
 
@@ -44,6 +44,14 @@ extern "C"
 #if HAVE_FCNTL_H
 #include <fcntl.h>
 #endif
+
+#if HAVE_TIME_H
+#include <time.h>
+#endif
+
+#if HAVE_POLL_H
+#include <poll.h>
+#endif
 }
 
     // webdar headers
@@ -52,17 +60,40 @@ extern "C"
 
 using namespace std;
 
+    /// max time in second a client has to complete the TLS handshake
+#define TLS_HANDSHAKE_TIMEOUT 10
+
+    /// max time in second the peer has to accept more data when the socket is full
+#define TLS_WRITE_TIMEOUT 60
+
 ssl_connexion::ssl_connexion(int fd, SSL_CTX & ctx, const string & peerip, unsigned int peerport):
     connexion(fd, peerip, peerport)
 {
     ssl = SSL_new(&ctx);
     if(ssl == nullptr)
 	throw exception_openssl();
-    if(! SSL_set_fd(ssl, fd))
-	throw exception_openssl();
-    (void)SSL_set_mode(ssl, SSL_MODE_AUTO_RETRY); // is set by default, but this does not hurt forcing this mode here
-    if(!SSL_accept(ssl))
-	throw exception_openssl();
+
+    try
+    {
+	if(! SSL_set_fd(ssl, fd))
+	    throw exception_openssl();
+
+	int flag = fcntl(fd, F_GETFL);
+	if(flag < 0 || fcntl(fd, F_SETFL, flag | O_NONBLOCK) < 0)
+	    throw exception_system("Failed setting socket in non-blocking mode: ", errno);
+    }
+    catch(...)
+    {
+	    // the destructor is not run for an object which construction failed
+	SSL_free(ssl);
+	throw;
+    }
+
+    (void)SSL_set_mode(ssl, SSL_MODE_AUTO_RETRY); // has no effect on non-blocking sockets but does not hurt either
+    SSL_set_accept_state(ssl);
+    handshake_done = false;
+    handshake_deadline = time(nullptr) + TLS_HANDSHAKE_TIMEOUT;
+    ktls_send = false;
 }
 
 ssl_connexion::~ssl_connexion()
@@ -70,31 +101,60 @@ ssl_connexion::~ssl_connexion()
     SSL_free(ssl);
 }
 
+string ssl_connexion::get_application_protocol()
+{
+    const unsigned char *proto = nullptr;
+    unsigned int len = 0;
+
+    if(!handshake(true))
+	throw WEBDAR_BUG;
+
+    SSL_get0_alpn_selected(ssl, &proto, &len);
+    if(proto == nullptr)
+	return "";
+    else
+	return string((const char *)(proto), len);
+}
+
 unsigned int ssl_connexion::read_impl(char *a, unsigned int size, bool blocking)
 {
     size_t lu = 0;
-    int fd = SSL_get_fd(ssl);
+    int code;
 
-    if(fd < 0)
-	throw exception_openssl();
+    if(!handshake(blocking))
+	return 0; // handshake still in progress in non-blocking mode
 
-    int flag = fcntl(fd, F_GETFL);
-    if(blocking)
-	fcntl(fd, F_SETFL, flag & ~O_NONBLOCK);
-    else
-	fcntl(fd, F_SETFL, flag | O_NONBLOCK);
+	// the socket is non-blocking, blocking mode is
+	// obtained by waiting with poll() and retrying
 
-    try
+    while(! SSL_read_ex(ssl, (void *)a, size, &lu))
     {
-	if(! SSL_read_ex(ssl, (void *)a, size, &lu))
+	code = SSL_get_error(ssl, 0);
+
+	switch(code)
+	{
+	case SSL_ERROR_WANT_READ:
+	case SSL_ERROR_WANT_WRITE:
+	    if(!blocking)
+		return 0; // no data available in non-blocking mode
+	    else
+	    {
+		int wait = get_read_wait();
+
+		while(!wait_for(code, wait, true))
+		    wait = get_read_wait();
+	    }
+	    break;
+	case SSL_ERROR_ZERO_RETURN:
+	    throw exception_range("reached end of data on TLS connection");
+	case SSL_ERROR_SYSCALL:
+	    if(errno == EINTR)
+		throw exception_signal();
+	    throw exception_range("TLS connection closed by peer");
+	default:
 	    throw exception_openssl();
+	}
     }
-    catch(...)
-    {
-	fcntl(fd, F_SETFL, flag);
-	throw;
-    }
-    fcntl(fd, F_SETFL, flag);
 
     return (unsigned int)lu;
 }
@@ -103,12 +163,114 @@ void ssl_connexion::write_impl(const char *a, unsigned int size)
 {
     size_t wrote = 0;
     size_t wrote_total = 0;
+    int code;
+
+    if(!handshake(true))
+	throw WEBDAR_BUG;
 
     while(wrote_total < size)
     {
+	count_write_syscall();
 	if(! SSL_write_ex(ssl, (void *)(a + wrote_total), size - wrote_total, &wrote))
-	    throw exception_openssl();
+	{
+	    code = SSL_get_error(ssl, 0);
+
+	    switch(code)
+	    {
+	    case SSL_ERROR_WANT_READ:
+	    case SSL_ERROR_WANT_WRITE:
+		    // retrying with the same arguments, as expected by openssl
+		if(!wait_for(code, TLS_WRITE_TIMEOUT * 1000))
+		    throw exception_range("TLS peer did not accept data in time");
+		    // a peer that stops reading must not hold the thread for ever
+		break;
+	    case SSL_ERROR_SYSCALL:
+		throw exception_range("TLS connection closed by peer");
+	    default:
+		throw exception_openssl();
+	    }
+	}
 	else
 	    wrote_total += wrote;
     }
 }
+
+void ssl_connexion::write_vector_impl(const struct iovec *vec,
+				      unsigned int count,
+				      const shared_ptr<const string> & owner)
+{
+    if(ktls_send)
+	connexion::write_vector_impl(vec, count, shared_ptr<const string>());
+	// the kernel builds the TLS records from what is written to the socket,
+	// but zero-copy is not supported by the kernel TLS layer
+    else
+	proto_connexion::write_vector_impl(vec, count, owner);
+}
+
+void ssl_connexion::send_file_impl(const struct iovec *vec, unsigned int count, int fd, off_t offset, size_t size)
+{
+    if(ktls_send)
+	connexion::send_file_impl(vec, count, fd, offset, size);
+    else
+	proto_connexion::send_file_impl(vec, count, fd, offset, size);
+}
+
+bool ssl_connexion::handshake(bool blocking)
+{
+    int ret;
+    int code;
+    time_t remaining;
+
+    if(handshake_done)
+	return true;
+
+    do
+    {
+	remaining = handshake_deadline - time(nullptr);
+	if(remaining <= 0)
+	    throw exception_range("TLS handshake not completed in time");
+
+	ret = SSL_do_handshake(ssl);
+	code = ret == 1 ? SSL_ERROR_NONE : SSL_get_error(ssl, ret);
+
+	switch(code)
+	{
+	case SSL_ERROR_NONE:
+	    handshake_done = true;
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+	    ktls_send = BIO_get_ktls_send(SSL_get_wbio(ssl));
+		// false if kTLS was not requested in the SSL_CTX or if
+		// the kernel does not support the negociated cipher
+#endif
+	    break;
+	case SSL_ERROR_WANT_READ:
+	case SSL_ERROR_WANT_WRITE:
+	    if(!blocking)
+		return false;
+	    if(!wait_for(code, remaining * 1000))
+		throw exception_range("TLS handshake not completed in time");
+		// a blocking handshake must not hold the thread for ever
+	    break;
+	case SSL_ERROR_SYSCALL:
+	    throw exception_range("connection closed during TLS handshake");
+	default:
+	    throw exception_openssl();
+	}
+    }
+    while(!handshake_done);
+
+    return true;
+}
+
+bool ssl_connexion::wait_for(int code, int timeout, bool interruptible)
+{
+    switch(code)
+    {
+    case SSL_ERROR_WANT_READ:
+	return wait_socket(POLLIN, timeout, interruptible);
+    case SSL_ERROR_WANT_WRITE:
+	return wait_socket(POLLOUT, timeout, interruptible);
+    default:
+	throw WEBDAR_BUG;
+    }
+}
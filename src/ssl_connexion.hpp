@@ -33,6 +33,10 @@ extern "C"
 #if HAVE_OPENSSL_SSL_H
 #include <openssl/ssl.h>
 #endif
+
+#if HAVE_TIME_H
+#include <time.h>
+#endif
 }
 
     // C++ system header files
@@ -51,6 +55,13 @@ class ssl_connexion : public connexion
 public:
 
 	/// constructor: create a new object based on a existing socket filedescriptor
+
+	/// \note the socket is set in non-blocking mode once for all, blocking
+	/// operations wait with poll() for the socket to be ready
+	/// \note the TLS handshake is not done here but by the first read or
+	/// write operation, this way it is not run by the thread accepting the
+	/// connections. It has to complete within a limited time, else the
+	/// connection is dropped (exception_range is thrown)
     ssl_connexion(int fd, SSL_CTX & ctx, const std::string & peerip, unsigned int peerport);
 
 	/// copy is forbidden, move is allowed
@@ -62,6 +73,20 @@ public:
 	/// destructor
     ~ssl_connexion();
 
+	/// whether the TLS handshake has completed
+    bool is_handshake_done() const { return handshake_done; };
+
+	/// whether record ciphering for sending is done by the kernel (kTLS)
+
+	/// \note only meaningful once the handshake has completed
+    bool is_ktls_send() const { return ktls_send; };
+
+	/// inherited from proto_connexion
+    virtual bool can_write_now() const override { return handshake_done; };
+
+	/// inherited from proto_connexion
+    virtual std::string get_application_protocol() override;
+
 protected:
 
 	/// inherited from proto_connexion
@@ -70,9 +95,41 @@ protected:
     	/// inherited from proto_connexion
     virtual unsigned int read_impl(char *a, unsigned int size, bool blocking) override;
 
+	/// inherited from proto_connexion
+    virtual bool read_pending_impl() const override { return SSL_pending(ssl) > 0; };
+
+	/// inherited from proto_connexion
+
+	/// \note unless the kernel does the ciphering, data has to go through the
+	/// TLS layer and we cannot rely on connexion's implementation
+    virtual void write_vector_impl(const struct iovec *vec,
+				   unsigned int count,
+				   const std::shared_ptr<const std::string> & owner) override;
+
+	/// inherited from proto_connexion
+    virtual void send_file_impl(const struct iovec *vec, unsigned int count, int fd, off_t offset, size_t size) override;
+
 private:
 
-    SSL *ssl;     ///< holds ssl status
+    SSL *ssl;        ///< holds ssl status
+    bool handshake_done; ///< whether the TLS handshake has completed
+    time_t handshake_deadline; ///< time at which the handshake must have completed
+    bool ktls_send;  ///< whether the kernel ciphers what we send
+
+	/// run or continue the TLS handshake
+
+	/// \param[in] blocking whether to wait for the handshake to complete
+	/// \return true if the handshake has completed, false if more data has
+	/// to be received (only in non-blocking mode)
+    bool handshake(bool blocking);
+
+	/// wait for the socket to be ready after a SSL_ERROR_WANT_* openssl error code
+
+	/// \param[in] code the openssl error code
+	/// \param[in] timeout in millisecond, -1 for no limit
+	/// \param[in] interruptible if true exception_signal is thrown when a signal is received
+	/// \return false if the timeout expired
+    bool wait_for(int code, int timeout, bool interruptible = false);
 
 };
 
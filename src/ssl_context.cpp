@@ -25,15 +25,41 @@
 #include "my_config.h"
 extern "C"
 {
+#if HAVE_OPENSSL_RAND_H
+#include <openssl/rand.h>
+#endif
+
+#if HAVE_OPENSSL_EVP_H
+#include <openssl/evp.h>
+#endif
+
+#if HAVE_OPENSSL_CORE_NAMES_H
+#include <openssl/core_names.h>
+#endif
+
+#if HAVE_STRING_H
+#include <string.h>
+#endif
 }
 
     // webdar headers
+#include "webdar_tools.hpp"
 
 #include "ssl_context.hpp"
 
 using namespace std;
 
 bool ssl_context::initialized = false;
+bool ssl_context::ktls = false;
+bool ssl_context::http2 = false;
+unsigned int ssl_context::session_cache_size = 1024;
+unsigned int ssl_context::session_lifetime = 3600;
+
+    /// session ID context (sessions are not shared with other applications)
+static const unsigned char session_id_context[] = "webdar";
+
+    /// application protocols we support, in preference order and in ALPN wire format
+static const unsigned char alpn_protocols[] = "\x02h2\x08http/1.1";
 
 ssl_context::ssl_context(const string & certificate, const string & privatekey)
 {
@@ -57,6 +83,18 @@ ssl_context::ssl_context(const string & certificate, const string & privatekey)
 
 	if(! SSL_CTX_check_private_key(ctx))
 	    throw exception_openssl();
+
+#ifdef SSL_OP_ENABLE_KTLS
+	if(ktls)
+	    (void)SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+	    // openssl silently falls back to user space
+	    // ciphering if the kernel cannot do the job
+#endif
+
+	set_session_resumption();
+
+	if(http2)
+	    SSL_CTX_set_alpn_select_cb(ctx, alpn_callback, nullptr);
     }
     catch(...)
     {
@@ -66,6 +104,38 @@ ssl_context::ssl_context(const string & certificate, const string & privatekey)
 }
 
 
+void ssl_context::set_session_cache(unsigned int cache_size, unsigned int lifetime)
+{
+    if(lifetime == 0)
+	throw exception_range("TLS session lifetime cannot be zero");
+    session_cache_size = cache_size;
+    session_lifetime = lifetime;
+}
+
+string ssl_context::get_session_stats()
+{
+    return string("TLS sessions: ")
+	+ webdar_tools_convert_to_string(SSL_CTX_sess_accept(ctx))
+	+ " handshake(s), "
+	+ webdar_tools_convert_to_string(SSL_CTX_sess_hits(ctx))
+	+ " resumed (cache hit), "
+	+ webdar_tools_convert_to_string(SSL_CTX_sess_misses(ctx))
+	+ " cache miss(es), "
+	+ webdar_tools_convert_to_string(SSL_CTX_sess_timeouts(ctx))
+	+ " expired, "
+	+ webdar_tools_convert_to_string(SSL_CTX_sess_number(ctx))
+	+ " in cache";
+}
+
+bool ssl_context::ktls_available()
+{
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+    return true;
+#else
+    return false;
+#endif
+}
+
 void ssl_context::go_init_openssl()
 {
     if(!initialized)
@@ -79,3 +149,164 @@ void ssl_context::go_init_openssl()
     }
 }
 
+void ssl_context::set_session_resumption()
+{
+    if(session_cache_size == 0)
+    {
+	(void)SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+	(void)SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+	return;
+    }
+
+    (void)SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    (void)SSL_CTX_sess_set_cache_size(ctx, session_cache_size);
+    (void)SSL_CTX_set_timeout(ctx, session_lifetime);
+    if(! SSL_CTX_set_session_id_context(ctx, session_id_context, sizeof(session_id_context) - 1))
+	throw exception_openssl();
+
+#ifdef WEBDAR_TICKET_KEYS
+    tickets.reset(new (nothrow) ticket_keys());
+    if(!tickets)
+	throw exception_memory();
+
+    generate_key(tickets->current);
+    tickets->has_previous = false;
+    tickets->period = session_lifetime;
+    tickets->renewal = time(nullptr) + session_lifetime;
+
+    if(! SSL_CTX_set_app_data(ctx, tickets.get()))
+	throw exception_openssl();
+    if(! SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, ticket_callback))
+	throw exception_openssl();
+#endif
+	// else openssl uses a single ticket key generated at startup
+}
+
+#ifdef WEBDAR_TICKET_KEYS
+int ssl_context::ticket_callback(SSL *ssl,
+				 unsigned char key_name[16],
+				 unsigned char *iv,
+				 EVP_CIPHER_CTX *cctx,
+				 EVP_MAC_CTX *hctx,
+				 int enc)
+{
+    ticket_keys *keys = nullptr;
+    ticket_key used;
+    int ret = -1;
+    OSSL_PARAM params[3];
+
+    if(ssl == nullptr)
+	return -1;
+
+    keys = (ticket_keys *)(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    if(keys == nullptr)
+	return -1;
+
+	// no exception must cross openssl code
+    try
+    {
+	keys->control.lock();
+	try
+	{
+	    time_t now = time(nullptr);
+
+	    if(now >= keys->renewal)
+	    {
+		keys->previous = keys->current;
+		keys->has_previous = true;
+		generate_key(keys->current);
+		keys->renewal = now + keys->period;
+	    }
+
+	    if(enc != 0)
+	    {
+		used = keys->current;
+		ret = 1;
+	    }
+	    else
+	    {
+		if(memcmp(key_name, keys->current.name, sizeof(keys->current.name)) == 0)
+		{
+		    used = keys->current;
+		    ret = 1;
+		}
+		else if(keys->has_previous
+			&& memcmp(key_name, keys->previous.name, sizeof(keys->previous.name)) == 0)
+		{
+		    used = keys->previous;
+		    ret = 2; // ticket is valid but has to be renewed
+		}
+		else
+		    ret = 0; // unknown key, a full handshake will take place
+	    }
+	}
+	catch(...)
+	{
+	    keys->control.unlock();
+	    throw;
+	}
+	keys->control.unlock();
+    }
+    catch(...)
+    {
+	return -1;
+    }
+
+    if(ret <= 0)
+	return ret;
+
+    params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, used.hmac, sizeof(used.hmac));
+    params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char *)"sha256", 0);
+    params[2] = OSSL_PARAM_construct_end();
+
+    if(enc != 0)
+    {
+	(void)memcpy(key_name, used.name, sizeof(used.name));
+	if(RAND_bytes(iv, EVP_CIPHER_get_iv_length(EVP_aes_256_cbc())) <= 0)
+	    return -1;
+	if(! EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), nullptr, used.aes, iv))
+	    return -1;
+    }
+    else
+    {
+	if(! EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), nullptr, used.aes, iv))
+	    return -1;
+    }
+
+    if(! EVP_MAC_CTX_set_params(hctx, params))
+	return -1;
+
+    return ret;
+}
+#endif
+
+int ssl_context::alpn_callback(SSL *ssl,
+			      const unsigned char **out,
+			      unsigned char *outlen,
+			      const unsigned char *in,
+			      unsigned int inlen,
+			      void *arg)
+{
+    unsigned char *selected = nullptr;
+
+	// our list is the first argument, for our preference order to be used
+
+    if(SSL_select_next_proto(&selected,
+			     outlen,
+			     alpn_protocols,
+			     sizeof(alpn_protocols) - 1,
+			     in,
+			     inlen) != OPENSSL_NPN_NEGOTIATED)
+	return SSL_TLSEXT_ERR_NOACK; // no common protocol, going on without ALPN (HTTP/1.x)
+
+    *out = selected;
+    return SSL_TLSEXT_ERR_OK;
+}
+
+void ssl_context::generate_key(ticket_key & key)
+{
+    if(RAND_bytes(key.name, sizeof(key.name)) <= 0
+       || RAND_bytes(key.aes, sizeof(key.aes)) <= 0
+       || RAND_bytes(key.hmac, sizeof(key.hmac)) <= 0)
+	throw exception_openssl();
+}
@@ -31,10 +31,21 @@ extern "C"
 #if HAVE_OPENSSL_SSL_H
 #include <openssl/ssl.h>
 #endif
+
+#if HAVE_TIME_H
+#include <time.h>
+#endif
 }
 
+#if defined(OPENSSL_VERSION_NUMBER) && OPENSSL_VERSION_NUMBER >= 0x30000000L
+    /// session ticket keys are managed by webdar (EVP_MAC based callback is only available since openssl 3.0)
+#define WEBDAR_TICKET_KEYS 1
+#endif
+
     // C++ system header files
 #include <string>
+#include <memory>
+#include <libthreadar/libthreadar.hpp>
 
     // webdar headers
 #include "exceptions.hpp"
@@ -45,6 +56,11 @@ extern "C"
     /// connection method and algorithms... they are used to create
     /// an SSL object that ciphers/deciphers/authenticate SSL exchanges
     /// on a particular connection (for example a TCP connection)
+    ///
+    /// the context also holds a server side session cache and the keys
+    /// used to cipher session tickets, which are renewed periodically. Both
+    /// let browsers reconnecting resume their previous TLS session with an
+    /// abbreviated handshake.
 
 class ssl_context
 {
@@ -64,9 +80,92 @@ public:
 
     SSL_CTX & get_context() { return *ctx; };
 
+	/// whether kernel TLS offload is requested for the SSL contexts to come
+
+	/// \note once the handshake completed, record ciphering is done by the kernel
+	/// which lets answers be sent with sendmsg() and sendfile() as for plain
+	/// connections. If the kernel or openssl does not support it for a given
+	/// connection, ciphering stays done by openssl in user space
+    static void set_ktls(bool mode) { ktls = mode; };
+
+	/// whether kernel TLS offload has been requested
+    static bool get_ktls() { return ktls; };
+
+	/// whether the openssl library webdar has been built against supports kernel TLS
+    static bool ktls_available();
+
+	/// set the TLS session resumption parameters for the SSL contexts to come
+
+	/// \param[in] cache_size max number of sessions kept in the server side cache,
+	/// zero disables both the session cache and the session tickets
+	/// \param[in] lifetime time in seconds a session can be resumed, session ticket
+	/// keys are renewed at that period (tickets ciphered with the previous key are still
+	/// accepted, and then renewed)
+    static void set_session_cache(unsigned int cache_size, unsigned int lifetime);
+
+	/// whether HTTP/2 is offered to the clients by the SSL contexts to come
+
+	/// \note the protocol is negotiated during the TLS handshake (ALPN), "h2"
+	/// being preferred to "http/1.1" when the browser supports both
+    static void set_http2(bool mode) { http2 = mode; };
+
+	/// whether HTTP/2 is offered
+    static bool get_http2() { return http2; };
+
+	/// provides a human readable summary of the session cache statistics
+    std::string get_session_stats();
+
 private:
 
+	/// keys used to cipher and authenticate the session tickets
+    struct ticket_key
+    {
+	unsigned char name[16];
+	unsigned char aes[32];
+	unsigned char hmac[32];
+    };
+
+	/// the current and previous session ticket keys
+    struct ticket_keys
+    {
+	libthreadar::mutex control; ///< the ticket callback is called from any thread
+	ticket_key current;
+	ticket_key previous;
+	bool has_previous;
+	time_t renewal;             ///< time at which current key will be renewed
+	unsigned int period;        ///< renewal period in second
+    };
+
     SSL_CTX *ctx;
+    std::unique_ptr<ticket_keys> tickets; ///< kept in an allocated struct as passed to openssl
+
+    static bool ktls;
+    static bool http2;
+    static unsigned int session_cache_size;
+    static unsigned int session_lifetime;
+
+    void set_session_resumption();
+
+#ifdef WEBDAR_TICKET_KEYS
+	/// callback used by openssl to cipher or decipher a session ticket
+    static int ticket_callback(SSL *ssl,
+			       unsigned char key_name[16],
+			       unsigned char *iv,
+			       EVP_CIPHER_CTX *cctx,
+			       EVP_MAC_CTX *hctx,
+			       int enc);
+#endif
+
+	/// callback used by openssl to select the application protocol among those proposed by the client
+    static int alpn_callback(SSL *ssl,
+			     const unsigned char **out,
+			     unsigned char *outlen,
+			     const unsigned char *in,
+			     unsigned int inlen,
+			     void *arg);
+
+	/// fill a ticket key with random data
+    static void generate_key(ticket_key & key);
 
     static bool initialized;
     static void go_init_openssl();
@@ -25,29 +25,108 @@
 #include "my_config.h"
 extern "C"
 {
-
+#if HAVE_OPENSSL_EVP_H
+#include <openssl/evp.h>
+#endif
 }
 
     // C++ system header files
-
+#include <cstdio>
 
     // webdar headers
 #include "tokens.hpp"
 #include "base64.hpp"
+#include "http_compression.hpp"
+#include "webdar_tools.hpp"
+#include "exceptions.hpp"
 
     //
 #include "static_object.hpp"
 
 using namespace std;
 
-answer static_object_text::give_answer() const
+    /// how long a versioned static object can be kept by browsers (one year)
+#define STATIC_OBJECT_MAX_AGE "31536000"
+
+    /// number of bytes of the content hash kept to form the object version
+#define STATIC_OBJECT_VERSION_BYTES 12
+
+answer static_object::give_answer(const request & req, bool versioned) const
+{
+    answer ret;
+    string val;
+
+    if(!etag.empty()
+       && (req.get_method_id() == http_token::method_get || req.get_method_id() == http_token::method_head)
+       && req.find_attribute(http_token::hdr_if_none_match, val)
+       && webdar_tools_etag_match(val, etag))
+    {
+	    // the browser already has it, no need to build the body
+	ret.set_status(STATUS_CODE_NOT_MODIFIED);
+	ret.set_reason("not modified");
+    }
+    else
+	ret = build_answer();
+
+    if(!etag.empty())
+	ret.set_attribute(http_token::hdr_etag, etag);
+
+    if(versioned)
+	ret.set_attribute(http_token::hdr_cache_control, string("public, max-age=") + STATIC_OBJECT_MAX_AGE + ", immutable");
+    else
+	ret.set_attribute(http_token::hdr_cache_control, "no-cache");
+	// no-cache let the browser store the object but it
+	// has to revalidate it (If-None-Match) before use
+
+    return ret;
+}
+
+void static_object::compute_etag()
+{
+    string payload = get_payload();
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int md_len = 0;
+    char hex[3];
+
+    if(EVP_Digest(payload.c_str(), payload.size(), md, &md_len, EVP_sha256(), nullptr) != 1)
+	throw exception_openssl();
+    if(md_len < STATIC_OBJECT_VERSION_BYTES)
+	throw WEBDAR_BUG;
+
+    version.clear();
+    for(unsigned int i = 0; i < STATIC_OBJECT_VERSION_BYTES; ++i)
+    {
+	(void)snprintf(hex, sizeof(hex), "%02x", md[i]);
+	version += hex;
+    }
+
+	// weak entity-tag as the same tag is used whatever
+	// content-coding (compression) is applied to the body
+    etag = "W/\"" + version + "\"";
+}
+
+static_object_text::static_object_text(const char *text)
+{
+    data = text;
+    if(data == nullptr)
+	throw WEBDAR_BUG;
+
+	// compressing once for all, the parser will send this
+	// version when the browser accepts it
+    if(http_compression::is_available())
+	gzipped = make_shared<const string>(http_compression::compress(data, http_compression::gzip, 9));
+}
+
+answer static_object_text::build_answer() const
 {
     answer ret;
 
     ret.set_status(STATUS_CODE_OK);
     ret.set_reason("ok");
-    ret.set_attribute(HDR_CONTENT_TYPE, "text/plain");
+    ret.set_attribute(http_token::hdr_content_type, "text/plain");
     ret.add_body(data);
+    if(gzipped)
+	ret.add_encoded_body(http_compression::gzip, gzipped);
 	// recreating the answer at each request consume CPU cycles
 	// at the advantage of avoiding permanently duplicating
 	// text data in memory (present once as static data in data segment
@@ -65,27 +144,26 @@ static_object_jpeg::static_object_jpeg(const char *base_64)
     if(num % 4 != 0)
 	throw WEBDAR_BUG;
 
-    if(capa > data.max_size())
+    string tmp;
+
+    if(capa > tmp.max_size())
 	throw exception_range("maximum std::string size exceeded");
     else
-	data.reserve(capa);
+	tmp.reserve(capa);
 
-    data = base64().decode(base_64);
+    tmp = base64().decode(base_64);
+    data = make_shared<const string>(std::move(tmp));
 }
 
-answer static_object_jpeg::give_answer() const
+answer static_object_jpeg::build_answer() const
 {
     answer ret;
 
     ret.set_status(STATUS_CODE_OK);
     ret.set_reason("ok");
-    ret.set_attribute(HDR_CONTENT_TYPE, "image/jpeg");
+    ret.set_attribute(http_token::hdr_content_type, "image/jpeg");
     ret.add_body(data);
-	// recreating the answer at each request consume CPU cycles
-	// at the advantage of avoiding permanently duplicating
-	// text data in memory (present once as static data in data segment
-	// and a second time in the answer object as std::string data, but
-	// here this second time is temporary for the duration of the request
+	// the decoded image is shared with the answer, not copied
 
     return ret;
 }
@@ -32,10 +32,12 @@ extern "C"
 }
 
     // C++ system header files
-
+#include <string>
+#include <memory>
 
     // webdar headers
 #include "answer.hpp"
+#include "request.hpp"
 
     /// common ancestor to all static object, this makes easier to add new object type in the future
 class static_object
@@ -48,7 +50,32 @@ public:
     static_object & operator = (static_object && ref) noexcept = default;
     virtual ~static_object() {};
 
-    virtual answer give_answer() const = 0;
+	/// provides the answer to the given request
+
+	/// \param[in] req the request asking for this object
+	/// \param[in] versioned whether the request URL contains the version of this object
+	/// \note if the request's If-None-Match header matches the entity-tag of the object
+	/// a 304 (not modified) answer is returned without building the body. Versioned URL
+	/// (see static_object_library::get_url()) are sent as immutable, the others have to be
+	/// revalidated by the browser at each use.
+    answer give_answer(const request & req, bool versioned) const;
+
+	/// compute the entity-tag of the object from its content
+    void compute_etag();
+
+	/// the version of the object (hash of its content) or an empty string if not computed
+    const std::string & get_version() const { return version; };
+
+protected:
+	/// build the answer containing the object
+    virtual answer build_answer() const = 0;
+
+	/// the data the entity-tag is computed from
+    virtual std::string get_payload() const = 0;
+
+private:
+    std::string version; ///< hexadecimal hash of the content
+    std::string etag;    ///< entity-tag derived from version
 };
 
 
@@ -57,18 +84,23 @@ public:
 class static_object_text : public static_object
 {
 public:
-    static_object_text(const char *text) { data = text; };
+    static_object_text(const char *text);
     static_object_text(const static_object_text & ref) = default;
     static_object_text(static_object_text && ref) noexcept = default;
     static_object_text & operator = (const static_object_text & ref) = default;
     static_object_text & operator = (static_object_text && ref) noexcept = default;
     ~static_object_text() = default;
 
+protected:
+	/// inherited from static_object
+    virtual answer build_answer() const override;
+
 	/// inherited from static_object
-    virtual answer give_answer() const override;
+    virtual std::string get_payload() const override { return data; };
 
 private:
     const char *data;
+    std::shared_ptr<const std::string> gzipped;  ///< data compressed once at startup, null if not available
 };
 
     /// static_object to return base64 encoded jpegs
@@ -83,11 +115,15 @@ public:
     static_object_jpeg & operator = (static_object_jpeg && ref) noexcept = default;
     ~static_object_jpeg() = default;
 
+protected:
+	/// inherited from static_object
+    virtual answer build_answer() const override;
+
 	/// inherited from static_object
-    virtual answer give_answer() const override;
+    virtual std::string get_payload() const override { return *data; };
 
 private:
-    std::string data;
+    std::shared_ptr<const std::string> data; ///< shared with the answers sent
 };
 
 #endif
@@ -33,6 +33,7 @@ extern "C"
 
     // webdar headers
 #include "tokens.hpp"
+#include "chemin.hpp"
 
 
     //
@@ -63,6 +64,22 @@ const static_object * static_object_library::find_object(const string & name)
     return it->second;
 }
 
+string static_object_library::get_url(const string & name)
+{
+    chemin ret(STATIC_PATH_ID);
+
+    if(frozen)
+    {
+	map<string, static_object *>::iterator it = library.find(name);
+	if(it != library.end() && it->second != nullptr && !it->second->get_version().empty())
+	    ret += chemin(it->second->get_version());
+    }
+
+    ret += chemin(name);
+
+    return ret.display(false);
+}
+
 void static_object_library::release()
 {
     map<string, static_object *>::iterator it = library.begin();
@@ -99,3 +116,18 @@ void static_object_library::add_object_to_library(const string & name, static_ob
 
     library[name] = ref;
 }
+
+void static_object_library::freeze_library()
+{
+    map<string, static_object *>::iterator it = library.begin();
+
+    while(it != library.end())
+    {
+	if(it->second == nullptr)
+	    throw WEBDAR_BUG;
+	it->second->compute_etag();
+	++it;
+    }
+
+    frozen = true;
+}
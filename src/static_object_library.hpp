@@ -66,6 +66,13 @@ public:
 	/// \note throw exception_range if no object can be found under that name
     static const static_object * find_object(const std::string & name);
 
+	/// provides the URL path to use to refer to a given static object
+
+	/// \note the returned path contains the version of the object, this
+	/// way it can be cached forever by browsers and is still refreshed
+	/// when the object changes (new webdar release)
+    static std::string get_url(const std::string & name);
+
 	/// release all objects added to the library
     static void release();
 
@@ -76,7 +83,7 @@ private:
     static void add_object_to_library(const std::string & name, static_object * ref);
 
 	/// freeze the library once and for all
-    static void freeze_library() { frozen = true; };
+    static void freeze_library();
 
 	// no locking is required as the library is filled once before
 	// multi-thread is started at startup and stays read-only the
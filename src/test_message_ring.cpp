@@ -0,0 +1,110 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    //  C system header files
+#include "my_config.h"
+
+    // C++ system header files
+#include <iostream>
+#include <string>
+#include <list>
+#include <vector>
+#include <atomic>
+#include <thread>
+
+    // webdar headers
+#include "exceptions.hpp"
+#include "message_ring.hpp"
+
+    // checks that readers of a message_ring do not stall on a dropped message:
+    // producers are run concurrently until some messages have been dropped,
+    // a last message is then pushed and must be read with all the messages kept
+
+using namespace std;
+
+    /// number of concurrent producers
+#define PRODUCERS 8
+
+    /// number of rounds, each one with a new ring
+#define ROUNDS 10
+
+static unsigned int failures = 0;
+
+static void round(unsigned int num)
+{
+    message_ring ring(16);
+    atomic<bool> stop(false);
+    atomic<uint64_t> pushed(0);
+    vector<thread> producers;
+    list<string> got;
+    uint64_t seq = 0;
+
+    for(unsigned int i = 0; i < PRODUCERS; ++i)
+	producers.push_back(thread([&ring, &stop, &pushed, i]()
+	{
+	    string msg(message_ring::slot_size, 'a' + i);
+
+	    while(!stop.load())
+	    {
+		ring.push(msg);
+		pushed.fetch_add(1);
+	    }
+	}));
+
+    while(ring.get_dropped() == 0)
+	this_thread::yield();
+    stop.store(true);
+    for(vector<thread>::iterator it = producers.begin(); it != producers.end(); ++it)
+	it->join();
+
+	// producers have all finished, none of the slots is being written
+
+    ring.push("last");
+    got = ring.read_since(seq);
+
+    if(seq != pushed.load() + 1 || got.empty() || got.back() != "last")
+    {
+	cout << "FAILED: round " << num << ": " << ring.get_dropped() << " message(s) dropped, "
+	     << "reader stopped at message " << seq << " of " << pushed.load() + 1 << endl;
+	++failures;
+    }
+    else
+	cout << "ok: round " << num << ": " << ring.get_dropped() << " message(s) dropped, "
+	     << got.size() << " of the last " << ring.get_capacity() << " read" << endl;
+}
+
+int main()
+{
+    try
+    {
+	for(unsigned int i = 1; i <= ROUNDS; ++i)
+	    round(i);
+    }
+    catch(exception_base & e)
+    {
+	cout << "FAILED: unexpected exception: " << e.get_message() << endl;
+	return 1;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
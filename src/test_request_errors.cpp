@@ -0,0 +1,232 @@
+/*********************************************************************/
+// webdar - a web server and interface program to libdar
+// Copyright (C) 2013-2025 Denis Corbin
+//
+// This file is part of Webdar
+//
+//  Webdar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Webdar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Webdar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+    //  C system header files
+#include "my_config.h"
+extern "C"
+{
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#if HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+
+#if HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+
+#if HAVE_POLL_H
+#include <poll.h>
+#endif
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+}
+
+    // C++ system header files
+#include <iostream>
+#include <string>
+#include <memory>
+
+    // webdar headers
+#include "central_report.hpp"
+#include "connexion.hpp"
+#include "exceptions.hpp"
+#include "parser.hpp"
+#include "request.hpp"
+
+    // checks the answers sent to requests that cannot be read entirely:
+    // they must be sent (not crash the server thread) and close the connection
+
+using namespace std;
+
+    /// max time in milliseconds waiting for the answer, beyond the timeouts set below
+#define ANSWER_WAIT 5000
+
+static unsigned int failures = 0;
+
+    /// send data to a parser, let it read a request and return what it has answered
+
+    /// \param[in] sent the data sent by the client, the client side is kept open
+    /// \param[out] closed whether the server closed the connection after the answer
+static string exchange(const string & sent, bool & closed)
+{
+    int fds[2];
+    string ret;
+    char buf[4096];
+    struct pollfd pfd;
+    shared_ptr<central_report> log(new central_report_stdout(crit));
+
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+	throw exception_system("socketpair", errno);
+
+    if(write(fds[1], sent.c_str(), sent.size()) != (ssize_t)(sent.size()))
+	throw exception_system("write", errno);
+
+    try
+    {
+	unique_ptr<proto_connexion> conn(new connexion(fds[0], "127.0.0.1", 0));
+	parser srv(conn, log);
+
+	try
+	{
+	    srv.wait_for_request();
+	    (void)srv.get_request();
+	}
+	catch(exception_input & e)
+	{
+		// the error has been answered
+	}
+
+	closed = srv.get_status() != proto_connexion::connected;
+    }
+    catch(...)
+    {
+	close(fds[1]);
+	throw;
+    }
+
+    pfd.fd = fds[1];
+    pfd.events = POLLIN;
+    while(poll(&pfd, 1, ANSWER_WAIT) > 0)
+    {
+	ssize_t lu = read(fds[1], buf, sizeof(buf));
+
+	if(lu <= 0)
+	    break;
+	ret.append(buf, lu);
+    }
+    close(fds[1]);
+
+    return ret;
+}
+
+static string many_fields(unsigned int num)
+{
+    string ret;
+
+    for(unsigned int i = 0; i < num; ++i)
+	ret += "X-Field-" + to_string(i) + ": value\r\n";
+
+    return ret;
+}
+
+static void check(const string & label, const string & sent, unsigned int expected)
+{
+    bool closed = false;
+    string got = exchange(sent, closed);
+    string status_line = got.substr(0, got.find('\r'));
+    string wanted = "HTTP/1.1 " + to_string(expected) + " ";
+
+    if(got.compare(0, wanted.size(), wanted) != 0 || !closed)
+    {
+	cout << "FAILED: " << label << ": expected " << expected
+	     << " and a closed connection, got \"" << status_line << "\""
+	     << (closed ? "" : " with the connection still open") << endl;
+	++failures;
+    }
+    else
+	cout << "ok: " << label << ": " << status_line << endl;
+}
+
+int main()
+{
+    const string host = "Host: localhost\r\n";
+
+    request::set_timeouts(1, 1);
+    request::set_header_limits(20, 1024);
+    request::set_max_body_size(4096);
+    request::set_max_multipart_size(65536);
+
+    try
+    {
+	check("oversized header value",
+	      "GET / HTTP/1.1\r\n" + host + "X-Big: " + string(4000, 'a') + "\r\n\r\n",
+	      STATUS_CODE_REQUEST_HEADER_FIELDS_TOO_LARGE);
+
+	check("endless header field name",
+	      "GET / HTTP/1.1\r\n" + host + string(8000, 'a'),
+	      STATUS_CODE_REQUEST_HEADER_FIELDS_TOO_LARGE);
+
+	check("too many header fields",
+	      "GET / HTTP/1.1\r\n" + host + many_fields(30) + "\r\n",
+	      STATUS_CODE_REQUEST_HEADER_FIELDS_TOO_LARGE);
+
+	check("stalled header",
+	      "GET / HTTP/1.1\r\n" + host,
+	      STATUS_CODE_REQUEST_TIME_OUT);
+
+	check("stalled in the middle of a field name",
+	      "GET / HTTP/1.1\r\n" + host + "X-Sta",
+	      STATUS_CODE_REQUEST_TIME_OUT);
+
+	check("stalled body",
+	      "POST / HTTP/1.1\r\n" + host + "Content-Length: 100\r\n\r\nabc",
+	      STATUS_CODE_REQUEST_TIME_OUT);
+
+	check("endless method",
+	      string(8000, 'G'),
+	      STATUS_CODE_NOT_IMPLEMENTED);
+
+	check("endless URI",
+	      "GET /" + string(8000, 'u'),
+	      STATUS_CODE_REQUEST_URI_TOO_LARGE);
+
+	check("body too large",
+	      "POST / HTTP/1.1\r\n" + host + "Content-Length: 2000000000\r\n\r\n",
+	      STATUS_CODE_REQUEST_ENTITY_TOO_LARGE);
+
+	check("chunked body too large",
+	      "POST / HTTP/1.1\r\n" + host + "Transfer-Encoding: chunked\r\n\r\nFFFFFF\r\n",
+	      STATUS_CODE_REQUEST_ENTITY_TOO_LARGE);
+
+	check("body growing too large",
+	      "POST / HTTP/1.1\r\n" + host + "Transfer-Encoding: chunked\r\n\r\n"
+	      + "F00\r\n" + string(0xF00, 'b') + "\r\n"
+	      + "F00\r\n" + string(0xF00, 'b') + "\r\n0\r\n\r\n",
+	      STATUS_CODE_REQUEST_ENTITY_TOO_LARGE);
+
+	check("multipart body too large",
+	      "POST / HTTP/1.1\r\n" + host + "Content-Type: multipart/form-data; boundary=xyz\r\n"
+	      + "Content-Length: 100000\r\n\r\n--xyz\r\n\r\n",
+	      STATUS_CODE_REQUEST_ENTITY_TOO_LARGE);
+
+	check("transfer coding without chunked",
+	      "POST / HTTP/1.1\r\n" + host + "Transfer-Encoding: gzip\r\n\r\n",
+	      STATUS_CODE_BAD_REQUEST);
+
+	check("unsupported transfer coding",
+	      "POST / HTTP/1.1\r\n" + host + "Transfer-Encoding: gzip, chunked\r\n\r\n",
+	      STATUS_CODE_NOT_IMPLEMENTED);
+    }
+    catch(exception_base & e)
+    {
+	cout << "FAILED: unexpected exception: " << e.get_message() << endl;
+	return 1;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
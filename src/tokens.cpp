@@ -37,10 +37,26 @@ const char* HDR_SET_COOKIE = "Set-Cookie";
 const char* HDR_COOKIE = "Cookie";
 const char* HDR_AUTHORIZATION = "Authorization";
 const char* HDR_LOCATION = "Location";
+const char* HDR_CONNECTION = "Connection";
+const char* HDR_TRANSFER_ENCODING = "Transfer-Encoding";
+const char* HDR_HOST = "Host";
+const char* HDR_EXPECT = "Expect";
+const char* HDR_CONTENT_ENCODING = "Content-Encoding";
+const char* HDR_ACCEPT_ENCODING = "Accept-Encoding";
+const char* HDR_VARY = "Vary";
+const char* HDR_ETAG = "ETag";
+const char* HDR_IF_NONE_MATCH = "If-None-Match";
+const char* HDR_CACHE_CONTROL = "Cache-Control";
+const char* HDR_RETRY_AFTER = "Retry-After";
 
     //
 
 const char* VAL_CONTENT_TYPE_FORM = "application/x-www-form-urlencoded";
+const char* VAL_CONTENT_TYPE_MULTIPART = "multipart/";
+const char* VAL_CONNECTION_CLOSE = "close";
+const char* VAL_CONNECTION_KEEP_ALIVE = "keep-alive";
+const char* VAL_TRANSFER_ENCODING_CHUNKED = "chunked";
+const char* VAL_EXPECT_CONTINUE = "100-continue";
 
     //
 
@@ -78,6 +94,12 @@ const char* COLOR_DAR_GREYBLUE = "rgb(221, 221, 255)";
 
 const char* STATIC_PATH_ID = "st";
 // STATIC_PATH_ID's length should be strictly less than the lenght of session_ID, as defined INITIAL_SESSION_ID_WIDTH in session.cpp to avoid collision with session_ID.
+const char* METRICS_PATH_ID = "mt";
+// same constraint as STATIC_PATH_ID on METRICS_PATH_ID's length
+const char* FEED_PATH_ID = "ev";
+// same constraint as STATIC_PATH_ID on FEED_PATH_ID's length
+const char* STATUS_PATH_ID = "js";
+// same constraint as STATIC_PATH_ID on STATUS_PATH_ID's length
 const char* STATIC_OBJ_LICENSING = "licensing";
 const char* STATIC_LOGO = "webdar.jpg";
 const char* STATIC_TITLE_LOGO = "webdar_title.jpg";
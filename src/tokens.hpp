@@ -77,6 +77,7 @@ const unsigned int STATUS_CODE_REQUEST_ENTITY_TOO_LARGE = 413;
 const unsigned int STATUS_CODE_REQUEST_URI_TOO_LARGE = 414;
 const unsigned int STATUS_CODE_UNSUPPORTED_MEDIA_TYPE = 415;
 const unsigned int STATUS_CODE_EXPECTATION_FAILED = 417;
+const unsigned int STATUS_CODE_REQUEST_HEADER_FIELDS_TOO_LARGE = 431;
 const unsigned int STATUS_CODE_INTERNAL_SERVER_ERROR = 500;
 const unsigned int STATUS_CODE_NOT_IMPLEMENTED = 501;
 const unsigned int STATUS_CODE_BAD_GATEWAY = 502;
@@ -99,9 +100,25 @@ extern const char* HDR_AUTHORIZATION;
 extern const char* HDR_SET_COOKIE;
 extern const char* HDR_COOKIE;
 extern const char* HDR_LOCATION;
+extern const char* HDR_CONNECTION;
+extern const char* HDR_TRANSFER_ENCODING;
+extern const char* HDR_HOST;
+extern const char* HDR_EXPECT;
+extern const char* HDR_CONTENT_ENCODING;
+extern const char* HDR_ACCEPT_ENCODING;
+extern const char* HDR_VARY;
+extern const char* HDR_ETAG;
+extern const char* HDR_IF_NONE_MATCH;
+extern const char* HDR_CACHE_CONTROL;
+extern const char* HDR_RETRY_AFTER;
 
     // HTTP header values
 extern const char* VAL_CONTENT_TYPE_FORM;
+extern const char* VAL_CONTENT_TYPE_MULTIPART;
+extern const char* VAL_CONNECTION_CLOSE;
+extern const char* VAL_CONNECTION_KEEP_ALIVE;
+extern const char* VAL_TRANSFER_ENCODING_CHUNKED;
+extern const char* VAL_EXPECT_CONTINUE;
 
 
     // HTML CSS colors by fonction
@@ -135,6 +152,9 @@ extern const char* BLACK;
 extern const char* COLOR_DAR_GREYBLUE;
 
 extern const char* STATIC_PATH_ID;
+extern const char* METRICS_PATH_ID;
+extern const char* FEED_PATH_ID;
+extern const char* STATUS_PATH_ID;
 extern const char* STATIC_OBJ_LICENSING;
 extern const char* STATIC_LOGO;
 extern const char* STATIC_TITLE_LOGO;
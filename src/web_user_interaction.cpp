@@ -39,9 +39,14 @@ extern "C"
 #include "web_user_interaction.hpp"
 
 
+    // the message ring holds more messages than displayed for the progress feed
+    // to catch up with the messages received between two polls
+#define WEB_UI_RING_FACTOR 4
+
 using namespace std;
 
 web_user_interaction::web_user_interaction(unsigned int x_warn_size):
+    warnings(x_warn_size * WEB_UI_RING_FACTOR),
     warn_size(x_warn_size)
 {
     if(warn_size == 0)
@@ -65,23 +70,9 @@ web_user_interaction::~web_user_interaction()
 
 void web_user_interaction::set_warning_list_size(unsigned int size)
 {
-	// critical section begins
-	//
-    control.lock();
-    try
-    {
-	warn_size = size;
-	while(warnings.size() > size)
-	    warnings.pop_front();
-    }
-    catch(...)
-    {
-	control.unlock();
-	throw;
-    }
-    control.unlock();
-	//
-	// critical section ended
+    if(size > warnings.get_capacity())
+	size = warnings.get_capacity();
+    warn_size = size;
 }
 
 void web_user_interaction::clear()
@@ -106,25 +97,46 @@ void web_user_interaction::clear()
     control.unlock();
 }
 
-list<string> web_user_interaction::get_warnings()
+void web_user_interaction::start_spool()
 {
-    list<string> ret;
-
-    	// critical section begins
-	//
-    control.lock();
+    spool.reset();
     try
     {
-	ret = warnings;
+	spool.reset(new (nothrow) log_spool());
+	if(!spool)
+	    throw exception_memory();
     }
-    catch(...)
+    catch(exception_base & e)
     {
-	control.unlock();
-	throw;
+	warnings.push(string("The full log of this job will not be available: ") + e.get_message());
     }
-    control.unlock();
-	//
-	// critical section ended
+}
+
+list<string> web_user_interaction::get_warnings()
+{
+    unsigned int seq;
+
+    return get_warnings(seq);
+}
+
+list<string> web_user_interaction::get_warnings(unsigned int & seq)
+{
+    list<string> ret;
+    uint64_t last;
+
+    ret = warnings.read_last(warn_size, last);
+    seq = last;
+
+    return ret;
+}
+
+list<string> web_user_interaction::get_warnings_since(unsigned int & seq)
+{
+    list<string> ret;
+    uint64_t last = seq;
+
+    ret = warnings.read_since(last);
+    seq = last;
 
     return ret;
 }
@@ -304,23 +316,11 @@ bool web_user_interaction::has_libdar_pending() const
 
 void web_user_interaction::inherited_message(const string & message)
 {
-    	// critical section begins
-	//
-    control.lock();
-    try
-    {
-	warnings.push_back(message);
-	while(warnings.size() >= warn_size)
-	    warnings.pop_front();
-    }
-    catch(...)
-    {
-	control.unlock();
-	throw;
-    }
-    control.unlock();
-	//
-	// critical section ended
+	// lock-free, libdar must not wait for the thread
+	// that renders the page while logging
+    warnings.push(message);
+    if(spool)
+	spool->append(message);
 }
 
 bool web_user_interaction::inherited_pause(const string & message)
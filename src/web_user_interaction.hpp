@@ -34,10 +34,14 @@ extern "C"
     // C++ system header files
 #include <string>
 #include <list>
+#include <atomic>
+#include <memory>
 #include <dar/libdar.hpp>
 #include <libthreadar/libthreadar.hpp>
 
     // webdar headers
+#include "message_ring.hpp"
+#include "log_spool.hpp"
 
 
     /// class web_user_interaction provides a libdar::user_interaction interface to libdar
@@ -64,14 +68,46 @@ public:
     ~web_user_interaction();
 
 	/// change the number of last warnings to display
+
+	/// \note the size is limited by the capacity of the message ring set at construction time
     void set_warning_list_size(unsigned int size);
 
+	/// the number of last warnings displayed
+    unsigned int get_warning_list_size() const { return warn_size.load(); };
+
 	/// clear logs and reset the object
     void clear();
 
 	/// obtain a copy of the current log buffer
     std::list<std::string> get_warnings();
 
+	/// obtain a copy of the current log buffer and the sequence number of its last message
+
+	/// \param[out] seq the number of messages received from libdar so far
+    std::list<std::string> get_warnings(unsigned int & seq);
+
+	/// obtain the messages received after the given sequence number
+
+	/// \param[in,out] seq sequence number of the last message already known by
+	/// the caller, it is updated to the number of the last message returned
+	/// \note messages that have been dropped from the log buffer since are lost
+    std::list<std::string> get_warnings_since(unsigned int & seq);
+
+	/// record all the messages from now on in a new log spool, the previous one is released
+
+	/// \note this must not be called while a libdar thread uses this object. If the spool
+	/// cannot be created, the reason is given as a message and no spool is used
+    void start_spool();
+
+	/// the log spool of the last job, an empty pointer if none
+    std::shared_ptr<log_spool> get_spool() const { return spool; };
+
+	/// number of messages from libdar lost because libdar threads competed for the same slot
+    uint64_t get_dropped_messages() const { return warnings.get_dropped(); };
+
+	/// number of messages from libdar overwritten by newer ones in the log buffer
+    uint64_t get_overwritten_messages() const { return warnings.get_overwritten(); };
+
 	/// wether libdar is pending for pause answer
     bool pending_pause(std::string & msg) const;
 
@@ -126,9 +162,10 @@ private:
     bool get_secu_string_echo;       ///< whether the answer has to be echoed
     libdar::secu_string get_secu_string_ans; ///< the user provided secu_string
 
-	// libdar warnings (= logs)
-    std::list<std::string> warnings;  ///< lines (message/warning) sent by libdar
-    unsigned warn_size;               ///< max number of line to record from libdar
+	// libdar warnings (= logs), not protected by "control"
+    message_ring warnings;               ///< lines (message/warning) sent by libdar
+    std::atomic<unsigned int> warn_size; ///< max number of line to show from libdar
+    std::shared_ptr<log_spool> spool;    ///< all messages of the current job, only changed while libdar does not run
 };
 
 #endif
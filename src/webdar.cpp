@@ -52,6 +52,10 @@ extern "C"
 #if HAVE_SYS_STAT_H
 #include <sys/stat.h>
 #endif
+
+#if HAVE_LIMITS_H
+#include <limits.h>
+#endif
 }
 
 /// the compiler version MACRO
@@ -86,12 +90,18 @@ extern "C"
 #include "webdar_tools.hpp"
 #include "server.hpp"
 #include "authentication.hpp"
+#include "authentication_cache.hpp"
 #include "base64.hpp"
 #include "choose.hpp"
 #include "static_object_library.hpp"
 #include "environment.hpp"
 #include "global_parameters.hpp"
 #include "server_pool.hpp"
+#include "request.hpp"
+#include "parser.hpp"
+#include "http_compression.hpp"
+#include "connexion.hpp"
+#include "progress_feed.hpp"
 
 #define WEBDAR_EXIT_OK 0
 #define WEBDAR_EXIT_SYNTAX 1
@@ -103,6 +113,12 @@ extern "C"
 
 #define DEFAULT_TCP_PORT 8008
 #define DEFAULT_POOL_SIZE 50
+#define DEFAULT_WORKERS_PER_IO 4
+#define DEFAULT_PRESPAWN 4
+#define DEFAULT_MAX_IDLE 8
+#define STREAM_SHARE 4 // at most one connection out of STREAM_SHARE holds a progress event stream
+#define DEFAULT_TLS_SESSION_LIFETIME 3600
+#define DEFAULT_WAIT_DEADLINE 5
 #define SECURED_MEM_BYTE_SIZE 524288
 
     /// \mainpage
@@ -121,7 +137,7 @@ extern "C"
     ///
     /// The role of a \ref listener object is to create a \ref proto_connexion for each new incoming TCP session.
     /// This proto_connexion is passed with pointers to the central_report and authentication objects to
-    /// a new \ref server object. Each server object with the help of a \ref parser object transforms the TCP byte
+    /// an idle \ref server object (or to a \ref reactor in event driven mode, see below). Each server object with the help of a \ref parser object transforms the TCP byte
     /// stream into a suite of HTTP \ref request, and transmit back the corresponding HTTP \ref answer.
     /// These answers are obtained from either:
     /// - a \ref static_object for static components (images, licensing text, and so on)!
@@ -129,6 +145,36 @@ extern "C"
     /// - a \ref choose object if the client is authenticated but the pointed to session does not exist
     /// - the \ref user_interface object from the \ref session pointed to by the HTTP request.
     /// The user_interface object is acquired by the server object from the \ref session class.
+    /// The per connection logic is held by a \ref conversation object, owned by the server object.
+    /// Server objects are long-lived threads of the \ref server_pool (-p option): once a connection
+    /// is closed, the server resets its conversation object and waits for the next connection.
+    ///
+    /// In event driven mode (-e option) no thread is dedicated to a connection: the \ref server_pool
+    /// hands each new \ref conversation to a \ref reactor whose I/O thread watches all the idle
+    /// connections with epoll. Once a whole request header has been received, the conversation is
+    /// given to one of the reactor's worker threads, which reads the body, answers and parks the
+    /// conversation back to the reactor.
+    ///
+    /// The time spent by each request phase is recorded by the conversation object in lock-free
+    /// histograms of the \ref metrics class, served in Prometheus text format under the /mt URL.
+    ///
+    /// With the -2 option, HTTP/2 is negotiated with the browsers on TLS connections (ALPN). The
+    /// \ref parser object then relies on an \ref http2_mux object that demultiplexes the streams
+    /// of the connection, each request being translated in HTTP/1.1 syntax for the \ref request
+    /// class. Streams are answered in sequence by the connection's server thread, which keeps
+    /// the session acquired while the next request already received addresses the same session.
+    ///
+    /// While libdar runs, the page showing its progression reads an event stream (text/event-stream)
+    /// from the /ev URL: the conversation releases the session and polls the \ref progress_feed
+    /// object shared with the \ref html_web_user_interaction, sending only the counters that changed
+    /// and the new libdar messages, until libdar ends or asks a question and the page is reloaded.
+    /// Browsers without javascript keep refreshing the page every second. As each stream holds a
+    /// server thread, only a quarter of the -m connections may stream at a time, the other pages
+    /// poll a JSON snapshot of the progression instead (the /js URL).
+    ///
+    /// With the -n option, several \ref listener threads are bound to the same address (SO_REUSEPORT)
+    /// and the kernel balances the new connections between them. Each of these shards feeds its own
+    /// \ref server_pool, holding its share of the max number of connections.
     ///
     /// the \ref session *class* manages a list of session *objects* associated with a reference counter
     /// that keep trace of the servers that have been given the session reference (only one can interact
@@ -183,7 +229,14 @@ static void parse_cmd(int argc, char *argv[],
 		      int & facility,
 		      string & certificate,
 		      string & privateK,
-		      unsigned int & max_srv);
+		      unsigned int & max_srv,
+		      unsigned int & io_threads,
+		      unsigned int & workers,
+		      unsigned int & shards,
+		      bool & pin_cpu,
+		      unsigned int & prespawn,
+		      unsigned int & max_idle,
+		      string & pam_service);
 
 static void add_item_to_list(const char *optarg, vector<interface_port> & ecoute);
 static void close_all_listeners(int sig);
@@ -197,7 +250,7 @@ static void show_ver();
     // it is necessary to have this global for signal handler able to report what they do
 static shared_ptr<central_report> creport;
 static vector<listener *> taches;
-static shared_ptr<server_pool> pool;
+static vector<shared_ptr<server_pool> > pools; ///< one server_pool per listener shard
 
 static void signal_handler(int x);
 static string reminder_msg;
@@ -213,10 +266,19 @@ int main(int argc, char *argv[], char** env)
     priority_t min;
     string fixed_user = "admin";
     string fixed_pass;
+    string pam_service;
+    shared_ptr<const authentication> base;
     string certificate;
     string privateK;
     unsigned int max_srv;
-    unique_ptr<ssl_context> cipher(nullptr);
+    unsigned int io_threads;
+    unsigned int workers;
+    unsigned int shards;
+    bool pin_cpu;
+    unsigned int prespawn;
+    unsigned int max_idle;
+    long num_cpu = 0;
+    shared_ptr<ssl_context> cipher;
 
     last_trigger = time(nullptr) - 1;
     global_envir.feed(env);
@@ -249,7 +311,14 @@ int main(int argc, char *argv[], char** env)
 		  facility,
 		  certificate,
 		  privateK,
-		  max_srv);
+		  max_srv,
+		  io_threads,
+		  workers,
+		  shards,
+		  pin_cpu,
+		  prespawn,
+		  max_idle,
+		  pam_service);
 
 
 	    /////////////////////////////////////////////////
@@ -272,6 +341,37 @@ int main(int argc, char *argv[], char** env)
 
 	creport->report(debug, "central report object has been created");
 
+	if(io_threads > 0 && ssl_context::get_http2())
+	{
+	    creport->report(warning, "HTTP/2 is not available in event driven mode, ignoring -2 option");
+	    ssl_context::set_http2(false);
+	}
+
+	if(io_threads > 0)
+	{
+		// an event stream would hold a worker thread as long as libdar runs,
+		// pages poll the progress status snapshot instead
+	    creport->report(debug, "progress of libdar jobs is reported by status polling in event driven mode");
+	    progress_feed::set_enabled(false);
+	}
+
+	    /////////////////////////////////////////////////
+	    // selecting the authentication method
+
+	if(pam_service.empty())
+	    base = auth;
+	else
+	{
+	    shared_ptr<authentication_unix> sys(new (nothrow) authentication_unix(pam_service));
+
+	    if(!sys)
+		throw exception_memory();
+	    base.reset(new (nothrow) authentication_cache(sys));
+	    if(!base)
+		throw exception_memory();
+	    creport->report(debug, string("authenticating users against the system accounts through PAM service ") + pam_service);
+	}
+
 	    /////////////////////////////////////////////////
 	    // set signal handlers for type 1 and type 2
 
@@ -306,16 +406,53 @@ int main(int argc, char *argv[], char** env)
 	    ++sl_it;
 	}
 
+	    // OpenSSL writes to the socket without MSG_NOSIGNAL, a browser
+	    // closing a TLS connection (like a left event stream) must only
+	    // fail the write with EPIPE, not terminate webdar
+	if(signal(SIGPIPE, SIG_IGN) == SIG_ERR)
+	    throw exception_system("Cannot ignore SIGPIPE", errno);
+
 	    /////////////////////////////////////////////////
 	    // creating the server_pool, managing servers
 	    // which each, interact with a browser through an
 	    // http/https connection.
 
-	pool.reset(new (nothrow) server_pool(max_srv, creport));
-	if(!pool)
-	    throw exception_memory();
+	    // with several listeners per address (shards), each shard has
+	    // its own slice of the server pool to avoid contention between them
+
+	if(shards > 1)
+	{
+	    max_srv = max_srv / shards > 0 ? max_srv / shards : 1;
+	    if(io_threads > 0)
+		io_threads = io_threads / shards > 0 ? io_threads / shards : 1;
+	    prespawn = prespawn / shards;
+	    max_idle = max_idle / shards > 0 ? max_idle / shards : 1;
+	}
+
+	    // an event stream holds a server for as long as libdar runs,
+	    // keep most of them available for the other requests
+	progress_feed::set_max_streams(max_srv / STREAM_SHARE > 0 ? max_srv / STREAM_SHARE : 1);
+
+	for(unsigned int i = 0; i < shards; ++i)
+	{
+	    shared_ptr<server_pool> tmp(new (nothrow) server_pool(max_srv, creport, io_threads, workers, prespawn, max_idle));
+
+	    if(!tmp)
+		throw exception_memory();
+	    pools.push_back(tmp);
+	}
+
+	if(io_threads > 0)
+	    creport->report(debug, libdar::tools_printf("%d pool(s) of %d I/O thread(s) with %d worker(s) each has been created for up to %d connection(s) each", shards, io_threads, workers, max_srv));
+	else
+	    creport->report(debug, libdar::tools_printf("%d pool(s) of up to %d server(s) has been created, %d of them prespawned, %d kept idle at most", shards, max_srv, prespawn, max_idle));
 
-	creport->report(debug, libdar::tools_printf("A pool of %d server(s) has been created", max_srv));
+	if(pin_cpu)
+	{
+	    num_cpu = sysconf(_SC_NPROCESSORS_ONLN);
+	    if(num_cpu < 1)
+		num_cpu = 1;
+	}
 
 
 	    /////////////////////////////////////////////////
@@ -349,6 +486,8 @@ int main(int argc, char *argv[], char** env)
 			    if(!cipher)
 				throw exception_memory();
 			    creport->report(info, "A new SSL context has been created");
+			    if(ssl_context::get_ktls() && !ssl_context::ktls_available())
+				creport->report(warning, "kernel TLS support is missing from the openssl library, TLS ciphering will be done in user space");
 			}
 
 			if(it->interface == "0.0.0.0")
@@ -359,29 +498,38 @@ int main(int argc, char *argv[], char** env)
 			    + (iface)
 			    + string(":") + to_string(it->port) + string("\n");
 
-			if(it->interface == "")
-			    tmp = new (nothrow) listener(creport, auth, cipher, pool, it->port);
-			else
-			    tmp = new (nothrow) listener(creport, auth, cipher, pool, it->interface, it->port);
-			if(tmp == nullptr)
-			    throw exception_memory();
-			else
+			for(unsigned int shard = 0; shard < shards; ++shard)
 			{
-			    taches.push_back(tmp);
-			    tmp->run();
+			    int cpu = pin_cpu ? (int)(shard % num_cpu) : -1;
+
+			    if(it->interface == "")
+				tmp = new (nothrow) listener(creport, base, cipher, pools[shard], it->port, shards > 1, cpu);
+			    else
+				tmp = new (nothrow) listener(creport, base, cipher, pools[shard], it->interface, it->port, shards > 1, cpu);
+			    if(tmp == nullptr)
+				throw exception_memory();
+			    else
+			    {
+				taches.push_back(tmp);
+				tmp->run();
+			    }
 			}
 
-			if(cipher)
-			    throw WEBDAR_BUG;
+			cipher.reset();
+			    // the listeners of this address share this
+			    // context, and thus its TLS session cache
 
 			++it;
 		    }
 
 		    creport->report(debug, "all listener threads have been launched, main thread waiting for all of them to complete");
 
-		    reminder_msg += string("\tand use the following to authenticate:\n")
-			+ string("\t\tuser name = ") + fixed_user + "\n"
-			+ string("\t\tpassword  = ") + fixed_pass + "\n\n";
+		    if(pam_service.empty())
+			reminder_msg += string("\tand use the following to authenticate:\n")
+			    + string("\t\tuser name = ") + fixed_user + "\n"
+			    + string("\t\tpassword  = ") + fixed_pass + "\n\n";
+		    else
+			reminder_msg += string("\tand authenticate with a system account\n\n");
 
 		    creport->report(warning, reminder_msg);
 
@@ -408,7 +556,8 @@ int main(int argc, char *argv[], char** env)
 			/////////////////////////////////////////////////
 			// killing remaining server threads
 
-		    pool->join();
+		    for(vector<shared_ptr<server_pool> >::iterator pt = pools.begin(); pt != pools.end(); ++pt)
+			(*pt)->join();
 		    creport->report(info, "all server threads have ended");
 		}
 		catch(...)
@@ -426,7 +575,8 @@ int main(int argc, char *argv[], char** env)
 		    }
 		    taches.clear();
 
-		    pool->cancel();
+		    for(vector<shared_ptr<server_pool> >::iterator pt = pools.begin(); pt != pools.end(); ++pt)
+			(*pt)->cancel();
 		    throw;
 		}
 	    }
@@ -514,7 +664,14 @@ static void parse_cmd(int argc, char *argv[],
 		      int & facility,
 		      string & certificate,
 		      string & privateK,
-		      unsigned int & max_srv)
+		      unsigned int & max_srv,
+		      unsigned int & io_threads,
+		      unsigned int & workers,
+		      unsigned int & shards,
+		      bool & pin_cpu,
+		      unsigned int & prespawn,
+		      unsigned int & max_idle,
+		      string & pam_service)
 {
     bool default_basic_auth = true;
     int lu;
@@ -525,9 +682,16 @@ static void parse_cmd(int argc, char *argv[],
     background = false;
     facility = LOG_USER;
     max_srv = DEFAULT_POOL_SIZE;
+    io_threads = 0;
+    workers = 0;
+    shards = 1;
+    pin_cpu = false;
+    prespawn = DEFAULT_PRESPAWN;
+    max_idle = DEFAULT_MAX_IDLE;
+    pam_service.clear();
     ecoute.clear();
 
-    while((lu = getopt(argc, argv, "vl:bC:K:hm:w:V")) != -1)
+    while((lu = getopt(argc, argv, "vl:bC:K:hm:w:Ve:u:z:DZ:ks:n:p:q:t:H:2P:")) != -1)
     {
 	switch(lu)
 	{
@@ -552,6 +716,118 @@ static void parse_cmd(int argc, char *argv[],
 	    if(privateK.empty())
 		throw exception_range("-K option needs a file name");
 	    break;
+	case 'k':
+	    ssl_context::set_ktls(true);
+	    break;
+	case '2':
+	    ssl_context::set_http2(true);
+	    break;
+	case 'P':
+	    if(optarg == nullptr)
+		throw exception_range("-P option needs an argument");
+	    else
+	    {
+		string m1, m2, m3;
+		int lifetime, entries;
+
+		webdar_tools_split_in_two(':', optarg, pam_service, m1);
+		if(pam_service.empty())
+		    throw exception_range("-P option needs a PAM service name");
+		webdar_tools_split_in_two(':', m1, m2, m3);
+		if(m2.empty())
+		    lifetime = authentication_cache::get_lifetime();
+		else
+		    lifetime = webdar_tools_convert_to_int(m2);
+		if(m3.empty())
+		    entries = authentication_cache::get_max_entries();
+		else
+		    entries = webdar_tools_convert_to_int(m3);
+		if(lifetime < 0 || entries < 0)
+		    throw exception_range("-P option needs positive integers");
+		authentication_cache::set_parameters(lifetime, entries);
+	    }
+	    break;
+	case 'n':
+	    if(optarg == nullptr)
+		throw exception_range("-n option needs an argument");
+	    else
+	    {
+		string m1, m2;
+		int val;
+
+		webdar_tools_split_in_two(':', optarg, m1, m2);
+		val = webdar_tools_convert_to_int(m1);
+		if(val < 1)
+		    throw exception_range("-n option needs a strictly positive integer");
+		shards = val;
+		if(m2 == "pin")
+		    pin_cpu = true;
+		else if(!m2.empty())
+		    throw exception_range("unknown -n option modifier, only \"pin\" is allowed");
+	    }
+	    break;
+	case 'p':
+	    if(optarg == nullptr)
+		throw exception_range("-p option needs an argument");
+	    else
+	    {
+		string m1, m2;
+		int val;
+
+		webdar_tools_split_in_two(':', optarg, m1, m2);
+		val = webdar_tools_convert_to_int(m1);
+		if(val < 0)
+		    throw exception_range("-p option needs a positive number of prespawned servers");
+		prespawn = val;
+		if(!m2.empty())
+		{
+		    val = webdar_tools_convert_to_int(m2);
+		    if(val < 0)
+			throw exception_range("-p option needs a positive max number of idle servers");
+		    max_idle = val;
+		}
+		if(max_idle < prespawn)
+		    max_idle = prespawn;
+	    }
+	    break;
+	case 'q':
+	    if(optarg == nullptr)
+		throw exception_range("-q option needs an argument");
+	    else
+	    {
+		string m1, m2;
+		int queue, deadline;
+
+		webdar_tools_split_in_two(':', optarg, m1, m2);
+		queue = webdar_tools_convert_to_int(m1);
+		if(m2.empty())
+		    deadline = DEFAULT_WAIT_DEADLINE;
+		else
+		    deadline = webdar_tools_convert_to_int(m2);
+		if(queue < 0 || deadline < 1)
+		    throw exception_range("-q option needs a positive number of connections and a strictly positive deadline");
+		server_pool::set_wait_queue(queue, deadline);
+	    }
+	    break;
+	case 's':
+	    if(optarg == nullptr)
+		throw exception_range("-s option needs an argument");
+	    else
+	    {
+		string m1, m2;
+		int cache_size, lifetime;
+
+		webdar_tools_split_in_two(':', optarg, m1, m2);
+		cache_size = webdar_tools_convert_to_int(m1);
+		if(m2.empty())
+		    lifetime = DEFAULT_TLS_SESSION_LIFETIME;
+		else
+		    lifetime = webdar_tools_convert_to_int(m2);
+		if(cache_size < 0 || lifetime < 1)
+		    throw exception_range("-s option needs a positive cache size and a strictly positive lifetime");
+		ssl_context::set_session_cache(cache_size, lifetime);
+	    }
+	    break;
 	case 'h':
 	    usage(argv[0]);
 	    break;
@@ -578,6 +854,140 @@ static void parse_cmd(int argc, char *argv[],
 	case 'V':
 	    show_ver();
 	    break;
+	case 'e':
+	    if(optarg == nullptr)
+		throw exception_range("-e option needs an argument");
+	    else
+	    {
+		string m1, m2;
+
+		webdar_tools_split_in_two(':', optarg, m1, m2);
+		io_threads = webdar_tools_convert_to_int(m1);
+		if(io_threads < 1)
+		    throw exception_range("-e option needs at least one I/O thread");
+		if(m2.empty())
+		    workers = DEFAULT_WORKERS_PER_IO;
+		else
+		    workers = webdar_tools_convert_to_int(m2);
+		if(workers < 1)
+		    throw exception_range("-e option needs at least one worker thread per I/O thread");
+	    }
+	    break;
+	case 'u':
+	    if(optarg == nullptr)
+		throw exception_range("-u option needs an argument");
+	    else
+	    {
+		string m1, m2;
+		int kib;
+
+		webdar_tools_split_in_two(':', optarg, m1, m2);
+		kib = webdar_tools_convert_to_int(m1);
+		if(kib < 0)
+		    throw exception_range("-u option needs a positive integer");
+		if((unsigned long long)kib * 1024 > UINT_MAX)
+		    throw exception_range("-u option memory size is too large");
+		request::set_multipart_memory_limit(kib * 1024u);
+		if(!m2.empty())
+		{
+		    string m3;
+		    int body_kib;
+
+		    webdar_tools_split_in_two(':', m2, m1, m3);
+		    body_kib = webdar_tools_convert_to_int(m1);
+		    if(body_kib <= 0)
+			throw exception_range("-u option needs a strictly positive body size");
+		    if((unsigned long long)body_kib * 1024 > UINT_MAX)
+			throw exception_range("-u option body size is too large");
+		    request::set_max_body_size(body_kib * 1024u);
+
+		    if(!m3.empty())
+		    {
+			int spool_kib = webdar_tools_convert_to_int(m3);
+
+			if(spool_kib < 0)
+			    throw exception_range("-u option needs a positive multipart body size");
+			if((unsigned long long)spool_kib * 1024 > UINT_MAX)
+			    throw exception_range("-u option multipart body size is too large");
+			request::set_max_multipart_size(spool_kib * 1024u);
+		    }
+		}
+	    }
+	    break;
+	case 't':
+	    if(optarg == nullptr)
+		throw exception_range("-t option needs an argument");
+	    else
+	    {
+		string m1, m2, m3, m4;
+		int idle, header = DEFAULT_HEADER_TIMEOUT, body = DEFAULT_BODY_TIMEOUT;
+
+		webdar_tools_split_in_two(':', optarg, m1, m2);
+		webdar_tools_split_in_two(':', m2, m3, m4);
+		idle = webdar_tools_convert_to_int(m1);
+		if(!m3.empty())
+		    header = webdar_tools_convert_to_int(m3);
+		if(!m4.empty())
+		    body = webdar_tools_convert_to_int(m4);
+		if(idle < 0 || header < 0 || body < 0)
+		    throw exception_range("-t option needs positive numbers of seconds");
+		parser::set_idle_timeout(idle);
+		request::set_timeouts(header, body);
+	    }
+	    break;
+	case 'H':
+	    if(optarg == nullptr)
+		throw exception_range("-H option needs an argument");
+	    else
+	    {
+		string m1, m2;
+		int count, size = DEFAULT_MAX_HEADER_SIZE;
+
+		webdar_tools_split_in_two(':', optarg, m1, m2);
+		count = webdar_tools_convert_to_int(m1);
+		if(!m2.empty())
+		    size = webdar_tools_convert_to_int(m2);
+		if(count < 0 || size < 0)
+		    throw exception_range("-H option needs positive integers");
+		request::set_header_limits(count, size);
+	    }
+	    break;
+	case 'z':
+	    if(optarg == nullptr)
+		throw exception_range("-z option needs an argument");
+	    else
+	    {
+		string m1, m2;
+		int level, threshold;
+
+		webdar_tools_split_in_two(':', optarg, m1, m2);
+		level = webdar_tools_convert_to_int(m1);
+		if(m2.empty())
+		    threshold = http_compression::get_threshold();
+		else
+		    threshold = webdar_tools_convert_to_int(m2);
+		if(level < 0 || threshold < 0)
+		    throw exception_range("-z option needs positive integers");
+		http_compression::set_parameters(level, threshold);
+	    }
+	    break;
+	case 'D':
+	    http_compression::set_dynamic(true);
+	    break;
+	case 'Z':
+	    if(optarg == nullptr)
+		throw exception_range("-Z option needs an argument");
+	    else
+	    {
+		int kib = webdar_tools_convert_to_int(optarg);
+
+		if(kib < 0)
+		    throw exception_range("-Z option needs a positive integer");
+		if(kib > 0 && !connexion::zerocopy_available())
+		    throw exception_feature("zero-copy sending (MSG_ZEROCOPY)");
+		connexion::set_zerocopy_threshold(kib * 1024);
+	    }
+	    break;
 	default:
 	    throw WEBDAR_BUG; // "known option by getopt but not known by webdar!
 	}
@@ -729,8 +1139,11 @@ static void close_all_listeners(int sig)
 
 	creport->report(crit, "SIGNAL RECEIVED: propagating signal to all server thread objects...");
 
-	if(pool)
-	    pool->cancel();
+	for(vector<shared_ptr<server_pool> >::iterator pt = pools.begin(); pt != pools.end(); ++pt)
+	{
+	    if(*pt)
+		(*pt)->cancel();
+	}
 
 	creport->report(crit, "SIGNAL RECEIVED: All listeners and server thread objects have been asked to end");
     }
@@ -773,7 +1186,7 @@ static void signal_handler(int x)
 static void usage(const char* argv0)
 {
     string msg = "\n";
-    msg += libdar::tools_printf("Usage: %s [-l <IP>[:port]] [-v] [-b <facility>] [-w <yes|no>] [-m <num>] [-C <certificate file> -K <private key file>]\n", argv0);
+    msg += libdar::tools_printf("Usage: %s [-l <IP>[:port]] [-v] [-b <facility>] [-w <yes|no>] [-m <num>] [-e <num>[:<num>]] [-u <KiB>[:<KiB>]] [-z <level>[:<bytes>]] [-Z <KiB>] [-t <idle>[:<header>[:<body>]]] [-H <num>[:<bytes>]] [-n <num>[:pin]] [-p <num>[:<num>]] [-q <num>[:<seconds>]] [-P <service>[:<seconds>[:<num>]]] [-C <certificate file> -K <private key file> [-k] [-2] [-s <num>[:<seconds>]]]\n", argv0);
     msg += libdar::tools_printf("     : %s -V\n", argv0);
     msg += libdar::tools_printf("     : %s -h\n\n", argv0);
     msg += libdar::tools_printf("  -l : IP/port webdar will listen on. Defaults to loopback IP on TCP port %d\n", DEFAULT_TCP_PORT);
@@ -781,6 +1194,22 @@ static void usage(const char* argv0)
     msg += libdar::tools_printf("  -b : webdar in background sending messages to syslog <facility> (not yet implemented)\n");
     msg += libdar::tools_printf("  -w : yes: basic auth (no disconnection from browser), no: authentication requested for each TCP session\n");
     msg += libdar::tools_printf("  -m : max number of concurrent TCP sessions (%d by default)\n", DEFAULT_POOL_SIZE);
+    msg += libdar::tools_printf("  -e : event driven mode: <I/O threads>[:<workers per I/O thread>] (%d workers by default)\n", DEFAULT_WORKERS_PER_IO);
+    msg += libdar::tools_printf("  -n : number of listening threads per address sharing the connections (SO_REUSEPORT), \":pin\" pins them on distinct CPUs\n");
+    msg += libdar::tools_printf("  -p : number of server threads started beforehand (%d by default) and max number of idle ones kept for next connections (%d by default)\n", DEFAULT_PRESPAWN, DEFAULT_MAX_IDLE);
+    msg += libdar::tools_printf("  -q : max number of connections waiting for a server when all are busy (32 by default) and how long they can wait (%d seconds by default), others get a 503 answer\n", DEFAULT_WAIT_DEADLINE);
+    msg += libdar::tools_printf("  -P : authenticate with system accounts through the given PAM service, validated credentials being cached for <seconds> (300 by default, 0 to disable) up to <num> of them (256 by default)\n");
+    msg += libdar::tools_printf("  -u : max memory used per request to hold uploaded data, beyond it goes to temporary files (1024 KiB by default)\n");
+    msg += libdar::tools_printf("       followed by \":<KiB>\", max size of a non multipart request body (%d KiB by default)\n", DEFAULT_MAX_BODY_SIZE / 1024);
+    msg += libdar::tools_printf("       followed by \":<KiB>\", max size of a multipart request body, which may go to temporary files (%d KiB by default, 0 for no limit)\n", DEFAULT_MAX_MULTIPART_SIZE / 1024);
+    msg += libdar::tools_printf("  -t : timeouts in seconds waiting for a request (%d by default), receiving its header (%d by default) and between two pieces of its body (%d by default), 0 for no limit\n", DEFAULT_IDLE_TIMEOUT, DEFAULT_HEADER_TIMEOUT, DEFAULT_BODY_TIMEOUT);
+    msg += libdar::tools_printf("  -H : max number of header fields of a request (%d by default) and their max total size in bytes (%d by default), 0 for no limit\n", DEFAULT_MAX_HEADER_COUNT, DEFAULT_MAX_HEADER_SIZE);
+    msg += libdar::tools_printf("  -z : compression level (0 to disable, 6 by default) and min size of answers to compress (1024 by default)\n");
+    msg += libdar::tools_printf("  -D : also compress the pages generated per request, not only static resources (exposes them to the BREACH attack over HTTPS)\n");
+    msg += libdar::tools_printf("  -s : max number of TLS sessions cached for resumption (1024 by default, 0 to disable) and their lifetime (3600 seconds by default)\n");
+    msg += libdar::tools_printf("  -k : let the kernel cipher TLS records (kTLS) when supported\n");
+    msg += libdar::tools_printf("  -2 : offer HTTP/2 to browsers on HTTPS connections (ALPN), ignored in event driven mode\n");
+    msg += libdar::tools_printf("  -Z : min size of answers to send without copy (MSG_ZEROCOPY) on non TLS connections (0 to disable, the default)\n");
     msg += libdar::tools_printf("  -V : shows version information and exits\n");
     msg += libdar::tools_printf("  -h : displays this short help\n");
     msg += libdar::tools_printf("  -C : certificate from the PKI to authenticate the -K-given private key\n");
@@ -46,6 +46,7 @@ extern "C"
 
     // C++ system header files
 #include <iostream>
+#include <random>
 
     // webdar headers
 #include "webdar_tools.hpp"
@@ -223,17 +224,31 @@ void webdar_tools_init_randomization()
 	(void)rand();
 }
 
+    /// provides a generator seeded independently for each thread
+static mt19937 webdar_tools_seeded_generator()
+{
+    random_device source;
+    seed_seq seed{ source(), source(), source(), source(), source(), source(), source(), source() };
+
+    return mt19937(seed);
+}
+
 string webdar_tools_generate_random_string(unsigned int size)
 {
+	// rand() shares a state between threads without protection,
+	// each thread has here its own generator
+    static thread_local mt19937 generator = webdar_tools_seeded_generator();
+    uniform_int_distribution<unsigned int> first(10, 61);
+    uniform_int_distribution<unsigned int> others(0, 61);
     string ret = "";
     unsigned int x;
 
     for(unsigned int i = 0; i < size; ++i)
     {
 	if(i == 0)
-	    x = (rand() % 52) + 10;
+	    x = first(generator);
 	else
-	    x = rand() % 62;
+	    x = others(generator);
 
 	if(x < 10)
 	    ret += char(x + 48); // digits 0 - 9
@@ -467,3 +482,29 @@ string webdar_tools_capitalize_first_letter_of_words(const string & source)
 
     return ret;
 }
+
+bool webdar_tools_etag_match(const string & if_none_match, const string & etag)
+{
+    vector<string> tags;
+    string ref = etag;
+
+    if(ref.size() > 2 && ref[0] == 'W' && ref[1] == '/')
+	ref.erase(0, 2);
+
+    webdar_tools_split_by(',', if_none_match, tags);
+    for(vector<string>::iterator it = tags.begin(); it != tags.end(); ++it)
+    {
+	string tag = webdar_tools_remove_leading_spaces(*it);
+
+	while(!tag.empty() && (tag.back() == ' ' || tag.back() == '\t'))
+	    tag.pop_back();
+	if(tag == "*")
+	    return true;
+	if(tag.size() > 2 && tag[0] == 'W' && tag[1] == '/')
+	    tag.erase(0, 2);
+	if(tag == ref)
+	    return true;
+    }
+
+    return false;
+}
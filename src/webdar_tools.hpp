@@ -133,6 +133,7 @@ extern void webdar_tools_init_randomization();
     ///
     /// \param[in] size is the size of the string to generate
     /// \return a the quite random string
+    /// \note this call is thread-safe, each thread using its own generator seeded from std::random_device
 extern std::string webdar_tools_generate_random_string(unsigned int size);
 extern std::string webdar_tools_get_session_ID_from_URI(const uri & url);
 extern std::string webdar_tools_to_canonical_case(const std::string & ch);
@@ -146,4 +147,11 @@ extern bool webdar_tools_exists_and_is_dir(const std::string & path, bool follow
 
 extern std::string webdar_tools_capitalize_first_letter_of_words(const std::string & source);
 
+    /// whether an entity-tag matches the value of a If-None-Match header
+
+    /// \param[in] if_none_match the If-None-Match header value (list of entity-tags or "*")
+    /// \param[in] etag the entity-tag of the current representation
+    /// \note weak comparison is used (RFC 7232 paragraph 2.3.2)
+extern bool webdar_tools_etag_match(const std::string & if_none_match, const std::string & etag);
+
 #endif